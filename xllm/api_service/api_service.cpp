@@ -5,6 +5,8 @@
 #include <json2pb/json_to_pb.h>
 #include <json2pb/pb_to_json.h>
 
+#include <nlohmann/json.hpp>
+
 #include "call.h"
 #include "chat.pb.h"
 #include "completion.pb.h"
@@ -149,6 +151,79 @@ void APIService::ChatCompletionsHttp(
   }
 }
 
+namespace {
+// json2pb can't parse an array into the string field "input", so an array
+// input is moved to the batched input fields of the request.
+bool parse_embedding_request(const std::string& attachment,
+                             proto::EmbeddingRequest* req_pb,
+                             std::string* error) {
+  auto json = nlohmann::json::parse(attachment,
+                                    /*cb=*/nullptr,
+                                    /*allow_exceptions=*/false);
+  if (json.is_discarded() || !json.is_object()) {
+    *error = "request body is not a json object";
+    return false;
+  }
+  auto it = json.find("input");
+  if (it == json.end() || !it->is_array()) {
+    return json2pb::JsonToProtoMessage(attachment, req_pb, error);
+  }
+
+  nlohmann::json input = std::move(*it);
+  json.erase(it);
+  if (!json2pb::JsonToProtoMessage(json.dump(), req_pb, error)) {
+    return false;
+  }
+  if (input.empty()) {
+    *error = "input must not be an empty array";
+    return false;
+  }
+
+  auto add_token_ids = [&](const nlohmann::json& ids) {
+    if (ids.empty()) {
+      return false;
+    }
+    auto* token_ids = req_pb->add_input_token_ids();
+    token_ids->mutable_token_ids()->Reserve(ids.size());
+    for (const auto& id : ids) {
+      if (!id.is_number_integer()) {
+        return false;
+      }
+      token_ids->add_token_ids(id.get<int32_t>());
+    }
+    return true;
+  };
+
+  if (input.front().is_string()) {
+    // an array of strings
+    req_pb->mutable_input_texts()->Reserve(input.size());
+    for (auto& text : input) {
+      if (!text.is_string()) {
+        *error = "input must not mix strings and tokens";
+        return false;
+      }
+      req_pb->add_input_texts(std::move(text.get_ref<std::string&>()));
+    }
+  } else if (input.front().is_number_integer()) {
+    // an array of tokens
+    if (!add_token_ids(input)) {
+      *error = "input must be an array of integer tokens";
+      return false;
+    }
+  } else {
+    // an array of token arrays
+    req_pb->mutable_input_token_ids()->Reserve(input.size());
+    for (const auto& ids : input) {
+      if (!ids.is_array() || !add_token_ids(ids)) {
+        *error = "input must be an array of non-empty token arrays";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
 void APIService::Embeddings(::google::protobuf::RpcController* controller,
                             const proto::EmbeddingRequest* request,
                             proto::EmbeddingResponse* response,
@@ -178,7 +253,7 @@ void APIService::EmbeddingsHttp(::google::protobuf::RpcController* controller,
   auto ctrl = reinterpret_cast<brpc::Controller*>(controller);
   std::string attachment = std::move(ctrl->request_attachment().to_string());
   std::string error;
-  auto st = json2pb::JsonToProtoMessage(attachment, req_pb, &error);
+  auto st = parse_embedding_request(attachment, req_pb, &error);
   if (!st) {
     ctrl->SetFailed(error);
     LOG(ERROR) << "parse json to proto failed: " << error;
@@ -9,7 +9,10 @@
 
 #include <boost/algorithm/string.hpp>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "core/common/instance_name.h"
@@ -31,15 +34,14 @@ struct ToolCallResult {
   std::string finish_reason;
 };
 
+// the parser is shared by all choices of a response, detect_and_parse keeps
+// no state between calls.
 ToolCallResult process_tool_calls(std::string text,
-                                  const std::vector<xllm::JsonTool>& tools,
-                                  const std::string& parser_format,
+                                  function_call::FunctionCallParser& parser,
                                   std::string finish_reason,
                                   google::protobuf::Arena* arena = nullptr) {
   ToolCallResult result;
 
-  function_call::FunctionCallParser parser(tools, parser_format);
-
   if (!parser.has_tool_call(text)) {
     result.text = std::move(text);
     result.finish_reason = std::move(finish_reason);
@@ -83,6 +85,29 @@ ToolCallResult process_tool_calls(std::string text,
   return result;
 }
 
+// parses the tool calls of each choice of a streaming request
+class StreamingToolCallParsers {
+ public:
+  StreamingToolCallParsers(const std::vector<xllm::JsonTool>& tools,
+                           const std::string& parser_format)
+      : tools_(tools), parser_format_(parser_format) {}
+
+  function_call::FunctionCallParser& get(size_t index) {
+    auto& parser = parsers_[index];
+    if (parser == nullptr) {
+      parser = std::make_unique<function_call::FunctionCallParser>(
+          tools_, parser_format_);
+    }
+    return *parser;
+  }
+
+ private:
+  std::vector<xllm::JsonTool> tools_;
+  std::string parser_format_;
+  std::unordered_map<size_t, std::unique_ptr<function_call::FunctionCallParser>>
+      parsers_;
+};
+
 void set_logprobs(proto::ChatChoice* choice,
                   const std::optional<std::vector<LogProb>>& logprobs) {
   if (!logprobs.has_value() || logprobs.value().empty()) {
@@ -108,6 +133,57 @@ void set_logprobs(proto::ChatChoice* choice,
   }
 }
 
+// sends the normal text and the tool call deltas parsed from the streamed
+// text of a choice
+template <typename ChatCall>
+bool send_tool_call_deltas(std::shared_ptr<ChatCall> call,
+                           const std::string& request_id,
+                           int64_t created_time,
+                           const std::string& model,
+                           size_t index,
+                           const std::optional<std::vector<LogProb>>& logprobs,
+                           const function_call::StreamingParseResult& parsed) {
+  auto& response = call->response();
+  if (!parsed.normal_text.empty()) {
+    response.Clear();
+    response.set_object("chat.completion.chunk");
+    response.set_id(request_id);
+    response.set_created(created_time);
+    response.set_model(model);
+    auto* choice = response.add_choices();
+    choice->set_index(index);
+    set_logprobs(choice, logprobs);
+    auto* message = choice->mutable_delta();
+    message->set_content(parsed.normal_text);
+    if (!call->write(response)) {
+      return false;
+    }
+  }
+  for (const auto& call_item : parsed.calls) {
+    response.Clear();
+    response.set_object("chat.completion.chunk");
+    response.set_id(request_id);
+    response.set_created(created_time);
+    response.set_model(model);
+    auto* choice = response.add_choices();
+    choice->set_index(index);
+    auto* tool_call = choice->mutable_delta()->add_tool_calls();
+    tool_call->set_index(call_item.tool_index);
+    auto* function = tool_call->mutable_function();
+    if (call_item.name.has_value()) {
+      // the first delta of a tool call carries its id and name
+      tool_call->set_id(function_call::utils::generate_tool_call_id());
+      tool_call->set_type("function");
+      function->set_name(call_item.name.value());
+    }
+    function->set_arguments(call_item.parameters);
+    if (!call->write(response)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 template <typename ChatCall>
 bool send_delta_to_client_brpc(std::shared_ptr<ChatCall> call,
                                bool include_usage,
@@ -115,31 +191,44 @@ bool send_delta_to_client_brpc(std::shared_ptr<ChatCall> call,
                                const std::string& request_id,
                                int64_t created_time,
                                const std::string& model,
-                               const RequestOutput& output) {
+                               const RequestOutput& output,
+                               StreamingToolCallParsers* tool_call_parsers =
+                                   nullptr) {
   auto& response = call->response();
+  auto& chunk_writer = call->chunk_writer();
+  chunk_writer.init("chat.completion.chunk", request_id, created_time, model);
 
   // send delta to client
   for (const auto& seq_output : output.outputs) {
     const auto& index = seq_output.index;
-
-    if (first_message_sent->find(index) == first_message_sent->end()) {
-      response.Clear();
-      response.set_object("chat.completion.chunk");
-      response.set_id(request_id);
-      response.set_created(created_time);
-      response.set_model(model);
-      auto* choice = response.add_choices();
-      choice->set_index(index);
-      auto* message = choice->mutable_delta();
-      message->set_role("assistant");
-      message->set_content("");
-      first_message_sent->insert(index);
-      if (!call->write(response)) {
-        return false;
+    const bool first_message = first_message_sent->insert(index).second;
+    const bool has_logprobs =
+        seq_output.logprobs.has_value() && !seq_output.logprobs->empty();
+    function_call::FunctionCallParser* tool_call_parser =
+        tool_call_parsers != nullptr ? &tool_call_parsers->get(index)
+                                     : nullptr;
+
+    if (tool_call_parser == nullptr && !has_logprobs) {
+      // fast path: the role, the text and the finish reason of the step are
+      // rendered into one chunk
+      std::optional<std::string_view> content;
+      if (first_message || !seq_output.text.empty()) {
+        content = seq_output.text;
+      }
+      if (content.has_value() || seq_output.finish_reason.has_value()) {
+        chunk_writer.add_chat_chunk(index,
+                                    first_message ? "assistant" : nullptr,
+                                    content,
+                                    seq_output.finish_reason);
       }
+      continue;
+    }
+
+    if (first_message) {
+      chunk_writer.add_chat_chunk(index, "assistant", "", std::nullopt);
     }
 
-    if (!seq_output.text.empty()) {
+    if (tool_call_parser == nullptr) {
       response.Clear();
       response.set_object("chat.completion.chunk");
       response.set_id(request_id);
@@ -153,22 +242,47 @@ bool send_delta_to_client_brpc(std::shared_ptr<ChatCall> call,
       if (!call->write(response)) {
         return false;
       }
+    } else if (!seq_output.text.empty()) {
+      // the text of the tool calls is sent as tool_calls deltas
+      auto parsed =
+          tool_call_parser->parse_streaming_increment(seq_output.text);
+      if (!send_tool_call_deltas(call,
+                                 request_id,
+                                 created_time,
+                                 model,
+                                 index,
+                                 seq_output.logprobs,
+                                 parsed)) {
+        return false;
+      }
     }
 
-    if (seq_output.finish_reason.has_value()) {
-      response.Clear();
-      response.set_object("chat.completion.chunk");
-      response.set_id(request_id);
-      response.set_created(created_time);
-      response.set_model(model);
-      auto* choice = response.add_choices();
-      choice->set_index(index);
-      choice->mutable_delta();
-      choice->set_finish_reason(seq_output.finish_reason.value());
-      if (!call->write(response)) {
+    if (seq_output.finish_reason.has_value() && tool_call_parser != nullptr) {
+      // the text held back by the parser, e.g. a possibly incomplete start
+      // token, and an unterminated tool call are sent before the finish
+      auto parsed = tool_call_parser->finish_streaming();
+      if (!send_tool_call_deltas(call,
+                                 request_id,
+                                 created_time,
+                                 model,
+                                 index,
+                                 std::nullopt,
+                                 parsed)) {
         return false;
       }
     }
+
+    if (seq_output.finish_reason.has_value()) {
+      if (tool_call_parser != nullptr &&
+          tool_call_parser->get_detector()->has_streamed_tool_calls() &&
+          seq_output.finish_reason.value() == "stop") {
+        chunk_writer.add_chat_chunk(
+            index, nullptr, std::nullopt, std::string("tool_calls"));
+      } else {
+        chunk_writer.add_chat_chunk(
+            index, nullptr, std::nullopt, seq_output.finish_reason);
+      }
+    }
   }
 
   if (include_usage && output.usage.has_value()) {
@@ -193,7 +307,7 @@ bool send_delta_to_client_brpc(std::shared_ptr<ChatCall> call,
     response.Clear();
     return call->finish();
   }
-  return true;
+  return call->write_chunks();
 }
 
 template <typename ChatCall>
@@ -210,6 +324,12 @@ bool send_result_to_client_brpc(std::shared_ptr<ChatCall> call,
   response.set_created(created_time);
   response.set_model(model);
 
+  std::unique_ptr<function_call::FunctionCallParser> parser;
+  if (!tools.empty() && !parser_format.empty()) {
+    parser = std::make_unique<function_call::FunctionCallParser>(
+        tools, parser_format);
+  }
+
   response.mutable_choices()->Reserve(req_output.outputs.size());
   for (const auto& output : req_output.outputs) {
     auto* choice = response.add_choices();
@@ -225,11 +345,10 @@ bool send_result_to_client_brpc(std::shared_ptr<ChatCall> call,
       }
     };
 
-    if (!tools.empty() && !parser_format.empty()) {
+    if (parser != nullptr) {
       auto* arena = response.GetArena();
       auto result = process_tool_calls(output.text,
-                                       tools,
-                                       parser_format,
+                                       *parser,
                                        output.finish_reason.value_or(""),
                                        arena);
 
@@ -278,7 +397,7 @@ void ChatServiceImpl::process_async_impl(std::shared_ptr<ChatCall> call) {
   }
 
   // Check if the request is being rate-limited.
-  if (master_->get_rate_limiter()->is_limited()) {
+  if (master_->get_rate_limiter()->is_limited(rpc_request.user())) {
     call->finish_with_error(
         StatusCode::RESOURCE_EXHAUSTED,
         "The number of concurrent requests has reached the limit.");
@@ -318,6 +437,8 @@ void ChatServiceImpl::process_async_impl(std::shared_ptr<ChatCall> call) {
        stream = request_params.streaming,
        include_usage = include_usage,
        first_message_sent = std::unordered_set<size_t>(),
+       tool_call_parsers = std::shared_ptr<StreamingToolCallParsers>(),
+       tenant = request_params.tenant,
        request_id = request_params.request_id,
        created_time = absl::ToUnixSeconds(absl::Now()),
        json_tools = request_params.tools](
@@ -327,7 +448,7 @@ void ChatServiceImpl::process_async_impl(std::shared_ptr<ChatCall> call) {
           if (!status.ok()) {
             // Reduce the number of concurrent requests when a
             // request is finished with error.
-            master->get_rate_limiter()->decrease_one_request();
+            master->get_rate_limiter()->decrease_one_request(tenant);
 
             return call->finish_with_error(status.code(), status.message());
           }
@@ -336,7 +457,11 @@ void ChatServiceImpl::process_async_impl(std::shared_ptr<ChatCall> call) {
         // Reduce the number of concurrent requests when a request
         // is finished or canceled.
         if (req_output.finished || req_output.cancelled) {
-          master->get_rate_limiter()->decrease_one_request();
+          if (req_output.usage.has_value()) {
+            master->get_rate_limiter()->consume_tokens(
+                tenant, req_output.usage->num_generated_tokens);
+          }
+          master->get_rate_limiter()->decrease_one_request(tenant);
         }
 
         const std::string parser_format =
@@ -346,15 +471,19 @@ void ChatServiceImpl::process_async_impl(std::shared_ptr<ChatCall> call) {
 
         if (stream) {
           if (has_tool_support) {
-            // TODO: Support tool call streaming output
-            LOG(ERROR) << "Tool call does not support streaming output";
+            // Stream response with tool calls parsed incrementally
+            if (tool_call_parsers == nullptr) {
+              tool_call_parsers = std::make_shared<StreamingToolCallParsers>(
+                  json_tools, parser_format);
+            }
             return send_delta_to_client_brpc(call,
                                              include_usage,
                                              &first_message_sent,
                                              request_id,
                                              created_time,
                                              model,
-                                             req_output);
+                                             req_output,
+                                             tool_call_parsers.get());
           } else {
             // Stream response without tool support
             return send_delta_to_client_brpc(call,
@@ -400,7 +529,7 @@ void MMChatServiceImpl::process_async(std::shared_ptr<MMChatCall> call) {
   }
 
   // Check if the request is being rate-limited.
-  if (master_->get_rate_limiter()->is_limited()) {
+  if (master_->get_rate_limiter()->is_limited(rpc_request.user())) {
     call->finish_with_error(
         StatusCode::RESOURCE_EXHAUSTED,
         "The number of concurrent requests has reached the limit.");
@@ -436,6 +565,7 @@ void MMChatServiceImpl::process_async(std::shared_ptr<MMChatCall> call) {
        stream = request_params.streaming,
        include_usage = include_usage,
        first_message_sent = std::unordered_set<size_t>(),
+       tenant = request_params.tenant,
        request_id = request_params.request_id,
        created_time = absl::ToUnixSeconds(absl::Now())](
           const RequestOutput& req_output) mutable -> bool {
@@ -444,7 +574,7 @@ void MMChatServiceImpl::process_async(std::shared_ptr<MMChatCall> call) {
           if (!status.ok()) {
             // Reduce the number of concurrent requests when a request is
             // finished with error.
-            master->get_rate_limiter()->decrease_one_request();
+            master->get_rate_limiter()->decrease_one_request(tenant);
 
             return call->finish_with_error(status.code(), status.message());
           }
@@ -453,7 +583,11 @@ void MMChatServiceImpl::process_async(std::shared_ptr<MMChatCall> call) {
         // Reduce the number of concurrent requests when a request is finished
         // or canceled.
         if (req_output.finished || req_output.cancelled) {
-          master->get_rate_limiter()->decrease_one_request();
+          if (req_output.usage.has_value()) {
+            master->get_rate_limiter()->consume_tokens(
+                tenant, req_output.usage->num_generated_tokens);
+          }
+          master->get_rate_limiter()->decrease_one_request(tenant);
         }
 
         if (stream) {
@@ -40,8 +40,20 @@ bool send_delta_to_client_brpc(std::shared_ptr<CompletionCall> call,
                                const std::string& model,
                                const RequestOutput& output) {
   auto& response = call->response();
+  auto& chunk_writer = call->chunk_writer();
+  chunk_writer.init("text_completion", request_id, created_time, model);
 
   for (const auto& seq_output : output.outputs) {
+    if (!seq_output.logprobs.has_value() || seq_output.logprobs->empty()) {
+      // fast path: the text and the finish reason of the step are rendered
+      // into one chunk
+      if (!seq_output.text.empty() || seq_output.finish_reason.has_value()) {
+        chunk_writer.add_completion_chunk(
+            seq_output.index, seq_output.text, seq_output.finish_reason);
+      }
+      continue;
+    }
+
     if (!seq_output.text.empty()) {
       response.Clear();
       response.set_object("text_completion");
@@ -58,18 +70,8 @@ bool send_delta_to_client_brpc(std::shared_ptr<CompletionCall> call,
     }
 
     if (seq_output.finish_reason.has_value()) {
-      response.Clear();
-      response.set_object("text_completion");
-      response.set_id(request_id);
-      response.set_created(created_time);
-      response.set_model(model);
-      auto* choice = response.add_choices();
-      choice->set_index(seq_output.index);
-      choice->set_text("");
-      choice->set_finish_reason(seq_output.finish_reason.value());
-      if (!call->write(response)) {
-        return false;
-      }
+      chunk_writer.add_completion_chunk(
+          seq_output.index, "", seq_output.finish_reason);
     }
   }
 
@@ -96,7 +98,7 @@ bool send_delta_to_client_brpc(std::shared_ptr<CompletionCall> call,
     response.Clear();
     return call->finish();
   }
-  return true;
+  return call->write_chunks();
 }
 
 bool send_result_to_client_brpc(std::shared_ptr<CompletionCall> call,
@@ -153,7 +155,7 @@ void CompletionServiceImpl::process_async_impl(
   }
 
   // Check if the request is being rate-limited.
-  if (unlikely(master_->get_rate_limiter()->is_limited())) {
+  if (unlikely(master_->get_rate_limiter()->is_limited(rpc_request.user()))) {
     call->finish_with_error(
         StatusCode::RESOURCE_EXHAUSTED,
         "The number of concurrent requests has reached the limit.");
@@ -187,6 +189,7 @@ void CompletionServiceImpl::process_async_impl(
        master = master_,
        stream = request_params.streaming,
        include_usage = include_usage,
+       tenant = request_params.tenant,
        request_id = request_params.request_id,
        created_time = absl::ToUnixSeconds(absl::Now())](
           const RequestOutput& req_output) -> bool {
@@ -195,7 +198,7 @@ void CompletionServiceImpl::process_async_impl(
           if (!status.ok()) {
             // Reduce the number of concurrent requests when a request is
             // finished with error.
-            master->get_rate_limiter()->decrease_one_request();
+            master->get_rate_limiter()->decrease_one_request(tenant);
 
             return call->finish_with_error(status.code(), status.message());
           }
@@ -204,7 +207,11 @@ void CompletionServiceImpl::process_async_impl(
         // Reduce the number of concurrent requests when a request is finished
         // or canceled.
         if (req_output.finished || req_output.cancelled) {
-          master->get_rate_limiter()->decrease_one_request();
+          if (req_output.usage.has_value()) {
+            master->get_rate_limiter()->consume_tokens(
+                tenant, req_output.usage->num_generated_tokens);
+          }
+          master->get_rate_limiter()->decrease_one_request(tenant);
         }
 
         if (stream) {
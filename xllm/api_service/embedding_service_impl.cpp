@@ -1,8 +1,15 @@
 #include "embedding_service_impl.h"
 
+#include <absl/strings/escaping.h>
+#include <absl/strings/str_cat.h>
+#include <absl/synchronization/mutex.h>
 #include <glog/logging.h>
 
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "api_service/stream_chunk_writer.h"
 
 #include "common/instance_name.h"
 #include "framework/request/request_params.h"
@@ -13,44 +20,109 @@
 namespace xllm {
 namespace {
 
-bool send_result_to_client_brpc(std::shared_ptr<EmbeddingCall> call,
-                                const std::string& request_id,
-                                int64_t created_time,
-                                const std::string& model,
-                                const RequestOutput& req_output) {
+// collects the outputs of the inputs of a batched embedding request
+struct EmbeddingBatch {
+  explicit EmbeddingBatch(size_t num_inputs)
+      : embeddings(num_inputs), num_pending(num_inputs) {}
+
+  absl::Mutex mutex;
+
+  std::vector<std::vector<float>> embeddings ABSL_GUARDED_BY(mutex);
+
+  Usage usage ABSL_GUARDED_BY(mutex);
+
+  size_t num_pending ABSL_GUARDED_BY(mutex);
+
+  bool failed ABSL_GUARDED_BY(mutex) = false;
+};
+
+void set_usage(proto::EmbeddingResponse& response, const Usage& usage) {
+  auto* proto_usage = response.mutable_usage();
+  proto_usage->set_prompt_tokens(static_cast<int32_t>(usage.num_prompt_tokens));
+  proto_usage->set_completion_tokens(
+      static_cast<int32_t>(usage.num_generated_tokens));
+  proto_usage->set_total_tokens(static_cast<int32_t>(usage.num_total_tokens));
+}
+
+bool send_result_to_client_brpc(
+    std::shared_ptr<EmbeddingCall> call,
+    const std::string& request_id,
+    int64_t created_time,
+    const std::string& model,
+    const std::vector<std::vector<float>>& embeddings,
+    const Usage& usage) {
   auto& response = call->response();
   response.set_object("list");
   response.set_id(request_id);
   response.set_created(created_time);
   response.set_model(model);
 
-  response.mutable_data()->Reserve(req_output.outputs.size());
-  for (const auto& output : req_output.outputs) {
+  response.mutable_data()->Reserve(embeddings.size());
+  for (size_t i = 0; i < embeddings.size(); ++i) {
     // add data into response
     auto* data = response.add_data();
-    data->set_index(output.index);
+    data->set_index(static_cast<int32_t>(i));
     data->set_object("embedding");
-    if (output.embeddings.has_value()) {
-      data->mutable_embedding()->Add(
-          output.embeddings->data(),
-          output.embeddings->data() + output.embeddings->size());
-    }
+    data->mutable_embedding()->Add(embeddings[i].begin(), embeddings[i].end());
   }
 
   // add usage statistics
-  if (req_output.usage.has_value()) {
-    const auto& usage = req_output.usage.value();
-    auto* proto_usage = response.mutable_usage();
-    proto_usage->set_prompt_tokens(
-        static_cast<int32_t>(usage.num_prompt_tokens));
-    proto_usage->set_completion_tokens(
-        static_cast<int32_t>(usage.num_generated_tokens));
-    proto_usage->set_total_tokens(static_cast<int32_t>(usage.num_total_tokens));
-  }
+  set_usage(response, usage);
 
   return call->write_and_finish(response);
 }
 
+// renders the response without json2pb, the embeddings are the base64 of the
+// raw little-endian float buffers instead of json arrays of floats.
+bool send_base64_result_to_client_brpc(
+    std::shared_ptr<EmbeddingCall> call,
+    const std::string& request_id,
+    int64_t created_time,
+    const std::string& model,
+    const std::vector<std::vector<float>>& embeddings,
+    const Usage& usage) {
+  static_assert(sizeof(float) == 4, "float must be 32 bits");
+  std::string json;
+  size_t num_bytes = 0;
+  for (const auto& embedding : embeddings) {
+    num_bytes += embedding.size() * sizeof(float);
+  }
+  json.reserve(256 + embeddings.size() * 64 + num_bytes * 4 / 3);
+
+  json.append("{\"id\":");
+  StreamChunkWriter::append_json_string(request_id, &json);
+  json.append(",\"object\":\"list\",\"created\":");
+  json.append(std::to_string(created_time));
+  json.append(",\"model\":");
+  StreamChunkWriter::append_json_string(model, &json);
+  json.append(",\"data\":[");
+  std::string encoded;
+  for (size_t i = 0; i < embeddings.size(); ++i) {
+    if (i > 0) {
+      json.push_back(',');
+    }
+    json.append("{\"index\":");
+    json.append(std::to_string(i));
+    json.append(",\"object\":\"embedding\",\"embedding\":\"");
+    // base64 needs no json escaping
+    absl::Base64Escape(
+        absl::string_view(reinterpret_cast<const char*>(embeddings[i].data()),
+                          embeddings[i].size() * sizeof(float)),
+        &encoded);
+    json.append(encoded);
+    json.append("\"}");
+  }
+  json.append("],\"usage\":{\"prompt_tokens\":");
+  json.append(std::to_string(usage.num_prompt_tokens));
+  json.append(",\"completion_tokens\":");
+  json.append(std::to_string(usage.num_generated_tokens));
+  json.append(",\"total_tokens\":");
+  json.append(std::to_string(usage.num_total_tokens));
+  json.append("}}");
+
+  return call->write_json_and_finish(json);
+}
+
 }  // namespace
 
 EmbeddingServiceImpl::EmbeddingServiceImpl(
@@ -74,29 +146,108 @@ void EmbeddingServiceImpl::process_async_impl(
   RequestParams request_params(
       rpc_request, call->get_x_request_id(), call->get_x_request_time());
 
-  // TODO only support input_str for now
-  auto& input = rpc_request.input();
+  // the inputs are scheduled as separate requests and the response is sent
+  // once all of them are finished.
+  std::vector<std::string> texts;
+  std::vector<std::vector<int>> token_ids;
+  if (rpc_request.input_token_ids_size() > 0) {
+    token_ids.reserve(rpc_request.input_token_ids_size());
+    for (const auto& ids : rpc_request.input_token_ids()) {
+      token_ids.emplace_back(ids.token_ids().begin(), ids.token_ids().end());
+    }
+  } else if (rpc_request.input_texts_size() > 0) {
+    texts.assign(rpc_request.input_texts().begin(),
+                 rpc_request.input_texts().end());
+  } else {
+    texts.push_back(rpc_request.input());
+  }
 
-  // schedule the request
-  master_->handle_request(
-      std::move(input),
-      std::nullopt,
-      std::move(request_params),
+  const size_t num_inputs = texts.size() + token_ids.size();
+  auto batch = std::make_shared<EmbeddingBatch>(num_inputs);
+  BatchOutputCallback callback =
       [call,
+       batch,
        model,
+       base64 = rpc_request.encoding_format() == "base64",
        request_id = request_params.request_id,
        created_time = absl::ToUnixSeconds(absl::Now())](
-          const RequestOutput& req_output) -> bool {
-        if (req_output.status.has_value()) {
-          const auto& status = req_output.status.value();
-          if (!status.ok()) {
-            return call->finish_with_error(status.code(), status.message());
-          }
-        }
-
-        return send_result_to_client_brpc(
-            call, request_id, created_time, model, req_output);
-      });
+          size_t index, RequestOutput req_output) -> bool {
+    absl::MutexLock lock(&batch->mutex);
+    if (batch->failed) {
+      return false;
+    }
+    if (req_output.status.has_value()) {
+      const auto& status = req_output.status.value();
+      if (!status.ok()) {
+        batch->failed = true;
+        return call->finish_with_error(status.code(), status.message());
+      }
+    }
+
+    for (auto& output : req_output.outputs) {
+      if (output.embeddings.has_value()) {
+        batch->embeddings[index] = std::move(output.embeddings.value());
+      }
+    }
+    if (req_output.usage.has_value()) {
+      const auto& usage = req_output.usage.value();
+      batch->usage.num_prompt_tokens += usage.num_prompt_tokens;
+      batch->usage.num_generated_tokens += usage.num_generated_tokens;
+      batch->usage.num_total_tokens += usage.num_total_tokens;
+    }
+    if (--batch->num_pending > 0) {
+      return true;
+    }
+
+    if (base64) {
+      return send_base64_result_to_client_brpc(call,
+                                               request_id,
+                                               created_time,
+                                               model,
+                                               batch->embeddings,
+                                               batch->usage);
+    }
+    return send_result_to_client_brpc(call,
+                                      request_id,
+                                      created_time,
+                                      model,
+                                      batch->embeddings,
+                                      batch->usage);
+  };
+
+  // every input is scheduled as its own request, so each one gets its own
+  // request id to keep them apart in the scheduler, e.g. for the remote
+  // requests of disaggregated PD.
+  std::vector<RequestParams> inputs_params(num_inputs, request_params);
+  if (num_inputs > 1) {
+    for (size_t i = 0; i < num_inputs; ++i) {
+      inputs_params[i].request_id =
+          absl::StrCat(request_params.request_id, "-", i);
+    }
+  }
+
+  // schedule the requests
+  if (!token_ids.empty()) {
+    for (size_t i = 0; i < token_ids.size(); ++i) {
+      master_->handle_request("",
+                              std::move(token_ids[i]),
+                              std::move(inputs_params[i]),
+                              [i, callback](RequestOutput output) {
+                                return callback(i, std::move(output));
+                              });
+    }
+  } else if (texts.size() > 1) {
+    // the prompts are encoded with one encode_batch() call
+    master_->handle_batch_request(
+        std::move(texts), std::move(inputs_params), std::move(callback));
+  } else {
+    master_->handle_request(std::move(texts[0]),
+                            std::nullopt,
+                            std::move(inputs_params[0]),
+                            [callback](RequestOutput output) {
+                              return callback(0, std::move(output));
+                            });
+  }
 }
 
 }  // namespace xllm
@@ -46,6 +46,12 @@ class NonStreamCall : public Call {
     return true;
   }
 
+  // For non stream response rendered without json2pb
+  bool write_json_and_finish(const std::string& json) {
+    controller_->response_attachment().append(json);
+    return true;
+  }
+
   // For non stream response
   bool finish_with_error(const StatusCode& code,
                          const std::string& error_message) {
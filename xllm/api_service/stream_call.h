@@ -11,6 +11,7 @@
 #include <string>
 
 #include "api_service/call.h"
+#include "api_service/stream_chunk_writer.h"
 #include "core/common/types.h"
 
 namespace xllm {
@@ -81,6 +82,8 @@ class StreamCall : public Call {
 
   // For stream response
   bool write(Response& response) {
+    // keep the order with the chunks rendered by chunk_writer()
+    write_chunks();
     io_buf_.clear();
     io_buf_.append("data: ");
     butil::IOBufAsZeroCopyOutputStream json_output(&io_buf_);
@@ -96,8 +99,23 @@ class StreamCall : public Call {
     return true;
   }
 
+  // For stream response, send the pending chunks of chunk_writer() in one
+  // write.
+  bool write_chunks() {
+    if (chunk_writer_.empty()) {
+      return true;
+    }
+    io_buf_.clear();
+    io_buf_.append(chunk_writer_.events());
+    chunk_writer_.clear();
+
+    pa_->Write(io_buf_);
+    return true;
+  }
+
   // For stream response
   bool finish() {
+    write_chunks();
     io_buf_.clear();
     io_buf_.append("data: [DONE]\n\n");
 
@@ -107,6 +125,7 @@ class StreamCall : public Call {
 
   const Request& request() const { return *request_; }
   Response& response() { return *response_; }
+  StreamChunkWriter& chunk_writer() { return chunk_writer_; }
   ::google::protobuf::Closure* done() { return done_; }
 
  private:
@@ -119,6 +138,9 @@ class StreamCall : public Call {
   butil::intrusive_ptr<brpc::ProgressiveAttachment> pa_;
   butil::IOBuf io_buf_;
 
+  // renders the streaming chunks without protobuf reflection
+  StreamChunkWriter chunk_writer_;
+
   json2pb::Pb2JsonOptions json_options_;
 };
 
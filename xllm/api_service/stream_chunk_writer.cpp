@@ -0,0 +1,118 @@
+#include "stream_chunk_writer.h"
+
+namespace xllm {
+
+void StreamChunkWriter::init(const std::string& object,
+                             const std::string& request_id,
+                             int64_t created_time,
+                             const std::string& model) {
+  if (initialized()) {
+    return;
+  }
+  prefix_.append("data: {\"id\":");
+  append_json_string(request_id, &prefix_);
+  prefix_.append(",\"object\":");
+  append_json_string(object, &prefix_);
+  // created is an uint32 field in the response protos
+  prefix_.append(",\"created\":");
+  prefix_.append(std::to_string(static_cast<uint32_t>(created_time)));
+  prefix_.append(",\"model\":");
+  append_json_string(model, &prefix_);
+  prefix_.append(",\"choices\":[");
+}
+
+void StreamChunkWriter::add_chat_chunk(
+    size_t index,
+    const char* role,
+    std::optional<std::string_view> content,
+    const std::optional<std::string>& finish_reason) {
+  append_choice_prefix(index);
+  events_.append(",\"delta\":{");
+  if (role != nullptr) {
+    events_.append("\"role\":");
+    append_json_string(role, &events_);
+  }
+  if (content.has_value()) {
+    if (role != nullptr) {
+      events_.push_back(',');
+    }
+    events_.append("\"content\":");
+    append_json_string(content.value(), &events_);
+  }
+  events_.push_back('}');
+  append_choice_suffix(finish_reason);
+}
+
+void StreamChunkWriter::add_completion_chunk(
+    size_t index,
+    std::string_view text,
+    const std::optional<std::string>& finish_reason) {
+  append_choice_prefix(index);
+  events_.append(",\"text\":");
+  append_json_string(text, &events_);
+  append_choice_suffix(finish_reason);
+}
+
+void StreamChunkWriter::append_choice_prefix(size_t index) {
+  events_.append(prefix_);
+  events_.append("{\"index\":");
+  events_.append(std::to_string(static_cast<uint32_t>(index)));
+}
+
+void StreamChunkWriter::append_choice_suffix(
+    const std::optional<std::string>& finish_reason) {
+  if (finish_reason.has_value()) {
+    events_.append(",\"finish_reason\":");
+    append_json_string(finish_reason.value(), &events_);
+  }
+  events_.append("}]}\n\n");
+}
+
+void StreamChunkWriter::append_json_string(std::string_view str,
+                                           std::string* out) {
+  static constexpr char kHexDigits[] = "0123456789ABCDEF";
+  out->reserve(out->size() + str.size() + 2);
+  out->push_back('"');
+  // copy runs of characters that need no escaping at once
+  size_t run_start = 0;
+  for (size_t i = 0; i < str.size(); ++i) {
+    const unsigned char c = str[i];
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    out->append(str.data() + run_start, i - run_start);
+    run_start = i + 1;
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\b':
+        out->append("\\b");
+        break;
+      case '\f':
+        out->append("\\f");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\r':
+        out->append("\\r");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default:
+        out->append("\\u00");
+        out->push_back(kHexDigits[c >> 4]);
+        out->push_back(kHexDigits[c & 0xF]);
+        break;
+    }
+  }
+  out->append(str.data() + run_start, str.size() - run_start);
+  out->push_back('"');
+}
+
+}  // namespace xllm
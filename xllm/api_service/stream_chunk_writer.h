@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace xllm {
+
+// Renders the chunks of streaming chat and completion responses into SSE
+// events without going through protobuf reflection. The fields shared by all
+// chunks of a request are rendered once, so only the delta text is escaped
+// for each token. The json is the same as json2pb renders for the chunk.
+//
+// Chunks are appended to a reused buffer, StreamCall flushes them together
+// with a single write.
+class StreamChunkWriter final {
+ public:
+  StreamChunkWriter() = default;
+
+  // set the fields shared by all chunks of the request, no-op once set.
+  void init(const std::string& object,
+            const std::string& request_id,
+            int64_t created_time,
+            const std::string& model);
+
+  bool initialized() const { return !prefix_.empty(); }
+
+  // append a chat chunk with a single choice. the role, the content and the
+  // finish reason are coalesced into one event, each is rendered only if set.
+  void add_chat_chunk(size_t index,
+                      const char* role,
+                      std::optional<std::string_view> content,
+                      const std::optional<std::string>& finish_reason);
+
+  // append a completion chunk with a single choice.
+  void add_completion_chunk(size_t index,
+                            std::string_view text,
+                            const std::optional<std::string>& finish_reason);
+
+  bool empty() const { return events_.empty(); }
+
+  const std::string& events() const { return events_; }
+
+  // clear the pending events and keep the buffer for reuse
+  void clear() { events_.clear(); }
+
+  // append str as a quoted json string to out
+  static void append_json_string(std::string_view str, std::string* out);
+
+ private:
+  void append_choice_prefix(size_t index);
+
+  void append_choice_suffix(const std::optional<std::string>& finish_reason);
+
+  // `data: {"id":...,"object":...,"created":...,"model":...,"choices":[`
+  std::string prefix_;
+
+  std::string events_;
+};
+
+}  // namespace xllm
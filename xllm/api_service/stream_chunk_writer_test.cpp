@@ -0,0 +1,147 @@
+#include "stream_chunk_writer.h"
+
+#include <gtest/gtest.h>
+#include <json2pb/pb_to_json.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "chat.pb.h"
+#include "completion.pb.h"
+
+namespace xllm {
+
+namespace {
+const std::string kRequestId = "chatcmpl-\"1\"\\";
+const int64_t kCreatedTime = 1700000000;
+const std::string kModel = "model/\t\xE6\xA8\xA1\xE5\x9E\x8B";
+
+// strings covering the characters that json escapes
+const std::vector<std::string> kTexts = {
+    "",
+    "hello world",
+    "quote \" and backslash \\ and slash /",
+    "\b\f\n\r\t",
+    std::string("nul \0 and", 9) + " \x01 \x1f \x7f",
+    "utf8 \xE4\xBD\xA0\xE5\xA5\xBD \xF0\x9F\x98\x80",
+    "</script><tool_call>\n{\"name\": \"f\"}\n</tool_call>",
+};
+
+// the event StreamCall::write() renders for the response
+std::string to_event(const google::protobuf::Message& response) {
+  json2pb::Pb2JsonOptions options;
+  options.bytes_to_base64 = false;
+  options.jsonify_empty_array = true;
+  std::string json;
+  std::string error;
+  EXPECT_TRUE(json2pb::ProtoMessageToJson(response, &json, options, &error))
+      << error;
+  return "data: " + json + "\n\n";
+}
+
+proto::ChatResponse chat_chunk(size_t index,
+                               const char* role,
+                               const std::optional<std::string>& content,
+                               const std::optional<std::string>& reason) {
+  proto::ChatResponse response;
+  response.set_object("chat.completion.chunk");
+  response.set_id(kRequestId);
+  response.set_created(kCreatedTime);
+  response.set_model(kModel);
+  auto* choice = response.add_choices();
+  choice->set_index(index);
+  auto* delta = choice->mutable_delta();
+  if (role != nullptr) {
+    delta->set_role(role);
+  }
+  if (content.has_value()) {
+    delta->set_content(content.value());
+  }
+  if (reason.has_value()) {
+    choice->set_finish_reason(reason.value());
+  }
+  return response;
+}
+
+proto::CompletionResponse completion_chunk(
+    size_t index,
+    const std::string& text,
+    const std::optional<std::string>& reason) {
+  proto::CompletionResponse response;
+  response.set_object("text_completion");
+  response.set_id(kRequestId);
+  response.set_created(kCreatedTime);
+  response.set_model(kModel);
+  auto* choice = response.add_choices();
+  choice->set_index(index);
+  choice->set_text(text);
+  if (reason.has_value()) {
+    choice->set_finish_reason(reason.value());
+  }
+  return response;
+}
+}  // namespace
+
+TEST(StreamChunkWriterTest, ChatChunkMatchesJson2pb) {
+  StreamChunkWriter writer;
+  writer.init("chat.completion.chunk", kRequestId, kCreatedTime, kModel);
+
+  const std::vector<std::optional<std::string>> reasons = {
+      std::nullopt, "stop", "length"};
+  for (const char* role : {static_cast<const char*>(nullptr), "assistant"}) {
+    std::vector<std::optional<std::string>> contents = {std::nullopt};
+    contents.insert(contents.end(), kTexts.begin(), kTexts.end());
+    for (const auto& content : contents) {
+      for (const auto& reason : reasons) {
+        writer.add_chat_chunk(
+            /*index=*/3,
+            role,
+            content.has_value()
+                ? std::optional<std::string_view>(content.value())
+                : std::nullopt,
+            reason);
+        EXPECT_EQ(writer.events(),
+                  to_event(chat_chunk(3, role, content, reason)));
+        writer.clear();
+      }
+    }
+  }
+}
+
+TEST(StreamChunkWriterTest, CompletionChunkMatchesJson2pb) {
+  StreamChunkWriter writer;
+  writer.init("text_completion", kRequestId, kCreatedTime, kModel);
+
+  for (const auto& text : kTexts) {
+    for (const auto& reason :
+         std::vector<std::optional<std::string>>{std::nullopt, "stop"}) {
+      writer.add_completion_chunk(/*index=*/0, text, reason);
+      EXPECT_EQ(writer.events(), to_event(completion_chunk(0, text, reason)));
+      writer.clear();
+    }
+  }
+}
+
+TEST(StreamChunkWriterTest, ChunksAreAppended) {
+  StreamChunkWriter writer;
+  EXPECT_FALSE(writer.initialized());
+  writer.init("chat.completion.chunk", kRequestId, kCreatedTime, kModel);
+  EXPECT_TRUE(writer.initialized());
+  // the shared fields are set once
+  writer.init("ignored", "ignored", 0, "ignored");
+  EXPECT_TRUE(writer.empty());
+
+  writer.add_chat_chunk(0, "assistant", "", std::nullopt);
+  writer.add_chat_chunk(1, nullptr, "a\nb", std::nullopt);
+  writer.add_chat_chunk(0, nullptr, std::nullopt, std::string("stop"));
+  EXPECT_EQ(writer.events(),
+            to_event(chat_chunk(0, "assistant", "", std::nullopt)) +
+                to_event(chat_chunk(1, nullptr, "a\nb", std::nullopt)) +
+                to_event(chat_chunk(0, nullptr, std::nullopt, "stop")));
+
+  writer.clear();
+  EXPECT_TRUE(writer.empty());
+}
+
+}  // namespace xllm
@@ -28,6 +28,17 @@ DEFINE_int32(
 
 BRPC_VALIDATE_GFLAG(max_concurrent_requests, brpc::NonNegativeInteger);
 
+DEFINE_int32(max_concurrent_requests_per_tenant,
+             0,
+             "Maximum number of concurrent requests of a single tenant, the "
+             "tenant is taken from the `user` field of the request. 0 means "
+             "no limit.");
+
+DEFINE_int32(max_tokens_per_second_per_tenant,
+             0,
+             "Maximum number of prompt and generated tokens per second of a "
+             "single tenant. 0 means no limit.");
+
 // --- model serving config ---
 
 DEFINE_string(model_id, "", "hf model name.");
@@ -85,6 +96,39 @@ DEFINE_int32(num_response_handling_threads,
              4,
              "Number of response handling threads.");
 
+DEFINE_int32(num_weight_load_threads,
+             16,
+             "Number of io threads to parse the model weights files and read "
+             "them ahead.");
+
+DEFINE_string(weight_cache_dir,
+              "",
+              "Directory of the cache of the sharded weights of each rank, "
+              "written by the first load and read by the later ones. Empty "
+              "to disable it.");
+
+DEFINE_int32(mm_data_cache_size_mb,
+             512,
+             "Host memory in MB to cache the processed images of the "
+             "multimodal requests by their contents, 0 to disable it.");
+
+DEFINE_int32(stream_flush_interval_ms,
+             0,
+             "Coalesce the streaming outputs of a request generated within "
+             "the interval into one response, in milliseconds. The first "
+             "token and the finish reason are always sent immediately. 0 "
+             "sends the outputs of every step.");
+
+DEFINE_int32(stream_flush_max_tokens,
+             16,
+             "Send the coalesced streaming outputs of a request once a "
+             "sequence has this many unsent tokens, regardless of "
+             "stream_flush_interval_ms. 0 means no limit.");
+
+DEFINE_int32(num_tokenizer_threads,
+             8,
+             "Number of threads to encode or decode a batch of texts.");
+
 DEFINE_bool(enable_chunked_prefill, true, "Whether to enable chunked prefill.");
 
 DEFINE_int32(dp_size, 1, "Data parallel size for MLA attention.");
@@ -99,6 +143,40 @@ DEFINE_double(prefill_scheduling_memory_usage_threshold,
               0.95,
               "The memory usage threshold during prefill scheduling.");
 
+DEFINE_bool(enable_swap_preemption,
+            false,
+            "Whether to swap the kv cache of preempted requests out to host "
+            "memory instead of recomputing it. Requires host_blocks_factor > "
+            "0, falls back to recompute when host memory is exhausted.");
+
+DEFINE_int32(schedule_coalescing_window_us,
+             0,
+             "How long the idle scheduler waits for more requests to arrive "
+             "after being woken up by a new request, in microseconds. 0 "
+             "schedules the request immediately.");
+
+DEFINE_int32(default_ttft_slo_ms,
+             10000,
+             "The TTFT SLO of requests without one, in milliseconds. Waiting "
+             "requests of the same priority class are ordered by the deadline "
+             "of their first token.");
+
+DEFINE_bool(enable_tenant_fair_share,
+            false,
+            "Whether to share the prefill budget fairly across tenants with "
+            "deficit round robin instead of serving waiting requests in "
+            "arrival order.");
+
+DEFINE_int32(tenant_quantum_tokens,
+             2048,
+             "Number of prefill tokens a tenant is credited per round when "
+             "tenant fair share is enabled.");
+
+DEFINE_string(tenant_weights,
+              "",
+              "Fair share weights of tenants, e.g. 'tenant_a:2,tenant_b:1'. "
+              "Tenants not listed have weight 1.");
+
 DEFINE_string(communication_backend, "hccl", "npu communication backend.");
 
 DEFINE_bool(enable_eplb, false, "Whether to use ep load balance.");
@@ -121,6 +199,19 @@ DEFINE_bool(enable_prefix_cache,
             true,
             "enable the prefix cache for the block manager");
 
+DEFINE_string(prefix_cache_policy,
+              "murmur_hash3",
+              "The prefix cache policy: murmur_hash3, sha256_hash or "
+              "radix_tree. radix_tree matches at token granularity and "
+              "copies the partially matched last block.");
+
+DEFINE_double(host_blocks_factor,
+              0.0,
+              "The number of host (CPU DRAM) kv cache blocks as a multiple "
+              "of the device kv cache blocks. Blocks evicted from the prefix "
+              "cache or of swapped out requests are kept in host memory and "
+              "swapped back in later. 0 disables the host tier.");
+
 // --- serving on multi-nodes config ---
 
 DEFINE_string(master_node_addr,
@@ -132,6 +223,23 @@ DEFINE_int32(nnodes, 1, "The number of multi-nodes.");
 
 DEFINE_int32(node_rank, 0, "The node rank.");
 
+DEFINE_int32(forward_input_snapshot_interval,
+             64,
+             "Send the full block tables to remote workers every N steps, the "
+             "other steps only send the changes since the previous step. 0 "
+             "always sends the full block tables.");
+
+DEFINE_bool(enable_step_shm_channel,
+            true,
+            "Whether to send the forward inputs and outputs of worker "
+            "processes on the same host through shared memory instead of "
+            "rpc. Workers on other hosts keep using rpc.");
+
+DEFINE_int32(step_shm_channel_capacity_mb,
+             64,
+             "The size of each shared memory ring between the master and a "
+             "worker process in MB. Larger steps fall back to rpc.");
+
 // --- disaggregated prefill and decode config ---
 
 DEFINE_string(xservice_addr, "", "xservice server address.");
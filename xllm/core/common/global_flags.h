@@ -38,6 +38,10 @@ DECLARE_double(max_memory_utilization);
 
 DECLARE_bool(enable_prefix_cache);
 
+DECLARE_string(prefix_cache_policy);
+
+DECLARE_double(host_blocks_factor);
+
 DECLARE_int32(max_tokens_per_batch);
 
 DECLARE_int32(max_seqs_per_batch);
@@ -50,6 +54,18 @@ DECLARE_int32(num_handling_threads);
 
 DECLARE_int32(num_response_handling_threads);
 
+DECLARE_int32(num_weight_load_threads);
+
+DECLARE_string(weight_cache_dir);
+
+DECLARE_int32(mm_data_cache_size_mb);
+
+DECLARE_int32(stream_flush_interval_ms);
+
+DECLARE_int32(stream_flush_max_tokens);
+
+DECLARE_int32(num_tokenizer_threads);
+
 DECLARE_string(communication_backend);
 
 DECLARE_bool(enable_eplb);
@@ -72,6 +88,12 @@ DECLARE_int32(nnodes);
 
 DECLARE_int32(node_rank);
 
+DECLARE_int32(forward_input_snapshot_interval);
+
+DECLARE_bool(enable_step_shm_channel);
+
+DECLARE_int32(step_shm_channel_capacity_mb);
+
 DECLARE_int32(dp_size);
 
 DECLARE_int32(ep_size);
@@ -90,10 +112,26 @@ DECLARE_int32(transfer_listen_port);
 
 DECLARE_int32(max_concurrent_requests);
 
+DECLARE_int32(max_concurrent_requests_per_tenant);
+
+DECLARE_int32(max_tokens_per_second_per_tenant);
+
 DECLARE_bool(enable_schedule_overlap);
 
 DECLARE_double(prefill_scheduling_memory_usage_threshold);
 
+DECLARE_bool(enable_swap_preemption);
+
+DECLARE_int32(schedule_coalescing_window_us);
+
+DECLARE_int32(default_ttft_slo_ms);
+
+DECLARE_bool(enable_tenant_fair_share);
+
+DECLARE_int32(tenant_quantum_tokens);
+
+DECLARE_string(tenant_weights);
+
 DECLARE_int32(expert_parallel_degree);
 
 DECLARE_int32(max_connect_count);
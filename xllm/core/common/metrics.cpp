@@ -40,6 +40,12 @@ DEFINE_COUNTER(prefix_cache_latency_seconds_evict,
 DEFINE_COUNTER(prefix_cache_match_length_total,
                "Length of matched prefix in tokens");
 
+DEFINE_COUNTER(prefix_cache_host_match_length_total,
+               "Length of matched prefix swapped in from host memory");
+
+DEFINE_COUNTER(prefix_cache_num_offloaded_blocks_total,
+               "Number of evicted blocks offloaded to host memory");
+
 DEFINE_COUNTER(allocate_blocks_latency_seconds,
                "Latency of blocks allocation in seconds");
 
@@ -73,6 +79,10 @@ DEFINE_GAUGE(num_running_requests, "Number of running requests in scheduler");
 DEFINE_GAUGE(num_waiting_requests, "Number of waiting requests in scheduler");
 DEFINE_GAUGE(num_preempted_requests,
              "Number of preempted requests in scheduler");
+DEFINE_COUNTER(num_swapped_out_blocks_total,
+               "Total number of blocks swapped out to host memory");
+DEFINE_COUNTER(num_swapped_in_blocks_total,
+               "Total number of blocks swapped in from host memory");
 
 DEFINE_GAUGE(num_running_sequences, "Number of running sequences");
 
@@ -170,6 +180,18 @@ DEFINE_GAUGE(total_kv_cache_size_in_kilobytes, "KV cache size in kilobytes");
 DEFINE_GAUGE(total_activation_size_in_kilobytes,
              "Total activation size in kilobytes");
 
+// weight loading metrics
+DEFINE_COUNTER(weight_read_ahead_bytes_total,
+               "Total bytes of model weights read ahead");
+DEFINE_HISTOGRAM(weight_read_ahead_throughput_mb_per_second,
+                 "Read ahead throughput of each model weights file in MB/s");
+
+// multimodal data cache metrics
+DEFINE_COUNTER(mm_data_cache_hit_total,
+               "Number of images whose processed data was found in the cache");
+DEFINE_COUNTER(mm_data_cache_miss_total,
+               "Number of images processed because they were not cached");
+
 DEFINE_MULTI_HISTOGRAM(active_kv_cache_size_in_kilobytes,
                        "dp_rank",
                        "Active kv cache size in kilobytes per dp rank");
@@ -113,6 +113,8 @@ DECLARE_COUNTER(prefix_cache_latency_seconds_insert);
 DECLARE_COUNTER(prefix_cache_latency_seconds_match);
 DECLARE_COUNTER(prefix_cache_latency_seconds_evict);
 DECLARE_COUNTER(prefix_cache_match_length_total);
+DECLARE_COUNTER(prefix_cache_host_match_length_total);
+DECLARE_COUNTER(prefix_cache_num_offloaded_blocks_total);
 DECLARE_COUNTER(allocate_blocks_latency_seconds);
 
 // latency of detokenization operations in seconds
@@ -134,6 +136,8 @@ DECLARE_GAUGE(num_pending_requests);
 DECLARE_GAUGE(num_running_requests);
 DECLARE_GAUGE(num_waiting_requests);
 DECLARE_GAUGE(num_preempted_requests);
+DECLARE_COUNTER(num_swapped_out_blocks_total);
+DECLARE_COUNTER(num_swapped_in_blocks_total);
 DECLARE_GAUGE(num_running_sequences);
 DECLARE_GAUGE(kv_cache_utilization_perc);
 DECLARE_GAUGE(num_blocks_in_prefix_cache);
@@ -196,6 +200,14 @@ DECLARE_GAUGE(weight_size_in_kilobytes);
 DECLARE_GAUGE(total_kv_cache_size_in_kilobytes);
 DECLARE_GAUGE(total_activation_size_in_kilobytes);
 
+// weight loading metrics
+DECLARE_COUNTER(weight_read_ahead_bytes_total);
+DECLARE_HISTOGRAM(weight_read_ahead_throughput_mb_per_second);
+
+// multimodal data cache metrics
+DECLARE_COUNTER(mm_data_cache_hit_total);
+DECLARE_COUNTER(mm_data_cache_miss_total);
+
 DECLARE_MULTI_HISTOGRAM(active_kv_cache_size_in_kilobytes);
 DECLARE_MULTI_HISTOGRAM(prefill_active_activation_size_in_kilobytes);
 DECLARE_MULTI_HISTOGRAM(decode_active_activation_size_in_kilobytes);
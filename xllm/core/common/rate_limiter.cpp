@@ -1,13 +1,23 @@
 #include "rate_limiter.h"
 
+#include <absl/time/clock.h>
 #include <gflags/gflags.h>
 
+#include <algorithm>
+
 #include "common/global_flags.h"
 #include "common/metrics.h"
 
 namespace xllm {
 
-bool RateLimiter::is_limited() {
+namespace {
+bool has_tenant_limits() {
+  return FLAGS_max_concurrent_requests_per_tenant > 0 ||
+         FLAGS_max_tokens_per_second_per_tenant > 0;
+}
+}  // namespace
+
+bool RateLimiter::is_limited(const std::string& tenant) {
   if (FLAGS_max_concurrent_requests > 0) {
     int32_t num_requests =
         num_concurrent_requests_.load(std::memory_order_relaxed);
@@ -16,6 +26,10 @@ bool RateLimiter::is_limited() {
       return true;
     }
   }
+  if (is_tenant_limited(tenant)) {
+    COUNTER_INC(server_request_total_limit);
+    return true;
+  }
   num_concurrent_requests_.fetch_add(1, std::memory_order_relaxed);
   GAUGE_SET(num_concurrent_requests,
             num_concurrent_requests_.load(std::memory_order_relaxed));
@@ -23,10 +37,77 @@ bool RateLimiter::is_limited() {
   return false;
 }
 
-void RateLimiter::decrease_one_request() {
+void RateLimiter::decrease_one_request(const std::string& tenant) {
   num_concurrent_requests_.fetch_sub(1, std::memory_order_relaxed);
   GAUGE_SET(num_concurrent_requests,
             num_concurrent_requests_.load(std::memory_order_relaxed));
+
+  if (tenant.empty() || !has_tenant_limits()) {
+    return;
+  }
+  absl::MutexLock lock(&mutex_);
+  auto it = tenants_.find(tenant);
+  if (it == tenants_.end()) {
+    return;
+  }
+  auto& state = it->second;
+  state.num_concurrent_requests =
+      std::max(state.num_concurrent_requests - 1, 0);
+  refill(state, absl::Now());
+  // drop idle tenants with a full bucket, they are recreated on demand
+  if (state.num_concurrent_requests == 0 &&
+      state.num_tokens >= FLAGS_max_tokens_per_second_per_tenant) {
+    tenants_.erase(it);
+  }
+}
+
+void RateLimiter::consume_tokens(const std::string& tenant,
+                                 int64_t num_tokens) {
+  if (tenant.empty() || FLAGS_max_tokens_per_second_per_tenant <= 0) {
+    return;
+  }
+  absl::MutexLock lock(&mutex_);
+  auto it = tenants_.find(tenant);
+  if (it == tenants_.end()) {
+    return;
+  }
+  refill(it->second, absl::Now());
+  it->second.num_tokens -= num_tokens;
+}
+
+bool RateLimiter::is_tenant_limited(const std::string& tenant) {
+  if (tenant.empty() || !has_tenant_limits()) {
+    return false;
+  }
+  const absl::Time now = absl::Now();
+  absl::MutexLock lock(&mutex_);
+  auto [it, inserted] = tenants_.try_emplace(tenant);
+  auto& state = it->second;
+  if (inserted) {
+    state.num_tokens = FLAGS_max_tokens_per_second_per_tenant;
+    state.last_refill_time = now;
+  }
+  refill(state, now);
+
+  if (FLAGS_max_concurrent_requests_per_tenant > 0 &&
+      state.num_concurrent_requests >=
+          FLAGS_max_concurrent_requests_per_tenant) {
+    return true;
+  }
+  if (FLAGS_max_tokens_per_second_per_tenant > 0 && state.num_tokens <= 0) {
+    return true;
+  }
+  ++state.num_concurrent_requests;
+  return false;
+}
+
+void RateLimiter::refill(TenantState& state, absl::Time now) {
+  const double rate = FLAGS_max_tokens_per_second_per_tenant;
+  if (rate > 0) {
+    const double elapsed = absl::ToDoubleSeconds(now - state.last_refill_time);
+    state.num_tokens = std::min(rate, state.num_tokens + elapsed * rate);
+  }
+  state.last_refill_time = now;
 }
 
 }  // namespace xllm
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
 #include <atomic>
+#include <string>
 
 namespace xllm {
 
@@ -10,12 +15,39 @@ class RateLimiter final {
 
   ~RateLimiter() = default;
 
-  bool is_limited();
+  // returns true if the request should be rejected. the per-tenant limits are
+  // only applied to requests with a non-empty tenant.
+  bool is_limited(const std::string& tenant = "");
+
+  void decrease_one_request(const std::string& tenant = "");
 
-  void decrease_one_request();
+  // charge the tokens used by a request to the token rate of the tenant: the
+  // prompt tokens when the request is admitted, the generated tokens when it
+  // finishes.
+  void consume_tokens(const std::string& tenant, int64_t num_tokens);
 
  private:
+  struct TenantState {
+    int32_t num_concurrent_requests = 0;
+
+    // tokens left in the bucket, can go negative after a large request so
+    // that the tenant is throttled until the debt is paid back.
+    double num_tokens = 0;
+
+    absl::Time last_refill_time;
+  };
+
+  bool is_tenant_limited(const std::string& tenant);
+
+  // refill the token bucket of the tenant up to one second worth of tokens.
+  void refill(TenantState& state, absl::Time now);
+
   std::atomic<int32_t> num_concurrent_requests_{0};
+
+  absl::Mutex mutex_;
+
+  absl::flat_hash_map<std::string, TenantState> tenants_
+      ABSL_GUARDED_BY(mutex_);
 };
 
-}  // namespace xllm
\ No newline at end of file
+}  // namespace xllm
@@ -8,6 +8,14 @@ DEFINE_int32(
     0,
     "Maximum number of concurrent requests the xllm service can handle.");
 
+DEFINE_int32(max_concurrent_requests_per_tenant,
+             0,
+             "Maximum number of concurrent requests of a single tenant.");
+
+DEFINE_int32(max_tokens_per_second_per_tenant,
+             0,
+             "Maximum number of tokens per second of a single tenant.");
+
 namespace xllm {
 
 TEST(RequestLimiterTest, Basic) {
@@ -27,4 +35,55 @@ TEST(RequestLimiterTest, Basic) {
   EXPECT_EQ(rate_limiter.is_limited(), false);
 }
 
-}  // namespace xllm
\ No newline at end of file
+TEST(RequestLimiterTest, PerTenantConcurrency) {
+  FLAGS_max_concurrent_requests = 0;
+  FLAGS_max_concurrent_requests_per_tenant = 1;
+  RateLimiter rate_limiter;
+  EXPECT_EQ(rate_limiter.is_limited("a"), false);
+  // tenant a has reached its limit while tenant b is not affected.
+  EXPECT_EQ(rate_limiter.is_limited("a"), true);
+  EXPECT_EQ(rate_limiter.is_limited("b"), false);
+  // requests without tenant are not limited per tenant.
+  EXPECT_EQ(rate_limiter.is_limited(), false);
+  EXPECT_EQ(rate_limiter.is_limited(), false);
+
+  rate_limiter.decrease_one_request("a");
+  EXPECT_EQ(rate_limiter.is_limited("a"), false);
+  FLAGS_max_concurrent_requests_per_tenant = 0;
+}
+
+TEST(RequestLimiterTest, PerTenantTokenRate) {
+  FLAGS_max_concurrent_requests = 0;
+  FLAGS_max_tokens_per_second_per_tenant = 1000;
+  RateLimiter rate_limiter;
+  EXPECT_EQ(rate_limiter.is_limited("a"), false);
+  // a large request puts tenant a into debt.
+  rate_limiter.consume_tokens("a", 32000);
+  rate_limiter.decrease_one_request("a");
+  EXPECT_EQ(rate_limiter.is_limited("a"), true);
+  EXPECT_EQ(rate_limiter.is_limited("b"), false);
+  FLAGS_max_tokens_per_second_per_tenant = 0;
+}
+
+TEST(RequestLimiterTest, PerTenantPromptChargedAtAdmission) {
+  FLAGS_max_concurrent_requests = 0;
+  FLAGS_max_tokens_per_second_per_tenant = 1000;
+  RateLimiter rate_limiter;
+  EXPECT_EQ(rate_limiter.is_limited("a"), false);
+  // the prompt is charged when the request is admitted, so a concurrent
+  // request of the tenant is throttled before the first one finishes.
+  rate_limiter.consume_tokens("a", 32000);
+  EXPECT_EQ(rate_limiter.is_limited("a"), true);
+
+  EXPECT_EQ(rate_limiter.is_limited("b"), false);
+  rate_limiter.consume_tokens("b", 400);
+  EXPECT_EQ(rate_limiter.is_limited("b"), false);
+  // the generated tokens are settled when the requests finish
+  rate_limiter.consume_tokens("b", 700);
+  rate_limiter.decrease_one_request("b");
+  rate_limiter.decrease_one_request("b");
+  EXPECT_EQ(rate_limiter.is_limited("b"), true);
+  FLAGS_max_tokens_per_second_per_tenant = 0;
+}
+
+}  // namespace xllm
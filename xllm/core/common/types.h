@@ -70,6 +70,14 @@ enum class StatusCode : uint8_t {
   RESOURCE_EXHAUSTED = 5,
 };
 
+// priority class of a request. requests of a higher class are admitted
+// before and preempted after the requests of a lower class.
+enum class RequestPriority : int32_t {
+  HIGH = 0,
+  MEDIUM = 1,
+  LOW = 2,
+};
+
 class Status final {
  public:
   Status() = default;
@@ -204,6 +212,31 @@ struct TransferKVInfo {
   InstanceInfo remote_instance_info;
 };
 
+enum class TransferType : int8_t {
+  // device memory to host memory
+  G2H = 0,
+  // host memory to device memory
+  H2G = 1,
+  // device memory to device memory
+  G2G = 2,
+};
+
+// a kv cache block copy between device and/or host memory. Workers execute the
+// copies of a step in the recorded order before the model forward.
+struct BlockTransferInfo {
+  int32_t src_block_id = -1;
+  int32_t dst_block_id = -1;
+  TransferType transfer_type = TransferType::G2H;
+
+  BlockTransferInfo() = default;
+  BlockTransferInfo(int32_t src_block_id,
+                    int32_t dst_block_id,
+                    TransferType transfer_type)
+      : src_block_id(src_block_id),
+        dst_block_id(dst_block_id),
+        transfer_type(transfer_type) {}
+};
+
 // in bytes
 struct DeviceStats {
   int64_t total_memory = 0;
@@ -70,6 +70,15 @@ std::shared_ptr<Request> DisaggDecodeServiceImpl::generate_request(
                          scheduler_->enable_schedule_overlap(),
                          output_callback,
                          batch_output_callback);
+  req_state.priority = static_cast<RequestPriority>(req.priority());
+  // 0 means the request has no slo
+  if (req.ttft_slo_ms() > 0) {
+    req_state.ttft_slo_ms = req.ttft_slo_ms();
+  }
+  if (req.tpot_slo_ms() > 0) {
+    req_state.tpot_slo_ms = req.tpot_slo_ms();
+  }
+  req_state.tenant = req.tenant();
 
   auto new_request = std::make_shared<Request>(req.req_id(),
                                                req.x_request_id(),
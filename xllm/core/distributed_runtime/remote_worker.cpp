@@ -6,6 +6,8 @@
 #include <glog/logging.h>
 #include <torch/torch.h>
 
+#include <unistd.h>
+
 #include <chrono>
 #include <memory>
 #include <optional>
@@ -36,7 +38,141 @@ RemoteWorker::RemoteWorker(int32_t global_rank,
   // Initialize stub
   stub_.reset(new proto::DistributeWorker_Stub(&channel_));
 
-  wait_for_server_ready(server_address);
+  if (wait_for_server_ready(server_address)) {
+    attach_step_channel();
+  }
+}
+
+RemoteWorker::~RemoteWorker() {
+  stopped_.store(true, std::memory_order_relaxed);
+  if (step_channel_thread_ != nullptr && step_channel_thread_->joinable()) {
+    step_channel_thread_->join();
+  }
+  fail_step_channel_promises();
+}
+
+void RemoteWorker::attach_step_channel() {
+  if (!FLAGS_enable_step_shm_channel) {
+    return;
+  }
+  const std::string name = "/xllm_step_" + std::to_string(getpid()) + "_" +
+                           std::to_string(global_rank_);
+  const size_t capacity =
+      static_cast<size_t>(FLAGS_step_shm_channel_capacity_mb) << 20;
+  auto step_channel = StepChannel::create(name, capacity);
+  if (step_channel == nullptr) {
+    return;
+  }
+
+  proto::StepChannelInfo req;
+  req.set_name(name);
+  req.set_capacity(capacity);
+  req.set_nonce(step_channel->nonce());
+  proto::StepChannelInfo resp;
+  brpc::Controller cntl;
+  stub_->AttachStepChannel(&cntl, &req, &resp, nullptr);
+  // the worker opens the shared memory only if it is on the same host
+  step_channel->unlink();
+  if (cntl.Failed() || resp.nonce() != step_channel->nonce() ||
+      !step_channel->peer_alive()) {
+    LOG(INFO) << "Step channel is not available for global_rank_ "
+              << global_rank_ << ", fall back to rpc.";
+    return;
+  }
+
+  LOG(INFO) << "Step channel attached, global_rank_: " << global_rank_;
+  step_channel_ = std::move(step_channel);
+  step_channel_thread_ =
+      std::make_unique<std::thread>([this]() { step_channel_loop(); });
+}
+
+void RemoteWorker::step_channel_loop() {
+  while (!stopped_.load(std::memory_order_relaxed)) {
+    RawForwardOutput raw_forward_output;
+    auto ok = StepChannel::read(
+        step_channel_->output_ring(),
+        [&raw_forward_output](FlatReader* reader) {
+          return flat_to_forward_output(reader, raw_forward_output);
+        },
+        absl::Milliseconds(100));
+    if (!ok.has_value()) {
+      if (!step_channel_->peer_alive()) {
+        LOG(ERROR) << "Worker process of global_rank_ " << global_rank_
+                   << " exited, fall back to rpc.";
+        fail_step_channel_promises();
+        return;
+      }
+      continue;
+    }
+    folly::Promise<std::optional<RawForwardOutput>> promise;
+    {
+      absl::MutexLock lock(&step_channel_mutex_);
+      CHECK(!step_channel_promises_.empty());
+      promise = std::move(step_channel_promises_.front());
+      step_channel_promises_.pop_front();
+    }
+    if (!ok.value()) {
+      LOG(ERROR) << "Execute_model_async failed through the step channel, "
+                 << "global_rank_: " << global_rank_;
+      // the same empty output as a failed rpc
+      raw_forward_output = RawForwardOutput();
+    }
+    promise.setValue(std::move(raw_forward_output));
+  }
+}
+
+void RemoteWorker::fail_step_channel_promises() {
+  std::deque<folly::Promise<std::optional<RawForwardOutput>>> promises;
+  {
+    absl::MutexLock lock(&step_channel_mutex_);
+    // no more steps are sent through the channel
+    step_channel_broken_ = true;
+    promises.swap(step_channel_promises_);
+  }
+  for (auto& promise : promises) {
+    promise.setValue(RawForwardOutput());
+  }
+}
+
+bool RemoteWorker::send_through_step_channel(
+    const RawForwardInput& inputs,
+    folly::Promise<std::optional<RawForwardOutput>>& promise) {
+  if (step_channel_ == nullptr) {
+    return false;
+  }
+  step_channel_buffer_.clear();
+  FlatWriter writer(&step_channel_buffer_);
+  forward_input_to_flat(inputs, &writer);
+  {
+    absl::MutexLock lock(&step_channel_mutex_);
+    if (step_channel_broken_) {
+      return false;
+    }
+    step_channel_promises_.push_back(std::move(promise));
+  }
+  // don't hold the lock while writing, the reader may need it to drain the
+  // outputs before the worker can accept more inputs.
+  auto written = step_channel_->write_while_alive(
+      step_channel_->input_ring(), /*ok=*/true, step_channel_buffer_, stopped_);
+  if (written.value_or(false)) {
+    return true;
+  }
+  if (!written.has_value() && !stopped_.load(std::memory_order_relaxed)) {
+    LOG(ERROR) << "Worker process of global_rank_ " << global_rank_
+               << " exited, fall back to rpc.";
+  }
+  // no output will come for this step, and only this thread pushes. the
+  // promise is already failed if the reader found the worker exited.
+  absl::MutexLock lock(&step_channel_mutex_);
+  if (step_channel_promises_.empty()) {
+    return true;
+  }
+  promise = std::move(step_channel_promises_.back());
+  step_channel_promises_.pop_back();
+  if (!written.has_value()) {
+    step_channel_broken_ = true;
+  }
+  return false;
 }
 
 bool RemoteWorker::wait_for_server_ready(const std::string& server_address) {
@@ -71,7 +207,8 @@ bool RemoteWorker::wait_for_server_ready(const std::string& server_address) {
 }
 
 bool RemoteWorker::allocate_kv_cache(
-    const std::vector<std::vector<int64_t>>& kv_cache_shape) {
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
   proto::KVCacheShape shape;
   shape.mutable_key_shape()->Reserve(kv_cache_shape[0].size());
   shape.mutable_value_shape()->Reserve(kv_cache_shape[1].size());
@@ -79,6 +216,7 @@ bool RemoteWorker::allocate_kv_cache(
     shape.add_key_shape(kv_cache_shape[0][i]);
     shape.add_value_shape(kv_cache_shape[1][i]);
   }
+  shape.set_num_host_blocks(num_host_blocks);
   proto::Status s;
   brpc::Controller cntl;
   stub_->AllocateKVCache(&cntl, &shape, &s, nullptr);
@@ -258,13 +396,23 @@ folly::SemiFuture<std::optional<RawForwardOutput>> RemoteWorker::step_async(
   auto future = promise.getSemiFuture();
   threadpool_.schedule(
       [this, inputs = inputs, promise = std::move(promise)]() mutable {
-        // 1. convert to proto::ForwardInput
+        // 1. send through the step channel if the worker is on the same
+        // host, steps too large for the ring fall back to rpc.
+        if (send_through_step_channel(inputs, promise)) {
+          return;
+        }
+
+        // 2. convert to proto::ForwardInput
         proto::ForwardInput pb_forward_input;
-        forward_input_to_proto(inputs, &pb_forward_input);
+        ForwardInputDeltaEncoder* delta_encoder =
+            FLAGS_forward_input_snapshot_interval > 0 ? &delta_encoder_
+                                                      : nullptr;
+        forward_input_to_proto(inputs, &pb_forward_input, delta_encoder);
 
-        // 2. call ExecuteModel with callback
+        // 3. call ExecuteModel with callback
         auto done = new ExecuteModelClosure();
         done->promise = std::move(promise);
+        done->delta_encoder = delta_encoder;
         stub_->ExecuteModel(
             &done->cntl, &pb_forward_input, &done->pb_output, done);
       });
@@ -278,9 +426,12 @@ void ExecuteModelClosure::Run() {
   if (cntl.Failed()) {
     LOG(ERROR) << "Execute_model_async failed. Error code : "
                << cntl.ErrorCode() << ", error message : " << cntl.ErrorText();
+    if (delta_encoder != nullptr) {
+      delta_encoder->reset();
+    }
   }
 
-  // 3. parse tokens
+  // 4. parse tokens
   RawForwardOutput raw_forward_output;
   proto_to_forward_output(pb_output, raw_forward_output);
   promise.setValue(raw_forward_output);
@@ -335,28 +486,32 @@ void InitModelClosure::Run() {
 }
 
 folly::SemiFuture<bool> RemoteWorker::allocate_kv_cache_async(
-    const std::vector<std::vector<int64_t>>& kv_cache_shape) {
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
   folly::Promise<bool> promise;
   auto future = promise.getSemiFuture();
-  threadpool_.schedule(
-      [this, kv_cache_shape, promise = std::move(promise)]() mutable {
-        proto::KVCacheShape shape;
-        shape.mutable_key_shape()->Reserve(kv_cache_shape[0].size());
-        shape.mutable_value_shape()->Reserve(kv_cache_shape[1].size());
-        for (int32_t i = 0; i < kv_cache_shape[0].size(); ++i) {
-          shape.add_key_shape(kv_cache_shape[0][i]);
-          shape.add_value_shape(kv_cache_shape[1][i]);
-        }
-        proto::Status s;
-        brpc::Controller cntl;
-        stub_->AllocateKVCache(&cntl, &shape, &s, nullptr);
-        if (cntl.Failed() || !s.ok()) {
-          LOG(ERROR) << "allocate_kv_cache_async failed, " << cntl.ErrorText();
-          promise.setValue(false);
-        } else {
-          promise.setValue(s.ok());
-        }
-      });
+  threadpool_.schedule([this,
+                        kv_cache_shape,
+                        num_host_blocks,
+                        promise = std::move(promise)]() mutable {
+    proto::KVCacheShape shape;
+    shape.mutable_key_shape()->Reserve(kv_cache_shape[0].size());
+    shape.mutable_value_shape()->Reserve(kv_cache_shape[1].size());
+    for (int32_t i = 0; i < kv_cache_shape[0].size(); ++i) {
+      shape.add_key_shape(kv_cache_shape[0][i]);
+      shape.add_value_shape(kv_cache_shape[1][i]);
+    }
+    shape.set_num_host_blocks(num_host_blocks);
+    proto::Status s;
+    brpc::Controller cntl;
+    stub_->AllocateKVCache(&cntl, &shape, &s, nullptr);
+    if (cntl.Failed() || !s.ok()) {
+      LOG(ERROR) << "allocate_kv_cache_async failed, " << cntl.ErrorText();
+      promise.setValue(false);
+    } else {
+      promise.setValue(s.ok());
+    }
+  });
   return future;
 }
 
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <absl/synchronization/mutex.h>
 #include <brpc/channel.h>
 #include <folly/futures/Future.h>
 #include <torch/torch.h>
 
+#include <atomic>
+#include <deque>
+#include <thread>
+
 #include "common/macros.h"
+#include "distributed_runtime/step_channel.h"
 #include "framework/model/causal_lm.h"
 #include "framework/model/embedding_lm.h"
 #include "framework/model/model_args.h"
@@ -13,6 +19,7 @@
 #include "framework/quant_args.h"
 #include "framework/state_dict/state_dict.h"
 #include "runtime/executor.h"
+#include "runtime/forward_input_delta.h"
 #include "runtime/forward_params.h"
 #include "runtime/worker_client.h"
 #include "util/threadpool.h"
@@ -25,7 +32,7 @@ class RemoteWorker : public WorkerClient {
   explicit RemoteWorker(int32_t global_rank,
                         const std::string& server_address,
                         const torch::Device& d);
-  virtual ~RemoteWorker() = default;
+  virtual ~RemoteWorker();
 
   bool wait_for_server_ready(const std::string& server_address);
 
@@ -34,7 +41,8 @@ class RemoteWorker : public WorkerClient {
   virtual std::tuple<int64_t, int64_t> estimate_kv_cache_capacity() override;
 
   virtual bool allocate_kv_cache(
-      const std::vector<std::vector<int64_t>>& kv_cache_shape) override;
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks) override;
 
   virtual void get_device_info(std::string& device_ip, uint16_t& port);
 
@@ -73,7 +81,8 @@ class RemoteWorker : public WorkerClient {
   estimate_kv_cache_capacity_async() override;
 
   virtual folly::SemiFuture<bool> allocate_kv_cache_async(
-      const std::vector<std::vector<int64_t>>& kv_cache_shape) override;
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks) override;
 
   virtual folly::SemiFuture<bool> allocate_kv_cache_with_transfer_async(
       const uint64_t kv_cache_size,
@@ -109,6 +118,22 @@ class RemoteWorker : public WorkerClient {
  private:
   DISALLOW_COPY_AND_ASSIGN(RemoteWorker);
 
+  // try to set up the shared memory channel with the worker
+  void attach_step_channel();
+
+  // read the step outputs from the shared memory channel
+  void step_channel_loop();
+
+  // send the step through the shared memory channel, the output fulfils the
+  // promise. returns false with the promise untouched if the step has to be
+  // sent through rpc.
+  bool send_through_step_channel(
+      const RawForwardInput& inputs,
+      folly::Promise<std::optional<RawForwardOutput>>& promise);
+
+  // fail the steps waiting for outputs from the channel and stop using it
+  void fail_step_channel_promises();
+
  private:
   int32_t global_rank_;
 
@@ -117,6 +142,24 @@ class RemoteWorker : public WorkerClient {
   brpc::ChannelOptions options_;
   std::unique_ptr<proto::DistributeWorker_Stub> stub_;
 
+  // only used in threadpool_ to keep the order of the steps. the steps sent
+  // through the step channel carry the full block tables and are not seen by
+  // the encoder.
+  ForwardInputDeltaEncoder delta_encoder_;
+
+  // shared memory channel to the worker when both are on the same host,
+  // the outputs come back in the order of the inputs.
+  std::unique_ptr<StepChannel> step_channel_;
+  // the flat layout of the step being sent, only used in threadpool_
+  std::string step_channel_buffer_;
+  absl::Mutex step_channel_mutex_;
+  std::deque<folly::Promise<std::optional<RawForwardOutput>>>
+      step_channel_promises_ ABSL_GUARDED_BY(step_channel_mutex_);
+  // set once the worker process exits
+  bool step_channel_broken_ ABSL_GUARDED_BY(step_channel_mutex_) = false;
+  std::unique_ptr<std::thread> step_channel_thread_;
+  std::atomic<bool> stopped_{false};
+
   ThreadPool threadpool_;
   const torch::Device device_;
 };
@@ -137,6 +180,8 @@ class ExecuteModelClosure : public google::protobuf::Closure {
   proto::ForwardOutput pb_output;
   brpc::Controller cntl;
   folly::Promise<std::optional<RawForwardOutput>> promise;
+  // reset on failure since the worker may have lost the delta state
+  ForwardInputDeltaEncoder* delta_encoder = nullptr;
 };
 
 }  // namespace xllm
@@ -0,0 +1,196 @@
+#include "step_channel.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <random>
+
+namespace xllm {
+
+namespace {
+constexpr size_t kAlignment = 64;
+
+// how long a write waits for space before checking the peer again
+constexpr absl::Duration kPollInterval = absl::Milliseconds(100);
+
+size_t align_up(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+void* map_shared_memory(int fd, size_t size) {
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  return addr == MAP_FAILED ? nullptr : addr;
+}
+}  // namespace
+
+size_t StepChannel::memory_size(size_t capacity) {
+  return kAlignment + 2 * align_up(ShmRing::memory_size(capacity));
+}
+
+StepChannel::StepChannel(const std::string& name,
+                         size_t capacity,
+                         void* addr,
+                         bool is_creator)
+    : name_(name),
+      capacity_(capacity),
+      addr_(addr),
+      is_creator_(is_creator),
+      linked_(is_creator) {
+  static_assert(sizeof(Header) <= kAlignment);
+  char* base = static_cast<char*>(addr_);
+  header_ = reinterpret_cast<Header*>(base);
+  // the memory of a new shared memory object is zero filled
+  input_ring_ =
+      std::make_unique<ShmRing>(base + kAlignment, capacity, is_creator);
+  output_ring_ = std::make_unique<ShmRing>(
+      base + kAlignment + align_up(ShmRing::memory_size(capacity)),
+      capacity,
+      is_creator);
+}
+
+StepChannel::~StepChannel() {
+  unlink();
+  input_ring_.reset();
+  output_ring_.reset();
+  munmap(addr_, memory_size(capacity_));
+}
+
+std::unique_ptr<StepChannel> StepChannel::create(const std::string& name,
+                                                 size_t capacity) {
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_EXCL, 0600);
+  if (fd == -1) {
+    LOG(WARNING) << "Failed to create shared memory " << name << ": "
+                 << strerror(errno);
+    return nullptr;
+  }
+  const size_t size = memory_size(capacity);
+  void* addr = nullptr;
+  if (ftruncate(fd, size) == -1 ||
+      (addr = map_shared_memory(fd, size)) == nullptr) {
+    LOG(WARNING) << "Failed to map shared memory " << name << ": "
+                 << strerror(errno);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+  auto channel = std::unique_ptr<StepChannel>(
+      new StepChannel(name, capacity, addr, /*is_creator=*/true));
+  std::random_device rd;
+  std::mt19937_64 gen(rd());
+  // 0 is reserved for a worker that can not access the memory
+  do {
+    channel->header_->nonce = gen();
+  } while (channel->header_->nonce == 0);
+  channel->header_->creator_pid.store(getpid(), std::memory_order_release);
+  return channel;
+}
+
+std::unique_ptr<StepChannel> StepChannel::attach(const std::string& name,
+                                                 size_t capacity,
+                                                 uint64_t nonce) {
+  // only the master creates the memory, it is missing on another host.
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd == -1) {
+    return nullptr;
+  }
+  struct stat st;
+  const size_t size = memory_size(capacity);
+  if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) != size) {
+    close(fd);
+    return nullptr;
+  }
+  void* addr = map_shared_memory(fd, size);
+  if (addr == nullptr) {
+    return nullptr;
+  }
+  auto channel = std::unique_ptr<StepChannel>(
+      new StepChannel(name, capacity, addr, /*is_creator=*/false));
+  if (channel->nonce() != nonce) {
+    LOG(WARNING) << "Stale shared memory " << name;
+    return nullptr;
+  }
+  // the liveness of the master can't be checked from another pid namespace
+  if (!channel->peer_alive()) {
+    LOG(WARNING) << "The master of shared memory " << name
+                 << " is not visible to this process";
+    return nullptr;
+  }
+  channel->header_->attacher_pid.store(getpid(), std::memory_order_release);
+  return channel;
+}
+
+void StepChannel::unlink() {
+  if (linked_) {
+    shm_unlink(name_.c_str());
+    linked_ = false;
+  }
+}
+
+bool StepChannel::peer_alive() const {
+  const std::atomic<int64_t>& peer_pid =
+      is_creator_ ? header_->attacher_pid : header_->creator_pid;
+  const int64_t pid = peer_pid.load(std::memory_order_acquire);
+  // EPERM means the process exists but belongs to another user
+  return pid > 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+std::optional<bool> StepChannel::write(ShmRing& ring,
+                                       bool ok,
+                                       const std::string& data,
+                                       absl::Duration timeout) {
+  const size_t size = data.size() + 1;
+  if (size > ring.max_message_size()) {
+    return false;
+  }
+  char* message = ring.begin_write(size, timeout);
+  if (message == nullptr) {
+    return std::nullopt;
+  }
+  message[0] = ok ? 1 : 0;
+  std::memcpy(message + 1, data.data(), data.size());
+  ring.end_write();
+  return true;
+}
+
+std::optional<bool> StepChannel::write_while_alive(
+    ShmRing& ring,
+    bool ok,
+    const std::string& data,
+    const std::atomic<bool>& stopped) const {
+  while (!stopped.load(std::memory_order_relaxed) && peer_alive()) {
+    auto written = write(ring, ok, data, kPollInterval);
+    if (written.has_value()) {
+      return written;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<bool> StepChannel::read(
+    ShmRing& ring,
+    const std::function<bool(FlatReader*)>& parse,
+    absl::Duration timeout) {
+  size_t size = 0;
+  const char* data = ring.begin_read(&size, timeout);
+  if (data == nullptr) {
+    return std::nullopt;
+  }
+  bool ok = size > 0 && data[0] != 0;
+  if (ok) {
+    FlatReader reader(data + 1, size - 1);
+    if (!parse(&reader)) {
+      LOG(ERROR) << "Malformed message from the step channel";
+      ok = false;
+    }
+  }
+  ring.end_read();
+  return ok;
+}
+
+}  // namespace xllm
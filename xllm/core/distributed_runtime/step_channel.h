@@ -0,0 +1,110 @@
+#pragma once
+
+#include <absl/time/time.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "util/flat_buffer.h"
+#include "util/shm_ring.h"
+
+namespace xllm {
+
+// Carries the ExecuteModel requests and responses between the master and a
+// worker process on the same host through shared memory, which skips the
+// loopback rpc. The master writes the inputs and reads the outputs, the
+// worker does the opposite. Each message is a status byte followed by the
+// flat layout of the step, see forward_input_to_flat(), which is read in
+// place without parsing. Both sides store their pid in the shared memory, so
+// a side waiting on the rings can tell when the other process has exited.
+class StepChannel final {
+ public:
+  ~StepChannel();
+
+  // create the channel on the master side, returns nullptr on failure.
+  static std::unique_ptr<StepChannel> create(const std::string& name,
+                                             size_t capacity);
+
+  // attach to the channel created by the master, returns nullptr if the
+  // shared memory or the master process is not accessible, e.g. the master
+  // is on another host or in another pid namespace.
+  static std::unique_ptr<StepChannel> attach(const std::string& name,
+                                             size_t capacity,
+                                             uint64_t nonce);
+
+  // remove the name of the shared memory once the worker has attached, the
+  // memory is released when both sides unmap it, even if they crash.
+  void unlink();
+
+  const std::string& name() const { return name_; }
+
+  size_t capacity() const { return capacity_; }
+
+  uint64_t nonce() const { return header_->nonce; }
+
+  // whether the process on the other side has attached and is still running
+  bool peer_alive() const;
+
+  ShmRing& input_ring() { return *input_ring_; }
+
+  ShmRing& output_ring() { return *output_ring_; }
+
+  // returns std::nullopt on timeout, otherwise whether the message fits into
+  // the ring.
+  static std::optional<bool> write(ShmRing& ring,
+                                   bool ok,
+                                   const std::string& data,
+                                   absl::Duration timeout);
+
+  // like write(), but waits for space in short slices until the peer exits or
+  // stopped is set, which returns std::nullopt.
+  std::optional<bool> write_while_alive(ShmRing& ring,
+                                        bool ok,
+                                        const std::string& data,
+                                        const std::atomic<bool>& stopped) const;
+
+  // returns std::nullopt on timeout, otherwise the status of the message. the
+  // data of a successful message is passed to parse in place, a message that
+  // parse rejects counts as failed.
+  static std::optional<bool> read(
+      ShmRing& ring,
+      const std::function<bool(FlatReader*)>& parse,
+      absl::Duration timeout);
+
+ private:
+  StepChannel(const std::string& name,
+              size_t capacity,
+              void* addr,
+              bool is_creator);
+
+  static size_t memory_size(size_t capacity);
+
+  // stored at the beginning of the shared memory
+  struct Header {
+    uint64_t nonce;
+    std::atomic<int64_t> creator_pid;
+    std::atomic<int64_t> attacher_pid;
+  };
+
+  std::string name_;
+
+  size_t capacity_ = 0;
+
+  void* addr_ = nullptr;
+
+  bool is_creator_ = false;
+
+  // whether the name is still owned by this side
+  bool linked_ = false;
+
+  Header* header_ = nullptr;
+
+  std::unique_ptr<ShmRing> input_ring_;
+
+  std::unique_ptr<ShmRing> output_ring_;
+};
+
+}  // namespace xllm
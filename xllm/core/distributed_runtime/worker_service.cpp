@@ -11,6 +11,7 @@
 #include <torch_npu/torch_npu.h>
 
 #include <boost/algorithm/string.hpp>
+#include <string>
 #include <vector>
 
 #include "common/global_flags.h"
@@ -58,7 +59,12 @@ WorkerService::WorkerService(runtime::Options options,
   npu_stream_helper_ = std::make_unique<NPUStreamHelper>();
 }
 
-WorkerService::~WorkerService() = default;
+WorkerService::~WorkerService() {
+  stopped_.store(true, std::memory_order_relaxed);
+  if (step_channel_thread_ != nullptr && step_channel_thread_->joinable()) {
+    step_channel_thread_->join();
+  }
+}
 
 void WorkerService::set_worker(std::unique_ptr<Worker> worker) {
   worker_ = std::move(worker);
@@ -140,7 +146,8 @@ void WorkerService::AllocateKVCache(
         request->key_shape().begin(), request->key_shape().end()));
     kv_cache_shape.emplace_back(std::vector<int64_t>(
         request->value_shape().begin(), request->value_shape().end()));
-    auto future = worker_->allocate_kv_cache_async(kv_cache_shape);
+    auto future = worker_->allocate_kv_cache_async(kv_cache_shape,
+                                                   request->num_host_blocks());
     bool status = std::move(future).get();
     response->set_ok(status);
   });
@@ -270,6 +277,68 @@ void WorkerService::UnlinkCluster(::google::protobuf::RpcController* controller,
   return;
 }
 
+void WorkerService::execute_model(ForwardInput& forward_inputs,
+                                  int32_t num_sequences,
+                                  uint32_t prefill_seq_len,
+                                  StepOutputs* outputs) {
+  // execute model
+  auto future = worker_->step_async(forward_inputs);
+
+  if (!options_.enable_schedule_overlap()) {
+    auto forward_outputs = std::move(future).get();
+    // copy ForwardOutput to the host
+    if (forward_outputs) {
+      DCHECK(forward_outputs.has_value()) << "Failed to execute model";
+      const auto& sample_output = forward_outputs.value().sample_output;
+      outputs->expert_load_data =
+          safe_to(forward_outputs.value().expert_load_data, torch::kCPU, true);
+      outputs->prepared_layer_id = forward_outputs.value().prepared_layer_id;
+
+      {
+        c10::StreamGuard streamGuard(
+            npu_stream_helper_->D2H_memcpy_stream.unwrap());
+        // only driver worker (rank=0) need to fill this
+        // [num_seq, ..., embed_dim] FloatTensor
+        outputs->embeddings =
+            safe_to(sample_output.embeddings, torch::kCPU, true);
+        outputs->embeddings =
+            safe_to(outputs->embeddings, torch::kFloat32, true);
+
+        // [num_seq]
+        outputs->next_tokens =
+            safe_to(sample_output.next_tokens, torch::kCPU, true);
+        if (outputs->next_tokens.defined()) {
+          // [num_seq]
+          outputs->logprobs =
+              safe_to(sample_output.logprobs, torch::kCPU, true);
+          // [num_seq, topk]
+          outputs->top_tokens =
+              safe_to(sample_output.top_tokens, torch::kCPU, true);
+          // [num_seq, topk]
+          outputs->top_logprobs =
+              safe_to(sample_output.top_logprobs, torch::kCPU, true);
+        }
+        aclrtSynchronizeStream(npu_stream_helper_->D2H_memcpy_stream.stream());
+      }
+    }
+  } else {
+    if (worker_->is_driver()) {
+      // construct fake output tensor
+      auto options =
+          torch::TensorOptions().dtype(torch::kInt32).device(torch::kCPU);
+      outputs->next_tokens =
+          torch::arange(-1,
+                        -1 * (num_sequences -
+                              static_cast<int32_t>(prefill_seq_len) + 1),
+                        -1,
+                        options);
+      std::move(future).deferValue([](auto&&) {});
+    }
+    outputs->expert_load_data =
+        torch::zeros({1, 1}).to(torch::kInt64).contiguous();
+  }
+}
+
 void WorkerService::ExecuteModel(::google::protobuf::RpcController* controller,
                                  const proto::ForwardInput* pb_forward_input,
                                  proto::ForwardOutput* pb_forward_output,
@@ -280,88 +349,113 @@ void WorkerService::ExecuteModel(::google::protobuf::RpcController* controller,
         // convert proto::ForwardInput to ForwardInput
         c10_npu::SetDevice(device_.index());
         Timer timer;
-        int32_t num_sequences = pb_forward_input->num_sequences();
 
         // TODO: FIXME, cost to much cpu time.
         // Convert pb data to ForwardInput
         ForwardInput forward_inputs;
-        proto_to_forward_input(
-            pb_forward_input, forward_inputs, options_.num_decoding_tokens());
-
-        // model output
-        torch::Tensor next_tokens;
-        torch::Tensor logprobs;
-        torch::Tensor top_tokens;
-        torch::Tensor top_logprobs;
-        torch::Tensor embeddings;
-        torch::Tensor expert_load_data;
-        int32_t prepared_layer_id = -1;
-        
-        // execute model
-        auto future = worker_->step_async(forward_inputs);
-
-        if (!options_.enable_schedule_overlap()) {
-          auto forward_outputs = std::move(future).get();
-          // convert ForwardOutput to proto::ForwardOutput which contain Tokens.
-          if (forward_outputs) {
-            DCHECK(forward_outputs.has_value()) << "Failed to execute model";
-            const auto& sample_output = forward_outputs.value().sample_output;
-            expert_load_data = safe_to(
-                forward_outputs.value().expert_load_data, torch::kCPU, true);
-            prepared_layer_id = forward_outputs.value().prepared_layer_id;
-
-            {
-              c10::StreamGuard streamGuard(
-                  npu_stream_helper_->D2H_memcpy_stream.unwrap());
-              // only driver worker (rank=0) need to fill this
-              // [num_seq, ..., embed_dim] FloatTensor
-              embeddings = safe_to(sample_output.embeddings, torch::kCPU, true);
-              embeddings = safe_to(embeddings, torch::kFloat32, true);
-
-              // [num_seq]
-              next_tokens =
-                  safe_to(sample_output.next_tokens, torch::kCPU, true);
-              if (next_tokens.defined()) {
-                // [num_seq]
-                logprobs = safe_to(sample_output.logprobs, torch::kCPU, true);
-                // [num_seq, topk]
-                top_tokens =
-                    safe_to(sample_output.top_tokens, torch::kCPU, true);
-                // [num_seq, topk]
-                top_logprobs =
-                    safe_to(sample_output.top_logprobs, torch::kCPU, true);
-              }
-              aclrtSynchronizeStream(
-                  npu_stream_helper_->D2H_memcpy_stream.stream());
-            }
-          }
-        } else {
-          if (worker_->is_driver()) {
-            // construct fake output tensor
-            auto options =
-                torch::TensorOptions().dtype(torch::kInt32).device(torch::kCPU);
-            int32_t prefill_seq_len =
-                static_cast<int32_t>(pb_forward_input->prefill_seq_len());
-            next_tokens = torch::arange(
-                -1, -1 * (num_sequences - prefill_seq_len + 1), -1, options);
-            std::move(future).deferValue([](auto&&) {});
-          }
-          expert_load_data =
-              torch::zeros({1, 1}).to(torch::kInt64).contiguous();
+        if (!proto_to_forward_input(pb_forward_input,
+                                    forward_inputs,
+                                    options_.num_decoding_tokens(),
+                                    &delta_decoder_)) {
+          controller->SetFailed("Failed to decode the forward input.");
+          return;
         }
 
-        forward_output_to_proto(next_tokens,
-                                logprobs,
-                                top_tokens,
-                                top_logprobs,
-                                embeddings,
-                                expert_load_data,
-                                prepared_layer_id,
+        StepOutputs outputs;
+        execute_model(forward_inputs,
+                      pb_forward_input->num_sequences(),
+                      pb_forward_input->prefill_seq_len(),
+                      &outputs);
+        // convert the outputs to proto::ForwardOutput which contain Tokens.
+        forward_output_to_proto(outputs.next_tokens,
+                                outputs.logprobs,
+                                outputs.top_tokens,
+                                outputs.top_logprobs,
+                                outputs.embeddings,
+                                outputs.expert_load_data,
+                                outputs.prepared_layer_id,
                                 pb_forward_output);
         COUNTER_ADD(worker_service_latency_seconds, timer.elapsed_seconds());
       });
 }
 
+void WorkerService::AttachStepChannel(
+    ::google::protobuf::RpcController* controller,
+    const proto::StepChannelInfo* req,
+    proto::StepChannelInfo* resp,
+    ::google::protobuf::Closure* done) {
+  brpc::ClosureGuard done_guard(done);
+  if (step_channel_ != nullptr) {
+    controller->SetFailed("Step channel is already attached.");
+    return;
+  }
+  step_channel_ =
+      StepChannel::attach(req->name(), req->capacity(), req->nonce());
+  if (step_channel_ == nullptr) {
+    // not on the same host as the master, keep using rpc
+    resp->set_nonce(0);
+    return;
+  }
+  resp->set_name(req->name());
+  resp->set_capacity(req->capacity());
+  resp->set_nonce(step_channel_->nonce());
+  step_channel_thread_ =
+      std::make_unique<std::thread>([this]() { step_channel_loop(); });
+}
+
+void WorkerService::step_channel_loop() {
+  c10_npu::SetDevice(device_.index());
+  // the flat layout of the step output
+  std::string buffer;
+  while (!stopped_.load(std::memory_order_relaxed)) {
+    ForwardInput forward_inputs;
+    int32_t num_sequences = 0;
+    uint32_t prefill_seq_len = 0;
+    auto ok = StepChannel::read(
+        step_channel_->input_ring(),
+        [&](FlatReader* reader) {
+          return flat_to_forward_input(
+              reader, forward_inputs, &num_sequences, &prefill_seq_len);
+        },
+        absl::Milliseconds(100));
+    if (!ok.has_value()) {
+      if (!step_channel_->peer_alive()) {
+        LOG(ERROR) << "Master process exited, stop the step channel.";
+        return;
+      }
+      continue;
+    }
+    buffer.clear();
+    if (ok.value()) {
+      Timer timer;
+      StepOutputs outputs;
+      execute_model(forward_inputs, num_sequences, prefill_seq_len, &outputs);
+      FlatWriter writer(&buffer);
+      forward_output_to_flat(outputs.next_tokens,
+                             outputs.logprobs,
+                             outputs.top_tokens,
+                             outputs.top_logprobs,
+                             outputs.embeddings,
+                             outputs.expert_load_data,
+                             outputs.prepared_layer_id,
+                             &writer);
+      COUNTER_ADD(worker_service_latency_seconds, timer.elapsed_seconds());
+    }
+    auto written = step_channel_->write_while_alive(
+        step_channel_->output_ring(), ok.value(), buffer, stopped_);
+    if (written.has_value() && !written.value()) {
+      LOG(ERROR) << "Forward output is too large for the step channel.";
+      buffer.clear();
+      written = step_channel_->write_while_alive(
+          step_channel_->output_ring(), /*ok=*/false, buffer, stopped_);
+    }
+    if (!written.has_value()) {
+      // stopped, or the master exited while the ring was full
+      return;
+    }
+  }
+}
+
 void WorkerService::GetLastStepResult(
     ::google::protobuf::RpcController* controller,
     const proto::Empty* req,
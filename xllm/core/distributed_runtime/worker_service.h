@@ -1,7 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <thread>
 
+#include "distributed_runtime/step_channel.h"
+#include "runtime/forward_input_delta.h"
 #include "runtime/worker.h"
 #include "worker.pb.h"
 
@@ -80,6 +84,11 @@ class WorkerService : public proto::DistributeWorker {
                     proto::ForwardOutput* pb_forward_output,
                     ::google::protobuf::Closure* done) override;
 
+  void AttachStepChannel(::google::protobuf::RpcController* controller,
+                         const proto::StepChannelInfo* req,
+                         proto::StepChannelInfo* resp,
+                         ::google::protobuf::Closure* done) override;
+
   void GetLastStepResult(::google::protobuf::RpcController* controller,
                          const proto::Empty* req,
                          proto::ForwardOutput* pb_forward_output,
@@ -93,6 +102,26 @@ class WorkerService : public proto::DistributeWorker {
  private:
   DISALLOW_COPY_AND_ASSIGN(WorkerService);
 
+  // the outputs of a step, copied to the host
+  struct StepOutputs {
+    torch::Tensor next_tokens;
+    torch::Tensor logprobs;
+    torch::Tensor top_tokens;
+    torch::Tensor top_logprobs;
+    torch::Tensor embeddings;
+    torch::Tensor expert_load_data;
+    int32_t prepared_layer_id = -1;
+  };
+
+  // run one step, the inputs come from rpc or the step channel.
+  void execute_model(ForwardInput& forward_inputs,
+                     int32_t num_sequences,
+                     uint32_t prefill_seq_len,
+                     StepOutputs* outputs);
+
+  // serve the steps sent through the shared memory channel
+  void step_channel_loop();
+
  private:
   // runtime options
   runtime::Options options_;
@@ -102,8 +131,16 @@ class WorkerService : public proto::DistributeWorker {
 
   std::unique_ptr<Worker> worker_;
 
+  // decodes the block tables sent by the master
+  ForwardInputDeltaDecoder delta_decoder_;
+
   ThreadPool threadpool_{5};
 
+  // shared memory channel to the master when both are on the same host
+  std::unique_ptr<StepChannel> step_channel_;
+  std::unique_ptr<std::thread> step_channel_thread_;
+  std::atomic<bool> stopped_{false};
+
   // a walkaround to avoid compilation conflict involved by
   // c10_npu::NPUStream related files.
   struct NPUStreamHelper;
@@ -109,14 +109,6 @@ void BatchInputBuilder::extract_tokens_and_positions(Sequence* sequence,
   const auto& token_ids = sequence->tokens();
   const uint32_t n_tokens = token_ids.size();
 
-  // Prepare adjusted token counts for sampling
-  std::unordered_map<int32_t, int32_t> adjusted_token_to_count_map;
-  for (uint32_t j = n_kv_cache_tokens; j < seq_len; ++j) {
-    // skip prompt tokens except the last one
-    if (j + 1 < n_tokens) continue;
-    ++adjusted_token_to_count_map[token_ids[j]];
-  }
-
   // Handle MRope positions
   if (use_mrope_) {
     const auto& args = *args_;
@@ -135,46 +127,29 @@ void BatchInputBuilder::extract_tokens_and_positions(Sequence* sequence,
     // Handle sampling for last tokens
     if (j + 1 < n_tokens) continue;
 
-    handle_sampling_parameters(
-        sequence, j, seq_len, adjusted_token_to_count_map);
+    handle_sampling_parameters(sequence, j, seq_len);
   }
 }
 
-void BatchInputBuilder::handle_sampling_parameters(
-    Sequence* sequence,
-    uint32_t token_position,
-    uint32_t seq_len,
-    std::unordered_map<int32_t, int32_t>& adjusted_token_to_count_map) {
-  // const auto token_ids = sequence->token_ids();
-  const auto token_id = sequence->tokens()[token_position];
-
-  // Adjust token count
-  --adjusted_token_to_count_map[token_id];
-
+void BatchInputBuilder::handle_sampling_parameters(Sequence* sequence,
+                                                   uint32_t token_position,
+                                                   uint32_t seq_len) {
   // Select token for sampling
   state_.selected_token_idxes.push_back(state_.flatten_tokens_vec.size() - 1);
-  state_.sampling_params.push_back(sequence->sampling_param());
-
-  // Process unique tokens
-  const auto& seq_token_counts = sequence->token_to_count_map();
-  auto& ids = state_.unique_token_ids_vec.emplace_back();
-  auto& counts = state_.unique_token_counts_vec.emplace_back();
-
-  ids.reserve(seq_token_counts.size());
-  counts.reserve(seq_token_counts.size());
-
-  for (const auto& [token_id, count] : seq_token_counts) {
-    const auto it = adjusted_token_to_count_map.find(token_id);
-    const auto adjust_count =
-        (it != adjusted_token_to_count_map.end()) ? it->second : 0;
-
-    if (count > adjust_count) {
-      ids.push_back(token_id);
-      counts.push_back(count - adjust_count);
-    }
-  }
-
-  state_.unique_token_lens_vec.push_back(static_cast<int32_t>(ids.size()));
+  const auto* sampling_param = sequence->sampling_param();
+  state_.sampling_params.push_back(sampling_param);
+  state_.sampling_seq_ids.push_back(sequence->id());
+
+  // Process unique tokens, which are only used by the penalties. the counts
+  // are maintained incrementally by the sequence and copied only when the
+  // input is built.
+  const bool need_token_stats = sampling_param->has_penalty();
+  state_.unique_token_sequences.push_back(need_token_stats ? sequence
+                                                           : nullptr);
+  state_.unique_token_lens_vec.push_back(
+      need_token_stats
+          ? static_cast<int32_t>(sequence->unique_token_ids().size())
+          : 0);
 
   // Mark sample token if it's the last token
   // TODO add test
@@ -216,6 +191,7 @@ void BatchInputBuilder::setup_kv_cache_info(Sequence* sequence,
   }
 
   state_.block_tables_vec.emplace_back(std::move(block_ids));
+  state_.seq_ids.push_back(sequence->id());
 }
 
 void BatchInputBuilder::padding_decode_batch_size(
@@ -296,14 +272,33 @@ ForwardInput BatchInputBuilder::state_to_forward_input() {
   CHECK_EQ(state_.sampling_params.size(), state_.selected_token_idxes.size());
   // Setup sampling parameters
   if (!state_.selected_token_idxes.empty()) {
-    util::pad_2d_vector<int64_t>(state_.unique_token_ids_vec, /*pad_value=*/0);
-    util::pad_2d_vector(state_.unique_token_counts_vec, /*pad_value=*/0);
+    // the counts of the sequences are copied into the tensors directly
+    std::vector<const std::vector<int64_t>*> unique_token_ids;
+    std::vector<const std::vector<int32_t>*> unique_token_counts;
+    unique_token_ids.reserve(state_.unique_token_sequences.size());
+    unique_token_counts.reserve(state_.unique_token_sequences.size());
+    bool need_token_stats = false;
+    for (const auto* sequence : state_.unique_token_sequences) {
+      unique_token_ids.push_back(
+          sequence != nullptr ? &sequence->unique_token_ids() : nullptr);
+      unique_token_counts.push_back(
+          sequence != nullptr ? &sequence->unique_token_counts() : nullptr);
+      need_token_stats = need_token_stats || sequence != nullptr;
+    }
+    torch::Tensor unique_token_ids_tensor;
+    torch::Tensor unique_token_counts_tensor;
+    if (need_token_stats) {
+      unique_token_ids_tensor = create_padded_2d_tensor<int64_t>(
+          unique_token_ids, /*pad_value=*/0, torch::kInt64);
+      unique_token_counts_tensor = create_padded_2d_tensor<int32_t>(
+          unique_token_counts, /*pad_value=*/0, torch::kInt);
+    }
 
     forward_input.sampling_params.init(state_.sampling_params,
                                        state_.selected_token_idxes,
                                        state_.sample_idxes,
-                                       state_.unique_token_ids_vec,
-                                       state_.unique_token_counts_vec,
+                                       unique_token_ids_tensor,
+                                       unique_token_counts_tensor,
                                        state_.unique_token_lens_vec);
   }
 
@@ -322,10 +317,9 @@ RawForwardInput BatchInputBuilder::state_to_raw_forward_input() {
   raw_forward_input.selected_token_idxes =
       std::move(state_.selected_token_idxes);
   raw_forward_input.sample_idxes = std::move(state_.sample_idxes);
-  raw_forward_input.unique_token_ids_vec =
-      std::move(state_.unique_token_ids_vec);
-  raw_forward_input.unique_token_counts_vec =
-      std::move(state_.unique_token_counts_vec);
+  raw_forward_input.sampling_seq_ids = std::move(state_.sampling_seq_ids);
+  raw_forward_input.unique_token_sequences =
+      std::move(state_.unique_token_sequences);
   raw_forward_input.unique_token_lens_vec =
       std::move(state_.unique_token_lens_vec);
   raw_forward_input.empty_kv_cache = state_.empty_kv_cache;
@@ -336,6 +330,7 @@ RawForwardInput BatchInputBuilder::state_to_raw_forward_input() {
   raw_forward_input.q_seq_lens = std::move(state_.q_seq_lens);
   raw_forward_input.new_token_slot_ids = std::move(state_.new_token_slot_ids);
   raw_forward_input.block_tables_vec = std::move(state_.block_tables_vec);
+  raw_forward_input.seq_ids = std::move(state_.seq_ids);
   raw_forward_input.num_sequences = num_sequences_;
   // raw_forward_input.dp_global_token_nums = ;
   raw_forward_input.transfer_kv_infos = std::move(state_.transfer_kv_infos);
@@ -41,11 +41,9 @@ class BatchInputBuilder {
   void extract_tokens_and_positions(Sequence* sequence,
                                     uint32_t n_kv_cache_tokens,
                                     uint32_t seq_len);
-  void handle_sampling_parameters(
-      Sequence* sequence,
-      uint32_t token_position,
-      uint32_t seq_len,
-      std::unordered_map<int32_t, int32_t>& adjusted_counts);
+  void handle_sampling_parameters(Sequence* sequence,
+                                  uint32_t token_position,
+                                  uint32_t seq_len);
   void setup_kv_cache_info(Sequence* sequence,
                            uint32_t n_kv_cache_tokens,
                            uint32_t seq_len,
@@ -62,10 +60,10 @@ class BatchInputBuilder {
     std::vector<const RequestSamplingParam*> sampling_params;
     std::vector<int32_t> selected_token_idxes;
     std::vector<int32_t> sample_idxes;
+    std::vector<uint64_t> sampling_seq_ids;
 
-    // Unique token tracking
-    std::vector<std::vector<int64_t>> unique_token_ids_vec;
-    std::vector<std::vector<int32_t>> unique_token_counts_vec;
+    // Unique token tracking, the ids and counts are kept by the sequences
+    std::vector<const Sequence*> unique_token_sequences;
     std::vector<int32_t> unique_token_lens_vec;
 
     // Sequence metadata
@@ -78,6 +76,7 @@ class BatchInputBuilder {
     // Cache and block data
     std::vector<int32_t> new_token_slot_ids;
     std::vector<std::vector<int32_t>> block_tables_vec;
+    std::vector<uint64_t> seq_ids;
 
     // Additional data
     std::vector<int32_t> embedding_ids;
@@ -160,17 +160,18 @@ TEST(BatchTest, Basic) {
   // EXPECT_TRUE(equal(input_params.last_token_idxes, last_token_idxes));
 
   const auto& sampling_params = forward_input.sampling_params;
+  // the unique tokens are in the order they first appear
   const std::vector<int64_t> unique_ids = {
-    /*seq1*/   2,  4,  7,  5,  3,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    /*seq2*/ 100,  8,  6,  4,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 
-    /*seq3*/ 200,  19, 17, 1,  2,  15, 3,  4,  5,  6,  7,  8,  9, 10, 11, 13
+    /*seq1*/   1,  3,  5,  7,  4,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    /*seq2*/   2,  4,  6,  8, 100, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    /*seq3*/   1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 13, 15, 17, 19, 200
     };
   // seq4 has no sampling parameters
   EXPECT_TRUE(equal(sampling_params.unique_token_ids, unique_ids));
 
   const std::vector<int32_t> unique_counts = {
-    /*seq1*/  1,  1,  1,  2,  2,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  
-    /*seq2*/  1,  1,  2,  2,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  
+    /*seq1*/  2,  2,  2,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    /*seq2*/  2,  2,  2,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
     /*seq3*/  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1
   };
   // seq4 has no sampling parameters
@@ -10,7 +10,7 @@
 
 namespace xllm {
 Block::Block(int32_t id, BlockManager* manager)
-    : id_(id), ref_count_(new uint32_t(1)), manager_(manager) {
+    : id_(id), shared_(new SharedState()), manager_(manager) {
   // get the block size from the manager
   size_ = manager_ == nullptr ? 0 : manager_->block_size();
 }
@@ -24,13 +24,10 @@ Block::~Block() {
 Block::Block(const Block& other)
     : id_(other.id_),
       size_(other.size_),
-      ref_count_(other.ref_count_),
+      shared_(other.shared_),
       manager_(other.manager_) {
   memcpy(hash_value_, other.hash_value_, HASH_VALUE_MAX_LEN);
 
-  token_ids_.reserve(other.token_ids_.size());
-  token_ids_.assign(other.token_ids_.begin(), other.token_ids_.end());
-
   // increase reference count
   inc_ref_count();
 }
@@ -43,13 +40,10 @@ Block& Block::operator=(const Block& other) {
     id_ = other.id_;
     size_ = other.size_;
     manager_ = other.manager_;
-    ref_count_ = other.ref_count_;
+    shared_ = other.shared_;
 
     memcpy(hash_value_, other.hash_value_, HASH_VALUE_MAX_LEN);
 
-    token_ids_.reserve(other.token_ids_.size());
-    token_ids_.assign(other.token_ids_.begin(), other.token_ids_.end());
-
     inc_ref_count();
   }
   return *this;
@@ -58,15 +52,14 @@ Block& Block::operator=(const Block& other) {
 Block::Block(Block&& other) noexcept
     : id_(other.id_),
       size_(other.size_),
-      ref_count_(other.ref_count_),
+      shared_(other.shared_),
       manager_(other.manager_) {
   memcpy(hash_value_, other.hash_value_, HASH_VALUE_MAX_LEN);
-  token_ids_.swap(other.token_ids_);
 
   // reset other without adjusting the reference count
   other.id_ = -1;
   other.size_ = 0;
-  other.ref_count_ = nullptr;
+  other.shared_ = nullptr;
   other.manager_ = nullptr;
 }
 
@@ -77,14 +70,12 @@ Block& Block::operator=(Block&& other) noexcept {
     id_ = other.id_;
     size_ = other.size_;
     manager_ = other.manager_;
-    ref_count_ = other.ref_count_;
+    shared_ = other.shared_;
 
     memcpy(hash_value_, other.hash_value_, HASH_VALUE_MAX_LEN);
-    token_ids_.swap(other.token_ids_);
-
     other.id_ = -1;
     other.size_ = 0;
-    other.ref_count_ = nullptr;
+    other.shared_ = nullptr;
     other.manager_ = nullptr;
   }
 
@@ -92,21 +83,26 @@ Block& Block::operator=(Block&& other) noexcept {
 }
 
 void Block::inc_ref_count() {
-  if (ref_count_ != nullptr) {
-    ++(*ref_count_);
+  if (shared_ != nullptr) {
+    ++shared_->ref_count;
   }
 }
 
 void Block::dec_ref_count() {
-  if (ref_count_ != nullptr && --(*ref_count_) == 0) {
-    // release the reference count memory
-    delete ref_count_;
+  if (shared_ == nullptr) {
+    return;
+  }
+  const uint32_t ref_count = --shared_->ref_count;
+  if (ref_count == 0) {
+    // release the shared state
+    delete shared_;
     // return the block id to the manager
     if (manager_ != nullptr) {
       manager_->free(id_);
     }
-
-    token_ids_.clear();
+  } else if (ref_count == 1 && shared_->cached && manager_ != nullptr) {
+    // the last sequence released the block, only the prefix cache holds it
+    manager_->unshare(id_);
   }
 }
 
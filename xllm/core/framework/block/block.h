@@ -33,13 +33,23 @@ class Block final {
   uint32_t size() const { return size_; }
 
   // get the reference count, 0 if the block is invalid after move
-  uint32_t ref_count() const { return ref_count_ == nullptr ? 0 : *ref_count_; }
+  uint32_t ref_count() const {
+    return shared_ == nullptr ? 0 : shared_->ref_count;
+  }
 
   // check if the block is shared
   bool is_shared() const { return ref_count() > 1; }
 
   // check if the block is valid
-  bool is_valid() const { return id_ >= 0 && ref_count_ != nullptr; }
+  bool is_valid() const { return id_ >= 0 && shared_ != nullptr; }
+
+  // mark the block as held by the prefix cache. The manager is notified with
+  // unshare() when the prefix cache becomes the only owner of a cached block.
+  void set_cached(bool cached) {
+    if (shared_ != nullptr) {
+      shared_->cached = cached;
+    }
+  }
 
   const uint8_t* const get_immutable_hash_value() const { return hash_value_; }
   uint8_t* get_mutable_hash_value() { return hash_value_; }
@@ -48,13 +58,6 @@ class Block final {
     memcpy(hash_value_, hash_value, len);
   }
 
-  void set_token_ids(const Slice<int32_t>& token_ids) {
-    token_ids_.reserve(token_ids.size());
-    token_ids_.assign(token_ids.begin(), token_ids.end());
-  }
-
-  const std::vector<int32_t>& get_token_ids() { return token_ids_; }
-
  private:
   // increase reference count
   void inc_ref_count();
@@ -68,15 +71,20 @@ class Block final {
   // block size
   uint32_t size_ = 0;
 
-  // reference count
-  uint32_t* ref_count_ = nullptr;
+  // state shared by all copies of the block
+  struct SharedState {
+    // reference count
+    uint32_t ref_count = 1;
+    // whether one of the references is held by the prefix cache
+    bool cached = false;
+  };
+  SharedState* shared_ = nullptr;
 
   // manager that manages this block
   BlockManager* manager_ = nullptr;
 
   // used for prefix cache
   uint8_t hash_value_[HASH_VALUE_MAX_LEN];
-  std::vector<int32_t> token_ids_;
 };
 
 // equeal operator, mainly used for testing
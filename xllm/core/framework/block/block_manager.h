@@ -28,6 +28,11 @@ class BlockManager {
     PROPERTY(bool, enable_prefix_cache) = true;
     PROPERTY(bool, enable_disagg_pd) = false;
     PROPERTY(bool, enable_service_routing) = false;
+    // number of host memory blocks for the prefix cache and swapped out
+    // sequences, 0 to disable
+    PROPERTY(uint32_t, num_host_blocks) = 0;
+    // prefix cache policy: murmur_hash3, sha256_hash or radix_tree
+    PROPERTY(std::string, prefix_cache_policy) = "murmur_hash3";
   };
 
   explicit BlockManager(Options options) : options_(options) {}
@@ -37,15 +42,42 @@ class BlockManager {
 
   virtual std::vector<Block> allocate(size_t num_blocks) = 0;
 
+  // match the token ids with the prefix cache. If num_shared_tokens is not
+  // null, the last block may be partially matched and is copied into a new
+  // block, num_shared_tokens is set to the number of matched tokens.
   virtual std::vector<Block> allocate_shared(
       const Slice<int32_t>& tokens_ids,
-      const Slice<Block>& existed_shared_blocks = {}) = 0;
+      const Slice<Block>& existed_shared_blocks = {},
+      size_t* num_shared_tokens = nullptr) = 0;
 
   virtual void cache(const Slice<int32_t>& token_ids,
                      const Slice<Block>& blocks) = 0;
 
   // get merged all dp rank KVCacheEvent
   virtual void get_merged_kvcache_event(KvCacheEvent* event) const = 0;
+
+  // take the pending block copies between device and host memory, which
+  // should be executed by workers before the next model forward.
+  virtual std::vector<BlockTransferInfo> take_block_transfer_infos() {
+    return {};
+  }
+
+  // copy the blocks into host memory, return the host block ids or {} if
+  // not enough host blocks. The device blocks are released by the caller.
+  virtual std::vector<int32_t> swap_out(const Slice<Block>& blocks) {
+    return {};
+  }
+
+  // allocate num_blocks device blocks, at least one per host block, copy the
+  // host blocks into the first ones and release the host blocks. return {}
+  // and keep the host blocks if there are not enough device blocks.
+  virtual std::vector<Block> swap_in(const std::vector<int32_t>& host_block_ids,
+                                     size_t num_blocks) {
+    return {};
+  }
+
+  // release host blocks without swapping them in
+  virtual void free_host_blocks(const std::vector<int32_t>& host_block_ids) {}
   virtual float get_gpu_cache_usage_perc() const = 0;
 
   virtual size_t num_blocks_in_prefix_cache() const = 0;
@@ -62,6 +94,9 @@ class BlockManager {
   // call BlockManager to free block used by Block.
   virtual void free(int32_t block_id) = 0;
 
+  // called by Block when the last sequence releases a cached block
+  virtual void unshare(int32_t block_id) {}
+
   // allocate a list of blocks, used for unit test
   // virtual std::vector<Block> allocate(uint32_t n_blocks) = 0;
 
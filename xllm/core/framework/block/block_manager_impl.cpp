@@ -1,6 +1,8 @@
 #include "block_manager_impl.h"
 
-#include "framework/prefix_cache/prefix_cache_hash_murmur3.h"
+#include <algorithm>
+
+#include "framework/prefix_cache/prefix_cache.h"
 
 namespace xllm {
 
@@ -8,9 +10,18 @@ BlockManagerImpl::BlockManagerImpl(const Options& options)
     : BlockManager(options) {
   CHECK_GT(options.num_blocks(), 0) << "No blocks to allocate";
   CHECK_GT(options.block_size(), 0) << "Block size must be positive";
+  if (options_.num_host_blocks() > 0) {
+    host_block_pool_ =
+        std::make_unique<HostBlockPool>(options_.num_host_blocks());
+  }
   if (options_.enable_prefix_cache()) {
-    prefix_cache_ = std::make_unique<PrefixCacheHashMurmur3>(
-        options.block_size(), options.enable_service_routing());
+    prefix_cache_ = CreatePrefixCachePolicy(options.block_size(),
+                                            options.prefix_cache_policy(),
+                                            options.enable_service_routing(),
+                                            host_block_pool_.get(),
+                                            &block_transfer_log_);
+    CHECK(prefix_cache_ != nullptr)
+        << "Unsupported prefix cache policy: " << options.prefix_cache_policy();
   }
 
   size_t total_blocks = options_.num_blocks();
@@ -69,6 +80,10 @@ bool BlockManagerImpl::has_enough_blocks(uint32_t num_blocks) {
 
   // try to evict some blocks from the prefix cache
   const uint32_t n_blocks_to_evict = num_blocks - num_free_blocks_;
+  // blocks used by sequences can not be evicted
+  if (prefix_cache_->num_evictable_blocks() < n_blocks_to_evict) {
+    return false;
+  }
 
   AUTO_COUNTER(prefix_cache_latency_seconds_evict);
   const uint32_t n_blocks_evicted = prefix_cache_->evict(n_blocks_to_evict);
@@ -88,31 +103,83 @@ bool BlockManagerImpl::has_enough_blocks(uint32_t num_blocks) {
 
 std::vector<Block> BlockManagerImpl::allocate_shared(
     const Slice<int32_t>& tokens_ids,
-    const Slice<Block>& existed_shared_blocks) {
+    const Slice<Block>& existed_shared_blocks,
+    size_t* num_shared_tokens) {
   // only allocate shared blocks for prefill sequences
   if (options_.enable_prefix_cache()) {
     AUTO_COUNTER(prefix_cache_latency_seconds_match);
 
-    std::vector<Block> shared_blocks =
-        prefix_cache_->match(tokens_ids, existed_shared_blocks);
-
-    const size_t prefix_length =
-        shared_blocks.empty() ? 0
-                              : shared_blocks.size() * shared_blocks[0].size();
-    COUNTER_ADD(prefix_cache_match_length_total, prefix_length);
+    size_t prefix_length = 0;
+    std::vector<Block> shared_blocks = prefix_cache_->match_partial(
+        tokens_ids, existed_shared_blocks, &prefix_length);
+    const size_t block_size = options_.block_size();
+    const size_t num_full_blocks = prefix_length / block_size;
 
     // update effective block usage
-    for (const auto& block : shared_blocks) {
+    for (size_t i = 0; i < num_full_blocks; ++i) {
       // the block is not shared by any sequence
-      if (block.ref_count() <= 2) {
+      if (shared_blocks[i].ref_count() <= 2) {
         num_used_blocks_.fetch_add(1, std::memory_order_relaxed);
       }
     }
+
+    // the partially matched last block is copied into a block owned by the
+    // sequence, since the sequence writes its following tokens into it.
+    if (shared_blocks.size() > num_full_blocks) {
+      std::vector<Block> blocks =
+          num_shared_tokens != nullptr ? allocate(1) : std::vector<Block>{};
+      if (blocks.empty()) {
+        shared_blocks.resize(num_full_blocks);
+        prefix_length = num_full_blocks * block_size;
+      } else {
+        block_transfer_log_.copy(shared_blocks.back().id(), blocks[0].id());
+        shared_blocks.back() = std::move(blocks[0]);
+      }
+    }
+    COUNTER_ADD(prefix_cache_match_length_total, prefix_length);
+
+    // blocks swapped in are counted as used by allocate()
+    if (options_.num_host_blocks() > 0 && prefix_length % block_size == 0) {
+      swap_in_from_host(tokens_ids, &shared_blocks);
+      prefix_length = shared_blocks.size() * block_size;
+    }
+    if (num_shared_tokens != nullptr) {
+      *num_shared_tokens = prefix_length;
+    }
     return shared_blocks;
   }
   return {};
 }
 
+void BlockManagerImpl::swap_in_from_host(const Slice<int32_t>& tokens_ids,
+                                         std::vector<Block>* shared_blocks) {
+  const size_t n_host_blocks =
+      prefix_cache_->match_host(tokens_ids, *shared_blocks);
+  if (n_host_blocks == 0) {
+    return;
+  }
+
+  std::vector<Block> blocks = allocate(n_host_blocks);
+  if (blocks.empty()) {
+    return;
+  }
+
+  // allocation may have reused some of the matched host blocks
+  const size_t n_swapped =
+      prefix_cache_->swap_in(tokens_ids, *shared_blocks, blocks);
+  if (n_swapped < blocks.size()) {
+    num_used_blocks_.fetch_sub(blocks.size() - n_swapped,
+                               std::memory_order_relaxed);
+    blocks.resize(n_swapped);
+  }
+  COUNTER_ADD(prefix_cache_host_match_length_total,
+              n_swapped * options_.block_size());
+
+  shared_blocks->insert(shared_blocks->end(),
+                        std::make_move_iterator(blocks.begin()),
+                        std::make_move_iterator(blocks.end()));
+}
+
 void BlockManagerImpl::cache(const Slice<int32_t>& token_ids,
                              const Slice<Block>& blocks) {
   if (options_.enable_prefix_cache()) {
@@ -132,6 +199,66 @@ void BlockManagerImpl::get_merged_kvcache_event(KvCacheEvent* event) const {
   }
 }
 
+std::vector<BlockTransferInfo> BlockManagerImpl::take_block_transfer_infos() {
+  return block_transfer_log_.take_block_transfer_infos();
+}
+
+std::vector<int32_t> BlockManagerImpl::swap_out(const Slice<Block>& blocks) {
+  if (options_.num_host_blocks() == 0 || blocks.empty()) {
+    return {};
+  }
+
+  // make room by dropping the least recently used host blocks of the prefix
+  // cache, swapped out sequences are more valuable than cached prefixes
+  const size_t num_free_host_blocks = host_block_pool_->num_free_blocks();
+  if (num_free_host_blocks < blocks.size() && prefix_cache_ != nullptr) {
+    prefix_cache_->evict_host(blocks.size() - num_free_host_blocks);
+  }
+  if (host_block_pool_->num_free_blocks() < blocks.size()) {
+    return {};
+  }
+
+  std::vector<int32_t> host_block_ids;
+  host_block_ids.reserve(blocks.size());
+  for (const auto& block : blocks) {
+    const int32_t host_block_id = host_block_pool_->allocate();
+    block_transfer_log_.swap_out(block.id(), host_block_id);
+    host_block_ids.push_back(host_block_id);
+  }
+  COUNTER_ADD(num_swapped_out_blocks_total, blocks.size());
+  return host_block_ids;
+}
+
+std::vector<Block> BlockManagerImpl::swap_in(
+    const std::vector<int32_t>& host_block_ids,
+    size_t num_blocks) {
+  if (options_.num_host_blocks() == 0 || host_block_ids.empty()) {
+    return {};
+  }
+
+  std::vector<Block> blocks =
+      allocate(std::max(num_blocks, host_block_ids.size()));
+  if (blocks.empty()) {
+    return {};
+  }
+
+  for (size_t i = 0; i < host_block_ids.size(); ++i) {
+    block_transfer_log_.swap_in(host_block_ids[i], blocks[i].id());
+  }
+  // the host blocks may be reused right away, later copies into them are
+  // recorded after the swap in.
+  free_host_blocks(host_block_ids);
+  COUNTER_ADD(num_swapped_in_blocks_total, blocks.size());
+  return blocks;
+}
+
+void BlockManagerImpl::free_host_blocks(
+    const std::vector<int32_t>& host_block_ids) {
+  for (const int32_t host_block_id : host_block_ids) {
+    host_block_pool_->free(host_block_id);
+  }
+}
+
 // // allocate a list of block ids
 // std::vector<Block> BlockManagerImpl::allocate(uint32_t n_blocks) {
 //   CHECK(n_blocks <= num_free_blocks_) << "Not enough blocks available";
@@ -160,4 +287,10 @@ void BlockManagerImpl::free(int32_t block_id) {
   }
 }
 
+void BlockManagerImpl::unshare(int32_t block_id) {
+  if (prefix_cache_ != nullptr) {
+    prefix_cache_->unshare(block_id);
+  }
+}
+
 }  // namespace xllm
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "block_manager.h"
+#include "block_transfer_log.h"
+#include "host_block_pool.h"
 #include "kv_cache/kv_cache_event.h"
 
 namespace xllm {
@@ -22,7 +24,8 @@ class BlockManagerImpl : public BlockManager {
   // allocate shared blocks when enable prefix cache
   std::vector<Block> allocate_shared(
       const Slice<int32_t>& tokens_ids,
-      const Slice<Block>& existed_shared_blocks = {}) override;
+      const Slice<Block>& existed_shared_blocks = {},
+      size_t* num_shared_tokens = nullptr) override;
 
   // cache blocks when enable prefix cache
   void cache(const Slice<int32_t>& token_ids,
@@ -30,6 +33,14 @@ class BlockManagerImpl : public BlockManager {
 
   void get_merged_kvcache_event(KvCacheEvent* event) const override;
 
+  std::vector<BlockTransferInfo> take_block_transfer_infos() override;
+
+  // swap blocks of preempted sequences between device and host memory
+  std::vector<int32_t> swap_out(const Slice<Block>& blocks) override;
+  std::vector<Block> swap_in(const std::vector<int32_t>& host_block_ids,
+                             size_t num_blocks) override;
+  void free_host_blocks(const std::vector<int32_t>& host_block_ids) override;
+
   size_t num_blocks_in_prefix_cache() const override {
     if (options_.enable_prefix_cache()) {
       CHECK(prefix_cache_);
@@ -56,6 +67,9 @@ class BlockManagerImpl : public BlockManager {
   // call BlockManager to free block used by Block.
   void free(int32_t block_id) override;
 
+  // make the block evictable if it is only held by the prefix cache
+  void unshare(int32_t block_id) override;
+
   // allocate a list of blocks
   // std::vector<Block> allocate(uint32_t n_blocks) override;
 
@@ -70,7 +84,18 @@ class BlockManagerImpl : public BlockManager {
   // from the prefix cache
   bool has_enough_blocks(uint32_t num_blocks);
 
+  // swap in the blocks following `shared_blocks` from the host memory tier
+  void swap_in_from_host(const Slice<int32_t>& tokens_ids,
+                         std::vector<Block>* shared_blocks);
+
  private:
+  // host memory blocks for the prefix cache and swapped out sequences,
+  // nullptr if disabled
+  std::unique_ptr<HostBlockPool> host_block_pool_;
+
+  // the ordered log of block copies between device and host memory
+  BlockTransferLog block_transfer_log_;
+
   // prefix cache
   std::unique_ptr<PrefixCache> prefix_cache_;
 
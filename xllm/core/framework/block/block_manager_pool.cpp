@@ -1,5 +1,7 @@
 #include "block_manager_pool.h"
 
+#include <algorithm>
+
 #include "block_manager_impl.h"
 #include "concurrent_block_manager_impl.h"
 
@@ -70,6 +72,65 @@ void BlockManagerPool::deallocate(Sequence* sequence) {
   block_managers_[dp_rank]->deallocate(sequence->kv_state().kv_blocks());
   // release the blocks after prefix cache insertion
   sequence->reset();
+
+  auto& kv_state = sequence->kv_state();
+  if (kv_state.num_host_blocks() > 0) {
+    block_managers_[dp_rank]->free_host_blocks(kv_state.host_block_ids());
+    kv_state.clear_host_blocks();
+  }
+}
+
+void BlockManagerPool::swap_out(Request* request) {
+  DCHECK(request != nullptr);
+  for (auto& sequence : request->sequences()) {
+    swap_out(sequence.get());
+  }
+}
+
+void BlockManagerPool::swap_out(Sequence* sequence) {
+  DCHECK(sequence != nullptr);
+  auto& kv_state = sequence->kv_state();
+  // already swapped out, keep its host blocks
+  if (kv_state.num_host_blocks() > 0) {
+    return;
+  }
+  const size_t num_tokens = kv_state.kv_cache_tokens_num();
+  const size_t block_size = options_.block_size();
+  // only the blocks holding computed kv cache are copied
+  const size_t num_blocks_needed = (num_tokens + block_size - 1) / block_size;
+  const size_t num_blocks =
+      std::min(kv_state.num_kv_blocks(), num_blocks_needed);
+
+  std::vector<int32_t> host_block_ids;
+  if (!sequence->finished() && num_blocks > 0) {
+    host_block_ids = block_managers_[sequence->dp_rank()]->swap_out(
+        kv_state.kv_blocks().slice(0, num_blocks));
+  }
+  // the copies are recorded before the device blocks can be reused
+  deallocate(sequence);
+  if (!host_block_ids.empty()) {
+    kv_state.set_host_blocks(std::move(host_block_ids), num_tokens);
+  }
+}
+
+bool BlockManagerPool::swap_in(Sequence* sequence, size_t num_blocks) {
+  auto& kv_state = sequence->kv_state();
+  const size_t num_host_blocks = kv_state.num_host_blocks();
+  std::vector<Block> blocks = block_managers_[sequence->dp_rank()]->swap_in(
+      kv_state.host_block_ids(), num_blocks);
+  if (blocks.empty()) {
+    return false;
+  }
+  std::vector<Block> new_blocks(
+      std::make_move_iterator(blocks.begin() + num_host_blocks),
+      std::make_move_iterator(blocks.end()));
+  blocks.resize(num_host_blocks);
+  kv_state.swap_in_kv_blocks(std::move(blocks));
+  CHECK_LT(kv_state.kv_cache_tokens_num(), sequence->num_tokens());
+  if (!new_blocks.empty()) {
+    sequence->add_kv_blocks(new_blocks);
+  }
+  return true;
 }
 
 bool BlockManagerPool::allocate(Sequence* sequence) {
@@ -92,15 +153,22 @@ bool BlockManagerPool::allocate(Sequence* sequence, size_t num_tokens) {
   AUTO_COUNTER(allocate_blocks_latency_seconds);
   DCHECK(sequence != nullptr);
 
+  // round up to the nearest block number
+  const size_t block_size = options_.block_size();
+  const size_t num_blocks_needed = (num_tokens + block_size - 1) / block_size;
+
+  // a swapped out sequence gets its kv cache back in the same allocation as
+  // the new blocks, so that it keeps its host blocks if the growth fails
+  if (sequence->kv_state().num_host_blocks() > 0) {
+    return swap_in(sequence, num_blocks_needed);
+  }
+
   // first try to allocate shared blocks
   if (sequence->kv_state().num_kv_blocks() == 0) {
     allocate_shared(sequence);
   }
 
   const size_t num_blocks = sequence->kv_state().num_kv_blocks();
-  // round up to the nearest block number
-  const size_t block_size = options_.block_size();
-  const size_t num_blocks_needed = (num_tokens + block_size - 1) / block_size;
   if (num_blocks_needed <= num_blocks) {
     return true;
   }
@@ -127,6 +195,12 @@ std::vector<Block> BlockManagerPool::allocate(size_t num_tokens,
 }
 
 void BlockManagerPool::allocate_shared(Sequence* sequence) {
+  // a swapped out sequence restores its own kv cache instead of matching,
+  // it is swapped in by allocate()
+  if (sequence->kv_state().num_host_blocks() > 0) {
+    return;
+  }
+
   // only allocate shared blocks for prefill sequences
   if (options_.enable_prefix_cache()) {
     int32_t dp_rank = get_dp_rank(sequence);
@@ -134,10 +208,17 @@ void BlockManagerPool::allocate_shared(Sequence* sequence) {
         0, sequence->kv_state().shared_kv_blocks_num());
     // If the sequence holds shared_blocks, the hash values of these blocks do
     // not need to be recalculated and can be reused directly.
+    // the partially matched last block can only be copied for a sequence
+    // without kv blocks
+    size_t num_shared_tokens = 0;
     std::vector<Block> shared_blocks =
-        block_managers_[dp_rank]->allocate_shared(sequence->tokens(),
-                                                  existed_shared_blocks);
-    sequence->add_shared_kv_blocks(std::move(shared_blocks));
+        block_managers_[dp_rank]->allocate_shared(
+            sequence->tokens(),
+            existed_shared_blocks,
+            sequence->kv_state().num_kv_blocks() == 0 ? &num_shared_tokens
+                                                      : nullptr);
+    sequence->add_shared_kv_blocks(std::move(shared_blocks),
+                                   num_shared_tokens);
   }
 }
 
@@ -154,6 +235,11 @@ void BlockManagerPool::get_merged_kvcache_event(KvCacheEvent* event) const {
   }
 }
 
+std::vector<BlockTransferInfo> BlockManagerPool::take_block_transfer_infos(
+    int32_t dp_rank) {
+  return block_managers_[dp_rank]->take_block_transfer_infos();
+}
+
 float BlockManagerPool::get_gpu_cache_usage_perc() const {
   float perc = 0.0;
   for (int32_t i = 0; i < block_managers_.size(); ++i) {
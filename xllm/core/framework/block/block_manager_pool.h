@@ -23,14 +23,27 @@ class BlockManagerPool {
   // return {} if not enough blocks
   std::vector<Block> allocate(size_t num_tokens, int32_t& dp_rank);
 
+  // release the device blocks of all sequences and the host blocks of
+  // swapped out sequences
   void deallocate(Request* request);
   void deallocate(std::vector<Sequence*>& sequences);
   void deallocate(Sequence* sequence);
 
+  // copy the kv cache of the sequences into host memory and release their
+  // device blocks. Sequences that can not be swapped out are deallocated and
+  // have to be recomputed. Swapped out sequences are swapped in by the next
+  // allocate().
+  void swap_out(Request* request);
+  void swap_out(Sequence* sequence);
+
   void allocate_shared(Sequence* sequence);
   void cache(Sequence* sequence);
 
   void get_merged_kvcache_event(KvCacheEvent* event) const;
+
+  // take the pending block copies between device and host memory of the
+  // given dp rank
+  std::vector<BlockTransferInfo> take_block_transfer_infos(int32_t dp_rank);
   float get_gpu_cache_usage_perc() const;
 
   std::vector<size_t> num_blocks_in_prefix_cache() const;
@@ -45,6 +58,10 @@ class BlockManagerPool {
   int32_t get_manager_with_max_free_blocks() const;
   int32_t get_dp_rank(Sequence* sequence) const;
 
+  // swap in the host blocks of a swapped out sequence, growing it to
+  // num_blocks. The sequence stays swapped out if the allocation fails.
+  bool swap_in(Sequence* sequence, size_t num_blocks);
+
   std::vector<std::unique_ptr<BlockManager>> block_managers_;
 
   // the options for the block manager
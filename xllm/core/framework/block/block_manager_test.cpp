@@ -103,4 +103,96 @@ TEST(BlockManagerTest, Basic) {
   }
 }
 
-}  // namespace xllm
\ No newline at end of file
+TEST(BlockManagerTest, SwapOutAndIn) {
+  const uint32_t n_blocks = 5;
+  const uint32_t block_size = 2;
+  BlockManager::Options options;
+  options.num_blocks(n_blocks)
+      .block_size(block_size)
+      .enable_prefix_cache(false)
+      .num_host_blocks(3);
+  BlockManagerImpl manager(options);
+
+  std::vector<int32_t> host_block_ids;
+  {
+    std::vector<Block> blocks = manager.allocate(2);
+    host_block_ids = manager.swap_out(blocks);
+    ASSERT_EQ(host_block_ids.size(), 2);
+    // not enough host blocks left
+    EXPECT_TRUE(manager.swap_out(blocks).empty());
+
+    auto infos = manager.take_block_transfer_infos();
+    ASSERT_EQ(infos.size(), 2);
+    for (size_t i = 0; i < infos.size(); ++i) {
+      EXPECT_EQ(infos[i].transfer_type, TransferType::G2H);
+      EXPECT_EQ(infos[i].src_block_id, blocks[i].id());
+      EXPECT_EQ(infos[i].dst_block_id, host_block_ids[i]);
+    }
+  }
+  EXPECT_EQ(manager.num_free_blocks(), n_blocks - 1);
+
+  // not enough device blocks, the host blocks are kept
+  EXPECT_TRUE(manager.swap_in(host_block_ids, n_blocks).empty());
+  EXPECT_TRUE(manager.take_block_transfer_infos().empty());
+  {
+    std::vector<Block> blocks = manager.allocate(1);
+    std::vector<int32_t> other_host_block_ids = manager.swap_out(blocks);
+    EXPECT_EQ(other_host_block_ids.size(), 1);
+    EXPECT_TRUE(manager.swap_out(blocks).empty());
+    manager.take_block_transfer_infos();
+    manager.free_host_blocks(other_host_block_ids);
+  }
+
+  {
+    // swap in together with a new block
+    std::vector<Block> blocks = manager.swap_in(host_block_ids, 3);
+    ASSERT_EQ(blocks.size(), 3);
+    EXPECT_EQ(manager.num_free_blocks(), n_blocks - 4);
+
+    auto infos = manager.take_block_transfer_infos();
+    ASSERT_EQ(infos.size(), 2);
+    for (size_t i = 0; i < infos.size(); ++i) {
+      EXPECT_EQ(infos[i].transfer_type, TransferType::H2G);
+      EXPECT_EQ(infos[i].src_block_id, host_block_ids[i]);
+      EXPECT_EQ(infos[i].dst_block_id, blocks[i].id());
+    }
+
+    // host blocks are released after the swap in
+    EXPECT_EQ(manager.swap_out(blocks).size(), 3);
+  }
+  EXPECT_EQ(manager.num_free_blocks(), n_blocks - 1);
+}
+
+TEST(BlockManagerTest, EvictOnlyUnusedBlocks) {
+  const uint32_t n_blocks = 6;
+  const uint32_t block_size = 2;
+  BlockManager::Options options;
+  options.num_blocks(n_blocks).block_size(block_size);
+  BlockManagerImpl manager(options);
+
+  std::vector<int32_t> token_ids = {1, 2, 3, 4, 5, 6, 7, 8};
+  {
+    std::vector<Block> blocks = manager.allocate(4);
+    manager.cache(Slice<int32_t>(token_ids), Slice<Block>(blocks));
+    EXPECT_EQ(manager.num_blocks_in_prefix_cache(), 4);
+
+    // cached blocks used by the sequence can not be evicted
+    EXPECT_TRUE(manager.allocate(2).empty());
+    EXPECT_EQ(manager.num_blocks_in_prefix_cache(), 4);
+
+    // release the last two blocks, the tail is evicted first
+    blocks.pop_back();
+    blocks.pop_back();
+    {
+      std::vector<Block> new_blocks = manager.allocate(2);
+      EXPECT_EQ(new_blocks.size(), 2);
+      EXPECT_EQ(manager.num_blocks_in_prefix_cache(), 3);
+    }
+    EXPECT_EQ(manager.allocate_shared(Slice<int32_t>(token_ids)).size(), 3);
+  }
+
+  // evict all cached blocks
+  EXPECT_EQ(manager.allocate(n_blocks - 1).size(), n_blocks - 1);
+}
+
+}  // namespace xllm
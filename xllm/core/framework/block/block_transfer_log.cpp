@@ -0,0 +1,28 @@
+#include "block_transfer_log.h"
+
+namespace xllm {
+
+void BlockTransferLog::swap_out(int32_t device_block_id,
+                                int32_t host_block_id) {
+  block_transfer_infos_.emplace_back(
+      device_block_id, host_block_id, TransferType::G2H);
+}
+
+void BlockTransferLog::swap_in(int32_t host_block_id,
+                               int32_t device_block_id) {
+  block_transfer_infos_.emplace_back(
+      host_block_id, device_block_id, TransferType::H2G);
+}
+
+void BlockTransferLog::copy(int32_t src_block_id, int32_t dst_block_id) {
+  block_transfer_infos_.emplace_back(
+      src_block_id, dst_block_id, TransferType::G2G);
+}
+
+std::vector<BlockTransferInfo> BlockTransferLog::take_block_transfer_infos() {
+  std::vector<BlockTransferInfo> block_transfer_infos;
+  block_transfer_infos.swap(block_transfer_infos_);
+  return block_transfer_infos;
+}
+
+}  // namespace xllm
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/types.h"
+
+namespace xllm {
+
+// The ordered log of the kv cache block copies that workers have to execute
+// before the next model forward.
+//
+// All copies go through one log: a device block evicted to host memory may
+// be reused in the same step, and a host block swapped in may be overwritten
+// by a later offload, so workers must replay copies in order. Device to
+// device copies (copy-on-write of partially matched prefix blocks) share the
+// log for the same reason.
+class BlockTransferLog final {
+ public:
+  // copy a device block into a host block
+  void swap_out(int32_t device_block_id, int32_t host_block_id);
+
+  // copy a host block into a device block
+  void swap_in(int32_t host_block_id, int32_t device_block_id);
+
+  // copy a device block into another device block
+  void copy(int32_t src_block_id, int32_t dst_block_id);
+
+  // take the recorded block copies, the log is cleared afterwards
+  std::vector<BlockTransferInfo> take_block_transfer_infos();
+
+ private:
+  // pending block copies in recorded order
+  std::vector<BlockTransferInfo> block_transfer_infos_;
+};
+
+}  // namespace xllm
@@ -6,40 +6,53 @@ ConcurrentBlockManagerImpl::ConcurrentBlockManagerImpl(const Options& options)
     : BlockManagerImpl(options) {}
 
 std::vector<Block> ConcurrentBlockManagerImpl::allocate(size_t num_blocks) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   return BlockManagerImpl::allocate(num_blocks);
 }
 
 void ConcurrentBlockManagerImpl::deallocate(const Slice<Block>& blocks) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   BlockManagerImpl::deallocate(blocks);
 }
 
 std::vector<Block> ConcurrentBlockManagerImpl::allocate_shared(
     const Slice<int32_t>& tokens_ids,
-    const Slice<Block>& existed_shared_blocks) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return BlockManagerImpl::allocate_shared(tokens_ids);
+    const Slice<Block>& existed_shared_blocks,
+    size_t* num_shared_tokens) {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return BlockManagerImpl::allocate_shared(
+      tokens_ids, existed_shared_blocks, num_shared_tokens);
 }
 
 void ConcurrentBlockManagerImpl::cache(const Slice<int32_t>& token_ids,
                                        const Slice<Block>& blocks) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   BlockManagerImpl::cache(token_ids, blocks);
 }
 
+std::vector<BlockTransferInfo>
+ConcurrentBlockManagerImpl::take_block_transfer_infos() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return BlockManagerImpl::take_block_transfer_infos();
+}
+
+void ConcurrentBlockManagerImpl::unshare(int32_t block_id) {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  BlockManagerImpl::unshare(block_id);
+}
+
 size_t ConcurrentBlockManagerImpl::num_blocks_in_prefix_cache() const {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   return BlockManagerImpl::num_blocks_in_prefix_cache();
 }
 
 size_t ConcurrentBlockManagerImpl::num_free_blocks() const {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   return BlockManagerImpl::num_free_blocks();
 }
 
 double ConcurrentBlockManagerImpl::kv_cache_utilization() const {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   return BlockManagerImpl::kv_cache_utilization();
 }
 
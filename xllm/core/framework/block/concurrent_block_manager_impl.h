@@ -18,12 +18,19 @@ class ConcurrentBlockManagerImpl : public BlockManagerImpl {
   // try to share blocks among sequences with the same prefix
   std::vector<Block> allocate_shared(
       const Slice<int32_t>& tokens_ids,
-      const Slice<Block>& existed_shared_blocks = {}) override;
+      const Slice<Block>& existed_shared_blocks = {},
+      size_t* num_shared_tokens = nullptr) override;
 
   // cache the blocks
   void cache(const Slice<int32_t>& token_ids,
              const Slice<Block>& blocks) override;
 
+  // take the pending block copies between device and host memory
+  std::vector<BlockTransferInfo> take_block_transfer_infos() override;
+
+  // make the block evictable if it is only held by the prefix cache
+  void unshare(int32_t block_id) override;
+
   // get the number of blocks in the prefix cache
   size_t num_blocks_in_prefix_cache() const override;
 
@@ -34,8 +41,9 @@ class ConcurrentBlockManagerImpl : public BlockManagerImpl {
   double kv_cache_utilization() const override;
 
  private:
-  // mutex for disagg prefill/decode mode
-  mutable std::mutex mutex_;
+  // mutex for disagg prefill/decode mode. Recursive since blocks released
+  // while holding the lock call back into unshare().
+  mutable std::recursive_mutex mutex_;
 };
 
 }  // namespace xllm
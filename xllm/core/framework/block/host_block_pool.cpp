@@ -0,0 +1,30 @@
+#include "host_block_pool.h"
+
+#include <glog/logging.h>
+
+namespace xllm {
+
+HostBlockPool::HostBlockPool(uint32_t num_blocks) {
+  num_free_blocks_ = num_blocks;
+  free_blocks_.reserve(num_blocks);
+  for (int32_t i = 0; i < num_blocks; ++i) {
+    // push smaller block ids to the back of the vector
+    free_blocks_.push_back(num_blocks - i - 1);
+  }
+}
+
+int32_t HostBlockPool::allocate() {
+  if (num_free_blocks_ == 0) {
+    return -1;
+  }
+  return free_blocks_[--num_free_blocks_];
+}
+
+void HostBlockPool::free(int32_t host_block_id) {
+  CHECK(host_block_id >= 0 && host_block_id < free_blocks_.size())
+      << "Invalid host block id: " << host_block_id;
+  CHECK(num_free_blocks_ < free_blocks_.size());
+  free_blocks_[num_free_blocks_++] = host_block_id;
+}
+
+}  // namespace xllm
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xllm {
+
+// Bookkeeping of the host (CPU DRAM) kv cache blocks on the scheduler side.
+// The actual host memory lives in the workers (see HostKVCache); this class
+// only hands out host block ids. The copies between device and host blocks
+// are recorded in a BlockTransferLog.
+class HostBlockPool final {
+ public:
+  explicit HostBlockPool(uint32_t num_blocks);
+
+  // allocate a host block, return -1 if no free block left
+  int32_t allocate();
+
+  // return a host block to the pool
+  void free(int32_t host_block_id);
+
+  size_t num_free_blocks() const { return num_free_blocks_; }
+
+  size_t num_total_blocks() const { return free_blocks_.size(); }
+
+ private:
+  // free block count
+  size_t num_free_blocks_ = 0;
+
+  // free host block list
+  std::vector<int32_t> free_blocks_;
+};
+
+}  // namespace xllm
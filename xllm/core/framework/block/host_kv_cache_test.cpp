@@ -0,0 +1,121 @@
+#include "framework/kv_cache/host_kv_cache.h"
+
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+#include <vector>
+
+#include "block_transfer_log.h"
+
+namespace xllm {
+
+namespace {
+
+const int64_t kNumLayers = 2;
+const int64_t kNumDeviceBlocks = 4;
+const int64_t kNumHostBlocks = 2;
+
+// [n_blocks, block_size, n_heads, head_dim]
+std::vector<std::vector<int64_t>> kv_cache_shape() {
+  return {{kNumDeviceBlocks, 2, 1, 3}, {kNumDeviceBlocks, 2, 1, 3}};
+}
+
+// the kv caches of the layers on cpu, the key of block i of layer l is filled
+// with 10 * l + i and its value with the negation
+std::vector<KVCache> create_device_kv_caches() {
+  const auto shape = kv_cache_shape();
+  std::vector<KVCache> kv_caches;
+  for (int64_t l = 0; l < kNumLayers; ++l) {
+    auto key_cache = torch::empty(shape[0], torch::kFloat32);
+    auto value_cache = torch::empty(shape[1], torch::kFloat32);
+    for (int64_t i = 0; i < kNumDeviceBlocks; ++i) {
+      key_cache[i].fill_(10 * l + i);
+      value_cache[i].fill_(-(10 * l + i));
+    }
+    kv_caches.emplace_back(key_cache, value_cache);
+  }
+  return kv_caches;
+}
+
+// whether the block of every layer holds the value filled for `block_id`
+bool block_equals(const std::vector<KVCache>& kv_caches,
+                  int64_t block_id,
+                  int64_t expected_block_id) {
+  for (int64_t l = 0; l < kNumLayers; ++l) {
+    const float value = 10 * l + expected_block_id;
+    const auto& kv_cache = kv_caches[l];
+    if (!kv_cache.get_k_cache()[block_id].eq(value).all().item<bool>() ||
+        !kv_cache.get_v_cache()[block_id].eq(-value).all().item<bool>()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(HostKVCacheTest, TransferBlock) {
+  auto device_kv_caches = create_device_kv_caches();
+  HostKVCache host_kv_cache(kNumLayers,
+                            kNumHostBlocks,
+                            kv_cache_shape(),
+                            torch::kFloat32,
+                            /*pin_memory=*/false);
+  EXPECT_EQ(host_kv_cache.num_blocks(), kNumHostBlocks);
+  ASSERT_EQ(host_kv_cache.kv_caches().size(), kNumLayers);
+  EXPECT_EQ(host_kv_cache.kv_caches()[0].get_k_cache().size(0),
+            kNumHostBlocks);
+
+  // device block 2 into host block 1
+  host_kv_cache.transfer_block(device_kv_caches,
+                               BlockTransferInfo(2, 1, TransferType::G2H));
+  EXPECT_TRUE(block_equals(host_kv_cache.kv_caches(), 1, 2));
+
+  // host block 1 back into device block 3
+  host_kv_cache.transfer_block(device_kv_caches,
+                               BlockTransferInfo(1, 3, TransferType::H2G));
+  EXPECT_TRUE(block_equals(device_kv_caches, 3, 2));
+  // the other device blocks are untouched
+  EXPECT_TRUE(block_equals(device_kv_caches, 1, 1));
+  EXPECT_TRUE(block_equals(device_kv_caches, 2, 2));
+}
+
+// Test that replaying the log in the recorded order, as the worker does before
+// the forward, restores an offloaded block whose device block is reused
+TEST(HostKVCacheTest, ReplayBlockTransferLog) {
+  auto device_kv_caches = create_device_kv_caches();
+  HostKVCache host_kv_cache(kNumLayers,
+                            kNumHostBlocks,
+                            kv_cache_shape(),
+                            torch::kFloat32,
+                            /*pin_memory=*/false);
+
+  BlockTransferLog log;
+  // offload block 1, overwrite it with block 2 and load it into block 3
+  log.swap_out(/*device_block_id=*/1, /*host_block_id=*/0);
+  log.copy(/*src_block_id=*/2, /*dst_block_id=*/1);
+  log.swap_in(/*host_block_id=*/0, /*device_block_id=*/3);
+
+  const auto infos = log.take_block_transfer_infos();
+  ASSERT_EQ(infos.size(), 3);
+  EXPECT_TRUE(log.take_block_transfer_infos().empty());
+  for (const auto& info : infos) {
+    if (info.transfer_type != TransferType::G2G) {
+      host_kv_cache.transfer_block(device_kv_caches, info);
+      continue;
+    }
+    for (const auto& kv_cache : device_kv_caches) {
+      kv_cache.get_k_cache()[info.dst_block_id].copy_(
+          kv_cache.get_k_cache()[info.src_block_id]);
+      kv_cache.get_v_cache()[info.dst_block_id].copy_(
+          kv_cache.get_v_cache()[info.src_block_id]);
+    }
+  }
+
+  EXPECT_TRUE(block_equals(host_kv_cache.kv_caches(), 0, 1));
+  EXPECT_TRUE(block_equals(device_kv_caches, 1, 2));
+  EXPECT_TRUE(block_equals(device_kv_caches, 3, 1));
+  EXPECT_TRUE(block_equals(device_kv_caches, 0, 0));
+}
+
+}  // namespace xllm
@@ -2,6 +2,8 @@
 
 #include <absl/strings/match.h>
 #include <absl/strings/str_replace.h>
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
 #include <glog/logging.h>
 #include <torch/torch.h>
 
@@ -9,6 +11,8 @@
 #include <filesystem>
 #include <vector>
 
+#include "core/common/global_flags.h"
+#include "core/common/metrics.h"
 #include "core/framework/tokenizer/fast_tokenizer.h"
 #include "core/framework/tokenizer/sentencepiece_tokenizer.h"
 #include "core/framework/tokenizer/tiktoken_tokenizer.h"
@@ -44,12 +48,37 @@ std::unique_ptr<Tokenizer> HFModelLoader::tokenizer() const {
 std::vector<std::unique_ptr<StateDict>>& HFModelLoader::get_state_dicts() {
   if (state_dicts_.empty()) {
     // load state dict
-    state_dicts_.reserve(model_weights_files_.size());
-    for (auto& model_weights_file : model_weights_files_) {
-      LOG(INFO) << "Loading model weights from " << model_weights_file;
-      state_dicts_.emplace_back(
-          StateDictFromSafeTensor::load(model_weights_file));
+    LOG(INFO) << "Loading " << model_weights_files_.size()
+              << " model weights files from " << model_weights_path_;
+    const absl::Time start = absl::Now();
+    safetensors_loader_ =
+        std::make_unique<SafeTensorsLoader>(FLAGS_num_weight_load_threads);
+    // the weights of the rank are read from the cache, only the headers of
+    // the model weights files are needed.
+    const bool read_ahead =
+        read_ahead_ && (weight_cache_ == nullptr || !weight_cache_->hit());
+    state_dicts_ = safetensors_loader_->load(
+        model_weights_files_,
+        [](const std::string& file, size_t num_bytes, double seconds) {
+          const double mb_per_second =
+              seconds > 0 ? num_bytes / seconds / 1e6 : 0;
+          COUNTER_ADD(weight_read_ahead_bytes_total, num_bytes);
+          HISTOGRAM_OBSERVE(weight_read_ahead_throughput_mb_per_second,
+                            static_cast<int64_t>(mb_per_second));
+          LOG(INFO) << "Read " << num_bytes / 1e9 << " GB of model weights "
+                    << "from " << file << " in " << seconds << "s ("
+                    << mb_per_second / 1e3 << " GB/s)";
+        },
+        read_ahead);
+    size_t num_tensors = 0;
+    for (const auto& state_dict : state_dicts_) {
+      num_tensors += state_dict->size();
+      state_dict->set_weight_cache(weight_cache_);
     }
+    // the data is still being read ahead, see the logs of each file
+    LOG(INFO) << "Parsed and indexed " << num_tensors << " tensors of "
+              << state_dicts_.size() << " model weights files in "
+              << absl::ToDoubleSeconds(absl::Now() - start) << "s";
   }
   return state_dicts_;
 }
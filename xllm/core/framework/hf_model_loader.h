@@ -4,6 +4,7 @@
 
 #include <vector>
 
+#include "core/framework/state_dict/safetensors_loader.h"
 #include "core/framework/state_dict/state_dict.h"
 #include "model_loader.h"
 
@@ -31,5 +32,8 @@ class HFModelLoader : public ModelLoader {
 
   // models weights tensors
   std::vector<std::unique_ptr<StateDict>> state_dicts_;
+
+  // reads the weights ahead in the background, destroyed before the tensors
+  std::unique_ptr<SafeTensorsLoader> safetensors_loader_;
 };
 }  // namespace xllm
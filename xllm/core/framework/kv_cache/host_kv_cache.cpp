@@ -0,0 +1,57 @@
+#include "host_kv_cache.h"
+
+#include <glog/logging.h>
+
+namespace xllm {
+
+HostKVCache::HostKVCache(
+    int64_t num_layers,
+    int64_t num_blocks,
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    torch::ScalarType dtype,
+    bool pin_memory)
+    : num_blocks_(num_blocks), non_blocking_(pin_memory) {
+  CHECK_GT(num_blocks, 0) << "No host blocks to allocate";
+  CHECK_EQ(kv_cache_shape.size(), 2) << "Expect shapes of key and value cache";
+
+  std::vector<int64_t> key_shape = kv_cache_shape[0];
+  std::vector<int64_t> value_shape = kv_cache_shape[1];
+  key_shape[0] = num_blocks;
+  value_shape[0] = num_blocks;
+
+  auto options = torch::TensorOptions()
+                     .dtype(dtype)
+                     .device(torch::kCPU)
+                     .pinned_memory(pin_memory);
+  kv_caches_.reserve(num_layers);
+  for (int64_t i = 0; i < num_layers; ++i) {
+    kv_caches_.emplace_back(torch::empty(key_shape, options),
+                            torch::empty(value_shape, options));
+  }
+}
+
+void HostKVCache::transfer_block(const std::vector<KVCache>& device_kv_caches,
+                                 const BlockTransferInfo& info) {
+  CHECK_EQ(device_kv_caches.size(), kv_caches_.size())
+      << "Layer number mismatch between device and host kv cache";
+
+  for (size_t i = 0; i < kv_caches_.size(); ++i) {
+    const KVCache& device_cache = device_kv_caches[i];
+    const KVCache& host_cache = kv_caches_[i];
+    if (info.transfer_type == TransferType::G2H) {
+      host_cache.get_k_cache()[info.dst_block_id].copy_(
+          device_cache.get_k_cache()[info.src_block_id], non_blocking_);
+      host_cache.get_v_cache()[info.dst_block_id].copy_(
+          device_cache.get_v_cache()[info.src_block_id], non_blocking_);
+    } else {
+      CHECK(info.transfer_type == TransferType::H2G)
+          << "Unexpected transfer type for host kv cache";
+      device_cache.get_k_cache()[info.dst_block_id].copy_(
+          host_cache.get_k_cache()[info.src_block_id], non_blocking_);
+      device_cache.get_v_cache()[info.dst_block_id].copy_(
+          host_cache.get_v_cache()[info.src_block_id], non_blocking_);
+    }
+  }
+}
+
+}  // namespace xllm
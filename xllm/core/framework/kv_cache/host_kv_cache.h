@@ -0,0 +1,46 @@
+#pragma once
+#include <torch/torch.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "common/types.h"
+#include "kv_cache.h"
+
+namespace xllm {
+
+// Host (CPU DRAM) copy of the kv cache of all layers, the second-tier storage
+// for blocks evicted from device memory. Host blocks use the same layout as
+// device blocks and are addressed by host block id, see HostBlockPool.
+class HostKVCache final {
+ public:
+  // kv_cache_shape is the shape of the device kv cache, whose first dim is
+  // replaced by num_blocks.
+  HostKVCache(int64_t num_layers,
+              int64_t num_blocks,
+              const std::vector<std::vector<int64_t>>& kv_cache_shape,
+              torch::ScalarType dtype,
+              bool pin_memory = true);
+
+  ~HostKVCache() = default;
+
+  // execute a block copy between device and host memory for all layers. With
+  // pinned host memory, copies are issued asynchronously on the current
+  // stream of the device, so they are ordered before the following forward.
+  void transfer_block(const std::vector<KVCache>& device_kv_caches,
+                      const BlockTransferInfo& info);
+
+  int64_t num_blocks() const { return num_blocks_; }
+
+  const std::vector<KVCache>& kv_caches() const { return kv_caches_; }
+
+ private:
+  int64_t num_blocks_ = 0;
+
+  bool non_blocking_ = false;
+
+  // host kv caches for each layer
+  std::vector<KVCache> kv_caches_;
+};
+
+}  // namespace xllm
@@ -7,6 +7,7 @@
 #include "core/framework/model/model_args.h"
 #include "core/framework/quant_args.h"
 #include "core/framework/state_dict/state_dict.h"
+#include "core/framework/state_dict/weight_cache.h"
 #include "core/framework/tokenizer/tokenizer.h"
 #include "core/framework/tokenizer/tokenizer_args.h"
 
@@ -26,6 +27,16 @@ class ModelLoader {
   virtual std::unique_ptr<Tokenizer> tokenizer() const = 0;
   virtual std::vector<std::unique_ptr<StateDict>>& get_state_dicts() = 0;
 
+  // serve the weights from the cache and record the ones read into it, must
+  // be set before the state dicts are loaded.
+  void set_weight_cache(std::shared_ptr<WeightCache> weight_cache) {
+    weight_cache_ = std::move(weight_cache);
+  }
+
+  // whether to read the weights files ahead when the state dicts are loaded,
+  // must be set before they are loaded.
+  void set_read_ahead(bool read_ahead) { read_ahead_ = read_ahead; }
+
  protected:
   // model args
   ModelArgs args_;
@@ -33,6 +44,10 @@ class ModelLoader {
   QuantArgs quant_args_;
   // tokenizer args
   TokenizerArgs tokenizer_args_;
+  // optional cache of the weights of the rank
+  std::shared_ptr<WeightCache> weight_cache_;
+  // read the whole weights files ahead
+  bool read_ahead_ = true;
 
  public:
   // create a model loader from the given path
@@ -5,13 +5,16 @@
 
 #include "prefix_cache_hash_murmur3.h"
 #include "prefix_cache_hash_sha256.h"
+#include "prefix_cache_radix_tree.h"
 
 namespace xllm {
 
 std::unique_ptr<PrefixCache> CreatePrefixCachePolicy(
     int32_t block_size,
     const std::string& policy,
-    const bool& enbale_service_routing) {
+    const bool& enbale_service_routing,
+    HostBlockPool* host_block_pool,
+    BlockTransferLog* block_transfer_log) {
   std::vector<absl::string_view> subs = absl::StrSplit(policy, ':');
   CHECK(subs.size() > 0) << " Prefix cache, input param invalid."
                          << " policy:" << policy;
@@ -20,7 +23,11 @@ std::unique_ptr<PrefixCache> CreatePrefixCachePolicy(
     return std::make_unique<PrefixCacheHashSha256>(block_size);
   } else if ("murmur_hash3" == subs[0]) {
     return std::make_unique<PrefixCacheHashMurmur3>(block_size,
-                                                    enbale_service_routing);
+                                                    enbale_service_routing,
+                                                    host_block_pool,
+                                                    block_transfer_log);
+  } else if ("radix_tree" == subs[0]) {
+    return std::make_unique<PrefixCacheRadixTree>(block_size);
   } else {
     return nullptr;
   }
@@ -44,6 +44,19 @@ class PrefixCache {
       const Slice<int32_t>& token_ids,
       const Slice<Block>& existed_shared_blocks = {}) = 0;
 
+  // match the token ids at token granularity, the last returned block may be
+  // partially matched. num_matched_tokens is set to the number of matched
+  // tokens. Block granularity caches only match full blocks.
+  virtual std::vector<Block> match_partial(
+      const Slice<int32_t>& token_ids,
+      const Slice<Block>& existed_shared_blocks,
+      size_t* num_matched_tokens) {
+    std::vector<Block> blocks = match(token_ids, existed_shared_blocks);
+    *num_matched_tokens =
+        blocks.empty() ? 0 : blocks.size() * blocks[0].size();
+    return blocks;
+  }
+
   size_t insert(const std::vector<int32_t>& token_ids,
                 const std::vector<Block>& blocks) {
     return insert(Slice<int32_t>(token_ids), Slice<Block>(blocks));
@@ -55,6 +68,36 @@ class PrefixCache {
 
   virtual size_t num_blocks() const = 0;
 
+  // called when the last sequence releases a cached block, the prefix cache is
+  // its only owner now and may evict it.
+  virtual void unshare(int32_t block_id) {}
+
+  // get the number of blocks not used by any sequence, an upper bound of the
+  // number of blocks evict() can release
+  virtual size_t num_evictable_blocks() const { return num_blocks(); }
+
+  // continue matching the token ids after `matched_blocks` against the host
+  // memory tier, return the number of consecutive blocks found there.
+  virtual size_t match_host(const Slice<int32_t>& token_ids,
+                            const Slice<Block>& matched_blocks) {
+    return 0;
+  }
+
+  // swap the host blocks following `matched_blocks` into the given device
+  // blocks and cache them, return the number of blocks swapped in.
+  virtual size_t swap_in(const Slice<int32_t>& token_ids,
+                         const Slice<Block>& matched_blocks,
+                         const Slice<Block>& blocks) {
+    return 0;
+  }
+
+  // release the least recently used blocks of the host memory tier back to
+  // the host block pool, return the number of released blocks.
+  virtual size_t evict_host(size_t n_blocks) { return 0; }
+
+  // get the number of blocks in the host memory tier
+  virtual size_t num_host_blocks() const { return 0; }
+
   float block_match_rate() {
     if (total_blocks_.load() == 0) {
       return 0;
@@ -72,9 +115,17 @@ class PrefixCache {
   std::atomic<uint64_t> total_blocks_{0}, matched_blocks_{0};
 };
 
+class BlockTransferLog;
+class HostBlockPool;
+
+// policy: murmur_hash3, sha256_hash or radix_tree. The host memory tier is
+// only supported by murmur_hash3. The block copies are recorded into
+// `block_transfer_log`.
 std::unique_ptr<PrefixCache> CreatePrefixCachePolicy(
     const int32_t block_size,
     const std::string& policy,
-    const bool& enbale_service_routing = false);
+    const bool& enbale_service_routing = false,
+    HostBlockPool* host_block_pool = nullptr,
+    BlockTransferLog* block_transfer_log = nullptr);
 
 }  // namespace xllm
@@ -10,47 +10,53 @@
 #include "framework/block/block_manager_impl.h"
 #include "prefix_cache_hash_murmur3.h"
 #include "prefix_cache_hash_sha256.h"
+#include "prefix_cache_radix_tree.h"
 
 using namespace xllm;
 
-static void BM_MurmurHash3Search(benchmark::State& state) {
-  const uint32_t block_size = 16;
+namespace {
+
+constexpr uint32_t kBlockSize = 16;
+
+std::vector<int32_t> random_token_ids(std::mt19937* gen, uint32_t count) {
+  std::uniform_int_distribution<unsigned> dist(0, 65535);
+  std::vector<int32_t> token_ids(count);
+  std::generate(
+      token_ids.begin(), token_ids.end(), [&]() { return dist(*gen); });
+  return token_ids;
+}
+
+// match the same prompt as inserted
+void search(benchmark::State& state, const std::string& policy) {
   const uint32_t total_blocks = state.range(0);
   const uint32_t token_id_count = state.range(1);
 
-  // LOG(INFO) << "total blocks " << total_blocks << ", token_id_count " <<
-  // token_id_count;
-
-  assert((token_id_count / block_size) < total_blocks);
+  assert((token_id_count / kBlockSize) < total_blocks);
 
   state.PauseTiming();
   BlockManager::Options options;
-  options.num_blocks(n_blocks + 1).block_size(block_size);
+  options.num_blocks(total_blocks + 1).block_size(kBlockSize);
   BlockManagerImpl block_manager(options);
 
-  PrefixCacheHashMurmur3 prefix_cache(block_size);
+  auto prefix_cache = CreatePrefixCachePolicy(kBlockSize, policy);
 
   std::random_device rd;
   std::mt19937 gen(rd());
-  std::uniform_int_distribution<unsigned> dist(0, 65535);
-
-  std::vector<int32_t> token_ids(token_id_count);
-  std::generate(
-      token_ids.begin(), token_ids.end(), [&]() { return dist(gen); });
+  std::vector<int32_t> token_ids = random_token_ids(&gen, token_id_count);
 
-  uint32_t n_blocks = token_id_count / block_size;
+  uint32_t n_blocks = token_id_count / kBlockSize;
 
   std::vector<Block> token_blocks = block_manager.allocate(n_blocks);
   Slice<Block> slice_token_blocks(token_blocks);
   Slice<int32_t> slice_token_ids(token_ids);
   std::vector<int32_t> match_token_ids(token_ids);
 
-  prefix_cache.insert(slice_token_ids, slice_token_blocks);
+  prefix_cache->insert(slice_token_ids, slice_token_blocks);
   state.ResumeTiming();
 
   size_t count = 0;
   for (auto _ : state) {
-    benchmark::DoNotOptimize(prefix_cache.match(match_token_ids));
+    benchmark::DoNotOptimize(prefix_cache->match(match_token_ids));
 
     ++count;
   }
@@ -58,59 +64,91 @@ static void BM_MurmurHash3Search(benchmark::State& state) {
   state.counters["iter count"] = count;
 }
 
-BENCHMARK(BM_MurmurHash3Search)
-    ->Args({2048, 5000})
-    ->Unit(benchmark::TimeUnit::kMillisecond)
-    ->UseRealTime()
-    ->Iterations(100)
-    ->Repetitions(20)
-    ->ReportAggregatesOnly(true);
-
-static void BM_Sha256Search(benchmark::State& state) {
-  const uint32_t block_size = 16;
+// agentic workloads: prompts share a long prefix and diverge at a random
+// position, usually in the middle of a block
+void search_near_identical(benchmark::State& state,
+                           const std::string& policy) {
   const uint32_t total_blocks = state.range(0);
   const uint32_t token_id_count = state.range(1);
 
-  // LOG(INFO) << "total blocks " << total_blocks << ", token_id_count " <<
-  // token_id_count;
-
-  assert((token_id_count / block_size) < total_blocks);
+  assert((token_id_count / kBlockSize) < total_blocks);
 
   state.PauseTiming();
   BlockManager::Options options;
-  options.num_blocks(n_blocks + 1).block_size(block_size);
+  options.num_blocks(total_blocks + 1).block_size(kBlockSize);
   BlockManagerImpl block_manager(options);
 
-  PrefixCacheHashSha256 prefix_cache(block_size);
+  auto prefix_cache = CreatePrefixCachePolicy(kBlockSize, policy);
 
   std::random_device rd;
   std::mt19937 gen(rd());
-  std::uniform_int_distribution<unsigned> dist(0, 65535);
-
-  std::vector<int32_t> token_ids(token_id_count);
-  std::generate(
-      token_ids.begin(), token_ids.end(), [&]() { return dist(gen); });
-
-  uint32_t n_blocks = token_id_count / block_size;
+  std::vector<int32_t> token_ids = random_token_ids(&gen, token_id_count);
 
+  uint32_t n_blocks = token_id_count / kBlockSize;
   std::vector<Block> token_blocks = block_manager.allocate(n_blocks);
-  Slice<Block> slice_token_blocks(token_blocks);
-  Slice<int32_t> slice_token_ids(token_ids);
-  std::vector<int32_t> match_token_ids(token_ids);
-
-  prefix_cache.insert(slice_token_ids, slice_token_blocks);
+  prefix_cache->insert(Slice<int32_t>(token_ids), Slice<Block>(token_blocks));
+
+  // diverge within the last quarter of the prompt
+  std::uniform_int_distribution<uint32_t> diverge_dist(
+      token_id_count * 3 / 4, token_id_count - 1);
+  std::vector<std::vector<int32_t>> prompts(64, token_ids);
+  for (auto& prompt : prompts) {
+    prompt[diverge_dist(gen)] = -1;
+  }
   state.ResumeTiming();
 
   size_t count = 0;
+  size_t matched_tokens = 0;
   for (auto _ : state) {
-    benchmark::DoNotOptimize(prefix_cache.match(match_token_ids));
+    const auto& prompt = prompts[count % prompts.size()];
+    size_t num_matched_tokens = 0;
+    benchmark::DoNotOptimize(prefix_cache->match_partial(
+        Slice<int32_t>(prompt), {}, &num_matched_tokens));
+    matched_tokens += num_matched_tokens;
 
     ++count;
   }
 
   state.counters["iter count"] = count;
+  state.counters["matched tokens"] =
+      static_cast<double>(matched_tokens) / std::max<size_t>(count, 1);
+  state.counters["block matched rate"] = prefix_cache->block_match_rate();
+}
+
+}  // namespace
+
+static void BM_MurmurHash3Search(benchmark::State& state) {
+  search(state, "murmur_hash3");
+}
+
+static void BM_Sha256Search(benchmark::State& state) {
+  search(state, "sha256_hash");
+}
+
+static void BM_RadixTreeSearch(benchmark::State& state) {
+  search(state, "radix_tree");
+}
+
+static void BM_MurmurHash3SearchNearIdentical(benchmark::State& state) {
+  search_near_identical(state, "murmur_hash3");
 }
 
+static void BM_Sha256SearchNearIdentical(benchmark::State& state) {
+  search_near_identical(state, "sha256_hash");
+}
+
+static void BM_RadixTreeSearchNearIdentical(benchmark::State& state) {
+  search_near_identical(state, "radix_tree");
+}
+
+BENCHMARK(BM_MurmurHash3Search)
+    ->Args({2048, 5000})
+    ->Unit(benchmark::TimeUnit::kMillisecond)
+    ->UseRealTime()
+    ->Iterations(100)
+    ->Repetitions(20)
+    ->ReportAggregatesOnly(true);
+
 BENCHMARK(BM_Sha256Search)
     ->Args({2048, 5000})
     ->Unit(benchmark::TimeUnit::kMillisecond)
@@ -119,4 +157,36 @@ BENCHMARK(BM_Sha256Search)
     ->Repetitions(20)
     ->ReportAggregatesOnly(true);
 
+BENCHMARK(BM_RadixTreeSearch)
+    ->Args({2048, 5000})
+    ->Unit(benchmark::TimeUnit::kMillisecond)
+    ->UseRealTime()
+    ->Iterations(100)
+    ->Repetitions(20)
+    ->ReportAggregatesOnly(true);
+
+BENCHMARK(BM_MurmurHash3SearchNearIdentical)
+    ->Args({2048, 5000})
+    ->Unit(benchmark::TimeUnit::kMillisecond)
+    ->UseRealTime()
+    ->Iterations(100)
+    ->Repetitions(20)
+    ->ReportAggregatesOnly(true);
+
+BENCHMARK(BM_Sha256SearchNearIdentical)
+    ->Args({2048, 5000})
+    ->Unit(benchmark::TimeUnit::kMillisecond)
+    ->UseRealTime()
+    ->Iterations(100)
+    ->Repetitions(20)
+    ->ReportAggregatesOnly(true);
+
+BENCHMARK(BM_RadixTreeSearchNearIdentical)
+    ->Args({2048, 5000})
+    ->Unit(benchmark::TimeUnit::kMillisecond)
+    ->UseRealTime()
+    ->Iterations(100)
+    ->Repetitions(20)
+    ->ReportAggregatesOnly(true);
+
 BENCHMARK_MAIN();
@@ -2,10 +2,13 @@
 
 #include <glog/logging.h>
 
+#include <absl/container/flat_hash_map.h>
+
 #include <atomic>
+#include <memory>
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <vector>
 
 #include "prefix_cache/prefix_cache.h"
 #include "util/double_buffer.h"
@@ -30,32 +33,89 @@ class PrefixCacheHash : public PrefixCache {
     return nullptr;
   }
 
+  // the block is no longer used by any sequence, make it evictable
+  void unshare(int32_t block_id) override {
+    if (block_id < 0 || block_id >= block_nodes_.size()) {
+      return;
+    }
+    Node* node = block_nodes_[block_id];
+    if (node == nullptr || !node->in_use) {
+      return;
+    }
+    unlink_node(node);
+    link_node(node);
+  }
+
+  size_t num_evictable_blocks() const override { return num_evictable_blocks_; }
+
  protected:
   struct Node {
     Block block;
     // the last access time of the node, used to evict blocks
     int64_t last_access_time = 0;
 
+    // whether the block is used by sequences, i.e. in the in use list
+    bool in_use = false;
+
     // the previous and next nodes, used to maintain the LRU list
     Node* prev = nullptr;
     Node* next = nullptr;
   };
 
+  // Nodes are allocated in fixed size slabs and recycled through a free list,
+  // so that insert and evict do not go through the heap allocator. Node
+  // addresses are stable, the LRU list is threaded through the slabs.
+  class NodePool {
+   public:
+    ~NodePool() {
+      // the blocks outliving the prefix cache must not notify it
+      for (auto& slab : slabs_) {
+        for (size_t i = 0; i < kSlabSize; ++i) {
+          slab[i].block.set_cached(false);
+        }
+      }
+    }
+
+    Node* allocate() {
+      if (free_nodes_.empty()) {
+        slabs_.emplace_back(std::make_unique<Node[]>(kSlabSize));
+        Node* slab = slabs_.back().get();
+        free_nodes_.reserve(kSlabSize);
+        for (size_t i = kSlabSize; i > 0; --i) {
+          free_nodes_.push_back(&slab[i - 1]);
+        }
+      }
+      Node* node = free_nodes_.back();
+      free_nodes_.pop_back();
+      return node;
+    }
+
+    // release the block held by the node and recycle the node
+    void free(Node* node) {
+      node->block.set_cached(false);
+      node->block = Block();
+      node->last_access_time = 0;
+      node->in_use = false;
+      node->prev = nullptr;
+      node->next = nullptr;
+      free_nodes_.push_back(node);
+    }
+
+   private:
+    static constexpr size_t kSlabSize = 4096;
+
+    std::vector<std::unique_ptr<Node[]>> slabs_;
+
+    std::vector<Node*> free_nodes_;
+  };
+
+  // the nodes are owned by the node pool
   struct DNodeList {
     DNodeList() {
       lst_front.next = &lst_back;
       lst_back.prev = &lst_front;
     }
 
-    ~DNodeList() {
-      Node* node = lst_front.next;
-      while (node != &lst_back) {
-        Node* next = node->next;
-        delete node;
-        node = next;
-      }
-    }
-
     bool is_empty() { return lst_front.next == &lst_back; }
 
     // remove the node from the LRU list, and return next node
@@ -114,8 +174,60 @@ class PrefixCacheHash : public PrefixCache {
     Node lst_back;
   };
 
+  // register a new node holding its block
+  void add_node(Node* node) {
+    const int32_t block_id = node->block.id();
+    if (block_id >= block_nodes_.size()) {
+      block_nodes_.resize(block_id + 1, nullptr);
+    }
+    block_nodes_[block_id] = node;
+    node->block.set_cached(true);
+  }
+
+  // unregister an unlinked node and recycle it
+  void remove_node(Node* node) {
+    block_nodes_[node->block.id()] = nullptr;
+    node_pool_.free(node);
+  }
+
+  // remove the node from the list it is in
+  void unlink_node(Node* node) {
+    if (node->in_use) {
+      in_use_lst_.remove_node(node);
+    } else {
+      lru_lst_.remove_node(node);
+      --num_evictable_blocks_;
+    }
+  }
+
+  // append the node to the in use list if its block is used by sequences,
+  // otherwise to the evictable LRU list
+  void link_node(Node* node) {
+    node->in_use = node->block.is_shared();
+    if (node->in_use) {
+      in_use_lst_.push_back(node);
+    } else {
+      lru_lst_.push_back(node);
+      ++num_evictable_blocks_;
+    }
+  }
+
+  // declared before the LRU lists, the nodes outlive the lists
+  NodePool node_pool_;
+
+  // nodes whose blocks are only held by the prefix cache, from least to most
+  // recently used. Eviction only walks this list.
   DNodeList lru_lst_;
 
+  // nodes whose blocks are used by sequences, they move to the evictable list
+  // once the last sequence releases the block, see unshare()
+  DNodeList in_use_lst_;
+
+  size_t num_evictable_blocks_ = 0;
+
+  // cached nodes indexed by block id
+  std::vector<Node*> block_nodes_;
+
   // the block size of the memory blocks
   uint32_t block_size_;
 
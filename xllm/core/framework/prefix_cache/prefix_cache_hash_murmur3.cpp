@@ -14,11 +14,18 @@
 
 namespace xllm {
 
-PrefixCacheHashMurmur3::PrefixCacheHashMurmur3(uint32_t block_size,
-                                               bool enable_service_routing)
+PrefixCacheHashMurmur3::PrefixCacheHashMurmur3(
+    uint32_t block_size,
+    bool enable_service_routing,
+    HostBlockPool* host_block_pool,
+    BlockTransferLog* block_transfer_log)
     : PrefixCacheHash(block_size),
       enable_service_routing_(enable_service_routing),
-      hash_value_len_(MURMUR_HASH3_VALUE_LEN) {
+      hash_value_len_(MURMUR_HASH3_VALUE_LEN),
+      host_block_pool_(host_block_pool),
+      block_transfer_log_(block_transfer_log) {
+  CHECK(host_block_pool_ == nullptr || block_transfer_log_ != nullptr)
+      << "The host memory tier needs a block transfer log";
   if (enable_service_routing_) {
     db_kvcache_events_.set_front_value(new KvCacheEvent());
     db_kvcache_events_.set_back_value(new KvCacheEvent());
@@ -78,17 +85,17 @@ std::vector<Block> PrefixCacheHashMurmur3::match(
     auto iter = murmur3_cached_blocks_.find(murmur3_key);
     if (iter != murmur3_cached_blocks_.end()) {
       blocks.push_back(iter->second->block);
-      lru_lst_.remove_node(iter->second);
+      unlink_node(iter->second);
       node_list.push_front(iter->second);
     } else {
       break;
     }
   }
 
-  // update LRU list
+  // update LRU lists, the matched blocks are in use now
   while (!node_list.is_empty()) {
     Node* node = node_list.pop_front();
-    lru_lst_.push_back(node);
+    link_node(node);
   }
 
   matched_blocks_.fetch_add(blocks.size());
@@ -137,15 +144,15 @@ size_t PrefixCacheHashMurmur3::insert(const Slice<int32_t>& token_ids,
     if (iter != murmur3_cached_blocks_.end()) {
       iter->second->last_access_time = now;
 
-      lru_lst_.remove_node(iter->second);
+      unlink_node(iter->second);
       node_list.push_front(iter->second);
     } else {
-      Node* new_node = new Node();
+      Node* new_node = node_pool_.allocate();
 
       new_node->block = blocks[block_idx];
       new_node->block.set_hash_value(murmur3_key.data, hash_value_len_);
-      new_node->block.set_token_ids(token_ids.slice(i, i + block_size_));
       new_node->last_access_time = now;
+      add_node(new_node);
 
       node_list.push_front(new_node);
 
@@ -163,82 +170,251 @@ size_t PrefixCacheHashMurmur3::insert(const Slice<int32_t>& token_ids,
 
   while (!node_list.is_empty()) {
     Node* node = node_list.pop_front();
-    lru_lst_.push_back(node);
+    link_node(node);
   }
   if (enable_service_routing_) {
-    threadpool_.schedule([insert_list = std::move(insert_list), this]() {
-      auto front_ptr = this->db_kvcache_events_.get_front_value();
-      if (!front_ptr) {
-        LOG(INFO) << "Front DoubleBufferKvCacheEvent is nullptr!";
-        return;
-      }
-      if (!this->exited_.load()) {
-        for (const auto& hash_id : insert_list) {
-          front_ptr->removed_cache.erase(hash_id);
-          front_ptr->stored_cache.insert(hash_id);
-        }
-      }
-    });
+    schedule_kvcache_events(std::move(insert_list), {}, {});
   }
 
   return n_tokens;
 }
 
 size_t PrefixCacheHashMurmur3::evict(size_t n_blocks) {
-  if (num_blocks_ == 0 || lru_lst_.is_empty()) {
+  if (num_blocks_ == 0) {
     return 0;
   }
 
   size_t evict_count = 0;
-  Node* iter_node = lru_lst_.get_first();
   std::vector<Murmur3Key> del_list;
+  std::vector<Murmur3Key> offload_list;
   del_list.reserve(n_blocks);
-  for (size_t i = 0; i < n_blocks; ++i) {
-    if (lru_lst_.is_last(iter_node)) {
-      break;
+  while (evict_count < n_blocks && !lru_lst_.is_empty()) {
+    Node* del_node = lru_lst_.get_first();
+    unlink_node(del_node);
+    if (del_node->block.is_shared()) {  // in use
+      link_node(del_node);
+      continue;
     }
 
-    if (iter_node->block.is_shared()) {  // in use
-      iter_node = iter_node->next;
+    Murmur3Key token_hash_key(del_node->block.get_immutable_hash_value());
 
-      continue;
+    murmur3_cached_blocks_.erase(token_hash_key);
+
+    // the copy is recorded before the device block is freed below, so it is
+    // executed before any later write into the reused block.
+    if (host_block_pool_ != nullptr &&
+        offload(token_hash_key, del_node->block.id(), &del_list)) {
+      offload_list.emplace_back(token_hash_key);
+    } else if (enable_service_routing_) {
+      del_list.emplace_back(token_hash_key);
     }
 
-    Node* del_node = iter_node;
+    remove_node(del_node);
+    ++evict_count;
+    --num_blocks_;
+  }
+  COUNTER_ADD(prefix_cache_num_offloaded_blocks_total, offload_list.size());
+  if (enable_service_routing_) {
+    schedule_kvcache_events({}, std::move(del_list), std::move(offload_list));
+  }
 
-    iter_node = lru_lst_.remove_node(del_node);
+  return evict_count;
+}
 
-    Murmur3Key token_hash_key(del_node->block.get_immutable_hash_value());
+bool PrefixCacheHashMurmur3::offload(const Murmur3Key& key,
+                                     int32_t device_block_id,
+                                     std::vector<Murmur3Key>* dropped_keys) {
+  auto iter = host_cached_blocks_.find(key);
+  if (iter != host_cached_blocks_.end()) {
+    // the host copy is still valid, only refresh its LRU position
+    host_lru_lst_.splice(host_lru_lst_.end(), host_lru_lst_, iter->second);
+    return true;
+  }
 
-    if (enable_service_routing_) {
-      del_list.emplace_back(token_hash_key.data);
+  int32_t host_block_id = host_block_pool_->allocate();
+  if (host_block_id < 0) {
+    if (host_lru_lst_.empty()) {
+      return false;
+    }
+    // reuse the least recently used host block
+    auto& [dropped_key, dropped_block_id] = host_lru_lst_.front();
+    host_cached_blocks_.erase(dropped_key);
+    if (enable_service_routing_ &&
+        murmur3_cached_blocks_.find(dropped_key) ==
+            murmur3_cached_blocks_.end()) {
+      dropped_keys->emplace_back(dropped_key);
     }
+    host_block_id = dropped_block_id;
+    host_lru_lst_.pop_front();
+  }
 
-    murmur3_cached_blocks_.erase(token_hash_key);
+  block_transfer_log_->swap_out(device_block_id, host_block_id);
+  host_lru_lst_.emplace_back(key, host_block_id);
+  host_cached_blocks_.emplace(key, std::prev(host_lru_lst_.end()));
+  return true;
+}
+
+size_t PrefixCacheHashMurmur3::evict_host(size_t n_blocks) {
+  if (host_block_pool_ == nullptr) {
+    return 0;
+  }
 
-    delete del_node;
+  size_t evict_count = 0;
+  std::vector<Murmur3Key> del_list;
+  while (evict_count < n_blocks && !host_lru_lst_.empty()) {
+    const auto& [key, host_block_id] = host_lru_lst_.front();
+    if (enable_service_routing_ &&
+        murmur3_cached_blocks_.find(key) == murmur3_cached_blocks_.end()) {
+      del_list.emplace_back(key);
+    }
+    host_cached_blocks_.erase(key);
+    host_block_pool_->free(host_block_id);
+    host_lru_lst_.pop_front();
     ++evict_count;
-    --num_blocks_;
   }
   if (enable_service_routing_) {
-    threadpool_.schedule([del_list = std::move(del_list), this]() {
-      auto front_ptr = this->db_kvcache_events_.get_front_value();
-      if (!front_ptr) {
-        LOG(INFO) << "Front DoubleBufferKvCacheEvent is nullptr!";
-        return;
-      }
-      if (!this->exited_.load()) {
-        for (const auto& hash_id : del_list) {
-          front_ptr->removed_cache.insert(hash_id);
-          front_ptr->stored_cache.erase(hash_id);
-        }
-      }
-    });
+    schedule_kvcache_events({}, std::move(del_list), {});
   }
 
   return evict_count;
 }
 
+size_t PrefixCacheHashMurmur3::match_host(const Slice<int32_t>& token_ids,
+                                          const Slice<Block>& matched_blocks) {
+  if (host_block_pool_ == nullptr || host_cached_blocks_.empty()) {
+    return 0;
+  }
+
+  const size_t n_tokens = round_down(token_ids.size(), block_size_);
+  const size_t start_index = matched_blocks.size() * block_size_;
+  Murmur3Key murmur3_key =
+      matched_blocks.empty()
+          ? Murmur3Key{}
+          : Murmur3Key{matched_blocks.back().get_immutable_hash_value()};
+
+  std::vector<HostLruList::iterator> matched_iters;
+  for (size_t i = start_index; i < n_tokens; i += block_size_) {
+    if (i == 0) {
+      murmur_hash3(
+          nullptr, token_ids.slice(i, i + block_size_), murmur3_key.data);
+    } else {
+      murmur_hash3(murmur3_key.data,
+                   token_ids.slice(i, i + block_size_),
+                   murmur3_key.data);
+    }
+
+    auto iter = host_cached_blocks_.find(murmur3_key);
+    if (iter == host_cached_blocks_.end()) {
+      break;
+    }
+    matched_iters.emplace_back(iter->second);
+  }
+
+  // refresh in reverse order, so that the tail of a chain is reused first
+  for (auto it = matched_iters.rbegin(); it != matched_iters.rend(); ++it) {
+    host_lru_lst_.splice(host_lru_lst_.end(), host_lru_lst_, *it);
+  }
+
+  return matched_iters.size();
+}
+
+size_t PrefixCacheHashMurmur3::swap_in(const Slice<int32_t>& token_ids,
+                                       const Slice<Block>& matched_blocks,
+                                       const Slice<Block>& blocks) {
+  if (host_block_pool_ == nullptr || blocks.empty()) {
+    return 0;
+  }
+
+  const int64_t now = absl::ToUnixMicros(absl::Now());
+  const size_t n_tokens = round_down(token_ids.size(), block_size_);
+  const size_t start_index = matched_blocks.size() * block_size_;
+  Murmur3Key murmur3_key =
+      matched_blocks.empty()
+          ? Murmur3Key{}
+          : Murmur3Key{matched_blocks.back().get_immutable_hash_value()};
+
+  DNodeList node_list;
+  std::vector<Murmur3Key> insert_list;
+  size_t block_idx = 0;
+  for (size_t i = start_index; i < n_tokens && block_idx < blocks.size();
+       i += block_size_) {
+    if (i == 0) {
+      murmur_hash3(
+          nullptr, token_ids.slice(i, i + block_size_), murmur3_key.data);
+    } else {
+      murmur_hash3(murmur3_key.data,
+                   token_ids.slice(i, i + block_size_),
+                   murmur3_key.data);
+    }
+
+    // the host block may have been reused by offloads since match_host()
+    auto iter = host_cached_blocks_.find(murmur3_key);
+    if (iter == host_cached_blocks_.end()) {
+      break;
+    }
+    DCHECK(murmur3_cached_blocks_.find(murmur3_key) ==
+           murmur3_cached_blocks_.end());
+
+    block_transfer_log_->swap_in(iter->second->second,
+                                 blocks[block_idx].id());
+
+    Node* new_node = node_pool_.allocate();
+    new_node->block = blocks[block_idx];
+    new_node->block.set_hash_value(murmur3_key.data, hash_value_len_);
+    new_node->last_access_time = now;
+    add_node(new_node);
+    node_list.push_front(new_node);
+    murmur3_cached_blocks_.emplace(std::make_pair(murmur3_key, new_node));
+    if (enable_service_routing_) {
+      insert_list.emplace_back(murmur3_key);
+    }
+
+    ++num_blocks_;
+    ++block_idx;
+  }
+
+  while (!node_list.is_empty()) {
+    Node* node = node_list.pop_front();
+    link_node(node);
+  }
+  if (enable_service_routing_) {
+    schedule_kvcache_events(std::move(insert_list), {}, {});
+  }
+
+  return block_idx;
+}
+
+void PrefixCacheHashMurmur3::schedule_kvcache_events(
+    std::vector<Murmur3Key>&& stored_keys,
+    std::vector<Murmur3Key>&& removed_keys,
+    std::vector<Murmur3Key>&& offloaded_keys) {
+  threadpool_.schedule([stored_keys = std::move(stored_keys),
+                        removed_keys = std::move(removed_keys),
+                        offloaded_keys = std::move(offloaded_keys),
+                        this]() {
+    auto front_ptr = this->db_kvcache_events_.get_front_value();
+    if (!front_ptr) {
+      LOG(INFO) << "Front DoubleBufferKvCacheEvent is nullptr!";
+      return;
+    }
+    if (!this->exited_.load()) {
+      for (const auto& hash_id : stored_keys) {
+        front_ptr->removed_cache.erase(hash_id);
+        front_ptr->stored_cache.insert(hash_id);
+      }
+      for (const auto& hash_id : removed_keys) {
+        front_ptr->removed_cache.insert(hash_id);
+        front_ptr->stored_cache.erase(hash_id);
+        front_ptr->offload_cache.erase(hash_id);
+      }
+      for (const auto& hash_id : offloaded_keys) {
+        front_ptr->offload_cache.insert(hash_id);
+        front_ptr->stored_cache.erase(hash_id);
+      }
+    }
+  });
+}
+
 KvCacheEvent* PrefixCacheHashMurmur3::get_upload_kvcache_events() {
   if (!enable_service_routing_) {
     return nullptr;
@@ -2,13 +2,22 @@
 
 #include <glog/logging.h>
 
+#include <list>
+
+#include "framework/block/block_transfer_log.h"
+#include "framework/block/host_block_pool.h"
 #include "prefix_cache_hash.h"
 
 namespace xllm {
 class PrefixCacheHashMurmur3 final : public PrefixCacheHash {
  public:
-  explicit PrefixCacheHashMurmur3(uint32_t block_size,
-                                  bool enable_service_routing = false);
+  // blocks evicted from the device are offloaded into `host_block_pool` if
+  // it is not nullptr, the copies are recorded into `block_transfer_log`.
+  explicit PrefixCacheHashMurmur3(
+      uint32_t block_size,
+      bool enable_service_routing = false,
+      HostBlockPool* host_block_pool = nullptr,
+      BlockTransferLog* block_transfer_log = nullptr);
 
   ~PrefixCacheHashMurmur3();
 
@@ -35,19 +44,67 @@ class PrefixCacheHashMurmur3 final : public PrefixCacheHash {
     return num_blocks_;
   }
 
+  // match the token ids after `matched_blocks` against the host memory tier
+  // return the number of consecutive host blocks
+  size_t match_host(const Slice<int32_t>& token_ids,
+                    const Slice<Block>& matched_blocks) override;
+
+  // swap the host blocks following `matched_blocks` into `blocks`
+  // return the number of blocks swapped in
+  size_t swap_in(const Slice<int32_t>& token_ids,
+                 const Slice<Block>& matched_blocks,
+                 const Slice<Block>& blocks) override;
+
+  // release the least recently used host blocks to the host block pool
+  // return the actual number of released blocks
+  size_t evict_host(size_t n_blocks) override;
+
+  // get the number of blocks in the host memory tier
+  size_t num_host_blocks() const override {
+    return host_cached_blocks_.size();
+  }
+
   virtual KvCacheEvent* get_upload_kvcache_events() override;
 
  private:
-  std::unordered_map<Murmur3Key,
-                     Node*,
-                     FixedStringKeyHash<Murmur3Key>,
-                     FixedStringKeyEqual<Murmur3Key>>
+  using HostLruList = std::list<std::pair<Murmur3Key, int32_t>>;
+
+  // copy an evicted device block into the host memory tier, the least
+  // recently used host block is reused if the host pool is exhausted.
+  // return false if the block can not be offloaded.
+  bool offload(const Murmur3Key& key,
+               int32_t device_block_id,
+               std::vector<Murmur3Key>* dropped_keys);
+
+  void schedule_kvcache_events(std::vector<Murmur3Key>&& stored_keys,
+                               std::vector<Murmur3Key>&& removed_keys,
+                               std::vector<Murmur3Key>&& offloaded_keys);
+
+  absl::flat_hash_map<Murmur3Key,
+                      Node*,
+                      FixedStringKeyHash<Murmur3Key>,
+                      FixedStringKeyEqual<Murmur3Key>>
       murmur3_cached_blocks_;
 
   uint32_t hash_value_len_;
 
   bool enable_service_routing_ = false;
 
+  // host memory tier, not owned. nullptr if disabled
+  HostBlockPool* host_block_pool_ = nullptr;
+
+  // the log of the copies into and out of the host memory tier, not owned
+  BlockTransferLog* block_transfer_log_ = nullptr;
+
+  // host blocks from least to most recently used, with their hash keys
+  HostLruList host_lru_lst_;
+
+  absl::flat_hash_map<Murmur3Key,
+                      HostLruList::iterator,
+                      FixedStringKeyHash<Murmur3Key>,
+                      FixedStringKeyEqual<Murmur3Key>>
+      host_cached_blocks_;
+
   ThreadPool threadpool_;
 
   DoubleBufferKvCacheEvent db_kvcache_events_;
@@ -55,7 +55,7 @@ std::vector<Block> PrefixCacheHashSha256::match(
     auto iter = sha256_cached_blocks_.find(token_hash_key);
     if (iter != sha256_cached_blocks_.end()) {
       blocks.push_back(iter->second->block);
-      lru_lst_.remove_node(iter->second);
+      unlink_node(iter->second);
       // block_nodes.push_back(iter->second);
       node_list.push_front(iter->second);
     } else {
@@ -63,10 +63,10 @@ std::vector<Block> PrefixCacheHashSha256::match(
     }
   }
 
-  // update LRU list
+  // update LRU lists, the matched blocks are in use now
   while (!node_list.is_empty()) {
     Node* node = node_list.pop_front();
-    lru_lst_.push_back(node);
+    link_node(node);
   }
 
   matched_blocks_.fetch_add(blocks.size());
@@ -113,15 +113,15 @@ size_t PrefixCacheHashSha256::insert(const Slice<int32_t>& token_ids,
     if (iter != sha256_cached_blocks_.end()) {
       iter->second->last_access_time = now;
 
-      lru_lst_.remove_node(iter->second);
+      unlink_node(iter->second);
       node_list.push_front(iter->second);
     } else {
-      Node* new_node = new Node();
+      Node* new_node = node_pool_.allocate();
 
       new_node->block = blocks[block_idx];
       new_node->block.set_hash_value(token_hash_key.data, SHA256_DIGEST_LENGTH);
-      new_node->block.set_token_ids(token_ids.slice(i, i + block_size_));
       new_node->last_access_time = now;
+      add_node(new_node);
 
       node_list.push_front(new_node);
 
@@ -133,43 +133,36 @@ size_t PrefixCacheHashSha256::insert(const Slice<int32_t>& token_ids,
     block_idx++;
   }
 
-  // update LRU list
+  // update LRU lists
   while (!node_list.is_empty()) {
     Node* node = node_list.pop_front();
-    lru_lst_.push_back(node);
+    link_node(node);
   }
 
   return n_tokens;
 }
 
 size_t PrefixCacheHashSha256::evict(size_t n_blocks) {
-  if (num_blocks_ == 0 || lru_lst_.is_empty()) {
+  if (num_blocks_ == 0) {
     return 0;
   }
 
   size_t evict_count = 0;
-  Node* iter_node = lru_lst_.get_first();
-  for (; evict_count < n_blocks; ++evict_count) {
-    if (lru_lst_.is_last(iter_node)) {
-      break;
-    }
-
-    if (iter_node->block.is_shared()) {  // in use
-      iter_node = iter_node->next;
-
+  while (evict_count < n_blocks && !lru_lst_.is_empty()) {
+    Node* del_node = lru_lst_.get_first();
+    unlink_node(del_node);
+    if (del_node->block.is_shared()) {  // in use
+      link_node(del_node);
       continue;
     }
 
-    Node* del_node = iter_node;
-
-    iter_node = lru_lst_.remove_node(del_node);
-
     Sha256Key token_hash_key(del_node->block.get_immutable_hash_value());
 
     sha256_cached_blocks_.erase(token_hash_key);
 
-    delete del_node;
+    remove_node(del_node);
 
+    ++evict_count;
     --num_blocks_;
   }
 
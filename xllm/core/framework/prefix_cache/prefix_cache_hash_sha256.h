@@ -37,10 +37,10 @@ class PrefixCacheHashSha256 final : public PrefixCacheHash {
   }
 
  private:
-  std::unordered_map<Sha256Key,
-                     Node*,
-                     FixedStringKeyHash<Sha256Key>,
-                     FixedStringKeyEqual<Sha256Key>>
+  absl::flat_hash_map<Sha256Key,
+                      Node*,
+                      FixedStringKeyHash<Sha256Key>,
+                      FixedStringKeyEqual<Sha256Key>>
       sha256_cached_blocks_;
 
   uint32_t hash_value_len_;
@@ -1,11 +1,47 @@
 #include <gtest/gtest.h>
 
 #include "framework/block/block_manager_impl.h"
+#include "framework/block/host_block_pool.h"
 #include "prefix_cache_hash_murmur3.h"
 #include "prefix_cache_hash_sha256.h"
+#include "prefix_cache_radix_tree.h"
 
 namespace xllm {
 
+// A block manager notifying a standalone prefix cache, which is not owned by
+// the manager, when the cache becomes the only owner of a block.
+class UnshareForwardingBlockManager : public BlockManagerImpl {
+ public:
+  explicit UnshareForwardingBlockManager(const Options& options)
+      : BlockManagerImpl(options) {}
+
+  void set_prefix_cache(PrefixCache* prefix_cache) {
+    forwarded_prefix_cache_ = prefix_cache;
+  }
+
+  void unshare(int32_t block_id) override {
+    ++num_unshares_;
+    if (forwarded_prefix_cache_ != nullptr) {
+      forwarded_prefix_cache_->unshare(block_id);
+    }
+  }
+
+  size_t num_unshares() const { return num_unshares_; }
+
+ private:
+  PrefixCache* forwarded_prefix_cache_ = nullptr;
+
+  size_t num_unshares_ = 0;
+};
+
+// release the blocks from the tail like a finished sequence does, so the end of
+// a prefix becomes evictable before its head
+void release_from_tail(std::vector<Block>* blocks) {
+  while (!blocks->empty()) {
+    blocks->pop_back();
+  }
+}
+
 void test_basic_operation(BlockManagerImpl* block_manager,
                           PrefixCacheHash* prefix_cache_hash,
                           uint32_t block_size) {
@@ -33,6 +69,7 @@ void test_basic_operation(BlockManagerImpl* block_manager,
   {
     auto block_matched = prefix_cache_hash->match(slice_token_ids);
     EXPECT_EQ(block_matched.size(), n_blocks);
+    release_from_tail(&block_matched);
   }
 
   {
@@ -63,9 +100,10 @@ TEST(PrefixCacheHashTest, Sha256BasicOperation) {
   const uint32_t total_blocks = 5;
   BlockManager::Options options;
   options.num_blocks(total_blocks).block_size(block_size);
-  BlockManagerImpl block_manager(options);
+  UnshareForwardingBlockManager block_manager(options);
 
   PrefixCacheHashSha256 prefix_cache_hash(block_size);
+  block_manager.set_prefix_cache(&prefix_cache_hash);
 
   test_basic_operation(&block_manager, &prefix_cache_hash, block_size);
 }
@@ -75,9 +113,10 @@ TEST(PrefixCacheHashTest, Murmur3BasicOperation) {
   const uint32_t total_blocks = 5;
   BlockManager::Options options;
   options.num_blocks(total_blocks).block_size(block_size);
-  BlockManagerImpl block_manager(options);
+  UnshareForwardingBlockManager block_manager(options);
 
   PrefixCacheHashMurmur3 prefix_cache_hash(block_size);
+  block_manager.set_prefix_cache(&prefix_cache_hash);
 
   test_basic_operation(&block_manager, &prefix_cache_hash, block_size);
 }
@@ -112,6 +151,7 @@ void test_insert_operation(BlockManagerImpl* block_manager,
   {
     auto block_matched = prefix_cache_hash->match(slice_token_ids);
     EXPECT_EQ(block_matched.size(), n_blocks);
+    release_from_tail(&block_matched);
   }
 
   // insert another two-block
@@ -138,11 +178,13 @@ void test_insert_operation(BlockManagerImpl* block_manager,
   {
     auto block_matched = prefix_cache_hash->match(slice_token_ids_1);
     EXPECT_EQ(block_matched.size(), n_blocks);
+    release_from_tail(&block_matched);
   }
 
   {
     auto block_matched = prefix_cache_hash->match(slice_token_ids);
     EXPECT_EQ(block_matched.size(), n_blocks);
+    release_from_tail(&block_matched);
   }
 
   EXPECT_EQ(prefix_cache_hash->evict(1), 1);
@@ -156,6 +198,7 @@ void test_insert_operation(BlockManagerImpl* block_manager,
   {
     auto block_matched = prefix_cache_hash->match(slice_token_ids);
     EXPECT_EQ(block_matched.size(), n_blocks);
+    release_from_tail(&block_matched);
   }
 
   EXPECT_EQ(prefix_cache_hash->evict(1), 1);
@@ -179,6 +222,7 @@ void test_insert_operation(BlockManagerImpl* block_manager,
   {
     auto block_matched = prefix_cache_hash->match(slice_token_ids);
     EXPECT_EQ(block_matched.size(), n_blocks);
+    release_from_tail(&block_matched);
   }
 
   prefix_cache_hash->evict(1);
@@ -200,9 +244,10 @@ TEST(PrefixCacheHashTest, Sha256InsertOperation) {
   const uint32_t total_blocks = 5;
   BlockManager::Options options;
   options.num_blocks(total_blocks).block_size(block_size);
-  BlockManagerImpl block_manager(options);
+  UnshareForwardingBlockManager block_manager(options);
 
   PrefixCacheHashSha256 prefix_cache_hash(block_size);
+  block_manager.set_prefix_cache(&prefix_cache_hash);
 
   test_insert_operation(&block_manager, &prefix_cache_hash, block_size);
 }
@@ -212,9 +257,10 @@ TEST(PrefixCacheHashTest, MurmurInsertOperation) {
   const uint32_t total_blocks = 5;
   BlockManager::Options options;
   options.num_blocks(total_blocks).block_size(block_size);
-  BlockManagerImpl block_manager(options);
+  UnshareForwardingBlockManager block_manager(options);
 
   PrefixCacheHashMurmur3 prefix_cache_hash(block_size);
+  block_manager.set_prefix_cache(&prefix_cache_hash);
 
   test_insert_operation(&block_manager, &prefix_cache_hash, block_size);
 }
@@ -252,6 +298,7 @@ void test_evict_operation(BlockManagerImpl* block_manager,
   {
     auto block_matched = prefix_cache_hash->match(slice_token_ids);
     EXPECT_EQ(block_matched.size(), n_blocks);
+    release_from_tail(&block_matched);
   }
 
   EXPECT_EQ(block_manager->num_free_blocks(),
@@ -278,6 +325,7 @@ void test_evict_operation(BlockManagerImpl* block_manager,
   {
     auto block_matched = prefix_cache_hash->match(slice_token_ids);
     EXPECT_EQ(block_matched.size(), n_blocks);
+    release_from_tail(&block_matched);
   }
 }
 
@@ -286,9 +334,10 @@ TEST(PrefixCacheHashTest, Sha256EvictOperation) {
   const uint32_t total_blocks = 5;
   BlockManager::Options options;
   options.num_blocks(total_blocks).block_size(block_size);
-  BlockManagerImpl block_manager(options);
+  UnshareForwardingBlockManager block_manager(options);
 
   PrefixCacheHashSha256 prefix_cache_hash(block_size);
+  block_manager.set_prefix_cache(&prefix_cache_hash);
 
   test_evict_operation(&block_manager, &prefix_cache_hash, block_size);
 }
@@ -298,11 +347,265 @@ TEST(PrefixCacheHashTest, Murmur3EvictOperation) {
   const uint32_t total_blocks = 5;
   BlockManager::Options options;
   options.num_blocks(total_blocks).block_size(block_size);
-  BlockManagerImpl block_manager(options);
+  UnshareForwardingBlockManager block_manager(options);
 
   PrefixCacheHashMurmur3 prefix_cache_hash(block_size);
+  block_manager.set_prefix_cache(&prefix_cache_hash);
 
   test_evict_operation(&block_manager, &prefix_cache_hash, block_size);
 }
 
+TEST(PrefixCacheHashTest, UnshareOnLastSequenceRelease) {
+  const uint32_t block_size = 4;
+  const uint32_t total_blocks = 5;
+  BlockManager::Options options;
+  options.num_blocks(total_blocks).block_size(block_size);
+  UnshareForwardingBlockManager block_manager(options);
+
+  PrefixCacheHashMurmur3 prefix_cache_hash(block_size);
+  block_manager.set_prefix_cache(&prefix_cache_hash);
+
+  std::vector<int32_t> token_ids = {1, 2, 3, 4, 5, 6, 7, 8};
+  std::vector<Block> blocks = block_manager.allocate(2);
+  prefix_cache_hash.insert(token_ids, blocks);
+  EXPECT_EQ(prefix_cache_hash.num_evictable_blocks(), 0);
+
+  // temporary copies of cached and uncached blocks do not notify the cache
+  {
+    Block copy = blocks[0];
+    std::vector<Block> uncached_blocks = block_manager.allocate(1);
+    Block uncached_copy = uncached_blocks[0];
+  }
+  EXPECT_EQ(block_manager.num_unshares(), 0);
+
+  // a block shared by two sequences is evictable once both released it
+  std::vector<Block> matched = prefix_cache_hash.match(token_ids);
+  ASSERT_EQ(matched.size(), 2);
+  release_from_tail(&blocks);
+  EXPECT_EQ(block_manager.num_unshares(), 0);
+  EXPECT_EQ(prefix_cache_hash.num_evictable_blocks(), 0);
+
+  matched.pop_back();
+  EXPECT_EQ(block_manager.num_unshares(), 1);
+  EXPECT_EQ(prefix_cache_hash.num_evictable_blocks(), 1);
+  EXPECT_EQ(prefix_cache_hash.evict(2), 1);
+
+  matched.pop_back();
+  EXPECT_EQ(block_manager.num_unshares(), 2);
+  EXPECT_EQ(prefix_cache_hash.evict(2), 1);
+  EXPECT_EQ(prefix_cache_hash.num_blocks(), 0);
+}
+
+TEST(PrefixCacheHashTest, Murmur3HostOffload) {
+  const uint32_t block_size = 4;
+  const uint32_t total_blocks = 5;
+  BlockManager::Options options;
+  options.num_blocks(total_blocks).block_size(block_size);
+  UnshareForwardingBlockManager block_manager(options);
+
+  HostBlockPool host_block_pool(2);
+  BlockTransferLog block_transfer_log;
+  PrefixCacheHashMurmur3 prefix_cache_hash(block_size,
+                                           /*enable_service_routing=*/false,
+                                           &host_block_pool,
+                                           &block_transfer_log);
+  block_manager.set_prefix_cache(&prefix_cache_hash);
+
+  std::vector<int32_t> token_ids = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  Slice<int32_t> slice_token_ids(token_ids);
+  const uint32_t n_blocks = token_ids.size() / block_size;
+
+  {
+    std::vector<Block> token_blocks = block_manager.allocate(n_blocks);
+    prefix_cache_hash.insert(slice_token_ids, Slice<Block>(token_blocks));
+  }
+
+  // evicted device blocks are copied into host memory
+  EXPECT_EQ(prefix_cache_hash.evict(n_blocks), n_blocks);
+  EXPECT_EQ(prefix_cache_hash.num_blocks(), 0);
+  EXPECT_EQ(prefix_cache_hash.num_host_blocks(), n_blocks);
+  EXPECT_EQ(host_block_pool.num_free_blocks(), 0);
+  {
+    auto infos = block_transfer_log.take_block_transfer_infos();
+    ASSERT_EQ(infos.size(), n_blocks);
+    for (size_t i = 0; i < infos.size(); ++i) {
+      EXPECT_EQ(infos[i].transfer_type, TransferType::G2H);
+    }
+  }
+
+  EXPECT_EQ(prefix_cache_hash.match(slice_token_ids).size(), 0);
+  EXPECT_EQ(prefix_cache_hash.match_host(slice_token_ids, {}), n_blocks);
+
+  // swap the host blocks back into new device blocks
+  {
+    std::vector<Block> token_blocks = block_manager.allocate(n_blocks);
+    EXPECT_EQ(prefix_cache_hash.swap_in(
+                  slice_token_ids, {}, Slice<Block>(token_blocks)),
+              n_blocks);
+    auto infos = block_transfer_log.take_block_transfer_infos();
+    ASSERT_EQ(infos.size(), n_blocks);
+    for (size_t i = 0; i < infos.size(); ++i) {
+      EXPECT_EQ(infos[i].transfer_type, TransferType::H2G);
+      EXPECT_EQ(infos[i].dst_block_id, token_blocks[i].id());
+    }
+  }
+  EXPECT_EQ(prefix_cache_hash.num_blocks(), n_blocks);
+  EXPECT_EQ(prefix_cache_hash.match(slice_token_ids).size(), n_blocks);
+
+  // the host copies are still valid, evicting again needs no copy
+  EXPECT_EQ(prefix_cache_hash.evict(n_blocks), n_blocks);
+  EXPECT_TRUE(block_transfer_log.take_block_transfer_infos().empty());
+  EXPECT_EQ(prefix_cache_hash.num_host_blocks(), n_blocks);
+
+  // offloading other blocks reuses the least recently used host blocks
+  std::vector<int32_t> other_token_ids = {11, 12, 13, 14, 15, 16, 17, 18};
+  {
+    std::vector<Block> token_blocks = block_manager.allocate(n_blocks);
+    prefix_cache_hash.insert(other_token_ids, token_blocks);
+  }
+  EXPECT_EQ(prefix_cache_hash.evict(n_blocks), n_blocks);
+  EXPECT_EQ(block_transfer_log.take_block_transfer_infos().size(), n_blocks);
+  EXPECT_EQ(prefix_cache_hash.num_host_blocks(), n_blocks);
+  EXPECT_EQ(prefix_cache_hash.match_host(slice_token_ids, {}), 0);
+  EXPECT_EQ(prefix_cache_hash.match_host(Slice<int32_t>(other_token_ids), {}),
+            n_blocks);
+}
+
+TEST(PrefixCacheRadixTreeTest, PartialMatchSplitAndEvict) {
+  const uint32_t block_size = 4;
+  BlockManager::Options options;
+  options.num_blocks(10).block_size(block_size);
+  UnshareForwardingBlockManager block_manager(options);
+
+  PrefixCacheRadixTree prefix_cache(block_size);
+  block_manager.set_prefix_cache(&prefix_cache);
+
+  std::vector<int32_t> token_ids = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  std::vector<int32_t> other_token_ids = {1, 2, 3, 4, 5, 6, 20, 21};
+  {
+    std::vector<Block> blocks = block_manager.allocate(3);
+    EXPECT_EQ(prefix_cache.insert(token_ids, blocks), token_ids.size());
+    EXPECT_EQ(prefix_cache.num_blocks(), 3);
+
+    // diverge in the middle of the second block
+    size_t num_matched_tokens = 0;
+    auto matched = prefix_cache.match_partial(
+        Slice<int32_t>(other_token_ids), {}, &num_matched_tokens);
+    EXPECT_EQ(num_matched_tokens, 6);
+    ASSERT_EQ(matched.size(), 2);
+    EXPECT_EQ(matched[1].id(), blocks[1].id());
+    EXPECT_EQ(prefix_cache.match(other_token_ids).size(), 1);
+
+    // insert with a copy of the partially matched block splits the edge
+    std::vector<Block> other_blocks = {blocks[0]};
+    std::vector<Block> copied = block_manager.allocate(1);
+    other_blocks.push_back(copied[0]);
+    EXPECT_EQ(prefix_cache.insert(other_token_ids, other_blocks), 2);
+    EXPECT_EQ(prefix_cache.num_blocks(), 4);
+
+    matched = prefix_cache.match_partial(
+        Slice<int32_t>(other_token_ids), {}, &num_matched_tokens);
+    EXPECT_EQ(num_matched_tokens, other_token_ids.size());
+    ASSERT_EQ(matched.size(), 2);
+    EXPECT_EQ(matched[1].id(), copied[0].id());
+
+    matched = prefix_cache.match_partial(
+        Slice<int32_t>(token_ids), {}, &num_matched_tokens);
+    EXPECT_EQ(num_matched_tokens, token_ids.size());
+    ASSERT_EQ(matched.size(), 3);
+    EXPECT_EQ(matched[1].id(), blocks[1].id());
+
+    // blocks used by sequences are not evicted
+    EXPECT_EQ(prefix_cache.num_evictable_blocks(), 0);
+    EXPECT_EQ(prefix_cache.evict(1), 0);
+  }
+  EXPECT_EQ(prefix_cache.num_evictable_blocks(), 4);
+
+  // leaves are evicted first, then their parent
+  EXPECT_EQ(prefix_cache.evict(1), 1);
+  EXPECT_EQ(prefix_cache.num_blocks(), 3);
+  EXPECT_EQ(prefix_cache.evict(10), 3);
+  EXPECT_EQ(prefix_cache.num_blocks(), 0);
+  EXPECT_EQ(prefix_cache.num_evictable_blocks(), 0);
+  EXPECT_EQ(block_manager.num_free_blocks(), 9);
+}
+
+TEST(PrefixCacheRadixTreeTest, MatchWithExistedSharedBlocks) {
+  const uint32_t block_size = 4;
+  BlockManager::Options options;
+  options.num_blocks(10).block_size(block_size);
+  UnshareForwardingBlockManager block_manager(options);
+
+  PrefixCacheRadixTree prefix_cache(block_size);
+  block_manager.set_prefix_cache(&prefix_cache);
+
+  std::vector<int32_t> token_ids = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  {
+    std::vector<Block> blocks = block_manager.allocate(3);
+    prefix_cache.insert(token_ids, blocks);
+  }
+  EXPECT_EQ(prefix_cache.num_evictable_blocks(), 3);
+
+  {
+    // the sequence already holds the first block
+    std::vector<Block> existed_blocks = block_manager.allocate(1);
+    auto matched = prefix_cache.match(token_ids, existed_blocks);
+    ASSERT_EQ(matched.size(), 3);
+    EXPECT_EQ(matched[0].id(), existed_blocks[0].id());
+    EXPECT_EQ(prefix_cache.num_evictable_blocks(), 1);
+
+    // the existed blocks are kept when the tree diverges before their end
+    std::vector<int32_t> other_token_ids = {1, 2, 3, 4, 20, 21, 22, 23, 24};
+    existed_blocks = matched;
+    existed_blocks.pop_back();
+    size_t num_matched_tokens = 0;
+    auto partial = prefix_cache.match_partial(
+        Slice<int32_t>(other_token_ids), existed_blocks, &num_matched_tokens);
+    EXPECT_EQ(num_matched_tokens, 2 * block_size);
+    ASSERT_EQ(partial.size(), 2);
+    EXPECT_EQ(partial[1].id(), matched[1].id());
+  }
+  EXPECT_EQ(prefix_cache.num_evictable_blocks(), 3);
+  EXPECT_EQ(prefix_cache.evict(10), 3);
+  EXPECT_EQ(block_manager.num_free_blocks(), 9);
+}
+
+TEST(PrefixCacheRadixTreeTest, CopyOnWriteInBlockManager) {
+  const uint32_t block_size = 4;
+  BlockManager::Options options;
+  options.num_blocks(10).block_size(block_size).prefix_cache_policy(
+      "radix_tree");
+  BlockManagerImpl block_manager(options);
+
+  {
+    std::vector<int32_t> token_ids = {1, 2, 3, 4, 5, 6, 7, 8};
+    std::vector<Block> blocks = block_manager.allocate(2);
+    block_manager.cache(Slice<int32_t>(token_ids), Slice<Block>(blocks));
+
+    std::vector<int32_t> other_token_ids = {1, 2, 3, 4, 5, 6, 20};
+    size_t num_shared_tokens = 0;
+    auto shared_blocks = block_manager.allocate_shared(
+        Slice<int32_t>(other_token_ids), {}, &num_shared_tokens);
+    EXPECT_EQ(num_shared_tokens, 6);
+    ASSERT_EQ(shared_blocks.size(), 2);
+    EXPECT_EQ(shared_blocks[0].id(), blocks[0].id());
+    EXPECT_NE(shared_blocks[1].id(), blocks[1].id());
+
+    auto infos = block_manager.take_block_transfer_infos();
+    ASSERT_EQ(infos.size(), 1);
+    EXPECT_EQ(infos[0].transfer_type, TransferType::G2G);
+    EXPECT_EQ(infos[0].src_block_id, blocks[1].id());
+    EXPECT_EQ(infos[0].dst_block_id, shared_blocks[1].id());
+
+    // without a copy only full blocks are shared
+    shared_blocks =
+        block_manager.allocate_shared(Slice<int32_t>(other_token_ids));
+    EXPECT_EQ(shared_blocks.size(), 1);
+    EXPECT_TRUE(block_manager.take_block_transfer_infos().empty());
+  }
+
+  // evict the cached blocks
+  EXPECT_EQ(block_manager.allocate(9).size(), 9);
+}
+
 }  // namespace xllm
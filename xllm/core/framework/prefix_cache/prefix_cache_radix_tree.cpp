@@ -0,0 +1,333 @@
+#include "prefix_cache_radix_tree.h"
+
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+#include <glog/logging.h>
+
+#include "common/metrics.h"
+
+namespace xllm {
+
+PrefixCacheRadixTree::PrefixCacheRadixTree(uint32_t block_size)
+    : block_size_(block_size) {
+  CHECK_GT(block_size_, 0) << "Block size must be positive";
+}
+
+PrefixCacheRadixTree::~PrefixCacheRadixTree() {
+  LOG(INFO) << "block matched rate: " << block_match_rate();
+  for (auto& [_, child] : root_.children) {
+    delete_subtree(child);
+  }
+}
+
+void PrefixCacheRadixTree::delete_subtree(Node* node) {
+  for (auto& [_, child] : node->children) {
+    delete_subtree(child);
+  }
+  // the blocks outliving the prefix cache must not notify it
+  for (auto& block : node->blocks) {
+    block.set_cached(false);
+  }
+  delete node;
+}
+
+std::vector<Block> PrefixCacheRadixTree::match(
+    const Slice<int32_t>& token_ids,
+    const Slice<Block>& existed_shared_blocks) {
+  const size_t n_blocks = token_ids.size() / block_size_;
+  if (n_blocks == 0) {
+    return std::vector<Block>();
+  }
+
+  std::vector<Block> blocks;
+  const size_t n_matched_tokens =
+      match_tokens(token_ids, existed_shared_blocks, &blocks);
+  // only return full blocks
+  blocks.resize(n_matched_tokens / block_size_);
+
+  update_match_metrics(n_blocks, blocks.size());
+  return blocks;
+}
+
+std::vector<Block> PrefixCacheRadixTree::match_partial(
+    const Slice<int32_t>& token_ids,
+    const Slice<Block>& existed_shared_blocks,
+    size_t* num_matched_tokens) {
+  *num_matched_tokens = 0;
+  if (token_ids.empty()) {
+    return std::vector<Block>();
+  }
+
+  std::vector<Block> blocks;
+  *num_matched_tokens =
+      match_tokens(token_ids, existed_shared_blocks, &blocks);
+
+  const size_t n_blocks = (token_ids.size() + block_size_ - 1) / block_size_;
+  update_match_metrics(n_blocks, blocks.size());
+  return blocks;
+}
+
+size_t PrefixCacheRadixTree::match_tokens(
+    const Slice<int32_t>& token_ids,
+    const Slice<Block>& existed_shared_blocks,
+    std::vector<Block>* blocks) {
+  const int64_t now = absl::ToUnixMicros(absl::Now());
+  blocks->assign(existed_shared_blocks.begin(), existed_shared_blocks.end());
+  const size_t n_existed_tokens = std::min(
+      existed_shared_blocks.size() * block_size_, token_ids.size());
+
+  Node* node = &root_;
+  size_t pos = 0;
+  while (pos < token_ids.size()) {
+    auto iter = node->children.find(token_ids[pos]);
+    if (iter == node->children.end()) {
+      break;
+    }
+
+    Node* child = iter->second;
+    const size_t len =
+        common_prefix_length(child->token_ids, token_ids.slice(pos));
+    touch(child, now);
+
+    // a deeper node holds the copy of a block that is valid for the path
+    const size_t last_block_idx = (pos + len - 1) / block_size_;
+    for (size_t i = 0; i < child->blocks.size(); ++i) {
+      const size_t block_idx = child->first_block_idx + i;
+      if (block_idx > last_block_idx) {
+        break;
+      }
+      if (block_idx < existed_shared_blocks.size()) {
+        // the sequence already holds the block
+        continue;
+      }
+      if (block_idx < blocks->size()) {
+        share_block(child, i, &(*blocks)[block_idx]);
+      } else {
+        share_block(child, i, &blocks->emplace_back());
+      }
+    }
+
+    pos += len;
+    if (len < child->token_ids.size()) {
+      break;
+    }
+    node = child;
+  }
+  return std::max(pos, n_existed_tokens);
+}
+
+void PrefixCacheRadixTree::share_block(Node* node, size_t idx, Block* block) {
+  const Block& cached_block = node->blocks[idx];
+  if (cached_block.ref_count() == 1) {
+    // the first sequence using the block
+    unlink_leaf(node);
+    ++node->num_in_use_blocks;
+    --num_evictable_blocks_;
+  }
+  *block = cached_block;
+}
+
+size_t PrefixCacheRadixTree::insert(const Slice<int32_t>& token_ids,
+                                    const Slice<Block>& blocks) {
+  const int64_t now = absl::ToUnixMicros(absl::Now());
+  const size_t n_tokens =
+      std::min(token_ids.size(), blocks.size() * block_size_);
+  if (n_tokens == 0) {
+    return 0;
+  }
+
+  Node* node = &root_;
+  // the block of the path holding the last matched position
+  const Block* path_block = nullptr;
+  size_t pos = 0;
+  while (pos < n_tokens) {
+    auto iter = node->children.find(token_ids[pos]);
+    if (iter == node->children.end()) {
+      const size_t block_idx = pos / block_size_;
+      if (path_block != nullptr && pos % block_size_ != 0 &&
+          path_block->id() != blocks[block_idx].id()) {
+        // the sequence holds its own copy of the boundary block
+        path_block = nullptr;
+      }
+      add_node(node, token_ids, blocks, pos, n_tokens, path_block, now);
+      return n_tokens - pos;
+    }
+
+    Node* child = iter->second;
+    const size_t len = common_prefix_length(child->token_ids,
+                                            token_ids.slice(pos, n_tokens));
+    if (len < child->token_ids.size()) {
+      child = split_node(child, len);
+    }
+    touch(child, now);
+    if (!child->blocks.empty()) {
+      path_block = &child->blocks.back();
+    }
+
+    pos += len;
+    node = child;
+  }
+  return 0;
+}
+
+PrefixCacheRadixTree::Node* PrefixCacheRadixTree::split_node(Node* node,
+                                                             size_t offset) {
+  CHECK(offset > 0 && offset < node->token_ids.size());
+
+  Node* upper = new Node();
+  upper->start = node->start;
+  upper->token_ids.assign(node->token_ids.begin(),
+                          node->token_ids.begin() + offset);
+  upper->first_block_idx = node->first_block_idx;
+  upper->parent = node->parent;
+  upper->last_access_time = node->last_access_time;
+  unlink_leaf(node);
+
+  // blocks covering positions before the split point move to the upper node,
+  // a block containing the split point is shared by the lower node.
+  const size_t upper_last_block_idx = (node->start + offset - 1) / block_size_;
+  const size_t n_upper_blocks =
+      upper_last_block_idx >= node->first_block_idx
+          ? std::min(upper_last_block_idx - node->first_block_idx + 1,
+                     node->blocks.size())
+          : 0;
+  upper->blocks.assign(std::make_move_iterator(node->blocks.begin()),
+                       std::make_move_iterator(node->blocks.begin() +
+                                               n_upper_blocks));
+  node->blocks.erase(node->blocks.begin(),
+                     node->blocks.begin() + n_upper_blocks);
+  node->first_block_idx += n_upper_blocks;
+  for (const auto& block : upper->blocks) {
+    block_nodes_[block.id()] = upper;
+    if (block.is_shared()) {
+      ++upper->num_in_use_blocks;
+      --node->num_in_use_blocks;
+    }
+  }
+
+  node->token_ids.erase(node->token_ids.begin(),
+                        node->token_ids.begin() + offset);
+  node->start += offset;
+  node->parent = upper;
+
+  upper->parent->children[upper->token_ids[0]] = upper;
+  upper->children.emplace(node->token_ids[0], node);
+  link_leaf(node);
+  return upper;
+}
+
+void PrefixCacheRadixTree::add_node(Node* parent,
+                                    const Slice<int32_t>& token_ids,
+                                    const Slice<Block>& blocks,
+                                    size_t start,
+                                    size_t end,
+                                    const Block* path_block,
+                                    int64_t now) {
+  Node* node = new Node();
+  node->start = start;
+  node->token_ids.assign(token_ids.begin() + start, token_ids.begin() + end);
+  node->parent = parent;
+  node->last_access_time = now;
+
+  // skip the boundary block already held by the path
+  size_t first_block_idx = start / block_size_;
+  if (path_block != nullptr && start % block_size_ != 0) {
+    ++first_block_idx;
+  }
+  const size_t last_block_idx = (end - 1) / block_size_;
+  node->first_block_idx = first_block_idx;
+  for (size_t i = first_block_idx; i <= last_block_idx; ++i) {
+    add_block(node, blocks[i]);
+  }
+
+  unlink_leaf(parent);
+  parent->children.emplace(node->token_ids[0], node);
+  link_leaf(node);
+}
+
+void PrefixCacheRadixTree::touch(Node* node, int64_t now) {
+  unlink_leaf(node);
+  node->last_access_time = now;
+  link_leaf(node);
+}
+
+void PrefixCacheRadixTree::add_block(Node* node, const Block& block) {
+  node->blocks.push_back(block);
+  Block& cached_block = node->blocks.back();
+  cached_block.set_cached(true);
+  if (cached_block.is_shared()) {
+    ++node->num_in_use_blocks;
+  } else {
+    ++num_evictable_blocks_;
+  }
+
+  const int32_t block_id = cached_block.id();
+  if (block_id >= block_nodes_.size()) {
+    block_nodes_.resize(block_id + 1, nullptr);
+  }
+  block_nodes_[block_id] = node;
+  ++num_blocks_;
+}
+
+void PrefixCacheRadixTree::unshare(int32_t block_id) {
+  if (block_id < 0 || block_id >= block_nodes_.size()) {
+    return;
+  }
+  Node* node = block_nodes_[block_id];
+  if (node == nullptr || node->num_in_use_blocks == 0) {
+    return;
+  }
+  unlink_leaf(node);
+  --node->num_in_use_blocks;
+  ++num_evictable_blocks_;
+  link_leaf(node);
+}
+
+void PrefixCacheRadixTree::unlink_leaf(Node* node) {
+  evictable_leaves_.erase({node->last_access_time, node});
+}
+
+void PrefixCacheRadixTree::link_leaf(Node* node) {
+  if (node != &root_ && node->children.empty() &&
+      node->num_in_use_blocks == 0) {
+    evictable_leaves_.emplace(node->last_access_time, node);
+  }
+}
+
+size_t PrefixCacheRadixTree::evict(size_t n_blocks) {
+  // evict from the least recently used leaves, a parent becomes a candidate
+  // once all its children are evicted.
+  size_t evict_count = 0;
+  while (evict_count < n_blocks && !evictable_leaves_.empty()) {
+    Node* leaf = evictable_leaves_.begin()->second;
+    evictable_leaves_.erase(evictable_leaves_.begin());
+
+    for (auto& block : leaf->blocks) {
+      block_nodes_[block.id()] = nullptr;
+      block.set_cached(false);
+    }
+    evict_count += leaf->blocks.size();
+    num_blocks_ -= leaf->blocks.size();
+    num_evictable_blocks_ -= leaf->blocks.size();
+
+    Node* parent = leaf->parent;
+    parent->children.erase(leaf->token_ids[0]);
+    delete leaf;
+    link_leaf(parent);
+  }
+
+  return evict_count;
+}
+
+void PrefixCacheRadixTree::update_match_metrics(size_t n_blocks,
+                                                size_t n_matched_blocks) {
+  total_blocks_.fetch_add(n_blocks);
+  matched_blocks_.fetch_add(n_matched_blocks);
+
+  int64_t int_rate_percent = static_cast<int64_t>(
+      static_cast<double>(n_matched_blocks) * 100.0 / n_blocks);
+  HISTOGRAM_OBSERVE(prefix_cache_block_matched_rate, int_rate_percent);
+  HISTOGRAM_OBSERVE(prefix_cache_block_matched_num, n_matched_blocks);
+}
+
+}  // namespace xllm
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <glog/logging.h>
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "prefix_cache.h"
+
+namespace xllm {
+
+// Prefix cache built on a compressed radix tree over token ids. Unlike the
+// hash based prefix caches, it matches at token granularity: the last matched
+// block may be only partially matched, in which case the block manager copies
+// it into a new block before the sequence writes into it (copy-on-write).
+//
+// Each node holds the tokens on the edge from its parent and the blocks
+// covering those token positions. For a block spanning several nodes, the
+// deepest node on the matched path holding it has the valid copy.
+class PrefixCacheRadixTree final : public PrefixCache {
+ public:
+  explicit PrefixCacheRadixTree(uint32_t block_size);
+
+  ~PrefixCacheRadixTree();
+
+  // match the token ids with the radix tree
+  // return matched full blocks
+  std::vector<Block> match(
+      const Slice<int32_t>& token_ids,
+      const Slice<Block>& existed_shared_blocks = {}) override;
+
+  // match the token ids with the radix tree at token granularity
+  // return matched blocks, the last one may be partially matched
+  std::vector<Block> match_partial(const Slice<int32_t>& token_ids,
+                                   const Slice<Block>& existed_shared_blocks,
+                                   size_t* num_matched_tokens) override;
+
+  // insert the token ids and blocks into the radix tree
+  // return the length of new inserted tokens
+  size_t insert(const Slice<int32_t>& token_ids,
+                const Slice<Block>& blocks) override;
+
+  // evict least recently used leaves whose blocks are not in use
+  // return the actual number of evicted blocks
+  size_t evict(size_t n_blocks) override;
+
+  // get the number of blocks in the prefix cache
+  size_t num_blocks() const override { return num_blocks_; }
+
+  // the block is no longer used by any sequence
+  void unshare(int32_t block_id) override;
+
+  size_t num_evictable_blocks() const override { return num_evictable_blocks_; }
+
+  // kv cache events are not supported for service routing
+  KvCacheEvent* get_upload_kvcache_events() override { return nullptr; }
+
+ private:
+  struct Node {
+    // position of the first token on the edge
+    size_t start = 0;
+
+    // token ids on the edge from the parent
+    std::vector<int32_t> token_ids;
+
+    // index of the first block in `blocks`. An edge starting in the middle
+    // of a block shares that block with its ancestors unless it holds its
+    // own copy, so every block is held by exactly one node.
+    size_t first_block_idx = 0;
+
+    // blocks covering the token positions on the edge
+    std::vector<Block> blocks;
+
+    Node* parent = nullptr;
+
+    // children keyed by the first token on their edges
+    std::unordered_map<int32_t, Node*> children;
+
+    // the last access time of the node, used to evict leaves
+    int64_t last_access_time = 0;
+
+    // number of blocks of the node used by sequences
+    size_t num_in_use_blocks = 0;
+
+    size_t end() const { return start + token_ids.size(); }
+  };
+
+  // walk down the tree along the token ids, return the number of matched
+  // tokens and the blocks covering them. The blocks already held by the
+  // sequence are used instead of the cached ones.
+  size_t match_tokens(const Slice<int32_t>& token_ids,
+                      const Slice<Block>& existed_shared_blocks,
+                      std::vector<Block>* blocks);
+
+  // split the edge of the node at offset, return the new upper node
+  Node* split_node(Node* node, size_t offset);
+
+  // add a leaf holding token ids [start, end) under the parent.
+  // `path_block` is the block of the path covering position start, if any.
+  void add_node(Node* parent,
+                const Slice<int32_t>& token_ids,
+                const Slice<Block>& blocks,
+                size_t start,
+                size_t end,
+                const Block* path_block,
+                int64_t now);
+
+  // update the last access time of the node, keeping its leaf order
+  void touch(Node* node, int64_t now);
+
+  // append the block to the node and take it over from the sequence
+  void add_block(Node* node, const Block& block);
+
+  // copy the block of the node for a sequence
+  void share_block(Node* node, size_t idx, Block* block);
+
+  // remove the node from the evictable leaves before changing it
+  void unlink_leaf(Node* node);
+
+  // add the node to the evictable leaves if it is a leaf not used by sequences
+  void link_leaf(Node* node);
+
+  void update_match_metrics(size_t n_blocks, size_t n_matched_blocks);
+
+  void delete_subtree(Node* node);
+
+  // the block size of the memory blocks
+  uint32_t block_size_;
+
+  // the total number of blocks in the prefix cache
+  size_t num_blocks_ = 0;
+
+  Node root_;
+
+  // the number of cached blocks not used by any sequence
+  size_t num_evictable_blocks_ = 0;
+
+  // nodes indexed by the ids of the blocks they hold
+  std::vector<Node*> block_nodes_;
+
+  // nodes without children whose blocks are not used by sequences, ordered
+  // by their last access time, the least recently used first
+  std::set<std::pair<int64_t, Node*>> evictable_leaves_;
+};
+
+}  // namespace xllm
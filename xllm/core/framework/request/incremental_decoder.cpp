@@ -4,7 +4,6 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <sstream>
 #include <string>
 
 namespace xllm {
@@ -25,14 +24,14 @@ IncrementalDecoder::IncrementalDecoder(const std::string_view& prompt,
 
 std::string IncrementalDecoder::decode(const Slice<int32_t>& token_ids,
                                        const Tokenizer& tokenizer) {
-  std::stringstream ss;
+  std::string text;
   // return prompt directly if prompt string is not empty
   if (output_offset_ < num_prompt_tokens_ && !prompt_.empty()) {
     // leave 6 tokens for the prefix to defeat cleanup algorithms in decode
     // which decide to add a space or not depending on the surrouding ids.
     prefix_offset_ = num_prompt_tokens_ <= 6 ? 0 : num_prompt_tokens_ - 6;
     output_offset_ = num_prompt_tokens_;
-    ss << prompt_;
+    text.append(prompt_);
   }
 
   // In PD mode, if a prefill token can directly generate characters, the decode
@@ -48,6 +47,23 @@ std::string IncrementalDecoder::decode(const Slice<int32_t>& token_ids,
     checking_prefill_token_ = false;
   }
 
+  if (tokenizer.support_stream_decode()) {
+    // only decode the tokens after output_offset_, the tokens of an unfinished
+    // utf-8 character are kept until the character is complete.
+    if (output_offset_ >= token_ids.size()) {
+      return text;
+    }
+    const size_t text_size = text.size();
+    if (tokenizer.stream_decode(token_ids.slice(output_offset_),
+                                skip_special_tokens_,
+                                &text) &&
+        text.size() > text_size) {
+      prefix_offset_ = output_offset_;
+      output_offset_ = token_ids.size();
+    }
+    return text;
+  }
+
   const auto prefix_text = tokenizer.decode(
       token_ids.slice(prefix_offset_, output_offset_), skip_special_tokens_);
   const auto new_text =
@@ -58,9 +74,27 @@ std::string IncrementalDecoder::decode(const Slice<int32_t>& token_ids,
     prefix_offset_ = output_offset_;
     output_offset_ = token_ids.size();
     // only print the delta text
-    ss << new_text.substr(prefix_text.size());
+    text.append(new_text, prefix_text.size());
+  }
+  return text;
+}
+
+bool IncrementalDecoder::can_decode_in_one_pass() const {
+  // the prompt is returned as is and the prefix tokens change the decoded
+  // text, only the tokens without any prefix can be decoded in one pass.
+  return prefix_offset_ == output_offset_ && !checking_prefill_token_ &&
+         (output_offset_ >= num_prompt_tokens_ || prompt_.empty());
+}
+
+bool IncrementalDecoder::accept_decoded_text(const std::string& text,
+                                             size_t end) {
+  if (!can_decode_in_one_pass() || end <= output_offset_ || text.empty() ||
+      absl::EndsWith(text, "�")) {
+    return false;
   }
-  return ss.str();
+  prefix_offset_ = output_offset_;
+  output_offset_ = end;
+  return true;
 }
 
 }  // namespace xllm
@@ -21,6 +21,15 @@ class IncrementalDecoder final {
   std::string decode(const Slice<int32_t>& token_ids,
                      const Tokenizer& tokenizer);
 
+  // whether the tokens after output_offset() can be decoded by a single
+  // tokenizer.decode() call, so that they can be decoded in a batch.
+  bool can_decode_in_one_pass() const;
+
+  // accept the text decoded from the tokens in [output_offset(), end),
+  // returns false if the text may end with an unfinished utf-8 character
+  // and the tokens should be decoded incrementally instead.
+  bool accept_decoded_text(const std::string& text, size_t end);
+
   // get the offset of the output text
   size_t output_offset() const { return output_offset_; }
 
@@ -0,0 +1,72 @@
+#include "mm_data_cache.h"
+
+#include <openssl/sha.h>
+
+namespace xllm {
+namespace {
+
+size_t num_bytes_of(const MMData& mm_data) {
+  size_t num_bytes = 0;
+  for (const auto& [key, value] : mm_data.data()) {
+    if (std::holds_alternative<torch::Tensor>(value)) {
+      num_bytes += std::get<torch::Tensor>(value).nbytes();
+    } else {
+      for (const auto& tensor : std::get<std::vector<torch::Tensor>>(value)) {
+        num_bytes += tensor.nbytes();
+      }
+    }
+  }
+  return num_bytes;
+}
+
+}  // namespace
+
+MMDataCache::MMDataCache(size_t capacity_bytes)
+    : capacity_bytes_(capacity_bytes) {}
+
+std::string MMDataCache::hash(std::string_view raw_data) {
+  std::string digest(SHA256_DIGEST_LENGTH, '\0');
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  SHA256(reinterpret_cast<const uint8_t*>(raw_data.data()),
+         raw_data.size(),
+         reinterpret_cast<uint8_t*>(digest.data()));
+  return digest;
+}
+
+std::optional<MMData> MMDataCache::get(const std::string& key) {
+  absl::MutexLock lock(&mutex_);
+  const auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return std::nullopt;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->mm_data;
+}
+
+void MMDataCache::put(const std::string& key, const MMData& mm_data) {
+  const size_t num_bytes = num_bytes_of(mm_data);
+  if (num_bytes > capacity_bytes_) {
+    return;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  if (entries_.contains(key)) {
+    return;
+  }
+  while (size_bytes_ + num_bytes > capacity_bytes_) {
+    const Entry& victim = lru_.back();
+    size_bytes_ -= victim.num_bytes;
+    entries_.erase(victim.key);
+    lru_.pop_back();
+  }
+  lru_.push_front(Entry{key, mm_data, num_bytes});
+  entries_[key] = lru_.begin();
+  size_bytes_ += num_bytes;
+}
+
+size_t MMDataCache::size_bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return size_bytes_;
+}
+
+}  // namespace xllm
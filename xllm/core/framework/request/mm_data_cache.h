@@ -0,0 +1,56 @@
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "mm_data.h"
+
+namespace xllm {
+
+// A bounded LRU cache of processed multimodal data in host memory, keyed by
+// the content hashes of the raw inputs. A cache serves a single processor, so
+// the processor config is implicitly part of the key.
+//
+// The cached tensors are shared with the requests and must not be modified.
+class MMDataCache final {
+ public:
+  explicit MMDataCache(size_t capacity_bytes);
+
+  // the sha256 digest of the raw data
+  static std::string hash(std::string_view raw_data);
+
+  // get the data and mark it as recently used, nullopt if not cached.
+  std::optional<MMData> get(const std::string& key);
+
+  // cache the data, evicting the least recently used ones to stay within the
+  // capacity. data larger than the capacity is not cached.
+  void put(const std::string& key, const MMData& mm_data);
+
+  size_t size_bytes() const;
+
+ private:
+  struct Entry {
+    std::string key;
+    MMData mm_data;
+    size_t num_bytes = 0;
+  };
+
+  const size_t capacity_bytes_;
+
+  mutable absl::Mutex mutex_;
+
+  size_t size_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  // the most recently used entry first
+  std::list<Entry> lru_ ABSL_GUARDED_BY(mutex_);
+
+  absl::flat_hash_map<std::string, std::list<Entry>::iterator> entries_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xllm
@@ -0,0 +1,58 @@
+#include "mm_data_cache.h"
+
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+namespace xllm {
+
+namespace {
+
+// an image of num_bytes bytes of processed data
+MMData make_data(int64_t num_bytes) {
+  return MMData(MMType::IMAGE,
+                {{"pixel_values", torch::zeros({num_bytes}, torch::kUInt8)}});
+}
+
+}  // namespace
+
+TEST(MMDataCacheTest, Hash) {
+  EXPECT_EQ(MMDataCache::hash("image"), MMDataCache::hash("image"));
+  EXPECT_NE(MMDataCache::hash("image"), MMDataCache::hash("images"));
+  EXPECT_EQ(MMDataCache::hash("image").size(), 32);
+}
+
+TEST(MMDataCacheTest, GetAndPut) {
+  MMDataCache cache(1024);
+  EXPECT_FALSE(cache.get("a").has_value());
+
+  const auto data = make_data(100);
+  cache.put("a", data);
+  const auto cached = cache.get("a");
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_TRUE(torch::equal(cached->get<torch::Tensor>("pixel_values").value(),
+                           data.get<torch::Tensor>("pixel_values").value()));
+  EXPECT_EQ(cache.size_bytes(), 100);
+}
+
+TEST(MMDataCacheTest, EvictLeastRecentlyUsed) {
+  MMDataCache cache(300);
+  cache.put("a", make_data(100));
+  cache.put("b", make_data(100));
+  cache.put("c", make_data(100));
+  // a is used after b
+  EXPECT_TRUE(cache.get("a").has_value());
+
+  cache.put("d", make_data(150));
+  EXPECT_TRUE(cache.get("a").has_value());
+  EXPECT_FALSE(cache.get("b").has_value());
+  EXPECT_FALSE(cache.get("c").has_value());
+  EXPECT_TRUE(cache.get("d").has_value());
+  EXPECT_EQ(cache.size_bytes(), 250);
+
+  // larger than the whole cache
+  cache.put("e", make_data(400));
+  EXPECT_FALSE(cache.get("e").has_value());
+  EXPECT_EQ(cache.size_bytes(), 250);
+}
+
+}  // namespace xllm
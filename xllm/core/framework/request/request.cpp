@@ -4,6 +4,7 @@
 #include <absl/time/time.h>
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -51,6 +52,27 @@ bool Request::expand_sequences(bool share_prefix) {
   return sequences_group_->expand_sequences(share_prefix);
 }
 
+absl::Time Request::ttft_deadline(absl::Duration default_ttft_slo) const {
+  if (!state_.ttft_slo_ms.has_value()) {
+    return created_time_ + default_ttft_slo;
+  }
+  return created_time_ + absl::Milliseconds(state_.ttft_slo_ms.value());
+}
+
+absl::Time Request::tpot_deadline() {
+  absl::Time deadline = absl::InfiniteFuture();
+  if (!state_.tpot_slo_ms.has_value()) {
+    return deadline;
+  }
+  const auto tpot = absl::Milliseconds(state_.tpot_slo_ms.value());
+  for (const auto& seq : sequences()) {
+    if (!seq->finished()) {
+      deadline = std::min(deadline, seq->latest_generate_time() + tpot);
+    }
+  }
+  return deadline;
+}
+
 void Request::log_statistic(double total_latency) {
   // log the request statistics
   int idx = 0;
@@ -51,6 +51,18 @@ class Request {
 
   bool preempted() const { return state_.preempted; }
 
+  RequestPriority priority() const { return state_.priority; }
+
+  const std::string& tenant() const { return state_.tenant; }
+
+  // the deadline of the first token, default_ttft_slo after the arrival if
+  // the request has no ttft slo.
+  absl::Time ttft_deadline(absl::Duration default_ttft_slo) const;
+
+  // the earliest deadline of the next token of the unfinished sequences,
+  // absl::InfiniteFuture() if the request has no tpot slo.
+  absl::Time tpot_deadline();
+
   void log_statistic(double total_latency);
 
   void log_error_statistic(Status status);
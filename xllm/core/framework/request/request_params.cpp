@@ -83,6 +83,16 @@ RequestParams::RequestParams(const proto::CompletionRequest& request,
     stop_token_ids = std::vector<int32_t>(request.stop_token_ids().begin(),
                                           request.stop_token_ids().end());
   }
+  if (request.has_priority()) {
+    priority = static_cast<RequestPriority>(request.priority());
+  }
+  if (request.has_ttft_slo_ms()) {
+    ttft_slo_ms = request.ttft_slo_ms();
+  }
+  if (request.has_tpot_slo_ms()) {
+    tpot_slo_ms = request.tpot_slo_ms();
+  }
+  tenant = request.user();
   if (request.has_stream()) {
     const size_t best_of_value = best_of.value_or(n);
     if (request.stream() && best_of_value == n) {
@@ -220,6 +230,16 @@ void InitFromChatRequest(RequestParams& params, const ChatRequest& request) {
     params.stop_token_ids = std::vector<int32_t>(
         request.stop_token_ids().begin(), request.stop_token_ids().end());
   }
+  if (request.has_priority()) {
+    params.priority = static_cast<RequestPriority>(request.priority());
+  }
+  if (request.has_ttft_slo_ms()) {
+    params.ttft_slo_ms = request.ttft_slo_ms();
+  }
+  if (request.has_tpot_slo_ms()) {
+    params.tpot_slo_ms = request.tpot_slo_ms();
+  }
+  params.tenant = request.user();
   if (request.has_stream()) {
     const size_t best_of_value = params.best_of.value_or(params.n);
     if (request.stream() && best_of_value == params.n) {
@@ -336,6 +356,13 @@ bool RequestParams::verify_params(OutputCallback callback) const {
                         "frequency_penalty must be between 0.0 and 2.0");
     return false;
   }
+
+  // priority between [HIGH, LOW]
+  if (priority < RequestPriority::HIGH || priority > RequestPriority::LOW) {
+    CALLBACK_WITH_ERROR(StatusCode::INVALID_ARGUMENT,
+                        "priority must be between 0 and 2");
+    return false;
+  }
   return true;
 }
 
@@ -104,6 +104,21 @@ struct RequestParams {
   // decode address.
   std::string decode_address;
 
+  // priority class of the request. default = MEDIUM
+  RequestPriority priority = RequestPriority::MEDIUM;
+
+  // the expected time to first token, requests closer to the deadline are
+  // scheduled first within the same priority class.
+  std::optional<uint32_t> ttft_slo_ms;
+
+  // the expected time per output token, requests with more slack are
+  // preempted first within the same priority class.
+  std::optional<uint32_t> tpot_slo_ms;
+
+  // the tenant of the request, taken from the `user` field. used for per
+  // tenant rate limiting and fair share scheduling.
+  std::string tenant;
+
   // JSON-based tools (replacing proto_tools)
   std::vector<xllm::JsonTool> tools;
   std::string tool_choice = "auto";
@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <deque>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -103,6 +104,16 @@ struct RequestState final {
   // decode address.
   std::string decode_address;
 
+  // priority class of the request
+  RequestPriority priority = RequestPriority::MEDIUM;
+
+  // the expected time to first token and time per output token
+  std::optional<uint32_t> ttft_slo_ms;
+  std::optional<uint32_t> tpot_slo_ms;
+
+  // the tenant the request belongs to, empty if unknown
+  std::string tenant;
+
   torch::Tensor input_embedding;
 
   // multimodal
@@ -118,6 +129,10 @@ struct RequestState final {
   // multi-threaded stream processing.
   int32_t response_thread_id = -1;
 
+  // the time the last streaming output was scheduled, the outputs of the
+  // following steps are coalesced until FLAGS_stream_flush_interval_ms passed.
+  absl::Time last_stream_flush_time = absl::InfinitePast();
+
   bool preempted = false;
 
   // This will be used in enable_scheduler_overlap
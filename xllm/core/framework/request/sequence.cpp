@@ -5,6 +5,7 @@
 #include <absl/time/time.h>
 #include <glog/logging.h>
 
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <optional>
@@ -18,6 +19,14 @@
 
 namespace xllm {
 
+namespace {
+std::atomic<uint64_t> next_sequence_id{1};
+
+// the number of recent unique token updates kept for the delta encoding,
+// far more than the tokens a sequence gets in one step.
+constexpr size_t kNumKeptUniqueTokenUpdates = 128;
+}  // namespace
+
 Sequence::Sequence(size_t index,
                    const std::vector<int32_t>& prompt_token_ids,
                    torch::Tensor input_embedding,
@@ -25,6 +34,7 @@ Sequence::Sequence(size_t index,
                    const IncrementalDecoder& decoder,
                    const SequenceParams& seq_params)
     : index_(index),
+      id_(next_sequence_id.fetch_add(1, std::memory_order_relaxed)),
       mm_data_(mm_data),
       latest_generate_time_(absl::Now()),
       sequence_params_(seq_params),
@@ -43,8 +53,11 @@ Sequence::Sequence(size_t index,
   // add the prompt tokens
   for (const auto token_id : prompt_token_ids) {
     tokens_[num_tokens_++] = token_id;
-    token_to_count_map_[token_id]++;
+    count_token(token_id);
   }
+  // a new sequence is always sent with its whole counts
+  num_trimmed_unique_token_updates_ = unique_token_updates_.size();
+  unique_token_updates_.clear();
   input_embedding_ = input_embedding;
   cur_generated_token_idx_ = num_prompt_tokens_;
 }
@@ -85,7 +98,7 @@ void Sequence::append_token(const Token& token) {
     return;
   }
 
-  token_to_count_map_[token_id]++;
+  count_token(token_id);
   // update logprobs if needed
   if (sequence_params_.sampling_param->logprobs) {
     logprob_state_->update_logprob(
@@ -126,7 +139,7 @@ void Sequence::update_last_step_token(const Token& token, size_t token_offset) {
 
   const int32_t token_id = static_cast<int32_t>(token.id);
   tokens_[cur_generated_token_idx_] = token_id;
-  token_to_count_map_[token_id]++;
+  count_token(token_id);
   // update logprobs if needed
   if (sequence_params_.sampling_param->logprobs) {
     logprob_state_->update_logprob(
@@ -138,6 +151,28 @@ void Sequence::update_last_step_token(const Token& token, size_t token_offset) {
   finish_status_invalidated_ = true;
 }
 
+void Sequence::count_token(int32_t token_id) {
+  if (!sequence_params_.sampling_param->has_penalty()) {
+    return;
+  }
+  auto [it, inserted] = token_to_index_.try_emplace(
+      token_id, static_cast<int32_t>(unique_token_ids_.size()));
+  if (inserted) {
+    unique_token_ids_.push_back(token_id);
+    unique_token_counts_.push_back(1);
+  } else {
+    ++unique_token_counts_[it->second];
+  }
+  unique_token_updates_.push_back(it->second);
+  if (unique_token_updates_.size() >= 2 * kNumKeptUniqueTokenUpdates) {
+    const size_t num_trimmed =
+        unique_token_updates_.size() - kNumKeptUniqueTokenUpdates;
+    unique_token_updates_.erase(unique_token_updates_.begin(),
+                                unique_token_updates_.begin() + num_trimmed);
+    num_trimmed_unique_token_updates_ += num_trimmed;
+  }
+}
+
 void Sequence::update_embeddings(const torch::Tensor& embeddings) {
   // cannot update embeddings to a finished sequence
   if (finished_) {
@@ -246,36 +281,34 @@ SequenceOutput Sequence::generate_output(const Tokenizer& tokenizer) {
     return output;
   }
 
-  // NOTE: enable_schedule_overlap will generate an extra '-1' token.
-  // we need to ignore these '-1' tokens.
   const auto ids = tokens();
-  size_t size;
-  for (auto i = num_tokens_ - 1; i >= 0; --i) {
-    if (tokens_[i] >= 0) {
-      size = i + 1;
-      break;
-    }
-  }
+  const size_t size = num_valid_tokens();
 
   // record the start index of token ids
   const size_t start = decoder_.output_offset();
 
-  // decide which position to start incremental decoding
-  // leave 6 tokens for potential unfinished byte sequence
-  size_t incremental_start = size <= 6 ? 0 : size - 6;
-  // at least start from the first generated token
-  if (incremental_start < num_prompt_tokens_) {
-    incremental_start = num_prompt_tokens_;
-  }
-  // incrementally decode tokens between [incremental_start, size)
-  std::stringstream ss;
-  for (size_t end = incremental_start; end <= size; ++end) {
-    ss << decoder_.decode(ids.slice(0, end), tokenizer);
-  }
-
   SequenceOutput output;
   output.index = index_;
-  output.text = ss.str();
+  if (decoded_output_text_.has_value() &&
+      decoder_.accept_decoded_text(decoded_output_text_.value(), size)) {
+    // the tokens have been decoded in a batch
+    output.text = std::move(decoded_output_text_.value());
+  } else {
+    // decide which position to start incremental decoding
+    // leave 6 tokens for potential unfinished byte sequence
+    size_t incremental_start = size <= 6 ? 0 : size - 6;
+    // at least start from the first generated token
+    if (incremental_start < num_prompt_tokens_) {
+      incremental_start = num_prompt_tokens_;
+    }
+    // incrementally decode tokens between [incremental_start, size)
+    std::stringstream ss;
+    for (size_t end = incremental_start; end <= size; ++end) {
+      ss << decoder_.decode(ids.slice(0, end), tokenizer);
+    }
+    output.text = ss.str();
+  }
+  decoded_output_text_.reset();
   if (output_embedding_.defined()) {
     output.embedding = output_embedding_;
   }
@@ -291,6 +324,29 @@ SequenceOutput Sequence::generate_output(const Tokenizer& tokenizer) {
   return output;
 }
 
+size_t Sequence::num_valid_tokens() const {
+  // NOTE: enable_schedule_overlap will generate an extra '-1' token.
+  // we need to ignore these '-1' tokens.
+  size_t size = num_tokens_;
+  while (size > 0 && tokens_[size - 1] < 0) {
+    --size;
+  }
+  return size;
+}
+
+Slice<int32_t> Sequence::output_tokens_to_decode() const {
+  if (sequence_params_.sampling_param->is_embeddings ||
+      !decoder_.can_decode_in_one_pass()) {
+    return {};
+  }
+  const size_t start = decoder_.output_offset();
+  const size_t size = num_valid_tokens();
+  if (start >= size) {
+    return {};
+  }
+  return tokens().slice(start, size);
+}
+
 void Sequence::add_kv_blocks(const std::vector<Block>& blocks) {
   kv_state_.add_kv_blocks(blocks);
   // use the last prefill block id as the embedding id
@@ -305,8 +361,10 @@ void Sequence::reset() {
   volatile_num_prompt_tokens_ = num_tokens_;
 }
 
-void Sequence::add_shared_kv_blocks(std::vector<Block>&& blocks) {
-  kv_state_.add_shared_kv_blocks(std::move(blocks), num_tokens_);
+void Sequence::add_shared_kv_blocks(std::vector<Block>&& blocks,
+                                    size_t num_shared_tokens) {
+  kv_state_.add_shared_kv_blocks(
+      std::move(blocks), num_tokens_, num_shared_tokens);
 }
 
 bool Sequence::finished() const {
@@ -3,6 +3,7 @@
 #include <absl/time/time.h>
 
 #include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 #include "core/common/types.h"
@@ -66,14 +67,33 @@ class Sequence final {
            const IncrementalDecoder& incremental_decoder,
            const SequenceParams& seq_params);
 
+  // the unique id of the sequence in the process
+  uint64_t id() const { return id_; }
+
   // get mm data
   const MMData& get_mm_data() const { return mm_data_; }
   void set_mrope_position_delta(int val) { mrope_position_delta_ = val; }
   int get_mrope_position_delta() { return mrope_position_delta_; }
 
-  // get token ids to count map
-  const std::unordered_map<int32_t, int32_t>& token_to_count_map() const {
-    return token_to_count_map_;
+  // the unique token ids in the order they first appear and their counts,
+  // updated incrementally as tokens are appended. only counted when a
+  // penalty is applied, empty otherwise.
+  const std::vector<int64_t>& unique_token_ids() const {
+    return unique_token_ids_;
+  }
+  const std::vector<int32_t>& unique_token_counts() const {
+    return unique_token_counts_;
+  }
+  // the index in unique_token_ids() updated by each counted token, in order,
+  // so the counts changed since a previous step are found without comparing
+  // the whole vectors. only the recent updates are kept, the first
+  // num_trimmed_unique_token_updates() ones, the prompt included, are
+  // dropped.
+  const std::vector<int32_t>& unique_token_updates() const {
+    return unique_token_updates_;
+  }
+  size_t num_trimmed_unique_token_updates() const {
+    return num_trimmed_unique_token_updates_;
   }
 
   // check if in prefill stage
@@ -113,6 +133,11 @@ class Sequence final {
   bool has_new_tokens_generated() const {
     return num_tokens_ > decoder_.output_offset();
   }
+  // the number of generated tokens not sent in streaming outputs yet
+  size_t num_unsent_tokens() const {
+    return has_new_tokens_generated() ? num_tokens_ - decoder_.output_offset()
+                                      : 0;
+  }
 
   // update embeddings to the sequence
   void update_embeddings(const torch::Tensor& embedding);
@@ -121,7 +146,10 @@ class Sequence final {
   torch::Tensor get_input_embedding() const { return input_embedding_; }
 
   void add_kv_blocks(const std::vector<Block>& blocks);
-  void add_shared_kv_blocks(std::vector<Block>&& blocks);
+  // num_shared_tokens is the number of matched tokens covered by the blocks,
+  // 0 if all blocks are fully matched
+  void add_shared_kv_blocks(std::vector<Block>&& blocks,
+                            size_t num_shared_tokens = 0);
 
   // whether the prefill stage has been cached.
   bool if_cache_block_for_prefill() {
@@ -144,6 +172,19 @@ class Sequence final {
   SequenceOutput generate_output(const Tokenizer& tokenizer);
   SequenceOutput generate_output();
 
+  // get the tokens to decode for the full output, empty if the tokens can't
+  // be decoded in one pass. used to decode the outputs of many sequences with
+  // tokenizer.decode_batch() before calling generate_output().
+  Slice<int32_t> output_tokens_to_decode() const;
+  // set the text decoded from output_tokens_to_decode()
+  void set_decoded_output_text(std::string text) {
+    decoded_output_text_ = std::move(text);
+  }
+
+  bool skip_special_tokens() const {
+    return sequence_params_.skip_special_tokens;
+  }
+
   // get the sampling parameters
   const RequestSamplingParam* sampling_param() const {
     return sequence_params_.sampling_param;
@@ -160,6 +201,8 @@ class Sequence final {
 
   // time between two tokens
   int64_t tbt(const absl::Time& now);
+  // the time when the latest token was generated
+  absl::Time latest_generate_time() const { return latest_generate_time_; }
   // set sequence ttft
   void set_time_to_first_token_latency_seconds(
       double time_to_first_token_latency_seconds) {
@@ -194,9 +237,17 @@ class Sequence final {
   void reset();
 
  private:
+  // the number of tokens without the trailing fake '-1' tokens
+  size_t num_valid_tokens() const;
+
+  // increase the count of the token id if a penalty is applied
+  void count_token(int32_t token_id);
+
   // the index of the sequence in the request
   size_t index_ = 0;
 
+  uint64_t id_ = 0;
+
   KVCacheState kv_state_;
 
   std::unique_ptr<LogprobState> logprob_state_;
@@ -218,6 +269,9 @@ class Sequence final {
   // incremental decoder to decode the tokens
   IncrementalDecoder decoder_;
 
+  // the output text decoded in a batch, consumed by generate_output()
+  std::optional<std::string> decoded_output_text_;
+
   // token ids generated for the sequence
   std::vector<int32_t> tokens_;
 
@@ -232,8 +286,14 @@ class Sequence final {
   // number of tokens in the sequence
   size_t num_tokens_ = 0;
 
-  // the count of each token id
-  std::unordered_map<int32_t, int32_t> token_to_count_map_;
+  // the count of each token id, see unique_token_ids()
+  std::vector<int64_t> unique_token_ids_;
+  std::vector<int32_t> unique_token_counts_;
+  // the index of each token id in unique_token_ids_
+  std::unordered_map<int32_t, int32_t> token_to_index_;
+  // see unique_token_updates()
+  std::vector<int32_t> unique_token_updates_;
+  size_t num_trimmed_unique_token_updates_ = 0;
 
   // the length of the prompt tokens
   size_t num_prompt_tokens_ = 0;
@@ -39,7 +39,8 @@ void KVCacheState::add_kv_blocks(const std::vector<Block>& new_blocks) {
 }
 
 void KVCacheState::add_shared_kv_blocks(std::vector<Block>&& blocks,
-                                        size_t current_total_num_tokens) {
+                                        size_t current_total_num_tokens,
+                                        size_t num_shared_tokens) {
   if (blocks.empty()) {
     return;
   }
@@ -54,12 +55,16 @@ void KVCacheState::add_shared_kv_blocks(std::vector<Block>&& blocks,
     return;
   }
 
+  const size_t block_size = blocks[0].size();
+  CHECK_GT(block_size, 0);
+  if (num_shared_tokens == 0) {
+    num_shared_tokens = blocks.size() * block_size;
+  }
+  // a partially matched last block is a copy owned by the sequence
   blocks_.clear();
-  num_owned_shared_blocks_ = blocks.size();
+  num_owned_shared_blocks_ = num_shared_tokens / block_size;
   blocks_ = std::move(blocks);
 
-  // update the kv cache position
-  size_t num_shared_tokens = blocks_.size() * blocks_[0].size();
   // It is possible that num_shared_tokens == current_total_num_tokens,
   // indicating that the exact same prompt has been received again. In this
   // case, it becomes necessary to adjust the kv cache position to the
@@ -67,10 +72,13 @@ void KVCacheState::add_shared_kv_blocks(std::vector<Block>&& blocks,
   // should be immutable ideally, but it remains safe to regenerate the kv
   // cache in this context, given the utiliztion of the exact same token.
   if (num_shared_tokens == current_total_num_tokens) {
-    size_t block_size = blocks_[0].size();
-    CHECK_GT(block_size, 0);
-    num_shared_tokens =
-        ((current_total_num_tokens - 1) / block_size) * block_size;
+    if (num_shared_tokens % block_size != 0) {
+      // the last block is owned by the sequence
+      num_shared_tokens -= 1;
+    } else {
+      num_shared_tokens =
+          ((current_total_num_tokens - 1) / block_size) * block_size;
+    }
   }
   CHECK_LT(num_shared_tokens, current_total_num_tokens);
   // update the kv cache position
@@ -116,10 +124,40 @@ std::optional<TransferKVInfo>& KVCacheState::transfer_kv_info() {
   return transfer_kv_info_;
 }
 
+void KVCacheState::set_host_blocks(std::vector<int32_t>&& host_block_ids,
+                                   size_t kv_cache_tokens_num) {
+  CHECK(blocks_.empty()) << "device blocks should be released before";
+  host_block_ids_ = std::move(host_block_ids);
+  host_kv_cache_tokens_num_ = kv_cache_tokens_num;
+}
+
+const std::vector<int32_t>& KVCacheState::host_block_ids() const {
+  return host_block_ids_;
+}
+
+size_t KVCacheState::num_host_blocks() const { return host_block_ids_.size(); }
+
+void KVCacheState::swap_in_kv_blocks(std::vector<Block>&& blocks) {
+  CHECK(blocks_.empty()) << "swap in a sequence holding device blocks";
+  CHECK_EQ(blocks.size(), host_block_ids_.size());
+  blocks_ = std::move(blocks);
+  kv_cache_tokens_num_ = host_kv_cache_tokens_num_;
+  clear_host_blocks();
+}
+
+void KVCacheState::clear_host_blocks() {
+  host_block_ids_.clear();
+  host_kv_cache_tokens_num_ = 0;
+}
+
 void KVCacheState::reset() {
   kv_cache_tokens_num_ = 0;
   num_owned_shared_blocks_ = 0;
-  blocks_.clear();
+  // release from the last block, so that cached blocks become evictable in
+  // that order and the prefix cache evicts the tail of a prefix first
+  while (!blocks_.empty()) {
+    blocks_.pop_back();
+  }
   transfer_kv_info_.reset();
 }
 
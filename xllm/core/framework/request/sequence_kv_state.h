@@ -20,7 +20,8 @@ class KVCacheState {
 
   void add_kv_blocks(const std::vector<Block>& new_blocks);
   void add_shared_kv_blocks(std::vector<Block>&& blocks,
-                            size_t current_total_num_tokens);
+                            size_t current_total_num_tokens,
+                            size_t num_shared_tokens = 0);
 
   size_t current_max_tokens_capacity() const;
 
@@ -33,6 +34,16 @@ class KVCacheState {
   void set_transfer_kv_info(TransferKVInfo&& info);
   std::optional<TransferKVInfo>& transfer_kv_info();
 
+  // host blocks holding the kv cache of a swapped out sequence
+  void set_host_blocks(std::vector<int32_t>&& host_block_ids,
+                       size_t kv_cache_tokens_num);
+  const std::vector<int32_t>& host_block_ids() const;
+  size_t num_host_blocks() const;
+  // replace the host blocks with the device blocks they are swapped into
+  void swap_in_kv_blocks(std::vector<Block>&& blocks);
+  void clear_host_blocks();
+
+  // NOTE: host blocks are kept, they are released by the block manager.
   void reset();
 
  private:
@@ -47,6 +58,12 @@ class KVCacheState {
 
   // shared blocks number of the sequence.
   uint32_t num_owned_shared_blocks_ = 0;
+
+  // host blocks of a swapped out sequence.
+  std::vector<int32_t> host_block_ids_;
+
+  // number of tokens in the host blocks.
+  size_t host_kv_cache_tokens_num_ = 0;
 };
 
 }  // namespace xllm
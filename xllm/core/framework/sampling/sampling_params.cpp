@@ -17,11 +17,44 @@ void SamplingParameters::init(
     const std::vector<std::vector<int64_t>>& unique_token_ids_vec,
     const std::vector<std::vector<int32_t>>& unique_token_counts_vec,
     const std::vector<int32_t>& unique_token_lens_vec) {
-  CHECK_EQ(req_sampling_params.size(), selected_token_idxes.size());
-  CHECK_GE(req_sampling_params.size(), sample_idxes.size());
   CHECK_EQ(req_sampling_params.size(), unique_token_ids_vec.size());
   CHECK_EQ(req_sampling_params.size(), unique_token_counts_vec.size());
   CHECK_EQ(req_sampling_params.size(), unique_token_lens_vec.size());
+  if (init_params(req_sampling_params, selected_token_idxes, sample_idxes)) {
+    this->unique_token_ids =
+        create_2d_tensor(unique_token_ids_vec, torch::kInt64);
+    this->unique_token_counts =
+        create_2d_tensor(unique_token_counts_vec, torch::kInt);
+    this->unique_token_ids_lens = torch::tensor(
+        unique_token_lens_vec,
+        torch::dtype(torch::kInt).device(torch::kCPU).pinned_memory(true));
+  }
+}
+
+void SamplingParameters::init(
+    const std::vector<const RequestSamplingParam*>& req_sampling_params,
+    const std::vector<int32_t>& selected_token_idxes,
+    const std::vector<int32_t>& sample_idxes,
+    const torch::Tensor& unique_token_ids,
+    const torch::Tensor& unique_token_counts,
+    const std::vector<int32_t>& unique_token_lens_vec) {
+  CHECK_EQ(req_sampling_params.size(), unique_token_lens_vec.size());
+  if (init_params(req_sampling_params, selected_token_idxes, sample_idxes)) {
+    CHECK(unique_token_ids.defined() && unique_token_counts.defined());
+    this->unique_token_ids = unique_token_ids;
+    this->unique_token_counts = unique_token_counts;
+    this->unique_token_ids_lens = torch::tensor(
+        unique_token_lens_vec,
+        torch::dtype(torch::kInt).device(torch::kCPU).pinned_memory(true));
+  }
+}
+
+bool SamplingParameters::init_params(
+    const std::vector<const RequestSamplingParam*>& req_sampling_params,
+    const std::vector<int32_t>& selected_token_idxes,
+    const std::vector<int32_t>& sample_idxes) {
+  CHECK_EQ(req_sampling_params.size(), selected_token_idxes.size());
+  CHECK_GE(req_sampling_params.size(), sample_idxes.size());
 
   std::vector<float> frequency_penalties;
   std::vector<float> presence_penalties;
@@ -98,14 +131,6 @@ void SamplingParameters::init(
 
   this->selected_token_idxes =
       torch::tensor(selected_token_idxes, int_tensor_options);
-  if (need_token_stats) {
-    this->unique_token_ids =
-        create_2d_tensor(unique_token_ids_vec, torch::kInt64);
-    this->unique_token_counts =
-        create_2d_tensor(unique_token_counts_vec, torch::kInt);
-    this->unique_token_ids_lens =
-        torch::tensor(unique_token_lens_vec, int_tensor_options);
-  }
 
   // construct do sample tensor
   std::vector<int32_t> do_sample;
@@ -121,6 +146,7 @@ void SamplingParameters::init(
   this->logprobs = logprobs;
   this->max_top_logprobs = max_top_logprobs;
   this->is_embeddings = is_embeddings;
+  return need_token_stats;
 }
 
 }  // namespace xllm
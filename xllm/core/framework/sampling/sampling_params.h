@@ -19,6 +19,12 @@ struct RequestSamplingParam {
   int64_t top_logprobs = 0;
   bool do_sample = false;
   bool is_embeddings = false;
+
+  // whether any penalty is applied, which needs the unique token counts
+  bool has_penalty() const {
+    return frequency_penalty != 0.0 || presence_penalty != 0.0 ||
+           repetition_penalty != 1.0;
+  }
 };
 
 struct SamplingParameters {
@@ -30,6 +36,16 @@ struct SamplingParameters {
             const std::vector<std::vector<int32_t>>& unique_token_counts_vec,
             const std::vector<int32_t>& unique_token_lens_vec);
 
+  // same as above, with the unique token ids and counts already padded into
+  // [num_tokens, max_unique_tokens] tensors on cpu. they are only used if a
+  // penalty is applied.
+  void init(const std::vector<const RequestSamplingParam*>& req_sampling_params,
+            const std::vector<int32_t>& selected_token_idxes,
+            const std::vector<int32_t>& sample_idxes,
+            const torch::Tensor& unique_token_ids,
+            const torch::Tensor& unique_token_counts,
+            const std::vector<int32_t>& unique_token_lens_vec);
+
   SamplingParameters to(const torch::Device& device,
                         torch::ScalarType dtype) const {
     SamplingParameters params;
@@ -115,6 +131,14 @@ struct SamplingParameters {
   // max number of top logprobs in the batch.
   // only used when logprobs is true.
   int64_t max_top_logprobs = 0;
+
+ private:
+  // initializes all but the unique token tensors, returns whether a penalty
+  // is applied and they are needed.
+  bool init_params(
+      const std::vector<const RequestSamplingParam*>& req_sampling_params,
+      const std::vector<int32_t>& selected_token_idxes,
+      const std::vector<int32_t>& sample_idxes);
 };
 
 struct SampleOutput {
@@ -0,0 +1,114 @@
+#include "safetensors_loader.h"
+
+#include <absl/time/clock.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "util/blocking_counter.h"
+
+namespace xllm {
+
+SafeTensorsLoader::SafeTensorsLoader(size_t num_threads, size_t chunk_size)
+    : chunk_size_(chunk_size),
+      max_chunks_in_flight_(2 * std::max<size_t>(num_threads, 1)),
+      threadpool_(std::max<size_t>(num_threads, 1)) {
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  // madvise needs page aligned chunks
+  chunk_size_ = std::max(page_size, chunk_size_ / page_size * page_size);
+}
+
+SafeTensorsLoader::~SafeTensorsLoader() {
+  absl::MutexLock lock(&mutex_);
+  stopped_.store(true, std::memory_order_relaxed);
+  queued_chunks_.clear();
+}
+
+std::vector<std::unique_ptr<StateDict>> SafeTensorsLoader::load(
+    const std::vector<std::string>& files,
+    ShardCallback on_shard_read,
+    bool read_ahead) {
+  on_shard_read_ = std::move(on_shard_read);
+
+  // map the shards and parse their headers concurrently, the data is not
+  // read yet
+  std::vector<std::unique_ptr<StateDict>> state_dicts(files.size());
+  BlockingCounter counter(files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    threadpool_.schedule([&, i]() {
+      state_dicts[i] =
+          StateDictFromSafeTensor::load(files[i], /*prefault=*/false);
+      counter.decrement_count();
+    });
+  }
+  counter.wait();
+  if (!read_ahead) {
+    return state_dicts;
+  }
+
+  // read the shards ahead in order, the reads of a shard are spread over all
+  // io threads
+  absl::MutexLock lock(&mutex_);
+  for (size_t i = 0; i < files.size(); ++i) {
+    const auto content =
+        static_cast<StateDictFromSafeTensor*>(state_dicts[i].get())->content();
+    auto shard = std::make_unique<Shard>();
+    shard->file = files[i];
+    shard->data = content.data();
+    shard->size = content.size();
+    shard->num_pending_chunks = (shard->size + chunk_size_ - 1) / chunk_size_;
+    for (size_t offset = 0; offset < shard->size; offset += chunk_size_) {
+      const size_t length = std::min(chunk_size_, shard->size - offset);
+      queued_chunks_.push_back({shard.get(), offset, length});
+    }
+    shards_.push_back(std::move(shard));
+  }
+  schedule_chunks();
+  return state_dicts;
+}
+
+void SafeTensorsLoader::schedule_chunks() {
+  while (num_chunks_in_flight_ < max_chunks_in_flight_ &&
+         !queued_chunks_.empty()) {
+    ++num_chunks_in_flight_;
+    threadpool_.schedule(
+        [this, chunk = queued_chunks_.front()]() { read_chunk(chunk); });
+    queued_chunks_.pop_front();
+  }
+}
+
+void SafeTensorsLoader::read_chunk(const Chunk& chunk) {
+  Shard* shard = chunk.shard;
+  if (!stopped_.load(std::memory_order_relaxed)) {
+    int64_t expected = 0;
+    shard->start_ns.compare_exchange_strong(expected,
+                                            absl::GetCurrentTimeNanos());
+
+    const uint8_t* begin = shard->data + chunk.offset;
+    // start the readahead of the whole chunk, then touch every page to wait
+    // for it, the chunk is resident once this returns.
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    madvise(const_cast<uint8_t*>(begin), chunk.length, MADV_WILLNEED);
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < chunk.length; i += page_size) {
+      checksum ^= *(static_cast<const volatile uint8_t*>(begin + i));
+    }
+    (void)checksum;
+  }
+
+  if (shard->num_pending_chunks.fetch_sub(1) == 1 &&
+      !stopped_.load(std::memory_order_relaxed) && on_shard_read_ != nullptr) {
+    const double seconds =
+        (absl::GetCurrentTimeNanos() - shard->start_ns.load()) / 1e9;
+    on_shard_read_(shard->file, shard->size, seconds);
+  }
+
+  absl::MutexLock lock(&mutex_);
+  --num_chunks_in_flight_;
+  schedule_chunks();
+}
+
+}  // namespace xllm
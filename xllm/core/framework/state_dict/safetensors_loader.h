@@ -0,0 +1,89 @@
+#pragma once
+
+#include <absl/synchronization/mutex.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "state_dict.h"
+#include "util/threadpool.h"
+
+namespace xllm {
+
+// Loads the safetensors shards of a checkpoint with a pool of io threads.
+// The headers of all shards are parsed concurrently, then the tensor data is
+// read ahead in large sequential chunks in the order of the shards, which is
+// the order models consume them in. Copying the weights then hits the page
+// cache instead of faulting the pages in one by one. Only two chunks per io
+// thread are read at a time, the others wait in order until a read finishes.
+//
+// The loader must be destroyed before the state dicts it returned.
+class SafeTensorsLoader final {
+ public:
+  // called on an io thread once the data of a shard has been read
+  using ShardCallback = std::function<
+      void(const std::string& file, size_t num_bytes, double seconds)>;
+
+  static constexpr size_t kDefaultChunkSize = 64 * 1024 * 1024;
+
+  explicit SafeTensorsLoader(size_t num_threads,
+                             size_t chunk_size = kDefaultChunkSize);
+
+  // stops reading ahead and waits for the running reads
+  ~SafeTensorsLoader();
+
+  // returns once all shards are mapped and their headers are parsed, the data
+  // is read ahead in the background if read_ahead is set.
+  std::vector<std::unique_ptr<StateDict>> load(
+      const std::vector<std::string>& files,
+      ShardCallback on_shard_read = nullptr,
+      bool read_ahead = true);
+
+ private:
+  struct Shard {
+    std::string file;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::atomic<size_t> num_pending_chunks{0};
+    // the time the first chunk started to be read, in nanoseconds
+    std::atomic<int64_t> start_ns{0};
+  };
+
+  struct Chunk {
+    Shard* shard = nullptr;
+    size_t offset = 0;
+    size_t length = 0;
+  };
+
+  // schedules the queued chunks until max_chunks_in_flight_ are being read
+  void schedule_chunks() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  void read_chunk(const Chunk& chunk);
+
+  size_t chunk_size_;
+
+  size_t max_chunks_in_flight_;
+
+  std::atomic<bool> stopped_{false};
+
+  ShardCallback on_shard_read_;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  absl::Mutex mutex_;
+
+  // the chunks waiting to be read, in the order of the shards
+  std::deque<Chunk> queued_chunks_ ABSL_GUARDED_BY(mutex_);
+
+  size_t num_chunks_in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  // declared last to be destroyed first, so that no read is running when the
+  // other members are destroyed
+  ThreadPool threadpool_;
+};
+
+}  // namespace xllm
@@ -0,0 +1,135 @@
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "safetensors_loader.h"
+#include "state_dict.h"
+
+using namespace xllm;
+
+namespace {
+
+constexpr size_t kTensorSize = 16 * 1024 * 1024;
+
+// write a synthetic checkpoint of f32 tensors split into num_shards files
+std::vector<std::string> write_checkpoint(size_t num_shards,
+                                          size_t shard_size) {
+  const std::string dir = "/tmp/safetensors_loader_benchmark_" +
+                          std::to_string(num_shards) + "x" +
+                          std::to_string(shard_size);
+  std::filesystem::create_directories(dir);
+  const size_t num_tensors = std::max<size_t>(shard_size / kTensorSize, 1);
+  const std::vector<char> tensor_data(kTensorSize, 1);
+
+  std::vector<std::string> files;
+  for (size_t shard = 0; shard < num_shards; ++shard) {
+    const std::string file =
+        dir + "/model-" + std::to_string(shard) + ".safetensors";
+    files.push_back(file);
+    if (std::filesystem::exists(file)) {
+      continue;
+    }
+
+    std::string header = "{";
+    for (size_t i = 0; i < num_tensors; ++i) {
+      if (i > 0) {
+        header += ",";
+      }
+      header += "\"layers." + std::to_string(shard * num_tensors + i) +
+                ".weight\":{\"dtype\":\"F32\",\"shape\":[" +
+                std::to_string(kTensorSize / sizeof(float)) +
+                "],\"data_offsets\":[" + std::to_string(i * kTensorSize) +
+                "," + std::to_string((i + 1) * kTensorSize) + "]}";
+    }
+    header += "}";
+    // the data is 8 bytes aligned
+    header.resize((header.size() + 7) / 8 * 8, ' ');
+
+    std::ofstream fs(file, std::ios::binary);
+    const uint64_t header_size = header.size();
+    fs.write(reinterpret_cast<const char*>(&header_size), sizeof(header_size));
+    fs.write(header.data(), header.size());
+    for (size_t i = 0; i < num_tensors; ++i) {
+      fs.write(tensor_data.data(), tensor_data.size());
+    }
+  }
+  return files;
+}
+
+// evict the files from the page cache to measure a cold start
+size_t drop_page_cache(const std::vector<std::string>& files) {
+  size_t num_bytes = 0;
+  for (const auto& file : files) {
+    const int fd = open(file.c_str(), O_RDONLY);
+    CHECK(fd >= 0) << "Failed to open " << file;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    num_bytes += std::filesystem::file_size(file);
+  }
+  return num_bytes;
+}
+
+// read every tensor like the weight copies of the models do
+void consume(const std::vector<std::unique_ptr<StateDict>>& state_dicts) {
+  for (const auto& state_dict : state_dicts) {
+    for (const auto& [name, tensor] : *state_dict) {
+      benchmark::DoNotOptimize(tensor.sum().item<float>());
+    }
+  }
+}
+
+}  // namespace
+
+// the baseline: map and prefault the shards one after another
+static void BM_LoadSerial(benchmark::State& state) {
+  const auto files = write_checkpoint(state.range(0), state.range(1) << 20);
+  size_t num_bytes = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    num_bytes = drop_page_cache(files);
+    state.ResumeTiming();
+
+    std::vector<std::unique_ptr<StateDict>> state_dicts;
+    for (const auto& file : files) {
+      state_dicts.push_back(StateDictFromSafeTensor::load(file));
+    }
+    consume(state_dicts);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_bytes);
+}
+
+// parse the headers concurrently and read the shards ahead on io threads
+static void BM_LoadReadAhead(benchmark::State& state) {
+  const auto files = write_checkpoint(state.range(0), state.range(1) << 20);
+  size_t num_bytes = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    num_bytes = drop_page_cache(files);
+    state.ResumeTiming();
+
+    // the read ahead stops with the loader, consume() has read every byte
+    SafeTensorsLoader loader(state.range(2));
+    auto state_dicts = loader.load(files);
+    consume(state_dicts);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_bytes);
+}
+
+// args: number of shards, shard size in MB[, number of io threads]
+BENCHMARK(BM_LoadSerial)->Args({8, 256})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_LoadReadAhead)
+    ->Args({8, 256, 4})
+    ->Args({8, 256, 16})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -2,16 +2,22 @@
 
 #include <ATen/core/TensorBody.h>
 #include <absl/strings/match.h>
+#include <absl/strings/str_cat.h>
 #include <caffe2/serialize/inline_container.h>
 #include <glog/logging.h>
+#include <sys/mman.h>
 #include <torch/csrc/jit/serialization/import_read.h>
 #include <torch/csrc/jit/serialization/storage_context.h>
 #include <torch/torch.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 
 #include "core/util/env_var.h"
 #include "safetensors/safetensors.h"
+#include "weight_cache.h"
 
 namespace xllm {
 namespace {
@@ -63,18 +69,132 @@ std::vector<int64_t> get_sizes(const View* view) {
   return sizes;
 }
 
+// hint the kernel to read the pages of [data, data + size) ahead, the tensors
+// of safetensors files are backed by the mapped file.
+void will_need(const void* data, size_t size) {
+  static const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+  const uintptr_t aligned_begin = begin / page_size * page_size;
+  // NOLINTNEXTLINE(performance-no-int-to-ptr)
+  madvise(reinterpret_cast<void*>(aligned_begin),
+          size + (begin - aligned_begin),
+          MADV_WILLNEED);
+}
+
+// slice the shard of the rank out of the tensor, only the bytes of the shard
+// are read from the mapped file.
+torch::Tensor slice_tensor(const torch::Tensor& tensor,
+                           int64_t dim,
+                           int rank,
+                           int world_size) {
+  if (dim < 0) {
+    dim += tensor.dim();
+  }
+  // only the rows and the columns of a row are sliced by hand
+  if (!tensor.is_cpu() || !tensor.is_contiguous() || (dim != 0 && dim != 1)) {
+    return tensor.chunk(world_size, dim)[rank];
+  }
+
+  const int64_t shard_size = tensor.size(dim) / world_size;
+  if (dim == 0) {
+    // the shard is a contiguous range of the tensor, return a view of it
+    auto shard = tensor.narrow(/*dim=*/0, rank * shard_size, shard_size);
+    will_need(shard.data_ptr(), shard.nbytes());
+    return shard;
+  }
+
+  // the shard is a column range of each row, gather the ranges row by row
+  // into a contiguous tensor instead of copying a strided view later.
+  const int64_t num_rows = tensor.size(0);
+  const size_t row_bytes = tensor.stride(0) * tensor.element_size();
+  const size_t shard_bytes =
+      shard_size * tensor.stride(1) * tensor.element_size();
+  auto sizes = tensor.sizes().vec();
+  sizes[1] = shard_size;
+  auto shard = torch::empty(sizes, tensor.options());
+
+  const char* src = static_cast<const char*>(tensor.data_ptr()) +
+                    static_cast<size_t>(rank) * shard_bytes;
+  char* dst = static_cast<char*>(shard.data_ptr());
+  for (int64_t row = 0; row < num_rows; ++row) {
+    std::memcpy(dst, src, shard_bytes);
+    src += row_bytes;
+    dst += shard_bytes;
+  }
+  return shard;
+}
+
+// the name relative to the prefix of a view
+std::string_view relative_name(const std::string& name, size_t name_offset) {
+  return std::string_view(name).substr(name_offset);
+}
+
 }  // namespace
 
 StateDict::StateDict(std::unordered_map<std::string, torch::Tensor> dict,
                      const std::string& prefix)
-    : dict_(std::move(dict)), prefix_(prefix) {}
+    : prefix_(prefix) {
+  auto catalog = std::make_shared<Catalog>();
+  catalog->reserve(dict.size());
+  while (!dict.empty()) {
+    auto node = dict.extract(dict.begin());
+    catalog->emplace_back(std::move(node.key()), std::move(node.mapped()));
+  }
+  std::sort(catalog->begin(),
+            catalog->end(),
+            [](const auto& lhs, const auto& rhs) {
+              return lhs.first < rhs.first;
+            });
+  end_ = catalog->size();
+  catalog_ = std::move(catalog);
+}
 
-torch::Tensor StateDict::get_tensor(const std::string& tensor_name) const {
-  const auto it = dict_.find(tensor_name);
-  if (it == dict_.end()) {
-    return torch::Tensor{nullptr};
+StateDict::StateDict(std::shared_ptr<const Catalog> catalog,
+                     size_t begin,
+                     size_t end,
+                     size_t name_offset,
+                     std::string prefix,
+                     std::shared_ptr<WeightCache> weight_cache)
+    : prefix_(std::move(prefix)),
+      catalog_(std::move(catalog)),
+      begin_(begin),
+      end_(end),
+      name_offset_(name_offset),
+      weight_cache_(std::move(weight_cache)) {}
+
+StateDict::Iterator::value_type StateDict::Iterator::operator*() const {
+  const std::string_view name =
+      std::string_view(it_->first).substr(name_offset_);
+  if (weight_cache_ != nullptr) {
+    // the iterated tensors may not be used, so a miss is not counted
+    auto tensor = weight_cache_->lookup(it_->first, /*count_miss=*/false);
+    if (tensor.defined()) {
+      return {name, std::move(tensor)};
+    }
   }
-  torch::Tensor tensor = it->second;
+  return {name, it_->second};
+}
+
+const StateDict::Catalog::value_type* StateDict::find(
+    const std::string& tensor_name) const {
+  const auto first = catalog_->begin() + begin_;
+  const auto last = catalog_->begin() + end_;
+  // the names in the view share the same prefix, so the relative names are
+  // sorted as well
+  const auto it = std::lower_bound(
+      first, last, tensor_name, [this](const auto& entry, const auto& name) {
+        return relative_name(entry.first, name_offset_) < name;
+      });
+  if (it == last || relative_name(it->first, name_offset_) != tensor_name) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+torch::Tensor StateDict::to_tensor(const Catalog::value_type& entry,
+                                   const std::string& tensor_name) const {
+  torch::Tensor tensor = entry.second;
   if (tensor.dim() == 0) {
     tensor = tensor.reshape({tensor.numel()});
   }
@@ -82,6 +202,25 @@ torch::Tensor StateDict::get_tensor(const std::string& tensor_name) const {
   return transform_func_ ? transform_func_(tensor_name, tensor) : tensor;
 }
 
+torch::Tensor StateDict::get_tensor(const std::string& tensor_name) const {
+  const auto* entry = find(tensor_name);
+  if (entry == nullptr) {
+    return torch::Tensor{nullptr};
+  }
+  const bool use_cache = weight_cache_ != nullptr && !transform_func_;
+  if (use_cache) {
+    auto tensor = weight_cache_->lookup(entry->first);
+    if (tensor.defined()) {
+      return tensor;
+    }
+  }
+  auto tensor = to_tensor(*entry, tensor_name);
+  if (use_cache) {
+    weight_cache_->record(entry->first, tensor);
+  }
+  return tensor;
+}
+
 torch::Tensor StateDict::get_sharded_tensor(const std::string& tensor_name,
                                             int64_t dim,
                                             int rank,
@@ -90,34 +229,59 @@ torch::Tensor StateDict::get_sharded_tensor(const std::string& tensor_name,
   CHECK(rank >= 0 && rank < world_size)
       << "Invalid rank " << rank << " for " << world_size << " shards";
 
-  auto tensor = get_tensor(tensor_name);
-  if (!tensor.defined()) {
-    return tensor;
+  const auto* entry = find(tensor_name);
+  if (entry == nullptr) {
+    return torch::Tensor{nullptr};
   }
-  // chunk tensor along the dim
-  const int64_t dim_size = tensor.size(dim);
-  if (dim_size < world_size) {
-    // too small to shard, return the whole tensor instead
-    // TODO: assert dim_size >= world_size
-    return tensor;
+  // the shards of the rank are cached under the full name and the sharding
+  const bool use_cache = weight_cache_ != nullptr && !transform_func_;
+  std::string cache_key;
+  if (use_cache) {
+    cache_key =
+        absl::StrCat(entry->first, "@", dim, "/", rank, "/", world_size);
+    auto tensor = weight_cache_->lookup(cache_key);
+    if (tensor.defined()) {
+      return tensor;
+    }
   }
 
-  CHECK(dim_size % world_size == 0)
-      << "can't devide tensor evenly on " << dim << " with dim: " << dim_size
-      << " world_size: " << world_size;
-  const auto chunks = tensor.chunk(world_size, dim);
-  return chunks[rank];
+  auto tensor = to_tensor(*entry, tensor_name);
+  // shard tensor along the dim
+  const int64_t dim_size = tensor.size(dim);
+  // too small to shard, return the whole tensor instead
+  // TODO: assert dim_size >= world_size
+  if (dim_size >= world_size) {
+    CHECK(dim_size % world_size == 0)
+        << "can't devide tensor evenly on " << dim << " with dim: " << dim_size
+        << " world_size: " << world_size;
+    tensor = slice_tensor(tensor, dim, rank, world_size);
+  }
+  if (use_cache) {
+    weight_cache_->record(cache_key, tensor);
+  }
+  return tensor;
 }
 
-// select all the tensors whose name starts with prefix.
+// select all the tensors whose name starts with prefix, they are a range of
+// the sorted catalog.
 StateDict StateDict::get_dict_with_prefix(const std::string& prefix) const {
-  std::unordered_map<std::string, torch::Tensor> tensors;
-  for (const auto& [name, tensor] : dict_) {
-    if (absl::StartsWith(name, prefix)) {
-      tensors[name.substr(prefix.length())] = tensor;
-    }
-  }
-  return {std::move(tensors), prefix_ + prefix};
+  const auto first = catalog_->begin() + begin_;
+  const auto last = catalog_->begin() + end_;
+  const auto range_begin =
+      std::partition_point(first, last, [&](const auto& entry) {
+        return relative_name(entry.first, name_offset_) < prefix;
+      });
+  const auto range_end =
+      std::partition_point(range_begin, last, [&](const auto& entry) {
+        return absl::StartsWith(relative_name(entry.first, name_offset_),
+                                prefix);
+      });
+  return StateDict(catalog_,
+                   range_begin - catalog_->begin(),
+                   range_end - catalog_->begin(),
+                   name_offset_ + prefix.size(),
+                   prefix_ + prefix,
+                   weight_cache_);
 }
 
 StateDict StateDict::get_dict_with_prefix(
@@ -134,9 +298,10 @@ StateDictFromSafeTensor::StateDictFromSafeTensor(
     : StateDict(std::move(dict)), mem_map_(std::move(mem_map)) {}
 
 std::unique_ptr<StateDict> StateDictFromSafeTensor::load(
-    const std::string& weights_file) {
+    const std::string& weights_file,
+    bool prefault) {
   folly::MemoryMapping::Options options;
-  options.setPrefault(true).setReadable(true);
+  options.setPrefault(prefault).setReadable(true);
   auto mem_map = std::make_unique<folly::MemoryMapping>(weights_file.c_str(),
                                                         0,   // offset
                                                         -1,  // length
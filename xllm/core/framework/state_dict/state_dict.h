@@ -3,12 +3,20 @@
 #include <folly/system/MemoryMapping.h>
 #include <torch/torch.h>
 
+#include <iterator>
 #include <memory>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace xllm {
 
+class WeightCache;
+
+// A view of a sorted catalog of named tensors. The catalog is shared by the
+// state dict and all the views taken from it, a prefix view is a range of the
+// catalog found by binary search, no tensor name is copied.
 class StateDict {
  public:
   StateDict(std::unordered_map<std::string, torch::Tensor> dict,
@@ -35,19 +43,97 @@ class StateDict {
   virtual StateDict get_dict_with_prefix(const std::string& prefix,
                                          TensorTransform transform_func) const;
 
-  size_t size() const { return dict_.size(); }
+  size_t size() const { return end_ - begin_; }
 
   std::string_view prefix() const { return prefix_; }
 
-  auto begin() const { return dict_.begin(); }
-  auto end() const { return dict_.end(); }
+  // serve the tensors from the cache and record the ones read into it, the
+  // views taken afterwards share the cache.
+  void set_weight_cache(std::shared_ptr<WeightCache> weight_cache) {
+    weight_cache_ = std::move(weight_cache);
+  }
+
+  // tensors sorted by their full names
+  using Catalog = std::vector<std::pair<std::string, torch::Tensor>>;
+
+  // iterates the (name, tensor) pairs of the view, the names are relative to
+  // the prefix of the view and point into the catalog, which lives as long as
+  // any view of it.
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::pair<std::string_view, torch::Tensor>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    Iterator(Catalog::const_iterator it,
+             size_t name_offset,
+             const WeightCache* weight_cache)
+        : it_(it), name_offset_(name_offset), weight_cache_(weight_cache) {}
+
+    // the tensor is served from the weight cache if it was cached
+    value_type operator*() const;
+
+    Iterator& operator++() {
+      ++it_;
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const { return it_ == other.it_; }
+    bool operator!=(const Iterator& other) const { return it_ != other.it_; }
+
+   private:
+    Catalog::const_iterator it_;
+    size_t name_offset_;
+    const WeightCache* weight_cache_;
+  };
+
+  Iterator begin() const {
+    return {catalog_->begin() + begin_, name_offset_, iterator_cache()};
+  }
+  Iterator end() const {
+    return {catalog_->begin() + end_, name_offset_, iterator_cache()};
+  }
 
  protected:
-  std::unordered_map<std::string, torch::Tensor> dict_;
-
   TensorTransform transform_func_ = nullptr;
 
   std::string prefix_;
+
+ private:
+  StateDict(std::shared_ptr<const Catalog> catalog,
+            size_t begin,
+            size_t end,
+            size_t name_offset,
+            std::string prefix,
+            std::shared_ptr<WeightCache> weight_cache);
+
+  // find the catalog entry of the name relative to the view
+  const Catalog::value_type* find(const std::string& tensor_name) const;
+
+  // the cache the tensors are iterated from, transformed tensors are not
+  // cached
+  const WeightCache* iterator_cache() const {
+    return transform_func_ ? nullptr : weight_cache_.get();
+  }
+
+  // the tensor of the entry with the transform applied
+  torch::Tensor to_tensor(const Catalog::value_type& entry,
+                          const std::string& tensor_name) const;
+
+  std::shared_ptr<const Catalog> catalog_;
+
+  // the range [begin_, end_) of the catalog in the view
+  size_t begin_ = 0;
+  size_t end_ = 0;
+
+  // the length of the prefix shared by the full names in the view, which is
+  // stripped from the names
+  size_t name_offset_ = 0;
+
+  // the cache of the tensors read, transformed tensors are not cached
+  std::shared_ptr<WeightCache> weight_cache_;
 };
 
 class StateDictFromSafeTensor : public StateDict {
@@ -55,7 +141,13 @@ class StateDictFromSafeTensor : public StateDict {
   StateDictFromSafeTensor(std::unique_ptr<folly::MemoryMapping> mem_map,
                           std::unordered_map<std::string, torch::Tensor> dict);
 
-  static std::unique_ptr<StateDict> load(const std::string& weights_file);
+  // prefault reads the whole file in when it is mapped, otherwise the pages
+  // are read on first access, see SafeTensorsLoader for reading them ahead.
+  static std::unique_ptr<StateDict> load(const std::string& weights_file,
+                                         bool prefault = true);
+
+  // the mapped content of the safetensors file
+  folly::ByteRange content() const { return mem_map_->range(); }
 
  private:
   // memory mapping for safetensors
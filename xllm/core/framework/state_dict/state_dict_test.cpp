@@ -0,0 +1,102 @@
+#include "state_dict.h"
+
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+
+namespace xllm {
+
+TEST(StateDictTest, ShardedTensorMatchesChunk) {
+  const auto weight = torch::arange(8 * 12, torch::kFloat32).reshape({8, 12});
+  const auto bias = torch::arange(8, torch::kFloat32);
+  StateDict state_dict({{"weight", weight}, {"bias", bias}});
+
+  const int world_size = 4;
+  for (int rank = 0; rank < world_size; ++rank) {
+    for (int64_t dim = 0; dim < 2; ++dim) {
+      const auto shard =
+          state_dict.get_sharded_tensor("weight", dim, rank, world_size);
+      const auto expected = weight.chunk(world_size, dim)[rank];
+      EXPECT_TRUE(shard.is_contiguous());
+      EXPECT_EQ(shard.sizes(), expected.sizes());
+      EXPECT_TRUE(torch::equal(shard, expected));
+    }
+    const auto shard =
+        state_dict.get_sharded_tensor("bias", 0, rank, world_size);
+    EXPECT_TRUE(torch::equal(shard, bias.chunk(world_size, 0)[rank]));
+  }
+}
+
+TEST(StateDictTest, ShardedTensorOfOtherDims) {
+  const auto weight =
+      torch::arange(2 * 4 * 6, torch::kFloat32).reshape({2, 4, 6});
+  StateDict state_dict({{"weight", weight}});
+
+  const int world_size = 2;
+  for (int rank = 0; rank < world_size; ++rank) {
+    for (int64_t dim : {-1, -2, 2}) {
+      const auto shard =
+          state_dict.get_sharded_tensor("weight", dim, rank, world_size);
+      const auto expected = weight.chunk(world_size, dim)[rank];
+      EXPECT_EQ(shard.sizes(), expected.sizes());
+      EXPECT_TRUE(torch::equal(shard, expected));
+    }
+  }
+}
+
+TEST(StateDictTest, ShardedTensorOfNonContiguousTensor) {
+  const auto weight =
+      torch::arange(6 * 4, torch::kFloat32).reshape({6, 4}).t();
+  StateDict state_dict({{"weight", weight}});
+
+  for (int rank = 0; rank < 2; ++rank) {
+    const auto shard = state_dict.get_sharded_tensor("weight", 1, rank, 2);
+    EXPECT_TRUE(torch::equal(shard, weight.chunk(2, 1)[rank]));
+  }
+}
+
+TEST(StateDictTest, ShardedTensorTooSmallToShard) {
+  const auto weight = torch::ones({2, 2});
+  StateDict state_dict({{"weight", weight}});
+
+  const auto shard = state_dict.get_sharded_tensor("weight", 1, 3, 4);
+  EXPECT_EQ(shard.sizes(), weight.sizes());
+  EXPECT_FALSE(state_dict.get_sharded_tensor("missing", 0, 0, 4).defined());
+}
+
+TEST(StateDictTest, PrefixViews) {
+  std::unordered_map<std::string, torch::Tensor> dict;
+  for (const std::string name : {"lm_head.weight",
+                                 "model.layers.0.mlp.weight",
+                                 "model.layers.0.self_attn.weight",
+                                 "model.layers.1.mlp.weight",
+                                 "model.layers.10.mlp.weight",
+                                 "model.norm.weight"}) {
+    dict[name] = torch::ones({1});
+  }
+  StateDict state_dict(std::move(dict));
+  EXPECT_EQ(state_dict.size(), 6);
+
+  const auto model = state_dict.get_dict_with_prefix("model.");
+  EXPECT_EQ(model.size(), 5);
+  EXPECT_EQ(model.prefix(), "model.");
+  EXPECT_TRUE(model.get_tensor("norm.weight").defined());
+  EXPECT_FALSE(model.get_tensor("lm_head.weight").defined());
+
+  const auto layer1 = model.get_dict_with_prefix("layers.1.");
+  EXPECT_EQ(layer1.size(), 1);
+  EXPECT_EQ(layer1.prefix(), "model.layers.1.");
+  EXPECT_TRUE(layer1.get_tensor("mlp.weight").defined());
+
+  const auto layer0 = model.get_dict_with_prefix("layers.0.");
+  std::vector<std::string> names;
+  for (const auto& [name, tensor] : layer0) {
+    names.emplace_back(name);
+  }
+  EXPECT_EQ(names,
+            std::vector<std::string>({"mlp.weight", "self_attn.weight"}));
+
+  EXPECT_EQ(model.get_dict_with_prefix("layers.2.").size(), 0);
+  EXPECT_EQ(state_dict.get_dict_with_prefix("").size(), 6);
+}
+
+}  // namespace xllm
@@ -0,0 +1,311 @@
+#include "weight_cache.h"
+
+#include <absl/strings/str_cat.h>
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <openssl/sha.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+#include "util/uuid.h"
+
+#ifndef XLLM_VERSION
+#define XLLM_VERSION "unknown"
+#endif
+
+namespace xllm {
+namespace {
+
+constexpr size_t kAlignment = 4096;
+
+size_t align_up(size_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// hash the names, sizes and modification times of the model files, the
+// weights are not read.
+std::string model_hash(const std::string& model_weights_path) {
+  std::vector<std::filesystem::path> files;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(model_weights_path)) {
+    if (entry.path().extension() == ".safetensors" ||
+        entry.path().filename() == "config.json") {
+      files.push_back(entry.path());
+    }
+  }
+  std::sort(files.begin(), files.end());
+
+  std::string files_info;
+  for (const auto& file : files) {
+    const auto mtime = std::filesystem::last_write_time(file);
+    absl::StrAppend(&files_info,
+                    file.filename().string(),
+                    ":",
+                    std::filesystem::file_size(file),
+                    ":",
+                    mtime.time_since_epoch().count(),
+                    "\n");
+  }
+
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  SHA256(reinterpret_cast<const uint8_t*>(files_info.data()),
+         files_info.size(),
+         digest);
+  static constexpr char kHexDigits[] = "0123456789abcdef";
+  std::string hash;
+  // the leading 16 bytes are enough to tell the models apart
+  for (size_t i = 0; i < 16; ++i) {
+    hash.push_back(kHexDigits[digest[i] >> 4]);
+    hash.push_back(kHexDigits[digest[i] & 0xF]);
+  }
+  return hash;
+}
+
+}  // namespace
+
+std::string WeightCache::cache_dir(const std::string& root_dir,
+                                   const std::string& model_weights_path,
+                                   int32_t world_size,
+                                   int32_t dp_size,
+                                   int32_t ep_size) {
+  return absl::StrCat(root_dir,
+                      "/",
+                      model_hash(model_weights_path),
+                      "-tp",
+                      world_size,
+                      "-dp",
+                      dp_size,
+                      "-ep",
+                      ep_size);
+}
+
+WeightCache::WeightCache(const std::string& dir, int32_t rank)
+    : dir_(dir),
+      rank_(rank),
+      manifest_file_(absl::StrCat(dir, "/rank-", rank, ".json")),
+      data_file_(absl::StrCat(dir, "/rank-", rank, ".bin")),
+      commit_id_(absl::StrCat(getpid(), "-", ShortUUID().random())),
+      tmp_suffix_(absl::StrCat(".", commit_id_, ".tmp")) {
+  if (open()) {
+    LOG(INFO) << "Loading " << tensors_.size() << " cached tensors of rank "
+              << rank_ << " from " << data_file_;
+  } else {
+    LOG(INFO) << "Recording the tensors of rank " << rank_
+              << " into the weight cache " << dir_;
+  }
+}
+
+WeightCache::~WeightCache() {
+  absl::MutexLock lock(&mutex_);
+  if (fd_ >= 0) {
+    close(fd_);
+    std::error_code ec;
+    std::filesystem::remove(data_file_ + tmp_suffix_, ec);
+  }
+}
+
+bool WeightCache::open() {
+  std::ifstream fs(manifest_file_);
+  if (!fs.is_open()) {
+    return false;
+  }
+  const auto manifest = nlohmann::json::parse(fs, nullptr, false);
+  if (manifest.is_discarded() ||
+      manifest.value("version", "") != XLLM_VERSION ||
+      manifest.value("rank", -1) != rank_ ||
+      !std::filesystem::exists(data_file_)) {
+    LOG(WARNING) << "Ignoring the stale weight cache " << manifest_file_;
+    return false;
+  }
+
+  // read the whole file in one go, it contains only the tensors of the rank
+  folly::MemoryMapping::Options options;
+  options.setPrefault(true).setReadable(true);
+  mem_map_ = std::make_unique<folly::MemoryMapping>(
+      data_file_.c_str(), 0, -1, options);
+  const folly::ByteRange content = mem_map_->range();
+  // the data file may have been replaced by another commit after the manifest
+  // was written, it ends with the page holding the id of its commit
+  const std::string commit_id = manifest.value("commit_id", "");
+  if (content.size() != manifest.value("data_size", size_t{0}) ||
+      content.size() < kAlignment || commit_id.empty() ||
+      commit_id.size() > kAlignment ||
+      std::memcmp(content.data() + content.size() - kAlignment,
+                  commit_id.data(),
+                  commit_id.size()) != 0) {
+    LOG(WARNING) << "Ignoring the weight cache " << data_file_
+                 << " not written by the commit of " << manifest_file_;
+    mem_map_.reset();
+    return false;
+  }
+  for (const auto& entry : manifest["tensors"]) {
+    const auto sizes = entry["sizes"].get<std::vector<int64_t>>();
+    const auto dtype =
+        static_cast<torch::ScalarType>(entry["dtype"].get<int32_t>());
+    const size_t offset = entry["offset"].get<size_t>();
+    size_t nbytes = c10::elementSize(dtype);
+    for (const int64_t size : sizes) {
+      nbytes *= static_cast<size_t>(std::max<int64_t>(size, 0));
+    }
+    // a tensor beyond the end of the file would fault on its first read
+    if (offset > content.size() || nbytes > content.size() - offset) {
+      LOG(WARNING) << "Ignoring the corrupted weight cache " << data_file_;
+      tensors_.clear();
+      mem_map_.reset();
+      return false;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    void* data = const_cast<uint8_t*>(content.data() + offset);
+    tensors_[entry["key"].get<std::string>()] =
+        at::from_blob(data, sizes, torch::dtype(dtype));
+  }
+  return true;
+}
+
+torch::Tensor WeightCache::lookup(const std::string& key,
+                                  bool count_miss) const {
+  if (!hit()) {
+    return torch::Tensor{nullptr};
+  }
+  const auto it = tensors_.find(key);
+  if (it == tensors_.end()) {
+    if (count_miss) {
+      num_misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return torch::Tensor{nullptr};
+  }
+  return it->second;
+}
+
+void WeightCache::record(const std::string& key, const torch::Tensor& tensor) {
+  if (hit()) {
+    return;
+  }
+  const auto cpu_tensor = tensor.to(torch::kCPU).contiguous();
+
+  absl::MutexLock lock(&mutex_);
+  if (failed_ || !recorded_keys_.insert(key).second) {
+    return;
+  }
+  if (fd_ < 0) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    fd_ = ::open((data_file_ + tmp_suffix_).c_str(),
+                 O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                 0644);
+    if (fd_ < 0) {
+      LOG(WARNING) << "Failed to create the weight cache " << data_file_
+                   << ": " << strerror(errno);
+      failed_ = true;
+      return;
+    }
+  }
+
+  Entry entry;
+  entry.key = key;
+  entry.dtype = static_cast<int32_t>(cpu_tensor.scalar_type());
+  entry.sizes = cpu_tensor.sizes().vec();
+  entry.offset = align_up(size_);
+  if (!write(cpu_tensor.data_ptr(), cpu_tensor.nbytes(), entry.offset)) {
+    failed_ = true;
+    return;
+  }
+  size_ = entry.offset + cpu_tensor.nbytes();
+  entries_.push_back(std::move(entry));
+}
+
+bool WeightCache::write(const void* data, size_t size, size_t offset) {
+  const char* begin = static_cast<const char*>(data);
+  while (size > 0) {
+    const ssize_t written = pwrite(fd_, begin, size, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(WARNING) << "Failed to write the weight cache " << data_file_
+                   << ": " << strerror(errno);
+      return false;
+    }
+    begin += written;
+    offset += written;
+    size -= written;
+  }
+  return true;
+}
+
+bool WeightCache::commit() {
+  if (hit()) {
+    LOG(INFO) << "Loaded " << tensors_.size() << " cached tensors of rank "
+              << rank_ << ", " << num_misses_.load()
+              << " tensors were read from the model weights files";
+    return false;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  if (fd_ < 0 || failed_) {
+    return false;
+  }
+  // pad the file to whole pages, so that it can be read with O_DIRECT, and
+  // end it with a page holding the commit id
+  const size_t data_size = align_up(size_) + kAlignment;
+  const bool synced =
+      ftruncate(fd_, data_size) == 0 &&
+      write(commit_id_.data(), commit_id_.size(), data_size - kAlignment) &&
+      fsync(fd_) == 0;
+  close(fd_);
+  fd_ = -1;
+
+  // drop a stale manifest before replacing the data file it describes
+  std::error_code ec;
+  std::filesystem::remove(manifest_file_, ec);
+  if (synced) {
+    std::filesystem::rename(data_file_ + tmp_suffix_, data_file_, ec);
+  }
+  if (!synced || ec) {
+    LOG(WARNING) << "Failed to write the weight cache " << data_file_;
+    std::filesystem::remove(data_file_ + tmp_suffix_, ec);
+    return false;
+  }
+
+  nlohmann::json manifest;
+  manifest["version"] = XLLM_VERSION;
+  manifest["rank"] = rank_;
+  manifest["commit_id"] = commit_id_;
+  manifest["data_size"] = data_size;
+  auto& tensors = manifest["tensors"];
+  tensors = nlohmann::json::array();
+  for (const auto& entry : entries_) {
+    tensors.push_back({{"key", entry.key},
+                       {"dtype", entry.dtype},
+                       {"sizes", entry.sizes},
+                       {"offset", entry.offset}});
+  }
+  // the manifest is written last, a cache without it is never used
+  {
+    std::ofstream fs(manifest_file_ + tmp_suffix_);
+    fs << manifest.dump();
+    if (!fs.good()) {
+      LOG(WARNING) << "Failed to write the weight cache " << manifest_file_;
+      std::filesystem::remove(manifest_file_ + tmp_suffix_, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(manifest_file_ + tmp_suffix_, manifest_file_, ec);
+  if (ec) {
+    LOG(WARNING) << "Failed to write the weight cache " << manifest_file_;
+    std::filesystem::remove(manifest_file_ + tmp_suffix_, ec);
+    return false;
+  }
+  LOG(INFO) << "Wrote " << entries_.size() << " tensors (" << size_ / 1e9
+            << " GB) of rank " << rank_ << " into the weight cache " << dir_;
+  return true;
+}
+
+}  // namespace xllm
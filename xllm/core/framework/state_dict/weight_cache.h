@@ -0,0 +1,108 @@
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+#include <folly/system/MemoryMapping.h>
+#include <torch/torch.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xllm {
+
+// An on-disk cache of the tensors a rank reads from the state dicts of a
+// model, already sharded for the rank.
+//
+// The first load records every tensor returned by StateDict::get_tensor() and
+// StateDict::get_sharded_tensor() into one data file per rank, each tensor
+// page aligned. Once the model is loaded successfully the manifest is
+// committed. Later loads of the same model files with the same parallel
+// config and xllm version map the data file in one sequential read and serve
+// the tensors from it, so only the bytes of the rank are read from the disk.
+// Reads that were not recorded fall back to the checkpoint.
+//
+// Each commit ends the data file with a page holding its commit id, which the
+// manifest records with the data file size, so a manifest is never used with
+// the data file of another commit.
+class WeightCache final {
+ public:
+  // the cache directory under root_dir for the model files in
+  // model_weights_path and the parallel config.
+  static std::string cache_dir(const std::string& root_dir,
+                               const std::string& model_weights_path,
+                               int32_t world_size,
+                               int32_t dp_size,
+                               int32_t ep_size);
+
+  // opens the cache of the rank in dir, records the tensors read if it does
+  // not exist or is stale.
+  WeightCache(const std::string& dir, int32_t rank);
+
+  ~WeightCache();
+
+  // whether the tensors are served from the cache
+  bool hit() const { return mem_map_ != nullptr; }
+
+  // get the cached tensor read with the key, undefined if not cached. the
+  // misses of a cache hit are logged on commit if count_miss is set.
+  torch::Tensor lookup(const std::string& key, bool count_miss = true) const;
+
+  // record the tensor read with the key, no-op for a cache hit.
+  void record(const std::string& key, const torch::Tensor& tensor);
+
+  // write the manifest of the recorded tensors so that the next load uses
+  // them. returns false if nothing was written.
+  bool commit();
+
+ private:
+  struct Entry {
+    std::string key;
+    int32_t dtype = 0;
+    std::vector<int64_t> sizes;
+    size_t offset = 0;
+  };
+
+  bool open();
+
+  bool write(const void* data, size_t size, size_t offset);
+
+  std::string dir_;
+
+  int32_t rank_ = 0;
+
+  std::string manifest_file_;
+
+  std::string data_file_;
+
+  // unique to the instance, identifies its commit
+  std::string commit_id_;
+
+  // the suffix of the temporary files written before they are renamed, unique
+  // to the instance so that concurrent instances don't clobber each other
+  std::string tmp_suffix_;
+
+  // the mapped data file and its tensors for a cache hit
+  std::unique_ptr<folly::MemoryMapping> mem_map_;
+
+  absl::flat_hash_map<std::string, torch::Tensor> tensors_;
+
+  mutable std::atomic<size_t> num_misses_{0};
+
+  absl::Mutex mutex_;
+
+  // the data file being written and its entries for a cache miss
+  int fd_ ABSL_GUARDED_BY(mutex_) = -1;
+
+  bool failed_ ABSL_GUARDED_BY(mutex_) = false;
+
+  size_t size_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  std::vector<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+
+  absl::flat_hash_set<std::string> recorded_keys_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xllm
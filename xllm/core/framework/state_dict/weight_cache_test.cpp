@@ -0,0 +1,120 @@
+#include "weight_cache.h"
+
+#include <gtest/gtest.h>
+#include <torch/torch.h>
+#include <unistd.h>
+
+#include <filesystem>
+
+#include "state_dict.h"
+
+namespace xllm {
+
+class WeightCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = std::filesystem::temp_directory_path() /
+           ("weight_cache_test_" + std::to_string(getpid()));
+    std::filesystem::remove_all(dir_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  std::filesystem::path dir_;
+};
+
+TEST_F(WeightCacheTest, RecordAndLoad) {
+  const auto weight = torch::arange(4 * 6, torch::kFloat32).reshape({4, 6});
+  const auto bias = torch::arange(3, torch::kInt64);
+  std::unordered_map<std::string, torch::Tensor> dict = {
+      {"model.weight", weight}, {"model.bias", bias}};
+
+  {
+    auto weight_cache = std::make_shared<WeightCache>(dir_.string(), 1);
+    EXPECT_FALSE(weight_cache->hit());
+    StateDict state_dict(dict);
+    state_dict.set_weight_cache(weight_cache);
+    const auto model = state_dict.get_dict_with_prefix("model.");
+    model.get_sharded_tensor("weight", 1, 1, 2);
+    model.get_tensor("bias");
+    EXPECT_TRUE(weight_cache->commit());
+  }
+
+  auto weight_cache = std::make_shared<WeightCache>(dir_.string(), 1);
+  ASSERT_TRUE(weight_cache->hit());
+  EXPECT_TRUE(torch::equal(weight_cache->lookup("model.weight@1/1/2"),
+                           weight.chunk(2, 1)[1]));
+  EXPECT_TRUE(torch::equal(weight_cache->lookup("model.bias"), bias));
+  EXPECT_FALSE(weight_cache->lookup("model.weight").defined());
+
+  // the tensors not recorded are read from the state dict
+  StateDict state_dict(dict);
+  state_dict.set_weight_cache(weight_cache);
+  const auto shard = state_dict.get_sharded_tensor("model.weight", 0, 0, 2);
+  EXPECT_TRUE(torch::equal(shard, weight.chunk(2, 0)[0]));
+  EXPECT_FALSE(weight_cache->commit());
+
+  // the cache of another rank is not used
+  EXPECT_FALSE(WeightCache(dir_.string(), 0).hit());
+}
+
+TEST_F(WeightCacheTest, ConcurrentRecordsAndTruncatedData) {
+  const auto weight = torch::arange(4096, torch::kFloat32);
+
+  // two instances record the same cache at the same time
+  auto first = std::make_shared<WeightCache>(dir_.string(), 0);
+  auto second = std::make_shared<WeightCache>(dir_.string(), 0);
+  first->record("bias", torch::ones({2}));
+  second->record("bias", torch::ones({2}));
+  first->record("weight", weight);
+  second->record("weight", weight);
+  EXPECT_TRUE(first->commit());
+  EXPECT_TRUE(second->commit());
+
+  {
+    auto weight_cache = std::make_shared<WeightCache>(dir_.string(), 0);
+    ASSERT_TRUE(weight_cache->hit());
+    EXPECT_TRUE(torch::equal(weight_cache->lookup("weight"), weight));
+
+    // the iterated tensors are served from the cache as well
+    StateDict state_dict({{"weight", weight}});
+    state_dict.set_weight_cache(weight_cache);
+    for (const auto& [name, tensor] : state_dict) {
+      EXPECT_EQ(tensor.data_ptr(), weight_cache->lookup("weight").data_ptr());
+    }
+  }
+
+  // the tensors beyond the end of a truncated data file are not mapped
+  std::filesystem::resize_file(dir_ / "rank-0.bin", 4096);
+  WeightCache weight_cache(dir_.string(), 0);
+  EXPECT_FALSE(weight_cache.hit());
+  EXPECT_FALSE(weight_cache.lookup("weight").defined());
+}
+
+TEST_F(WeightCacheTest, DataFileOfAnotherCommit) {
+  const auto weight = torch::arange(1024, torch::kFloat32);
+
+  // two commits of the same size with different data
+  {
+    WeightCache weight_cache(dir_.string(), 0);
+    weight_cache.record("weight", weight);
+    EXPECT_TRUE(weight_cache.commit());
+  }
+  const auto first_data_file = dir_ / "first.bin";
+  std::filesystem::copy_file(dir_ / "rank-0.bin", first_data_file);
+  {
+    WeightCache weight_cache(dir_.string(), 0);
+    weight_cache.record("weight", weight * 2);
+    EXPECT_TRUE(weight_cache.commit());
+  }
+  EXPECT_TRUE(WeightCache(dir_.string(), 0).hit());
+
+  // the manifest of the second commit with the data file of the first one,
+  // as left by two instances committing at the same time
+  std::filesystem::rename(first_data_file, dir_ / "rank-0.bin");
+  WeightCache weight_cache(dir_.string(), 0);
+  EXPECT_FALSE(weight_cache.hit());
+  EXPECT_FALSE(weight_cache.lookup("weight").defined());
+}
+
+}  // namespace xllm
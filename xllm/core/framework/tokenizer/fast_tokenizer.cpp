@@ -11,8 +11,16 @@ FastTokenizer::FastTokenizer(const std::string& tokenizer_json_path)
       << "Failed to load tokenizer from file: " << tokenizer_json_path;
 }
 
+FastTokenizer::FastTokenizer(const std::string& tokenizer_json_path,
+                             TokenizerHandle handle)
+    : tokenizer_json_path_(tokenizer_json_path), handle_(handle) {
+  CHECK(handle_ != nullptr) << "Invalid tokenizer handle";
+}
+
 std::unique_ptr<Tokenizer> FastTokenizer::clone() const {
-  return std::make_unique<FastTokenizer>(tokenizer_json_path_);
+  // the clone shares the loaded tokenizer instead of parsing the json again
+  return std::unique_ptr<Tokenizer>(
+      new FastTokenizer(tokenizer_json_path_, tokenizers_clone(handle_)));
 }
 
 FastTokenizer::~FastTokenizer() { tokenizers_free(handle_); }
@@ -25,6 +33,7 @@ bool FastTokenizer::encode(const std::string_view& text,
 
   std::vector<int32_t> ret(result.token_ids, result.token_ids + result.len);
   *ids = std::move(ret);
+  tokenizers_free_encode_results(&result, /*num_seqs=*/1);
 
   return true;
 }
@@ -42,6 +51,66 @@ std::string FastTokenizer::decode(const Slice<int32_t>& ids,
   return {data, len};
 }
 
+bool FastTokenizer::encode_batch(const std::vector<std::string_view>& texts,
+                                 std::vector<std::vector<int32_t>>* ids) const {
+  const size_t num_seqs = texts.size();
+  std::vector<const char*> data(num_seqs);
+  std::vector<size_t> lens(num_seqs);
+  for (size_t i = 0; i < num_seqs; ++i) {
+    // rust doesn't accept null pointers even for empty slices
+    data[i] = texts[i].empty() ? "" : texts[i].data();
+    lens[i] = texts[i].size();
+  }
+
+  std::vector<TokenizerEncodeResult> results(num_seqs);
+  tokenizers_encode_batch(handle_,
+                          data.data(),
+                          lens.data(),
+                          num_seqs,
+                          /*add_special_tokens=*/1,
+                          results.data());
+
+  ids->clear();
+  ids->reserve(num_seqs);
+  for (const auto& result : results) {
+    ids->emplace_back(result.token_ids, result.token_ids + result.len);
+  }
+  tokenizers_free_encode_results(results.data(), num_seqs);
+  return true;
+}
+
+std::vector<std::string> FastTokenizer::decode_batch(
+    const std::vector<Slice<int32_t>>& ids,
+    bool skip_special_tokens) const {
+  static const uint32_t kEmpty = 0;
+  const size_t num_seqs = ids.size();
+  std::vector<const uint32_t*> data(num_seqs);
+  std::vector<size_t> lens(num_seqs);
+  for (size_t i = 0; i < num_seqs; ++i) {
+    // rust doesn't accept null pointers even for empty slices
+    data[i] = ids[i].empty() ? &kEmpty
+                             : reinterpret_cast<const uint32_t*>(ids[i].data());
+    lens[i] = ids[i].size();
+  }
+
+  std::vector<const char*> decode_data(num_seqs, nullptr);
+  std::vector<size_t> decode_lens(num_seqs, 0);
+  tokenizers_decode_batch(handle_,
+                          data.data(),
+                          lens.data(),
+                          num_seqs,
+                          skip_special_tokens,
+                          decode_data.data(),
+                          decode_lens.data());
+
+  std::vector<std::string> texts;
+  texts.reserve(num_seqs);
+  for (size_t i = 0; i < num_seqs; ++i) {
+    texts.emplace_back(decode_data[i], decode_lens[i]);
+  }
+  return texts;
+}
+
 std::optional<int32_t> FastTokenizer::token_to_id(
     const std::string_view& token) const {
   int32_t id = -1;
@@ -17,6 +17,15 @@ class FastTokenizer : public Tokenizer {
   std::string decode(const Slice<int32_t>& ids,
                      bool skip_special_tokens) const override;
 
+  // the batch is passed to the rust tokenizer in one call, which encodes or
+  // decodes the sequences in parallel.
+  bool encode_batch(const std::vector<std::string_view>& texts,
+                    std::vector<std::vector<int32_t>>* ids) const override;
+
+  std::vector<std::string> decode_batch(
+      const std::vector<Slice<int32_t>>& ids,
+      bool skip_special_tokens) const override;
+
   std::optional<int32_t> token_to_id(
       const std::string_view& token) const override;
 
@@ -27,6 +36,10 @@ class FastTokenizer : public Tokenizer {
   std::unique_ptr<Tokenizer> clone() const override;
 
  private:
+  // takes the ownership of the handle
+  FastTokenizer(const std::string& tokenizer_json_path,
+                TokenizerHandle handle);
+
   std::string tokenizer_json_path_;
 
   TokenizerHandle handle_ = nullptr;
@@ -28,10 +28,11 @@ namespace xllm {
 SentencePieceTokenizer::SentencePieceTokenizer(const std::string_view& dir_path,
                                                const TokenizerArgs& args)
     : dir_path_(dir_path), args_(args) {
+  auto vocab = std::make_shared<Vocab>();
   const std::string vocab_file_path =
       dir_path.empty() ? args.vocab_file()
                        : absl::StrCat(dir_path_, "/", args.vocab_file());
-  const auto status = sp_processor_.Load(vocab_file_path);
+  const auto status = vocab->sp_processor.Load(vocab_file_path);
   if (!status.ok()) {
     LOG(FATAL) << "Failed to load SentencePiece model from " << vocab_file_path
                << ": " << status.ToString() << ", error " << status.ToString();
@@ -39,9 +40,9 @@ SentencePieceTokenizer::SentencePieceTokenizer(const std::string_view& dir_path,
 
   // add special tokens and construct special token regex
   if (!args.special_tokens().empty()) {
-    const auto vocab_size = sp_processor_.GetPieceSize();
-    load_special_tokens(args.special_tokens());
+    load_special_tokens(args.special_tokens(), vocab.get());
   }
+  vocab_ = vocab;
 
   // construct prefix tokens
   if (!args.prefix_tokens().empty()) {
@@ -51,7 +52,7 @@ SentencePieceTokenizer::SentencePieceTokenizer(const std::string_view& dir_path,
       }
       const auto token_id = token_to_id(token);
       if (token_id.has_value()) {
-        prefix_token_ids_.push_back(token_id.value());
+        vocab->prefix_token_ids.push_back(token_id.value());
         LOG(INFO) << "Prefix token: " << token << ", id: " << token_id.value();
       } else {
         LOG(ERROR) << "Failed to find prefix token: " << token;
@@ -61,18 +62,19 @@ SentencePieceTokenizer::SentencePieceTokenizer(const std::string_view& dir_path,
 }
 
 void SentencePieceTokenizer::load_special_tokens(
-    const std::vector<SpecialToken>& special_tokens) {
+    const std::vector<SpecialToken>& special_tokens,
+    Vocab* vocab) {
   // for each special token, add to encoder and decoder
   for (const auto& [token, id] : special_tokens) {
     if (token.empty()) {
       continue;
     }
 
-    if (!special_token_encoder_.try_emplace(token, id).second) {
+    if (!vocab->special_token_encoder.try_emplace(token, id).second) {
       LOG(WARNING) << "Duplicate special token: " << token << ", id: " << id;
     }
 
-    if (!special_token_decoder_.try_emplace(id, token).second) {
+    if (!vocab->special_token_decoder.try_emplace(id, token).second) {
       LOG(WARNING) << "Duplicate special token: " << token << ", id: " << id;
     }
   }
@@ -92,7 +94,7 @@ void SentencePieceTokenizer::load_special_tokens(
     const auto special_token_regex_str = absl::StrJoin(escaped_tokens, "|");
     // surround with () to match special tokens
     const auto regex_str = absl::StrCat("(", special_token_regex_str, ")");
-    special_token_regex_ = std::make_unique<re2::RE2>(regex_str);
+    vocab->special_token_regex = std::make_unique<re2::RE2>(regex_str);
   }
 }
 
@@ -104,7 +106,8 @@ bool SentencePieceTokenizer::encode_internal(const std::string_view& text,
   }
 
   sentencepiece::SentencePieceText spt;
-  RETURN_FALSE_IF_ERROR(sp_processor_.Encode({text.data(), text.size()}, &spt));
+  RETURN_FALSE_IF_ERROR(
+      vocab_->sp_processor.Encode({text.data(), text.size()}, &spt));
   for (const auto& sp : spt.pieces()) {
     ids->emplace_back(sp.id());
   }
@@ -114,12 +117,12 @@ bool SentencePieceTokenizer::encode_internal(const std::string_view& text,
 bool SentencePieceTokenizer::encode(const std::string_view& text,
                                     std::vector<int32_t>* ids) const {
   // prepend prefix tokens if exists
-  if (!prefix_token_ids_.empty()) {
-    ids->insert(
-        ids->begin(), prefix_token_ids_.begin(), prefix_token_ids_.end());
+  const auto& prefix_token_ids = vocab_->prefix_token_ids;
+  if (!prefix_token_ids.empty()) {
+    ids->insert(ids->begin(), prefix_token_ids.begin(), prefix_token_ids.end());
   }
 
-  if (special_token_regex_ == nullptr) {
+  if (vocab_->special_token_regex == nullptr) {
     return encode_internal(text, ids);
   }
 
@@ -127,7 +130,8 @@ bool SentencePieceTokenizer::encode(const std::string_view& text,
   absl::string_view special;
   while (true) {
     const auto* start = input.begin();
-    if (!re2::RE2::FindAndConsume(&input, *special_token_regex_, &special)) {
+    if (!re2::RE2::FindAndConsume(
+            &input, *vocab_->special_token_regex, &special)) {
       // no more special tokens
       break;
     }
@@ -140,8 +144,8 @@ bool SentencePieceTokenizer::encode(const std::string_view& text,
     }
 
     // add special token id if exists
-    const auto sit = special_token_encoder_.find(special);
-    if (sit != special_token_encoder_.end()) {
+    const auto sit = vocab_->special_token_encoder.find(special);
+    if (sit != vocab_->special_token_encoder.end()) {
       // find one special token
       ids->push_back(sit->second);
     }
@@ -162,7 +166,7 @@ void SentencePieceTokenizer::decode_internal(const Slice<int32_t>& ids,
 
   sentencepiece::SentencePieceText spt;
   std::vector<std::string> pieces;
-  const int num_pieces = sp_processor_.GetPieceSize();
+  const int num_pieces = vocab_->sp_processor.GetPieceSize();
   pieces.reserve(end - start);
   for (size_t i = start; i < end; ++i) {
     const auto id = ids[i];
@@ -170,9 +174,9 @@ void SentencePieceTokenizer::decode_internal(const Slice<int32_t>& ids,
       LOG(ERROR) << "Invalid id: " << id;
       continue;
     }
-    pieces.emplace_back(sp_processor_.IdToPiece(id));
+    pieces.emplace_back(vocab_->sp_processor.IdToPiece(id));
   }
-  RETURN_IF_ERROR(sp_processor_.Decode(pieces, &spt));
+  RETURN_IF_ERROR(vocab_->sp_processor.Decode(pieces, &spt));
   (*ss) << spt.text();
 }
 
@@ -182,8 +186,8 @@ std::string SentencePieceTokenizer::decode(const Slice<int32_t>& ids,
   size_t start = 0;
   for (size_t i = 0; i < ids.size(); ++i) {
     // identify special token
-    const auto sit = special_token_decoder_.find(ids[i]);
-    if (sit == special_token_decoder_.end()) {
+    const auto sit = vocab_->special_token_decoder.find(ids[i]);
+    if (sit == vocab_->special_token_decoder.end()) {
       continue;
     }
     // decode text before special token if exists
@@ -205,14 +209,14 @@ std::optional<int32_t> SentencePieceTokenizer::token_to_id(
     const std::string_view& token) const {
   // encode special token
   const absl::string_view token_view{token.data(), token.size()};
-  const auto sit = special_token_encoder_.find(token_view);
-  if (sit != special_token_encoder_.end()) {
+  const auto sit = vocab_->special_token_encoder.find(token_view);
+  if (sit != vocab_->special_token_encoder.end()) {
     return sit->second;
   }
 
   // encode token
-  const auto token_id = sp_processor_.PieceToId(token_view);
-  if (sp_processor_.IsUnknown(token_id)) {
+  const auto token_id = vocab_->sp_processor.PieceToId(token_view);
+  if (vocab_->sp_processor.IsUnknown(token_id)) {
     LOG(ERROR) << "Failed to find id for token: " << token;
     return std::nullopt;
   }
@@ -221,22 +225,23 @@ std::optional<int32_t> SentencePieceTokenizer::token_to_id(
 
 std::string SentencePieceTokenizer::id_to_token(int32_t id) const {
   // decode special token
-  const auto sit = special_token_decoder_.find(id);
-  if (sit != special_token_decoder_.end()) {
+  const auto sit = vocab_->special_token_decoder.find(id);
+  if (sit != vocab_->special_token_decoder.end()) {
     return sit->second;
   }
 
   // decode token
-  return sp_processor_.IdToPiece(id);
+  return vocab_->sp_processor.IdToPiece(id);
 }
 
 size_t SentencePieceTokenizer::vocab_size() const {
   // vocab size = sentencepiece vocab size + special tokens
-  return sp_processor_.GetPieceSize() + args_.special_tokens().size();
+  return vocab_->sp_processor.GetPieceSize() + args_.special_tokens().size();
 }
 
 std::unique_ptr<Tokenizer> SentencePieceTokenizer::clone() const {
-  return std::make_unique<SentencePieceTokenizer>(dir_path_, args_);
+  // the model is immutable, share it instead of loading it again
+  return std::make_unique<SentencePieceTokenizer>(*this);
 }
 
 }  // namespace xllm
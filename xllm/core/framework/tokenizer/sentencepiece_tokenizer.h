@@ -3,6 +3,7 @@
 #include <re2/re2.h>
 
 #include <cstdint>
+#include <memory>
 
 #include "sentencepiece/sentencepiece_processor.h"
 #include "tokenizer.h"
@@ -32,7 +33,27 @@ class SentencePieceTokenizer : public Tokenizer {
   std::unique_ptr<Tokenizer> clone() const override;
 
  private:
-  void load_special_tokens(const std::vector<SpecialToken>& special_tokens);
+  // sentencepiece model and special tokens, immutable once loaded and shared
+  // by all clones of the tokenizer.
+  struct Vocab {
+    sentencepiece::SentencePieceProcessor sp_processor;
+
+    // special tokens to ids
+    absl::flat_hash_map<std::string, int32_t> special_token_encoder;
+
+    // special token ids to tokens
+    absl::flat_hash_map<int32_t, std::string> special_token_decoder;
+
+    // special token regex (optional)
+    std::unique_ptr<re2::RE2> special_token_regex;
+
+    // token ids to add to the beginning of the input sequence
+    std::vector<int32_t> prefix_token_ids;
+  };
+
+  static void load_special_tokens(
+      const std::vector<SpecialToken>& special_tokens,
+      Vocab* vocab);
 
   bool encode_internal(const std::string_view& text,
                        std::vector<int32_t>* ids) const;
@@ -45,19 +66,7 @@ class SentencePieceTokenizer : public Tokenizer {
 
   TokenizerArgs args_;
 
-  sentencepiece::SentencePieceProcessor sp_processor_;
-
-  // special tokens to ids
-  absl::flat_hash_map<std::string, int32_t> special_token_encoder_;
-
-  // special token ids to tokens
-  absl::flat_hash_map<int32_t, std::string> special_token_decoder_;
-
-  // special token regex (optional)
-  std::unique_ptr<re2::RE2> special_token_regex_;
-
-  // token ids to add to the beginning of the input sequence
-  std::vector<int32_t> prefix_token_ids_;
+  std::shared_ptr<const Vocab> vocab_;
 };
 
 }  // namespace xllm
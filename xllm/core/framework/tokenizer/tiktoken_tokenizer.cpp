@@ -9,8 +9,12 @@
 #include <glog/logging.h>
 #include <re2/re2.h>
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
+#include <limits>
 #include <optional>
+#include <queue>
 #include <string>
 #include <string_view>
 
@@ -18,30 +22,65 @@
 
 namespace xllm {
 
+namespace {
+// U+FFFD in utf-8
+constexpr std::string_view kReplacementChar = "\xEF\xBF\xBD";
+
+inline uint64_t pair_key(int32_t left_id, int32_t right_id) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(left_id)) << 32) |
+         static_cast<uint32_t>(right_id);
+}
+
+// whether the bytes are the beginning of a multi-byte utf-8 character
+bool is_incomplete_utf8(absl::string_view bytes) {
+  const auto lead = static_cast<uint8_t>(bytes[0]);
+  size_t char_len = 0;
+  if ((lead & 0xE0) == 0xC0) {
+    char_len = 2;
+  } else if ((lead & 0xF0) == 0xE0) {
+    char_len = 3;
+  } else if ((lead & 0xF8) == 0xF0) {
+    char_len = 4;
+  }
+  if (bytes.size() >= char_len) {
+    return false;
+  }
+  for (size_t i = 1; i < bytes.size(); ++i) {
+    if ((static_cast<uint8_t>(bytes[i]) & 0xC0) != 0x80) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
 TiktokenTokenizer::TiktokenTokenizer(const std::string_view& dir_path,
                                      const TokenizerArgs& args)
     : dir_path_(dir_path), args_(args) {
+  auto vocab = std::make_shared<Vocab>();
   // load vocab from file
   const std::string vocab_file_path =
       dir_path.empty() ? args.vocab_file()
                        : absl::StrCat(dir_path_, "/", args.vocab_file());
-  load_vocab(vocab_file_path);
+  load_vocab(vocab_file_path, vocab.get());
+  build_merge_table(vocab.get());
 
   // add special tokens and construct special token regex
   if (!args.special_tokens().empty()) {
-    const auto vocab_size = encoder_.size();
-    load_special_tokens(args.special_tokens());
+    load_special_tokens(args.special_tokens(), vocab.get());
   }
+  build_decoder_table(vocab.get());
 
   // construct regex
   if (!args.pattern().empty()) {
     const auto regex_str = absl::StrCat("(", args.pattern(), ")");
-    regex_ = std::make_unique<re2::RE2>(regex_str);
-    if (regex_->error_code() != 0) {
+    vocab->regex = std::make_unique<re2::RE2>(regex_str);
+    if (vocab->regex->error_code() != 0) {
       LOG(FATAL) << "Failed to compile regex: " << args.pattern()
-                 << ", error: " << regex_->error();
+                 << ", error: " << vocab->regex->error();
     }
   }
+  vocab_ = vocab;
 
   // construct prefix tokens
   if (!args.prefix_tokens().empty()) {
@@ -51,7 +90,7 @@ TiktokenTokenizer::TiktokenTokenizer(const std::string_view& dir_path,
       }
       const auto token_id = token_to_id(token);
       if (token_id.has_value()) {
-        prefix_token_ids_.push_back(token_id.value());
+        vocab->prefix_token_ids.push_back(token_id.value());
         LOG(INFO) << "Prefix token: " << token << ", id: " << token_id.value();
       } else {
         LOG(ERROR) << "Failed to find prefix token: " << token;
@@ -61,18 +100,15 @@ TiktokenTokenizer::TiktokenTokenizer(const std::string_view& dir_path,
 }
 
 void TiktokenTokenizer::load_special_tokens(
-    const std::vector<SpecialToken>& special_tokens) {
-  // for each special token, add to encoder and decoder
+    const std::vector<SpecialToken>& special_tokens,
+    Vocab* vocab) {
+  // for each special token, add to encoder
   for (const auto& [token, id] : special_tokens) {
     if (token.empty()) {
       continue;
     }
 
-    if (!special_token_encoder_.try_emplace(token, id).second) {
-      LOG(WARNING) << "Duplicate special token: " << token << ", id: " << id;
-    }
-
-    if (!special_token_decoder_.try_emplace(id, token).second) {
+    if (!vocab->special_token_encoder.try_emplace(token, id).second) {
       LOG(WARNING) << "Duplicate special token: " << token << ", id: " << id;
     }
   }
@@ -92,11 +128,12 @@ void TiktokenTokenizer::load_special_tokens(
     const auto special_token_regex_str = absl::StrJoin(escaped_tokens, "|");
     // surround with () to match special tokens
     const auto regex_str = absl::StrCat("(", special_token_regex_str, ")");
-    special_token_regex_ = std::make_unique<re2::RE2>(regex_str);
+    vocab->special_token_regex = std::make_unique<re2::RE2>(regex_str);
   }
 }
 
-void TiktokenTokenizer::load_vocab(const std::string& vocab_file_path) {
+void TiktokenTokenizer::load_vocab(const std::string& vocab_file_path,
+                                   Vocab* vocab) {
   // read token + rank from vocab file
   std::ifstream fs(vocab_file_path);
   if (!fs) {
@@ -127,11 +164,86 @@ void TiktokenTokenizer::load_vocab(const std::string& vocab_file_path) {
       continue;
     }
 
-    if (!encoder_.try_emplace(token, rank).second) {
+    if (!vocab->encoder.try_emplace(token, rank).second) {
       LOG(WARNING) << "Duplicate token: " << token;
     }
-    if (!decoder_.try_emplace(rank, token).second) {
-      LOG(WARNING) << "Duplicate rank: " << rank;
+  }
+}
+
+void TiktokenTokenizer::build_decoder_table(Vocab* vocab) {
+  int32_t max_id = -1;
+  for (const auto& [token, id] : vocab->encoder) {
+    max_id = std::max(max_id, id);
+  }
+  for (const auto& [token, id] : vocab->special_token_encoder) {
+    max_id = std::max(max_id, id);
+  }
+
+  // special tokens take precedence over normal tokens with the same id
+  std::vector<const std::string*> tokens(max_id + 1, nullptr);
+  vocab->is_special_token.assign(max_id + 1, false);
+  size_t n_bytes = 0;
+  for (const auto& [token, id] : vocab->encoder) {
+    if (id < 0) {
+      LOG(WARNING) << "Invalid rank: " << id;
+      continue;
+    }
+    if (tokens[id] != nullptr) {
+      LOG(WARNING) << "Duplicate rank: " << id;
+    }
+    tokens[id] = &token;
+    n_bytes += token.size();
+  }
+  for (const auto& [token, id] : vocab->special_token_encoder) {
+    if (id < 0) {
+      LOG(WARNING) << "Invalid special token id: " << id;
+      continue;
+    }
+    if (vocab->is_special_token[id]) {
+      LOG(WARNING) << "Duplicate special token: " << token << ", id: " << id;
+    }
+    tokens[id] = &token;
+    vocab->is_special_token[id] = true;
+    n_bytes += token.size();
+  }
+
+  vocab->token_bytes.reserve(n_bytes);
+  vocab->token_offsets.reserve(tokens.size() + 1);
+  vocab->token_offsets.push_back(0);
+  for (const auto* token : tokens) {
+    if (token != nullptr) {
+      vocab->token_bytes.append(*token);
+    }
+    vocab->token_offsets.push_back(vocab->token_bytes.size());
+  }
+}
+
+void TiktokenTokenizer::build_merge_table(Vocab* vocab) {
+  vocab->byte_ranks.fill(-1);
+  for (int32_t b = 0; b < 256; ++b) {
+    const char c = static_cast<char>(b);
+    auto it = vocab->encoder.find(absl::string_view(&c, 1));
+    if (it != vocab->encoder.end()) {
+      vocab->byte_ranks[b] = it->second;
+    }
+  }
+
+  // a merge always produces a token of the vocab, so enumerating all splits
+  // of each token gives the rank of every possible merge of two tokens.
+  vocab->pair_ranks.reserve(vocab->encoder.size() * 2);
+  for (const auto& [token, rank] : vocab->encoder) {
+    const absl::string_view token_view(token);
+    for (size_t i = 1; i < token_view.size(); ++i) {
+      auto left = vocab->encoder.find(token_view.substr(0, i));
+      if (left == vocab->encoder.end()) {
+        continue;
+      }
+      auto right = vocab->encoder.find(token_view.substr(i));
+      if (right == vocab->encoder.end()) {
+        continue;
+      }
+      vocab->pair_ranks.try_emplace(pair_key(left->second, right->second),
+                                    rank);
     }
   }
 }
@@ -143,83 +255,98 @@ void TiktokenTokenizer::byte_pair_encode(const std::string_view& piece,
     return;
   }
 
-  // This is a vector of (start, rank) pairs.
-  // The rank is of the byte pair startig at position start.
-  // The rank of the last item in the vector is not a valid value.
-  std::vector<std::pair<int32_t, int32_t>> parts;
-  parts.reserve(piece.size() + 1);
+  const int32_t n_bytes = static_cast<int32_t>(piece.size());
   const int32_t kMaxRank = std::numeric_limits<int32_t>::max();
-  for (int32_t i = 0; i <= piece.size(); ++i) {
-    parts.emplace_back(i, kMaxRank);
-  }
-
-  auto get_rank = [&piece, &parts, this](
-                      int32_t start, int32_t skip) -> std::optional<int32_t> {
-    if (start + skip + 2 < parts.size()) {
-      auto s = parts[start].first;
-      auto e = parts[start + skip + 2].first;
-      const auto key = piece.substr(s, e - s);
-      auto it = encoder_.find({key.data(), key.size()});
-      if (it != encoder_.end()) {
-        return it->second;
-      }
+
+  // A doubly linked list of parts, indexed by the start byte of the part.
+  // The rank is of the merge with the next part, kMaxRank if not mergeable
+  // or the part has been merged into its previous part.
+  struct Part {
+    int32_t id;
+    int32_t rank;
+    int32_t prev;
+    int32_t next;
+  };
+  std::vector<Part> parts(n_bytes);
+  for (int32_t i = 0; i < n_bytes; ++i) {
+    const auto byte = static_cast<uint8_t>(piece[i]);
+    parts[i] = {vocab_->byte_ranks[byte], kMaxRank, i - 1, i + 1};
+  }
+
+  auto get_rank = [&piece, &parts, n_bytes, kMaxRank, this](int32_t i) {
+    const int32_t j = parts[i].next;
+    if (j >= n_bytes) {
+      return kMaxRank;
+    }
+    if (parts[i].id >= 0 && parts[j].id >= 0) {
+      auto it = vocab_->pair_ranks.find(pair_key(parts[i].id, parts[j].id));
+      return it != vocab_->pair_ranks.end() ? it->second : kMaxRank;
     }
-    return std::nullopt;
+    // one of the parts is not in the vocab, look up the bytes instead
+    const auto key = piece.substr(i, parts[j].next - i);
+    auto it = vocab_->encoder.find({key.data(), key.size()});
+    return it != vocab_->encoder.end() ? it->second : kMaxRank;
   };
 
-  // We look up the ranks once in the beginning and iteratively update
-  // them during each merge, which reduces the number of rank lookups.
-  for (int32_t i = 0; i < parts.size() - 2; ++i) {
-    const auto rank = get_rank(i, 0);
-    if (rank.has_value()) {
-      // kMaxRank is a sentinel value and cannot be a valid rank.
-      CHECK(rank.value() != kMaxRank) << "Invalid rank";
-      parts[i].second = rank.value();
-    }
-  }
-
-  while (parts.size() > 1) {
-    // find i with min rank. kMaxRank is a sentinel value.
-    int32_t min_rank = kMaxRank;
-    int32_t min_i = 0;
-    for (int32_t i = 0; i < parts.size() - 1; ++i) {
-      const auto rank = parts[i].second;
-      if (rank < min_rank) {
-        min_rank = rank;
-        min_i = i;
-      }
+  // min heap of (rank, start) of candidate merges, ties are broken by the
+  // leftmost position. Entries are stale once the rank of the part changes.
+  using Merge = std::pair<int32_t, int32_t>;
+  std::vector<Merge> heap_storage;
+  heap_storage.reserve(n_bytes);
+  std::priority_queue<Merge, std::vector<Merge>, std::greater<Merge>> heap(
+      std::greater<Merge>(), std::move(heap_storage));
+  for (int32_t i = 0; i + 1 < n_bytes; ++i) {
+    const int32_t rank = get_rank(i);
+    if (rank != kMaxRank) {
+      parts[i].rank = rank;
+      heap.emplace(rank, i);
     }
+  }
 
-    if (min_rank == kMaxRank) {
-      // No more merges possible.
-      break;
+  while (!heap.empty()) {
+    const auto [rank, i] = heap.top();
+    heap.pop();
+    if (parts[i].rank != rank) {
+      // stale entry
+      continue;
+    }
+
+    // merge parts[i] with the next part, the rank is the id of the new token
+    const int32_t j = parts[i].next;
+    parts[i].id = rank;
+    parts[i].next = parts[j].next;
+    if (parts[j].next < n_bytes) {
+      parts[parts[j].next].prev = i;
     }
+    parts[j].rank = kMaxRank;
 
-    // remove parts[min_i + 1].
-    parts[min_i].second = get_rank(min_i, 1).value_or(kMaxRank);
-    if (min_i > 0) {
-      parts[min_i - 1].second = get_rank(min_i - 1, 1).value_or(kMaxRank);
+    // update the ranks of the merges involving the new part
+    parts[i].rank = get_rank(i);
+    if (parts[i].rank != kMaxRank) {
+      heap.emplace(parts[i].rank, i);
+    }
+    const int32_t prev = parts[i].prev;
+    if (prev >= 0) {
+      parts[prev].rank = get_rank(prev);
+      if (parts[prev].rank != kMaxRank) {
+        heap.emplace(parts[prev].rank, prev);
+      }
     }
-    parts.erase(parts.begin() + min_i + 1);
   }
 
-  for (int32_t i = 0; i < parts.size() - 1; ++i) {
-    const auto s = parts[i].first;
-    const auto e = parts[i + 1].first;
-    // get rank for each piece
-    const auto key = piece.substr(s, e - s);
-    auto it = encoder_.find({key.data(), key.size()});
-    if (it == encoder_.end()) {
-      LOG(ERROR) << "Failed to find key: " << key;
+  for (int32_t i = 0; i < n_bytes; i = parts[i].next) {
+    if (parts[i].id < 0) {
+      LOG(ERROR) << "Failed to find key: "
+                 << piece.substr(i, parts[i].next - i);
     } else {
-      ids->push_back(it->second);
+      ids->push_back(parts[i].id);
     }
   }
 }
 
 void TiktokenTokenizer::encode_internal(const std::string_view& text,
                                         std::vector<int32_t>* ids) const {
-  if (regex_ == nullptr) {
+  if (vocab_->regex == nullptr) {
     byte_pair_encode(text, ids);
     return;
   }
@@ -227,9 +354,9 @@ void TiktokenTokenizer::encode_internal(const std::string_view& text,
   absl::string_view input{text.data(), text.size()};
   absl::string_view piece;
   // std::string_view piece;
-  while (re2::RE2::FindAndConsume(&input, *regex_, &piece)) {
-    auto it = encoder_.find(piece);
-    if (it != encoder_.end()) {
+  while (re2::RE2::FindAndConsume(&input, *vocab_->regex, &piece)) {
+    auto it = vocab_->encoder.find(piece);
+    if (it != vocab_->encoder.end()) {
       ids->push_back(it->second);
       continue;
     }
@@ -240,12 +367,12 @@ void TiktokenTokenizer::encode_internal(const std::string_view& text,
 bool TiktokenTokenizer::encode(const std::string_view& text,
                                std::vector<int32_t>* ids) const {
   // prepend prefix tokens if exists
-  if (!prefix_token_ids_.empty()) {
-    ids->insert(
-        ids->begin(), prefix_token_ids_.begin(), prefix_token_ids_.end());
+  const auto& prefix_token_ids = vocab_->prefix_token_ids;
+  if (!prefix_token_ids.empty()) {
+    ids->insert(ids->begin(), prefix_token_ids.begin(), prefix_token_ids.end());
   }
 
-  if (special_token_regex_ == nullptr) {
+  if (vocab_->special_token_regex == nullptr) {
     encode_internal(text, ids);
     return true;
   }
@@ -254,7 +381,8 @@ bool TiktokenTokenizer::encode(const std::string_view& text,
   absl::string_view special;
   while (true) {
     const auto* start = input.begin();
-    if (!re2::RE2::FindAndConsume(&input, *special_token_regex_, &special)) {
+    if (!re2::RE2::FindAndConsume(
+            &input, *vocab_->special_token_regex, &special)) {
       // no more special tokens
       break;
     }
@@ -265,8 +393,8 @@ bool TiktokenTokenizer::encode(const std::string_view& text,
     encode_internal(sub_input, ids);
 
     // add special token id if exists
-    const auto sit = special_token_encoder_.find(special);
-    if (sit != special_token_encoder_.end()) {
+    const auto sit = vocab_->special_token_encoder.find(special);
+    if (sit != vocab_->special_token_encoder.end()) {
       // find one special token
       ids->push_back(sit->second);
     }
@@ -277,89 +405,124 @@ bool TiktokenTokenizer::encode(const std::string_view& text,
   return true;
 }
 
-std::string TiktokenTokenizer::decode(const Slice<int32_t>& ids,
-                                      bool skip_special_tokens) const {
-  std::stringstream ss;
+void TiktokenTokenizer::append_token_bytes(const Slice<int32_t>& ids,
+                                           bool skip_special_tokens,
+                                           std::string* bytes) const {
+  const auto& offsets = vocab_->token_offsets;
+  const int32_t n_ids = static_cast<int32_t>(offsets.size()) - 1;
+
+  size_t n_bytes = 0;
   for (const auto& id : ids) {
-    // encode special token
-    const auto sit = special_token_decoder_.find(id);
-    if (sit != special_token_decoder_.end()) {
-      if (!skip_special_tokens) {
-        ss << sit->second;
-      }
-      continue;
+    if (id >= 0 && id < n_ids) {
+      n_bytes += offsets[id + 1] - offsets[id];
     }
+  }
+  bytes->reserve(bytes->size() + n_bytes);
 
-    // encode token
-    const auto it = decoder_.find(id);
-    if (it != decoder_.end()) {
-      ss << it->second;
+  for (const auto& id : ids) {
+    if (id < 0 || id >= n_ids || offsets[id] == offsets[id + 1]) {
+      LOG(ERROR) << "Failed to find token for id: " << id;
       continue;
     }
-    LOG(ERROR) << "Failed to find token for id: " << id;
+    if (skip_special_tokens && vocab_->is_special_token[id]) {
+      continue;
+    }
+    bytes->append(
+        vocab_->token_bytes, offsets[id], offsets[id + 1] - offsets[id]);
   }
+}
 
-  std::string data = ss.str();
-  absl::string_view bytes(data);
+std::string TiktokenTokenizer::decode(const Slice<int32_t>& ids,
+                                      bool skip_special_tokens) const {
+  std::string text;
+  append_token_bytes(ids, skip_special_tokens, &text);
 
   // replace unfinished utf8 bytes with � (U+FFFD)
-  std::stringstream utf8_ss;
+  const absl::string_view bytes(text);
   size_t offset = 0;
   while (offset < bytes.size()) {
+    if (static_cast<uint8_t>(bytes[offset]) < 0x80) {
+      // fast path for ascii
+      ++offset;
+      continue;
+    }
     size_t consumed = 0;
-    const bool is_valid = sentencepiece::string_util::IsValidDecodeUTF8(
-        bytes.substr(offset), &consumed);
-    if (is_valid) {
-      utf8_ss << bytes.substr(offset, consumed);
-    } else {
-      // add replacement character � (U+FFFD) in UTF-8
-      utf8_ss << "�";
+    if (!sentencepiece::string_util::IsValidDecodeUTF8(bytes.substr(offset),
+                                                       &consumed)) {
+      text.resize(offset);
+      text.append(kReplacementChar);
       break;
     }
     offset += consumed;
   }
-  return utf8_ss.str();
+  return text;
+}
+
+bool TiktokenTokenizer::stream_decode(const Slice<int32_t>& ids,
+                                      bool skip_special_tokens,
+                                      std::string* text) const {
+  const size_t start = text->size();
+  append_token_bytes(ids, skip_special_tokens, text);
+
+  size_t offset = start;
+  while (offset < text->size()) {
+    if (static_cast<uint8_t>((*text)[offset]) < 0x80) {
+      // fast path for ascii
+      ++offset;
+      continue;
+    }
+    const absl::string_view bytes(text->data() + offset,
+                                  text->size() - offset);
+    size_t consumed = 0;
+    if (sentencepiece::string_util::IsValidDecodeUTF8(bytes, &consumed)) {
+      offset += consumed;
+      continue;
+    }
+    if (is_incomplete_utf8(bytes)) {
+      // wait for the rest bytes of the character
+      text->resize(start);
+      return false;
+    }
+    // replace the invalid byte with � (U+FFFD)
+    text->replace(offset, 1, kReplacementChar);
+    offset += kReplacementChar.size();
+  }
+  return true;
 }
 
 size_t TiktokenTokenizer::vocab_size() const {
   // vocab size = encoder size + special tokens size
-  return encoder_.size() + args_.special_tokens().size();
+  return vocab_->encoder.size() + args_.special_tokens().size();
 }
 
 std::unique_ptr<Tokenizer> TiktokenTokenizer::clone() const {
-  return std::make_unique<TiktokenTokenizer>(dir_path_, args_);
+  // the vocab is immutable, share it instead of loading it again
+  return std::make_unique<TiktokenTokenizer>(*this);
 }
 
 std::optional<int32_t> TiktokenTokenizer::token_to_id(
     const std::string_view& token) const {
   const absl::string_view token_view{token.data(), token.size()};
   // encode special token
-  const auto sit = special_token_encoder_.find(token_view);
-  if (sit != special_token_encoder_.end()) {
+  const auto sit = vocab_->special_token_encoder.find(token_view);
+  if (sit != vocab_->special_token_encoder.end()) {
     return sit->second;
   }
 
   // encode token
-  const auto it = encoder_.find(token_view);
-  if (it != encoder_.end()) {
+  const auto it = vocab_->encoder.find(token_view);
+  if (it != vocab_->encoder.end()) {
     return it->second;
   }
   return std::nullopt;
 }
 
 std::string TiktokenTokenizer::id_to_token(int32_t id) const {
-  // encode special token
-  const auto sit = special_token_decoder_.find(id);
-  if (sit != special_token_decoder_.end()) {
-    return sit->second;
-  }
-
-  // encode token
-  const auto it = decoder_.find(id);
-  if (it != decoder_.end()) {
-    return it->second;
+  const auto& offsets = vocab_->token_offsets;
+  if (id < 0 || id + 1 >= static_cast<int32_t>(offsets.size())) {
+    return "";
   }
-  return "";
+  return vocab_->token_bytes.substr(offsets[id], offsets[id + 1] - offsets[id]);
 }
 
 }  // namespace xllm
@@ -3,6 +3,8 @@
 #include <absl/container/flat_hash_map.h>
 #include <re2/re2.h>
 
+#include <array>
+#include <memory>
 #include <vector>
 
 #include "tokenizer.h"
@@ -23,6 +25,12 @@ class TiktokenTokenizer : public Tokenizer {
   std::string decode(const Slice<int32_t>& ids,
                      bool skip_special_tokens) const override;
 
+  bool support_stream_decode() const override { return true; }
+
+  bool stream_decode(const Slice<int32_t>& ids,
+                     bool skip_special_tokens,
+                     std::string* text) const override;
+
   std::optional<int32_t> token_to_id(
       const std::string_view& token) const override;
 
@@ -33,9 +41,54 @@ class TiktokenTokenizer : public Tokenizer {
   std::unique_ptr<Tokenizer> clone() const override;
 
  private:
-  void load_special_tokens(const std::vector<SpecialToken>& special_tokens);
+  // vocab, merge tables and regexes, immutable once loaded and shared by all
+  // clones of the tokenizer.
+  struct Vocab {
+    // token to ids
+    absl::flat_hash_map<std::string, int32_t> encoder;
+
+    // bytes of all tokens including special tokens, indexed by id. the bytes
+    // of a token are token_bytes[token_offsets[id], token_offsets[id + 1]),
+    // an empty range means the id is not in the vocab.
+    std::string token_bytes;
+    std::vector<uint32_t> token_offsets;
+    std::vector<bool> is_special_token;
+
+    // rank of merging two adjacent tokens, keyed by (left_id << 32 | right_id)
+    absl::flat_hash_map<uint64_t, int32_t> pair_ranks;
+
+    // rank of each single byte, -1 if the byte is not in the vocab
+    std::array<int32_t, 256> byte_ranks;
+
+    // a regex pattern to tokenize text
+    // N.B. RE2 doesn't support look-around assertions.
+    // https://github.com/google/re2/wiki/Syntax
+    std::unique_ptr<re2::RE2> regex;
+
+    // special tokens to ids
+    absl::flat_hash_map<std::string, int32_t> special_token_encoder;
+
+    // special token regex (optional)
+    std::unique_ptr<re2::RE2> special_token_regex;
+
+    // token ids to add to the beginning of the input sequence
+    std::vector<int32_t> prefix_token_ids;
+  };
 
-  void load_vocab(const std::string& vocab_file_path);
+  static void load_special_tokens(
+      const std::vector<SpecialToken>& special_tokens,
+      Vocab* vocab);
+
+  static void load_vocab(const std::string& vocab_file_path, Vocab* vocab);
+
+  static void build_merge_table(Vocab* vocab);
+
+  static void build_decoder_table(Vocab* vocab);
+
+  // append the bytes of the tokens, which may not be valid utf-8
+  void append_token_bytes(const Slice<int32_t>& ids,
+                          bool skip_special_tokens,
+                          std::string* bytes) const;
 
   void encode_internal(const std::string_view& text,
                        std::vector<int32_t>* ids) const;
@@ -47,27 +100,7 @@ class TiktokenTokenizer : public Tokenizer {
 
   TokenizerArgs args_;
 
-  // token to ids
-  absl::flat_hash_map<std::string, int32_t> encoder_;
-  // id to token
-  absl::flat_hash_map<int32_t, std::string> decoder_;
-
-  // a regex pattern to tokenize text
-  // N.B. RE2 doesn't support look-around assertions.
-  // https://github.com/google/re2/wiki/Syntax
-  std::unique_ptr<re2::RE2> regex_;
-
-  // special tokens to ids
-  absl::flat_hash_map<std::string, int32_t> special_token_encoder_;
-
-  // special token ids to tokens
-  absl::flat_hash_map<int32_t, std::string> special_token_decoder_;
-
-  // special token regex (optional)
-  std::unique_ptr<re2::RE2> special_token_regex_;
-
-  // token ids to add to the beginning of the input sequence
-  std::vector<int32_t> prefix_token_ids_;
+  std::shared_ptr<const Vocab> vocab_;
 };
 
 }  // namespace xllm
@@ -0,0 +1,153 @@
+#include <absl/strings/escaping.h>
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tiktoken_tokenizer.h"
+
+using namespace xllm;
+
+namespace {
+
+// cl100k_base pattern without look-around assertions
+constexpr char kPattern[] =
+    R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+)";
+
+constexpr size_t kVocabSize = 32000;
+
+const std::string kChatText =
+    "Hello! Could you help me plan a three day trip to Kyoto in autumn? "
+    "I would like to visit temples, try local food and avoid the crowds "
+    "if possible. Thanks a lot, looking forward to your suggestions.\n";
+
+const std::string kSourceCode =
+    "template <typename T>\n"
+    "std::vector<T> merge_sorted(const std::vector<T>& a,\n"
+    "                            const std::vector<T>& b) {\n"
+    "  std::vector<T> result;\n"
+    "  result.reserve(a.size() + b.size());\n"
+    "  size_t i = 0, j = 0;\n"
+    "  while (i < a.size() && j < b.size()) {\n"
+    "    result.push_back(a[i] <= b[j] ? a[i++] : b[j++]);\n"
+    "  }\n"
+    "  return result;\n"
+    "}\n";
+
+std::string repeat(const std::string& text, size_t n_bytes) {
+  std::string result;
+  result.reserve(n_bytes + text.size());
+  while (result.size() < n_bytes) {
+    result += text;
+  }
+  return result;
+}
+
+// a long run of letters without separators, like a base64 blob or CJK text
+// without spaces, which ends up as a single piece after the regex split.
+std::string long_run(size_t n_bytes) {
+  static constexpr char kLetters[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<size_t> dist(0, sizeof(kLetters) - 2);
+  std::string text(n_bytes, '\0');
+  std::generate(
+      text.begin(), text.end(), [&]() { return kLetters[dist(gen)]; });
+  return text;
+}
+
+// build a vocab from the most frequent substrings of the corpus, shorter
+// tokens get lower ranks so that every token is reachable by merges.
+std::string write_vocab(const std::vector<std::string>& corpus) {
+  std::unordered_map<std::string, size_t> counts;
+  for (const auto& text : corpus) {
+    for (size_t len = 2; len <= 8; ++len) {
+      for (size_t i = 0; i + len <= text.size(); ++i) {
+        ++counts[text.substr(i, len)];
+      }
+    }
+  }
+  std::vector<std::pair<std::string, size_t>> tokens(counts.begin(),
+                                                     counts.end());
+  std::sort(tokens.begin(), tokens.end(), [](const auto& a, const auto& b) {
+    if (a.first.size() != b.first.size()) {
+      return a.first.size() < b.first.size();
+    }
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+  });
+
+  const std::string path = "/tmp/tiktoken_benchmark.vocab";
+  std::ofstream fs(path);
+  int32_t rank = 0;
+  for (int32_t b = 0; b < 256; ++b) {
+    fs << absl::Base64Escape(std::string(1, static_cast<char>(b))) << " "
+       << rank++ << "\n";
+  }
+  for (const auto& [token, count] : tokens) {
+    if (rank >= kVocabSize) {
+      break;
+    }
+    fs << absl::Base64Escape(token) << " " << rank++ << "\n";
+  }
+  return path;
+}
+
+const TiktokenTokenizer& tokenizer() {
+  static const TiktokenTokenizer* tokenizer = []() {
+    const std::string vocab_path = write_vocab({repeat(kChatText, 4096),
+                                                repeat(kSourceCode, 4096),
+                                                long_run(4096)});
+    TokenizerArgs args;
+    args.tokenizer_type("tiktoken").vocab_file(vocab_path).pattern(kPattern);
+    return new TiktokenTokenizer("", args);
+  }();
+  return *tokenizer;
+}
+
+void encode(benchmark::State& state, const std::string& text) {
+  const auto& tiktoken = tokenizer();
+  std::vector<int32_t> ids;
+  ids.reserve(text.size());
+  for (auto _ : state) {
+    ids.clear();
+    tiktoken.encode(text, &ids);
+    benchmark::DoNotOptimize(ids.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          text.size());
+  state.counters["MB/s per thread"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * text.size() / 1e6,
+      benchmark::Counter::kIsRate | benchmark::Counter::kAvgThreads);
+  state.counters["tokens"] = ids.size();
+}
+
+}  // namespace
+
+static void BM_EncodeChatText(benchmark::State& state) {
+  static const std::string text = repeat(kChatText, state.range(0));
+  encode(state, text);
+}
+
+static void BM_EncodeSourceCode(benchmark::State& state) {
+  static const std::string text = repeat(kSourceCode, state.range(0));
+  encode(state, text);
+}
+
+// a single piece of a long run, the worst case of the byte pair merging
+static void BM_EncodeLongRun(benchmark::State& state) {
+  static const std::string text = long_run(state.range(0));
+  encode(state, text);
+}
+
+BENCHMARK(BM_EncodeChatText)->Arg(4096)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK(BM_EncodeSourceCode)->Arg(4096)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK(BM_EncodeLongRun)->Arg(16384)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,79 @@
+#include "tokenizer.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "core/common/global_flags.h"
+#include "core/util/blocking_counter.h"
+#include "core/util/threadpool.h"
+
+namespace xllm {
+
+namespace {
+// the minimum number of texts handled by one task, smaller batches are not
+// worth the cost of scheduling.
+constexpr size_t kMinChunkSize = 16;
+
+// run func(i) for i in [0, n), chunks of the range are run by the shared
+// tokenizer threadpool and the calling thread.
+template <typename Func>
+void parallel_for(size_t n, Func&& func) {
+  const size_t num_threads =
+      static_cast<size_t>(std::max(FLAGS_num_tokenizer_threads, 0));
+  const size_t num_chunks =
+      std::min(num_threads + 1, (n + kMinChunkSize - 1) / kMinChunkSize);
+  if (num_chunks <= 1) {
+    for (size_t i = 0; i < n; ++i) {
+      func(i);
+    }
+    return;
+  }
+
+  // the threads are shared by all tokenizers, the tokenizers are immutable
+  // after construction so it is safe to call them concurrently.
+  static ThreadPool threadpool(num_threads);
+
+  auto run_chunk = [n, num_chunks, &func](size_t chunk) {
+    const size_t start = n * chunk / num_chunks;
+    const size_t end = n * (chunk + 1) / num_chunks;
+    for (size_t i = start; i < end; ++i) {
+      func(i);
+    }
+  };
+
+  BlockingCounter counter(num_chunks - 1);
+  for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+    threadpool.schedule([&run_chunk, &counter, chunk]() {
+      run_chunk(chunk);
+      counter.decrement_count();
+    });
+  }
+  run_chunk(0);
+  counter.wait();
+}
+}  // namespace
+
+bool Tokenizer::encode_batch(const std::vector<std::string_view>& texts,
+                             std::vector<std::vector<int32_t>>* ids) const {
+  ids->clear();
+  ids->resize(texts.size());
+  std::atomic<bool> success{true};
+  parallel_for(texts.size(), [&](size_t i) {
+    if (!encode(texts[i], &(*ids)[i])) {
+      success.store(false, std::memory_order_relaxed);
+    }
+  });
+  return success.load(std::memory_order_relaxed);
+}
+
+std::vector<std::string> Tokenizer::decode_batch(
+    const std::vector<Slice<int32_t>>& ids,
+    bool skip_special_tokens) const {
+  std::vector<std::string> texts(ids.size());
+  parallel_for(ids.size(), [&](size_t i) {
+    texts[i] = decode(ids[i], skip_special_tokens);
+  });
+  return texts;
+}
+
+}  // namespace xllm
@@ -3,6 +3,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "core/util/slice.h"
@@ -19,6 +20,30 @@ class Tokenizer {
   virtual std::string decode(const Slice<int32_t>& ids,
                              bool skip_special_tokens) const = 0;
 
+  // encode a batch of texts, returns false if any of the texts fails.
+  // the default implementation encodes the texts in parallel.
+  virtual bool encode_batch(const std::vector<std::string_view>& texts,
+                            std::vector<std::vector<int32_t>>* ids) const;
+
+  // decode a batch of token ids, the default implementation decodes the
+  // sequences in parallel.
+  virtual std::vector<std::string> decode_batch(
+      const std::vector<Slice<int32_t>>& ids,
+      bool skip_special_tokens) const;
+
+  // whether the text of a token doesn't depend on the surrounding tokens, so
+  // that a stream of tokens can be decoded with stream_decode().
+  virtual bool support_stream_decode() const { return false; }
+
+  // decode the tokens appended to the end of a stream and append the text.
+  // returns false and leaves text untouched if the tokens end with an
+  // incomplete utf-8 character, the caller should retry with more tokens.
+  virtual bool stream_decode(const Slice<int32_t>& ids,
+                             bool skip_special_tokens,
+                             std::string* text) const {
+    return false;
+  }
+
   virtual std::optional<int32_t> token_to_id(
       const std::string_view& token) const = 0;
 
@@ -5,11 +5,15 @@ use std::{collections::HashMap, str::FromStr};
 use std::fs;
 use std::ffi::{c_char, CStr};
 use std::io;
+use std::sync::Arc;
 use tokenizers::tokenizer::Tokenizer;
 
+// the tokenizer is immutable and shared by all clones of the wrapper, the
+// result buffers are owned by each wrapper.
 pub struct TokenizerWrapper {
-    tokenizer: Tokenizer,
+    tokenizer: Arc<Tokenizer>,
     decode_str: String,
+    decode_batch_str: Vec<String>,
     id_to_token_result: String,
 }
 
@@ -29,8 +33,18 @@ fn read_file_as_u8(path: &str) -> Result<Vec<u8>, io::Error> {
 impl TokenizerWrapper {
     pub fn from_str(json: &str) -> TokenizerWrapper {
         TokenizerWrapper {
-            tokenizer: Tokenizer::from_str(json).unwrap().into(),
+            tokenizer: Arc::new(Tokenizer::from_str(json).unwrap()),
             decode_str: String::new(),
+            decode_batch_str: Vec::new(),
+            id_to_token_result: String::new(),
+        }
+    }
+
+    pub fn clone_shared(&self) -> TokenizerWrapper {
+        TokenizerWrapper {
+            tokenizer: Arc::clone(&self.tokenizer),
+            decode_str: String::new(),
+            decode_batch_str: Vec::new(),
             id_to_token_result: String::new(),
         }
     }
@@ -51,6 +65,10 @@ impl TokenizerWrapper {
     pub fn decode(&mut self, ids: &[u32], skip_special_tokens: bool) {
         self.decode_str = self.tokenizer.decode(ids, skip_special_tokens).unwrap();
     }
+
+    pub fn decode_batch(&mut self, ids: &[&[u32]], skip_special_tokens: bool) {
+        self.decode_batch_str = self.tokenizer.decode_batch(ids, skip_special_tokens).unwrap();
+    }
 }
 
 #[no_mangle]
@@ -79,6 +97,13 @@ extern "C" fn tokenizers_new_from_path(path: *const c_char) -> *mut TokenizerWra
     }
 }
 
+#[no_mangle]
+extern "C" fn tokenizers_clone(handle: *mut TokenizerWrapper) -> *mut TokenizerWrapper {
+    unsafe {
+        return Box::into_raw(Box::new((*handle).clone_shared()));
+    }
+}
+
 #[no_mangle]
 extern "C" fn tokenizers_encode(
     handle: *mut TokenizerWrapper,
@@ -153,6 +178,31 @@ extern "C" fn tokenizers_decode(
     }
 }
 
+#[no_mangle]
+extern "C" fn tokenizers_decode_batch(
+    handle: *mut TokenizerWrapper,
+    input_ids: *const *const u32,
+    input_len: *const usize,
+    num_seqs: usize,
+    skip_special_tokens: i32,
+    out_cstr: *mut *mut u8,
+    out_len: *mut usize,
+) {
+    unsafe {
+        let input_data = (0..num_seqs)
+            .map(|i| {
+                std::slice::from_raw_parts(*input_ids.offset(i as isize), *input_len.offset(i as isize))
+            })
+            .collect::<Vec<&[u32]>>();
+        (*handle).decode_batch(&input_data, skip_special_tokens != 0);
+
+        for (i, decoded) in (*handle).decode_batch_str.iter_mut().enumerate() {
+            *out_cstr.offset(i as isize) = decoded.as_mut_ptr();
+            *out_len.offset(i as isize) = decoded.len();
+        }
+    }
+}
+
 #[no_mangle]
 extern "C" fn tokenizers_free(wrapper: *mut TokenizerWrapper) {
     unsafe {
@@ -19,12 +19,28 @@ typedef struct {
 
 TokenizerHandle tokenizers_new_from_path(const char* path);
 
+// tokenizers_clone returns a new handle sharing the tokenizer of the given
+// handle, each handle has its own result buffers.
+TokenizerHandle tokenizers_clone(TokenizerHandle handle);
+
 void tokenizers_encode(TokenizerHandle handle,
                        const char* data,
                        size_t len,
                        int add_special_token,
                        TokenizerEncodeResult* result);
 
+// tokenizers_encode_batch encodes num_seqs texts in parallel, the results
+// should be freed by tokenizers_free_encode_results.
+void tokenizers_encode_batch(TokenizerHandle handle,
+                             const char** data,
+                             const size_t* len,
+                             size_t num_seqs,
+                             int add_special_token,
+                             TokenizerEncodeResult* results);
+
+void tokenizers_free_encode_results(TokenizerEncodeResult* results,
+                                    size_t num_seqs);
+
 void tokenizers_decode(TokenizerHandle handle,
                        const uint32_t* data,
                        size_t len,
@@ -32,6 +48,16 @@ void tokenizers_decode(TokenizerHandle handle,
                        const char** decode_data,
                        size_t* decode_len);
 
+// tokenizers_decode_batch decodes num_seqs sequences in parallel, the
+// decoded texts are valid until the next decode_batch call on the handle.
+void tokenizers_decode_batch(TokenizerHandle handle,
+                             const uint32_t** data,
+                             const size_t* len,
+                             size_t num_seqs,
+                             int skip_special_tokens,
+                             const char** decode_data,
+                             size_t* decode_len);
+
 void tokenizers_id_to_token(TokenizerHandle handle,
                             uint32_t id,
                             const char** data,
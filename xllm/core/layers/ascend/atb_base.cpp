@@ -104,7 +104,8 @@ void ATBBase::set_weight(const StateDict& state_dict,
                          int weight_position) {
   for (const auto& [name, tensor] : state_dict) {
     if (absl::EndsWith(name, tensor_name)) {
-      at::Tensor mutable_tensor = tensor;
+      // read through the weight cache of the state dict
+      at::Tensor mutable_tensor = state_dict.get_tensor(std::string(name));
       correct_tensor_dtype(mutable_tensor, tensor_name);
       at_weight_tensors_[weight_position] = mutable_tensor.to(device_);
     }
@@ -118,7 +119,7 @@ void ATBBase::set_weight(const StateDict& state_dict,
   for (const auto& [name, tensor] : state_dict) {
     if (absl::EndsWith(name, tensor_name)) {
       if (parallel_args_.world_size() <= 1) {
-        at::Tensor mutable_tensor = tensor;
+        at::Tensor mutable_tensor = state_dict.get_tensor(std::string(name));
         correct_tensor_dtype(mutable_tensor, tensor_name);
         at_weight_tensors_[weight_position] = mutable_tensor.to(device_);
       } else {
@@ -144,7 +145,7 @@ void ATBBase::set_weight(const StateDict& state_dict,
   for (const auto& [name, tensor] : state_dict) {
     if (absl::EndsWith(name, tensor_name)) {
       if (world_size <= 1) {
-        at::Tensor mutable_tensor = tensor;
+        at::Tensor mutable_tensor = state_dict.get_tensor(std::string(name));
         correct_tensor_dtype(mutable_tensor, tensor_name);
         at_weight_tensors_[weight_position] = mutable_tensor.to(device_);
       } else {
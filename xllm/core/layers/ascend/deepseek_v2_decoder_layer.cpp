@@ -612,7 +612,9 @@ void DeepseekV2DecoderImpl::initialize_quantization_parameters(
 }
 
 void DeepseekV2DecoderImpl::load_state_dict(const StateDict& state_dict) {
-  for (const auto& [name, tensor] : state_dict) {
+  for (const auto& [tensor_name, tensor] : state_dict) {
+    // the weight mappings are keyed by std::string
+    const std::string name(tensor_name);
     bool is_sharded = false;
     int index = 0;
 
@@ -623,7 +625,7 @@ void DeepseekV2DecoderImpl::load_state_dict(const StateDict& state_dict) {
     }
 
     if (absl::StartsWith(name, "mlp.experts")) {
-      process_expert_weights(state_dict, name, tensor);
+      process_expert_weights(state_dict, name);
       continue;
     }
 
@@ -664,8 +666,7 @@ std::string DeepseekV2DecoderImpl::get_expert_shm_key(int32_t layer_id,
 
 void DeepseekV2DecoderImpl::process_expert_weights(
     const StateDict& state_dict,
-    const std::string& name,
-    const torch::Tensor& tensor) {
+    const std::string& name) {
   int expert_index = extract_expert_index(name);
   const std::string suffix = extract_endswith(name);
   const int index = get_mapped_index(suffix, WEIGHT_MAPPING_W8A8);
@@ -682,7 +683,7 @@ void DeepseekV2DecoderImpl::process_expert_weights(
                                         WEIGHT_SHARD_W8A8.at(index),
                                         ep_local_tp_rank_,
                                         ep_local_tp_size_)
-                   : tensor;
+                   : state_dict.get_tensor(name);
     std::string shm_key = get_expert_shm_key(layer_id_, expert_index, suffix);
     if (!decode_param_.isBF16) {
       if (absl::EndsWith(name, "_offset")) {
@@ -724,7 +725,7 @@ void DeepseekV2DecoderImpl::process_expert_weights(
                                       WEIGHT_SHARD_W8A8.at(index),
                                       ep_local_tp_rank_,
                                       ep_local_tp_size_)
-                 : tensor;
+                 : state_dict.get_tensor(name);
 
   for (auto pos : matches_pos) {
     experts_weights_[suffix][pos] = tmp_tensor.clone();
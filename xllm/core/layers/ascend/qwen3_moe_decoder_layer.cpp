@@ -420,12 +420,14 @@ void Qwen3MoeDecoderImpl::initialize_quantization_parameters(
 }
 
 void Qwen3MoeDecoderImpl::load_state_dict(const StateDict& state_dict) {
-  for (const auto& [name, tensor] : state_dict) {
+  for (const auto& [tensor_name, tensor] : state_dict) {
+    // the weight mappings are keyed by std::string
+    const std::string name(tensor_name);
     bool is_sharded = false;
     int index = 0;
 
     if (absl::StartsWith(name, "mlp.experts")) {
-      process_expert_weights(state_dict, name, tensor);
+      process_expert_weights(state_dict, name);
       continue;
     }
 
@@ -451,8 +453,7 @@ int Qwen3MoeDecoderImpl::get_mapped_index(
 }
 
 void Qwen3MoeDecoderImpl::process_expert_weights(const StateDict& state_dict,
-                                                 const std::string& name,
-                                                 const torch::Tensor& tensor) {
+                                                 const std::string& name) {
   int expert_index = extract_expert_index(name);
   if (expert_index < start_expert_id_ || expert_index > end_expert_id_) {
     return;
@@ -476,7 +477,7 @@ void Qwen3MoeDecoderImpl::process_expert_weights(const StateDict& state_dict,
                                                       shard_map.at(index),
                                                       ep_local_tp_rank_,
                                                       ep_local_tp_size_)
-                                 : tensor;
+                                 : state_dict.get_tensor(name);
 
   experts_weights_[suffix][local_index] = tmp_tensor.clone();
 }
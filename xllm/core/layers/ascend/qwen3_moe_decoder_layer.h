@@ -113,8 +113,7 @@ class Qwen3MoeDecoderImpl : public torch::nn::Module, public ATBBase {
   void preprocess_linear_for_rope();
 
   void process_expert_weights(const StateDict& state_dict,
-                              const std::string& name,
-                              const torch::Tensor& tensor);
+                              const std::string& name);
 
   void process_shared_expert_weights(const StateDict& state_dict,
                                      const std::string& name,
@@ -126,14 +126,15 @@ void SiglipEncoderLayerUpImpl::build_graph(const std::string& prefix) {
 }
 
 void SiglipEncoderLayerUpImpl::load_state_dict(const StateDict& state_dict) {
-  const std::set<std::string> key_names = {"layer_norm1.weight",
-                                           "layer_norm1.bias",
-                                           "self_attn.q_proj.weight",
-                                           "self_attn.q_proj.bias",
-                                           "self_attn.k_proj.weight",
-                                           "self_attn.k_proj.bias",
-                                           "self_attn.v_proj.weight",
-                                           "self_attn.v_proj.bias"};
+  const std::set<std::string, std::less<>> key_names = {
+      "layer_norm1.weight",
+      "layer_norm1.bias",
+      "self_attn.q_proj.weight",
+      "self_attn.q_proj.bias",
+      "self_attn.k_proj.weight",
+      "self_attn.k_proj.bias",
+      "self_attn.v_proj.weight",
+      "self_attn.v_proj.bias"};
 
   atb_torch::TorchTensorMap weights_map;
   for (const auto& [name, tensor] : state_dict) {
@@ -142,7 +143,7 @@ void SiglipEncoderLayerUpImpl::load_state_dict(const StateDict& state_dict) {
     auto weight_npu = tensor.to(options_);
 
     weights_.push_back(weight_npu);
-    weights_map[name] = weight_npu;
+    weights_map[std::string(name)] = weight_npu;
   }
   graph_.SetWeights(weights_map);
 }
@@ -289,14 +290,15 @@ void SiglipEncoderLayerDownImpl::build_graph(const std::string& prefix) {
 }
 
 void SiglipEncoderLayerDownImpl::load_state_dict(const StateDict& state_dict) {
-  const std::set<std::string> key_names = {"self_attn.out_proj.weight",
-                                           "self_attn.out_proj.bias",
-                                           "layer_norm2.weight",
-                                           "layer_norm2.bias",
-                                           "mlp.fc1.weight",
-                                           "mlp.fc1.bias",
-                                           "mlp.fc2.weight",
-                                           "mlp.fc2.bias"};
+  const std::set<std::string, std::less<>> key_names = {
+      "self_attn.out_proj.weight",
+      "self_attn.out_proj.bias",
+      "layer_norm2.weight",
+      "layer_norm2.bias",
+      "mlp.fc1.weight",
+      "mlp.fc1.bias",
+      "mlp.fc2.weight",
+      "mlp.fc2.bias"};
 
   atb_torch::TorchTensorMap weights_map;
   for (const auto& [name, tensor] : state_dict) {
@@ -305,7 +307,7 @@ void SiglipEncoderLayerDownImpl::load_state_dict(const StateDict& state_dict) {
     auto weight_npu = tensor.to(options_);
 
     weights_.push_back(weight_npu);
-    weights_map[name] = weight_npu;
+    weights_map[std::string(name)] = weight_npu;
   }
   graph_.SetWeights(weights_map);
 }
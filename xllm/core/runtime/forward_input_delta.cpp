@@ -0,0 +1,234 @@
+#include "runtime/forward_input_delta.h"
+
+#include <absl/time/time.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "common/global_flags.h"
+#include "framework/request/sequence.h"
+
+namespace xllm {
+
+namespace {
+// how long a step waits for the previous step to arrive
+constexpr absl::Duration kPrevStepTimeout = absl::Seconds(10);
+}  // namespace
+
+void ForwardInputDeltaEncoder::encode(const RawForwardInput& inputs,
+                                      proto::ForwardInput* pb_forward_input) {
+  const auto& seq_ids = inputs.seq_ids;
+  const auto& block_tables_vec = inputs.block_tables_vec;
+  CHECK_EQ(seq_ids.size(), block_tables_vec.size());
+  CHECK_EQ(inputs.sampling_seq_ids.size(),
+           inputs.unique_token_sequences.size());
+  ++step_;
+  bool snapshot = need_snapshot_.exchange(false, std::memory_order_relaxed);
+  if (FLAGS_forward_input_snapshot_interval > 0 &&
+      step_ - last_snapshot_step_ >=
+          static_cast<uint64_t>(FLAGS_forward_input_snapshot_interval)) {
+    snapshot = true;
+  }
+  if (snapshot) {
+    last_snapshot_step_ = step_;
+  }
+  pb_forward_input->set_delta_step(step_);
+  pb_forward_input->set_delta_base_step(snapshot ? 0 : step_ - 1);
+
+  std::unordered_map<uint64_t, std::vector<int32_t>> block_tables;
+  block_tables.reserve(seq_ids.size());
+  auto* pb_deltas = pb_forward_input->mutable_block_tables_deltas();
+  pb_deltas->Reserve(seq_ids.size());
+  for (size_t i = 0; i < seq_ids.size(); ++i) {
+    const auto& table = block_tables_vec[i];
+    std::vector<int32_t> sent;
+    size_t num_reused_blocks = 0;
+    if (!snapshot) {
+      auto it = block_tables_.find(seq_ids[i]);
+      if (it != block_tables_.end() && it->second.size() <= table.size() &&
+          std::equal(it->second.begin(), it->second.end(), table.begin())) {
+        num_reused_blocks = it->second.size();
+        sent = std::move(it->second);
+      }
+    }
+    sent.insert(sent.end(), table.begin() + num_reused_blocks, table.end());
+
+    auto* pb_delta = pb_deltas->Add();
+    pb_delta->set_seq_id(seq_ids[i]);
+    pb_delta->set_num_reused_blocks(num_reused_blocks);
+    pb_delta->mutable_new_blocks()->Add(table.begin() + num_reused_blocks,
+                                        table.end());
+    block_tables[seq_ids[i]] = std::move(sent);
+  }
+  // sequences not in this step are dropped on both sides
+  block_tables_ = std::move(block_tables);
+
+  std::unordered_map<uint64_t, SentTokenCounts> token_counts;
+  token_counts.reserve(inputs.sampling_seq_ids.size());
+  auto* pb_counts_deltas = pb_forward_input->mutable_token_counts_deltas();
+  pb_counts_deltas->Reserve(inputs.sampling_seq_ids.size());
+  for (size_t i = 0; i < inputs.sampling_seq_ids.size(); ++i) {
+    const uint64_t seq_id = inputs.sampling_seq_ids[i];
+    auto* pb_delta = pb_counts_deltas->Add();
+    pb_delta->set_seq_id(seq_id);
+    const Sequence* sequence = inputs.unique_token_sequences[i];
+    if (sequence == nullptr) {
+      // the penalties are not used, the worker gets empty token counts
+      continue;
+    }
+    const auto& ids = sequence->unique_token_ids();
+    const auto& counts = sequence->unique_token_counts();
+    const auto& updates = sequence->unique_token_updates();
+    const size_t num_trimmed = sequence->num_trimmed_unique_token_updates();
+    const size_t num_updates = num_trimmed + updates.size();
+
+    size_t num_reused_tokens = 0;
+    if (!snapshot) {
+      auto it = token_counts_.find(seq_id);
+      // the whole counts are sent again if the updates since the last step
+      // are trimmed
+      if (it != token_counts_.end() &&
+          it->second.num_updates >= num_trimmed &&
+          it->second.num_updates <= num_updates) {
+        num_reused_tokens = it->second.num_ids;
+        // the counts of the new ids are sent with them
+        updated_idxes_.clear();
+        for (size_t j = it->second.num_updates - num_trimmed;
+             j < updates.size();
+             ++j) {
+          if (static_cast<size_t>(updates[j]) < num_reused_tokens) {
+            updated_idxes_.push_back(updates[j]);
+          }
+        }
+        std::sort(updated_idxes_.begin(), updated_idxes_.end());
+        updated_idxes_.erase(
+            std::unique(updated_idxes_.begin(), updated_idxes_.end()),
+            updated_idxes_.end());
+        for (const int32_t idx : updated_idxes_) {
+          pb_delta->add_updated_idxes(idx);
+          pb_delta->add_updated_counts(counts[idx]);
+        }
+      }
+    }
+    pb_delta->set_num_reused_tokens(num_reused_tokens);
+    pb_delta->mutable_new_token_ids()->Add(ids.begin() + num_reused_tokens,
+                                           ids.end());
+    pb_delta->mutable_new_token_counts()->Add(
+        counts.begin() + num_reused_tokens, counts.end());
+    token_counts[seq_id] = {num_updates, ids.size()};
+  }
+  token_counts_ = std::move(token_counts);
+}
+
+bool ForwardInputDeltaDecoder::decode(
+    const proto::ForwardInput& pb_forward_input,
+    std::vector<std::vector<int32_t>>* block_tables_vec,
+    std::vector<std::vector<int64_t>>* unique_token_ids_vec,
+    std::vector<std::vector<int32_t>>* unique_token_counts_vec) {
+  const uint64_t step = pb_forward_input.delta_step();
+  const uint64_t base_step = pb_forward_input.delta_base_step();
+  absl::MutexLock lock(&mutex_);
+  // handle the steps in the order they are sent. a snapshot to a restarted
+  // worker does not wait.
+  auto prev_step_done = [this, step, base_step]()
+                            ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+                              return (base_step == 0 && step_ == 0) ||
+                                     step_ + 1 >= step;
+                            };
+  mutex_.AwaitWithTimeout(absl::Condition(&prev_step_done), kPrevStepTimeout);
+  if (base_step != 0 && (!valid_ || step_ != base_step)) {
+    LOG(ERROR) << "Base step " << base_step
+               << " of the forward input is not available, last step is "
+               << step_;
+    invalidate(step);
+    return false;
+  }
+
+  std::unordered_map<uint64_t, std::vector<int32_t>> block_tables;
+  block_tables.reserve(pb_forward_input.block_tables_deltas_size());
+  block_tables_vec->clear();
+  block_tables_vec->reserve(pb_forward_input.block_tables_deltas_size());
+  for (const auto& pb_delta : pb_forward_input.block_tables_deltas()) {
+    std::vector<int32_t> table;
+    const size_t num_reused_blocks = pb_delta.num_reused_blocks();
+    if (num_reused_blocks > 0) {
+      auto it = block_tables_.find(pb_delta.seq_id());
+      if (base_step == 0 || it == block_tables_.end() ||
+          it->second.size() != num_reused_blocks) {
+        LOG(ERROR) << "Missing block table of sequence " << pb_delta.seq_id();
+        invalidate(step);
+        return false;
+      }
+      table = std::move(it->second);
+    }
+    table.insert(
+        table.end(), pb_delta.new_blocks().begin(), pb_delta.new_blocks().end());
+    block_tables_vec->push_back(table);
+    block_tables[pb_delta.seq_id()] = std::move(table);
+  }
+  block_tables_ = std::move(block_tables);
+
+  std::unordered_map<uint64_t, TokenCounts> token_counts;
+  token_counts.reserve(pb_forward_input.token_counts_deltas_size());
+  unique_token_ids_vec->clear();
+  unique_token_ids_vec->reserve(pb_forward_input.token_counts_deltas_size());
+  unique_token_counts_vec->clear();
+  unique_token_counts_vec->reserve(
+      pb_forward_input.token_counts_deltas_size());
+  for (const auto& pb_delta : pb_forward_input.token_counts_deltas()) {
+    TokenCounts token_counts_of_seq;
+    const size_t num_reused_tokens = pb_delta.num_reused_tokens();
+    if (num_reused_tokens > 0) {
+      auto it = token_counts_.find(pb_delta.seq_id());
+      if (base_step == 0 || it == token_counts_.end() ||
+          it->second.ids.size() != num_reused_tokens) {
+        LOG(ERROR) << "Missing token counts of sequence " << pb_delta.seq_id();
+        invalidate(step);
+        return false;
+      }
+      token_counts_of_seq = std::move(it->second);
+    }
+    if (pb_delta.updated_idxes_size() != pb_delta.updated_counts_size() ||
+        pb_delta.new_token_ids_size() != pb_delta.new_token_counts_size()) {
+      LOG(ERROR) << "Malformed token counts of sequence " << pb_delta.seq_id();
+      invalidate(step);
+      return false;
+    }
+    auto& ids = token_counts_of_seq.ids;
+    auto& counts = token_counts_of_seq.counts;
+    for (int32_t j = 0; j < pb_delta.updated_idxes_size(); ++j) {
+      const int32_t idx = pb_delta.updated_idxes(j);
+      if (idx < 0 || static_cast<size_t>(idx) >= num_reused_tokens) {
+        LOG(ERROR) << "Malformed token counts of sequence "
+                   << pb_delta.seq_id();
+        invalidate(step);
+        return false;
+      }
+      counts[idx] = pb_delta.updated_counts(j);
+    }
+    ids.insert(ids.end(),
+               pb_delta.new_token_ids().begin(),
+               pb_delta.new_token_ids().end());
+    counts.insert(counts.end(),
+                  pb_delta.new_token_counts().begin(),
+                  pb_delta.new_token_counts().end());
+    unique_token_ids_vec->push_back(ids);
+    unique_token_counts_vec->push_back(counts);
+    token_counts[pb_delta.seq_id()] = std::move(token_counts_of_seq);
+  }
+  token_counts_ = std::move(token_counts);
+
+  step_ = step;
+  valid_ = true;
+  return true;
+}
+
+void ForwardInputDeltaDecoder::invalidate(uint64_t step) {
+  // the following deltas fail fast until the master sends a snapshot
+  block_tables_.clear();
+  token_counts_.clear();
+  step_ = std::max(step_, step);
+  valid_ = false;
+}
+
+}  // namespace xllm
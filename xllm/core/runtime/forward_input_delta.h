@@ -0,0 +1,99 @@
+#pragma once
+
+#include <absl/synchronization/mutex.h>
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "runtime/forward_params.h"
+#include "worker.pb.h"
+
+namespace xllm {
+
+// the unique token ids of a sequence and their counts
+struct TokenCounts {
+  std::vector<int64_t> ids;
+  std::vector<int32_t> counts;
+};
+
+// Delta encoding of the block tables sent to a remote worker. In steady state
+// decode only the last block of a sequence changes, so instead of the full
+// block tables the master sends, per sequence, how many blocks of the previous
+// step are kept and the newly appended blocks. The unique token counts used by
+// the penalties are encoded the same way: only the counts changed by the
+// tokens counted since the previous step, found from
+// Sequence::unique_token_updates(), are sent, or the whole counts of a
+// sequence if those updates are already trimmed. A full snapshot is sent every
+// FLAGS_forward_input_snapshot_interval steps and after a failed step.
+//
+// The encoder lives on the master, one per remote worker, and is not thread
+// safe: the inputs must be encoded in the order they are sent.
+class ForwardInputDeltaEncoder final {
+ public:
+  ForwardInputDeltaEncoder() = default;
+
+  void encode(const RawForwardInput& inputs,
+              proto::ForwardInput* pb_forward_input);
+
+  // the worker may have lost the state, send a full snapshot in the next
+  // step. can be called from any thread.
+  void reset() { need_snapshot_.store(true, std::memory_order_relaxed); }
+
+ private:
+  uint64_t step_ = 0;
+
+  uint64_t last_snapshot_step_ = 0;
+
+  std::atomic<bool> need_snapshot_{true};
+
+  // the block tables sent in the last step
+  std::unordered_map<uint64_t, std::vector<int32_t>> block_tables_;
+
+  // how much of the unique tokens of a sequence is sent
+  struct SentTokenCounts {
+    // the number of Sequence::unique_token_updates() applied, the trimmed
+    // ones included
+    size_t num_updates = 0;
+    size_t num_ids = 0;
+  };
+
+  // the unique token counts sent in the last step
+  std::unordered_map<uint64_t, SentTokenCounts> token_counts_;
+
+  // buffer of the indices updated in a sequence
+  std::vector<int32_t> updated_idxes_;
+};
+
+// The worker side of ForwardInputDeltaEncoder. rpcs can be handled out of
+// order, so decoding a step waits for the previous step to be decoded first.
+class ForwardInputDeltaDecoder final {
+ public:
+  ForwardInputDeltaDecoder() = default;
+
+  // returns false if the base step of the input is not available.
+  bool decode(const proto::ForwardInput& pb_forward_input,
+              std::vector<std::vector<int32_t>>* block_tables_vec,
+              std::vector<std::vector<int64_t>>* unique_token_ids_vec,
+              std::vector<std::vector<int32_t>>* unique_token_counts_vec);
+
+ private:
+  void invalidate(uint64_t step) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  absl::Mutex mutex_;
+
+  // the last decoded step
+  uint64_t step_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  // whether block_tables_ holds the block tables of step_
+  bool valid_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::unordered_map<uint64_t, std::vector<int32_t>> block_tables_
+      ABSL_GUARDED_BY(mutex_);
+
+  std::unordered_map<uint64_t, TokenCounts> token_counts_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xllm
@@ -11,6 +11,8 @@
 
 namespace xllm {
 
+class Sequence;
+
 class WorkerType {
  public:
   enum Value : int8_t {
@@ -74,6 +76,7 @@ struct ForwardInput {
     inputs.sampling_params = sampling_params.to(device, dtype);
     inputs.transfer_kv_infos = transfer_kv_infos;
     inputs.eplb_info = eplb_info;
+    inputs.block_transfer_infos = block_transfer_infos;
     return inputs;
   }
   // flatten token ids
@@ -85,6 +88,9 @@ struct ForwardInput {
   // kv info for disaggregated prefill/decode
   std::vector<TransferKVInfo> transfer_kv_infos;
   EplbInfo eplb_info;
+  // kv cache block copies between device and host memory, executed in order
+  // before the forward
+  std::vector<BlockTransferInfo> block_transfer_infos;
 };
 
 // output after forward execution
@@ -112,8 +118,13 @@ struct RawForwardInput {
   std::vector<const RequestSamplingParam*> sampling_params;
   std::vector<int32_t> selected_token_idxes;
   std::vector<int32_t> sample_idxes;
-  std::vector<std::vector<int64_t>> unique_token_ids_vec;
-  std::vector<std::vector<int32_t>> unique_token_counts_vec;
+  // ids of the sequences of the selected tokens, used to delta encode the
+  // unique token counts
+  std::vector<uint64_t> sampling_seq_ids;
+  // the sequence of each selected token if the penalties use its unique
+  // tokens, nullptr otherwise. the unique tokens are read from the sequence
+  // when the input is serialized, which happens before the step returns.
+  std::vector<const Sequence*> unique_token_sequences;
   std::vector<int32_t> unique_token_lens_vec;
   bool empty_kv_cache = true;
   bool global_empty_kv_cache = true;
@@ -123,12 +134,16 @@ struct RawForwardInput {
   std::vector<int32_t> q_seq_lens;
   std::vector<int32_t> new_token_slot_ids;
   std::vector<std::vector<int32_t>> block_tables_vec;
+  // ids of the sequences, used to delta encode the block tables
+  std::vector<uint64_t> seq_ids;
   int32_t num_sequences;
   // num tokens of all workers，mainly used for dp case
   std::vector<int32_t> dp_global_token_nums;
   // kv info for disaggregated prefill/decode
   std::vector<TransferKVInfo> transfer_kv_infos;
   EplbInfo eplb_info;
+  // kv cache block copies between device and host memory
+  std::vector<BlockTransferInfo> block_transfer_infos;
   std::vector<std::vector<float>> embeddings;
   // num of prefill sequence in chunked prefill case
   uint32_t prefill_seq_len;
@@ -264,6 +264,30 @@ bool LLMEngine::allocate_kv_cache(const Engine::KVCacheCapacity& kv_cache_cap) {
       .enable_prefix_cache(options_.enable_prefix_cache())
       .enable_disagg_pd(options_.enable_disagg_pd())
       .enable_service_routing(options_.enable_service_routing());
+  // the host memory tier holds the kv cache of the target model only. the
+  // workers allocate the host kv cache with the same number of blocks.
+  int64_t num_host_blocks = 0;
+  if (FLAGS_host_blocks_factor > 0 &&
+      (options_.enable_prefix_cache() || FLAGS_enable_swap_preemption) &&
+      options_.num_speculative_tokens() == 0 &&
+      options_.instance_role() == InstanceRole::DEFAULT) {
+    num_host_blocks = static_cast<int64_t>(kv_cache_cap.n_blocks *
+                                           FLAGS_host_blocks_factor);
+  }
+  options.num_host_blocks(static_cast<uint32_t>(num_host_blocks));
+  // partial block matching copies blocks on device ahead of the forward,
+  // which is not replayed by the draft model of speculative decoding nor
+  // reported to the service or the decode instance.
+  if (FLAGS_prefix_cache_policy == "radix_tree" &&
+      (options_.num_speculative_tokens() > 0 ||
+       options_.enable_service_routing() ||
+       options_.instance_role() != InstanceRole::DEFAULT)) {
+    LOG(WARNING) << "radix_tree prefix cache is not supported with "
+                    "speculative decoding, service routing or disaggregated "
+                    "PD, fall back to murmur_hash3.";
+  } else {
+    options.prefix_cache_policy(FLAGS_prefix_cache_policy);
+  }
   block_manager_pool_ =
       std::make_unique<BlockManagerPool>(options, options_.dp_size());
 
@@ -272,7 +296,8 @@ bool LLMEngine::allocate_kv_cache(const Engine::KVCacheCapacity& kv_cache_cap) {
   futures.reserve(worker_clients_.size());
   if (options_.instance_role() == InstanceRole::DEFAULT) {
     for (auto& worker : worker_clients_) {
-      futures.push_back(worker->allocate_kv_cache_async(kv_cache_shape));
+      futures.push_back(
+          worker->allocate_kv_cache_async(kv_cache_shape, num_host_blocks));
     }
   } else {
     if (!options_.device_ip().has_value()) {
@@ -476,6 +501,8 @@ ForwardOutput LLMEngine::step(std::vector<Batch>& batch) {
   for (auto dp_rank = 0; dp_rank < dp_size; ++dp_rank) {
     // assume the order in workers_ is its rank
     RawForwardInput raw_forward_input = batch[dp_rank].prepare_forward_input();
+    raw_forward_input.block_transfer_infos =
+        block_manager_pool_->take_block_transfer_infos(dp_rank);
     raw_forward_inputs.push_back(raw_forward_input);
     dp_global_token_nums[dp_rank] = raw_forward_input.flatten_tokens_vec.size();
     global_empty_kv_cache =
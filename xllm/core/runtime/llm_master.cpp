@@ -4,10 +4,12 @@
 #include <glog/logging.h>
 #include <pybind11/pybind11.h>
 
+#include <algorithm>
 #include <atomic>
 #include <boost/algorithm/string.hpp>
 #include <csignal>
 #include <memory>
+#include <string_view>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -138,15 +140,53 @@ void LLMMaster::handle_batch_request(std::vector<std::string> prompts,
 
   const size_t num_requests = prompts.size();
   scheduler_->incr_pending_requests(num_requests);
-  for (size_t i = 0; i < num_requests; ++i) {
-    handle_request(std::move(prompts[i]),
-                   std::nullopt,
-                   // the sampling parameter may be shared
-                   sps.size() == 1 ? sps[0] : std::move(sps[i]),
-                   [i, callback](const RequestOutput& output) {
-                     output.log_request_status();
-                     return callback(i, output);
-                   });
+  // split the prompts over the handling threads, each thread encodes its
+  // prompts with one encode_batch() call, which is much cheaper than encoding
+  // them one by one for large offline batches.
+  const size_t num_threads = threadpool_->size();
+  const size_t chunk_size = (num_requests + num_threads - 1) / num_threads;
+  for (size_t begin = 0; begin < num_requests; begin += chunk_size) {
+    const size_t end = std::min(begin + chunk_size, num_requests);
+    std::vector<std::string> chunk_prompts(
+        std::make_move_iterator(prompts.begin() + begin),
+        std::make_move_iterator(prompts.begin() + end));
+    std::vector<RequestParams> chunk_sps;
+    chunk_sps.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+      // the sampling parameter may be shared
+      chunk_sps.push_back(sps.size() == 1 ? sps[0] : std::move(sps[i]));
+    }
+
+    threadpool_->schedule([this,
+                           begin,
+                           prompts = std::move(chunk_prompts),
+                           sps = std::move(chunk_sps),
+                           callback]() mutable {
+      Timer timer;
+      std::vector<std::string_view> texts(prompts.begin(), prompts.end());
+      std::vector<std::vector<int32_t>> prompts_tokens;
+      if (!get_tls_tokenizer()->encode_batch(texts, &prompts_tokens)) {
+        // fall back to encoding the prompts one by one to report the error
+        LOG(ERROR) << "Failed to encode the batch of prompts";
+        prompts_tokens.clear();
+      }
+      COUNTER_ADD(tokenization_latency_seconds, timer.elapsed_seconds());
+
+      for (size_t i = 0; i < prompts.size(); ++i) {
+        std::optional<std::vector<int>> prompt_tokens;
+        if (!prompts_tokens.empty()) {
+          prompt_tokens = std::move(prompts_tokens[i]);
+        }
+        process_request(std::move(prompts[i]),
+                        std::move(prompt_tokens),
+                        std::move(sps[i]),
+                        [index = begin + i,
+                         callback](const RequestOutput& output) {
+                          output.log_request_status();
+                          return callback(index, output);
+                        });
+      }
+    });
   }
 }
 
@@ -158,7 +198,7 @@ void LLMMaster::handle_batch_request(
       << "Number of conversations and sampling parameters should be the same";
 
   const size_t num_requests = conversations.size();
-  scheduler_->incr_pending_requests(num_requests);
+  // handle_request() counts each request as pending
   for (size_t i = 0; i < num_requests; ++i) {
     handle_request(std::move(conversations[i]),
                    std::nullopt,
@@ -186,28 +226,37 @@ void LLMMaster::handle_request(std::string prompt,
                          prompt_token = std::move(prompt_tokens),
                          sp = std::move(sp),
                          callback = std::move(cb)]() mutable {
-    AUTO_COUNTER(request_handling_latency_seconds_completion);
+    process_request(std::move(prompt),
+                    std::move(prompt_token),
+                    std::move(sp),
+                    std::move(callback));
+  });
+}
 
-    // remove the pending request after scheduling
-    SCOPE_GUARD([this] { scheduler_->decr_pending_requests(); });
+void LLMMaster::process_request(std::string prompt,
+                                std::optional<std::vector<int>> prompt_tokens,
+                                RequestParams sp,
+                                OutputCallback callback) {
+  AUTO_COUNTER(request_handling_latency_seconds_completion);
 
-    Timer timer;
-    // verify the prompt
-    if (!sp.verify_params(callback)) {
-      return;
-    }
+  // remove the pending request after scheduling
+  SCOPE_GUARD([this] { scheduler_->decr_pending_requests(); });
 
-    auto request = generate_request(
-        std::move(prompt), std::move(prompt_token), sp, callback);
-    if (!request) {
-      return;
-    }
+  // verify the prompt
+  if (!sp.verify_params(callback)) {
+    return;
+  }
 
-    if (!scheduler_->add_request(request)) {
-      CALLBACK_WITH_ERROR(StatusCode::RESOURCE_EXHAUSTED,
-                          "No available resources to schedule request");
-    }
-  });
+  auto request = generate_request(
+      std::move(prompt), std::move(prompt_tokens), sp, callback);
+  if (!request) {
+    return;
+  }
+
+  if (!scheduler_->add_request(request)) {
+    CALLBACK_WITH_ERROR(StatusCode::RESOURCE_EXHAUSTED,
+                        "No available resources to schedule request");
+  }
 }
 
 void LLMMaster::handle_request(std::vector<Message> messages,
@@ -405,6 +454,13 @@ std::shared_ptr<Request> LLMMaster::generate_request(
                          options_.enable_schedule_overlap(),
                          callback,
                          nullptr);
+  req_state.priority = sp.priority;
+  req_state.ttft_slo_ms = sp.ttft_slo_ms;
+  req_state.tpot_slo_ms = sp.tpot_slo_ms;
+  req_state.tenant = sp.tenant;
+  // the prompt is charged to the tenant at admission and the generated tokens
+  // when the request finishes
+  rate_limiter_.consume_tokens(sp.tenant, req_state.prompt_tokens.size());
 
   auto request = std::make_shared<Request>(sp.request_id,
                                            sp.x_request_id,
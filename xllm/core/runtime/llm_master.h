@@ -73,6 +73,13 @@ class LLMMaster : public Master {
                       const int32_t dp_size);
 
  private:
+  // verify, build and schedule a completion request on a handling thread,
+  // the pending request is removed afterwards.
+  void process_request(std::string prompt,
+                       std::optional<std::vector<int>> prompt_tokens,
+                       RequestParams sp,
+                       OutputCallback callback);
+
   std::shared_ptr<Request> generate_request(
       std::string prompt,
       std::optional<std::vector<int>> prompt_tokens,
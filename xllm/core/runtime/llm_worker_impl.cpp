@@ -64,6 +64,44 @@ bool LLMWorkerImpl::init_model(torch::ScalarType dtype,
   return true;
 }
 
+bool LLMWorkerImpl::allocate_kv_cache(
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
+  if (!WorkerImpl::allocate_kv_cache(kv_cache_shape, num_host_blocks)) {
+    return false;
+  }
+
+  if (num_host_blocks > 0) {
+    LOG(INFO) << "Initializing host kv cache with " << num_host_blocks
+              << " blocks";
+    host_kv_cache_ =
+        std::make_unique<HostKVCache>(context_.get_model_args().n_layers(),
+                                      num_host_blocks,
+                                      kv_cache_shape,
+                                      dtype_);
+  }
+  return true;
+}
+
+void LLMWorkerImpl::transfer_blocks(
+    const std::vector<BlockTransferInfo>& infos) {
+  // copy block by block to keep the recorded order: a block may be written
+  // and read again by later copies of the same step.
+  for (const auto& info : infos) {
+    if (info.transfer_type != TransferType::G2G) {
+      CHECK(host_kv_cache_ != nullptr) << "Host kv cache is not initialized.";
+      host_kv_cache_->transfer_block(kv_caches_, info);
+      continue;
+    }
+    for (const auto& kv_cache : kv_caches_) {
+      kv_cache.get_k_cache()[info.dst_block_id].copy_(
+          kv_cache.get_k_cache()[info.src_block_id], /*non_blocking=*/true);
+      kv_cache.get_v_cache()[info.dst_block_id].copy_(
+          kv_cache.get_v_cache()[info.src_block_id], /*non_blocking=*/true);
+    }
+  }
+}
+
 std::optional<ForwardOutput> LLMWorkerImpl::step(const ForwardInput& inputs) {
   c10_npu::SetDevice(device_.index());
   Timer timer;
@@ -92,6 +130,11 @@ std::optional<ForwardOutput> LLMWorkerImpl::step(const ForwardInput& inputs) {
                                                  is_spec_draft_));
   }
 
+  // copy kv cache blocks before they are used
+  if (!inputs.block_transfer_infos.empty()) {
+    transfer_blocks(inputs.block_transfer_infos);
+  }
+
   // call model executor forward to get hidden states
   auto hidden_states = model_executor_->forward(
       flatten_tokens, flatten_positions, kv_caches_, params);
@@ -5,6 +5,7 @@
 
 #include "executor.h"
 #include "forward_params.h"
+#include "framework/kv_cache/host_kv_cache.h"
 #include "framework/model/causal_lm.h"
 #include "framework/model/embedding_lm.h"
 #include "framework/model/model_args.h"
@@ -30,6 +31,11 @@ class LLMWorkerImpl : public WorkerImpl {
                   const ModelArgs& args,
                   const QuantArgs& quant_args) override;
 
+  // allocate kv cache, and the host kv cache if num_host_blocks > 0
+  bool allocate_kv_cache(
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks) override;
+
   std::optional<ForwardOutput> step(const ForwardInput& inputs) override;
 
   hf::LlmHead get_lm_head() { return model_->get_lm_head(); };
@@ -43,6 +49,13 @@ class LLMWorkerImpl : public WorkerImpl {
   void set_word_embedding(hf::AtbWordEmbedding& embedding) {
     model_->set_word_embedding(embedding);
   };
+
+ private:
+  // execute the recorded block copies in order
+  void transfer_blocks(const std::vector<BlockTransferInfo>& infos);
+
+  // host memory tier of the kv cache, nullptr if disabled
+  std::unique_ptr<HostKVCache> host_kv_cache_;
 };
 
 }  // namespace xllm
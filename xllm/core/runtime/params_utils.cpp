@@ -9,6 +9,7 @@
 #include "common/macros.h"
 #include "common/metrics.h"
 #include "framework/model/model_input_params.h"
+#include "framework/request/sequence.h"
 #include "runtime/forward_params.h"
 #include "util/timer.h"
 #include "util/utils.h"
@@ -22,60 +23,160 @@ void aprint(std::vector<T> v, const std::string& name, int global_rank) {
   LOG(INFO) << "GlobalRank = " << global_rank << ", name = " << name
             << ", value = " << value;
 }
+
+// The fields of a forward input received by a worker, decoded from the proto
+// or the flat layout.
+struct ReceivedForwardInput {
+  std::vector<int32_t> flatten_tokens_vec;
+  std::vector<int32_t> flatten_positions_vec;
+  std::vector<RequestSamplingParam> sampling_params;
+  std::vector<int32_t> selected_token_idxes;
+  std::vector<int32_t> sample_idxes;
+  std::vector<std::vector<int64_t>> unique_token_ids_vec;
+  std::vector<std::vector<int32_t>> unique_token_counts_vec;
+  std::vector<int32_t> unique_token_lens_vec;
+  bool empty_kv_cache = true;
+  bool global_empty_kv_cache = true;
+  uint32_t max_seq_len = 0;
+  uint32_t q_max_seq_len = 0;
+  std::vector<int32_t> seq_lens;
+  std::vector<int32_t> q_seq_lens;
+  std::vector<int32_t> new_token_slot_ids;
+  std::vector<std::vector<int32_t>> block_tables_vec;
+  std::vector<int32_t> dp_global_token_nums;
+  std::vector<TransferKVInfo> transfer_kv_infos;
+  EplbInfo eplb_info;
+  std::vector<BlockTransferInfo> block_transfer_infos;
+  std::vector<std::vector<float>> embeddings;
+  std::vector<int32_t> embedding_ids;
+};
+
+void build_forward_input(ReceivedForwardInput& input,
+                         ForwardInput& forward_inputs) {
+  // Create ForwardInput on cpu pinned memory here
+  auto tensor_options = torch::TensorOptions()
+                            .dtype(torch::kInt)
+                            .device(torch::kCPU)
+                            .pinned_memory(true);
+  forward_inputs.token_ids =
+      torch::tensor(input.flatten_tokens_vec, tensor_options);
+  forward_inputs.positions =
+      torch::tensor(input.flatten_positions_vec, tensor_options);
+  std::pair<int, int> prefill_indices{0, 0};
+  if (input.q_seq_lens.size() >= 1) {
+    prefill_indices = util::find_ones_indices(input.q_seq_lens);
+  }
+  auto& input_params = forward_inputs.input_params;
+  input_params.empty_kv_cache = input.empty_kv_cache;
+  input_params.global_empty_kv_cache = input.global_empty_kv_cache;
+  input_params.num_sequences = input.block_tables_vec.size();
+  input_params.kv_max_seq_len = input.max_seq_len;
+  input_params.q_max_seq_len = input.q_max_seq_len;
+  input_params.kv_seq_lens = torch::tensor(input.seq_lens, tensor_options);
+  input_params.q_seq_lens = torch::tensor(input.q_seq_lens, tensor_options);
+  input_params.kv_seq_lens_vec = std::move(input.seq_lens);
+  input_params.q_seq_lens_vec = std::move(input.q_seq_lens);
+
+  input_params.new_cache_slots =
+      torch::tensor(input.new_token_slot_ids, tensor_options);
+  input_params.prefill_indices = prefill_indices;
+
+  util::pad_2d_vector(input.block_tables_vec, /*pad_value=*/0);
+  input_params.block_tables =
+      std::move(create_2d_tensor(input.block_tables_vec, torch::kInt));
+
+  input_params.dp_global_token_nums = std::move(input.dp_global_token_nums);
+  input_params.embedding_ids = std::move(input.embedding_ids);
+
+  if (!input.embeddings.empty()) {
+    torch::Tensor embeddings =
+        create_2d_tensor(input.embeddings, torch::kBFloat16);
+    input_params.mm_data =
+        MMData(MMType::EMBEDDING, {{"embedding", embeddings}});
+  }
+
+  std::vector<const RequestSamplingParam*> sampling_params;
+  sampling_params.reserve(input.sampling_params.size());
+  for (const auto& sampling_param : input.sampling_params) {
+    sampling_params.emplace_back(&sampling_param);
+  }
+  CHECK_EQ(sampling_params.size(), input.selected_token_idxes.size());
+  if (!input.selected_token_idxes.empty()) {
+    util::pad_2d_vector<int64_t>(input.unique_token_ids_vec, /*pad_value=*/0);
+    util::pad_2d_vector(input.unique_token_counts_vec, /*pad_value=*/0);
+    forward_inputs.sampling_params.init(sampling_params,
+                                        input.selected_token_idxes,
+                                        input.sample_idxes,
+                                        input.unique_token_ids_vec,
+                                        input.unique_token_counts_vec,
+                                        input.unique_token_lens_vec);
+  }
+
+  forward_inputs.transfer_kv_infos = std::move(input.transfer_kv_infos);
+  forward_inputs.eplb_info = std::move(input.eplb_info);
+  forward_inputs.block_transfer_infos = std::move(input.block_transfer_infos);
+}
 }  // namespace
 
-void proto_to_forward_input(const proto::ForwardInput* pb_forward_input,
+bool proto_to_forward_input(const proto::ForwardInput* pb_forward_input,
                             ForwardInput& forward_inputs,
-                            int64_t num_decoding_tokens) {
+                            int64_t num_decoding_tokens,
+                            ForwardInputDeltaDecoder* delta_decoder) {
   Timer timer;
-  int32_t num_sequences = pb_forward_input->num_sequences();
-  std::vector<int32_t> flatten_tokens_vec =
+  ReceivedForwardInput input;
+  input.flatten_tokens_vec =
       std::vector<int32_t>(pb_forward_input->flatten_tokens_vec().begin(),
                            pb_forward_input->flatten_tokens_vec().end());
-  std::vector<int32_t> flatten_positions_vec =
+  input.flatten_positions_vec =
       std::vector<int32_t>(pb_forward_input->flatten_positions_vec().begin(),
                            pb_forward_input->flatten_positions_vec().end());
-  std::vector<int32_t> new_token_slot_ids =
+  input.new_token_slot_ids =
       std::vector<int32_t>(pb_forward_input->new_token_slot_ids().begin(),
                            pb_forward_input->new_token_slot_ids().end());
   // aprint<int32_t>(new_token_slot_ids, "token_slot_ids", global_rank_);
-  std::vector<int32_t> seq_lens = std::vector<int32_t>(
-      pb_forward_input->seq_lens().begin(), pb_forward_input->seq_lens().end());
+  input.seq_lens = std::vector<int32_t>(pb_forward_input->seq_lens().begin(),
+                                        pb_forward_input->seq_lens().end());
   // aprint<int32_t>(seq_lens, "seq_lens", global_rank_);
-  std::vector<int32_t> q_seq_lens =
+  input.q_seq_lens =
       std::vector<int32_t>(pb_forward_input->q_seq_lens().begin(),
                            pb_forward_input->q_seq_lens().end());
   // aprint<int32_t>(q_seq_lens, "q_seq_lens", global_rank_);
-  std::vector<std::vector<int32_t>> block_tables_vec;
+  if (pb_forward_input->delta_step() > 0) {
+    CHECK(delta_decoder != nullptr) << "delta encoded forward input";
+    if (!delta_decoder->decode(*pb_forward_input,
+                               &input.block_tables_vec,
+                               &input.unique_token_ids_vec,
+                               &input.unique_token_counts_vec)) {
+      return false;
+    }
+  }
   for (size_t i = 0; i < pb_forward_input->block_tables_vec().size(); ++i) {
-    block_tables_vec.emplace_back(std::vector<int32_t>(
+    input.block_tables_vec.emplace_back(std::vector<int32_t>(
         pb_forward_input->block_tables_vec()[i].block_tables().begin(),
         pb_forward_input->block_tables_vec()[i].block_tables().end()));
     // aprint<int32_t>((block_tables_vec.back()), "block_tables_vec",
     // global_rank_);
   }
-  std::vector<int32_t> selected_token_idxes =
+  input.selected_token_idxes =
       std::vector<int32_t>(pb_forward_input->selected_token_idxes().begin(),
                            pb_forward_input->selected_token_idxes().end());
   // aprint<int32_t>(selected_token_idxes, "selected_token_idxes",
   // global_rank_);
-  std::vector<int32_t> sample_idxes =
+  input.sample_idxes =
       std::vector<int32_t>(pb_forward_input->sample_idxes().begin(),
                            pb_forward_input->sample_idxes().end());
   // aprint<int32_t>(sample_idxes, "sample_idxes", global_rank_);
 
-  std::vector<std::vector<int64_t>> unique_token_ids_vec;
   for (size_t i = 0; i < pb_forward_input->unique_token_ids_vec().size(); ++i) {
-    unique_token_ids_vec.emplace_back(std::vector<int64_t>(
+    input.unique_token_ids_vec.emplace_back(std::vector<int64_t>(
         pb_forward_input->unique_token_ids_vec()[i].unique_token_ids().begin(),
         pb_forward_input->unique_token_ids_vec()[i].unique_token_ids().end()));
     // aprint<int32_t>((unique_token_ids_vec.back()), "unique_token_ids_vec",
     // global_rank_);
   }
-  std::vector<std::vector<int32_t>> unique_token_counts_vec;
   for (size_t i = 0; i < pb_forward_input->unique_token_counts_vec().size();
        ++i) {
-    unique_token_counts_vec.emplace_back(
+    input.unique_token_counts_vec.emplace_back(
         std::vector<int32_t>(pb_forward_input->unique_token_counts_vec()[i]
                                  .unique_token_counts()
                                  .begin(),
@@ -85,18 +186,16 @@ void proto_to_forward_input(const proto::ForwardInput* pb_forward_input,
     // aprint<int32_t>((unique_token_counts_vec.back()),
     // "unique_token_counts_vec", global_rank_);
   }
-  std::vector<int32_t> unique_token_lens_vec =
+  input.unique_token_lens_vec =
       std::vector<int32_t>(pb_forward_input->unique_token_lens_vec().begin(),
                            pb_forward_input->unique_token_lens_vec().end());
   // aprint<int32_t>(unique_token_lens_vec, "unique_token_lens_vec",
   // global_rank_);
 
-  std::vector<int32_t> embedding_ids =
+  input.embedding_ids =
       std::vector<int32_t>(pb_forward_input->embedding_ids().begin(),
                            pb_forward_input->embedding_ids().end());
 
-  std::vector<const RequestSamplingParam*> sampling_params;
-  std::vector<RequestSamplingParam> tmp_sampling_params;
   for (auto sp : pb_forward_input->sampling_params()) {
     RequestSamplingParam tmp;
     tmp.frequency_penalty = sp.frequency_penalty();
@@ -109,79 +208,23 @@ void proto_to_forward_input(const proto::ForwardInput* pb_forward_input,
     tmp.top_logprobs = sp.top_logprobs();
     tmp.do_sample = sp.do_sample();
     tmp.is_embeddings = sp.is_embeddings();
-    tmp_sampling_params.emplace_back(tmp);
-  }
-  for (size_t i = 0; i < tmp_sampling_params.size(); ++i) {
-    sampling_params.emplace_back(&tmp_sampling_params[i]);
+    input.sampling_params.emplace_back(tmp);
   }
 
-  std::vector<int32_t> dp_global_token_nums =
+  input.dp_global_token_nums =
       std::vector<int32_t>(pb_forward_input->dp_global_token_nums().begin(),
                            pb_forward_input->dp_global_token_nums().end());
+  input.empty_kv_cache = pb_forward_input->empty_kv_cache();
+  input.global_empty_kv_cache = pb_forward_input->global_empty_kv_cache();
+  input.max_seq_len = pb_forward_input->max_seq_len();
+  input.q_max_seq_len = pb_forward_input->q_max_seq_len();
 
-  // Create ForwardInput on cpu pinned memory here
-  auto tensor_options = torch::TensorOptions()
-                            .dtype(torch::kInt)
-                            .device(torch::kCPU)
-                            .pinned_memory(true);
-  forward_inputs.token_ids = torch::tensor(flatten_tokens_vec, tensor_options);
-  forward_inputs.positions =
-      torch::tensor(flatten_positions_vec, tensor_options);
-  std::pair<int, int> prefill_indices{0, 0};
-  if (q_seq_lens.size() >= 1) {
-    prefill_indices = util::find_ones_indices(q_seq_lens);
-  }
-  auto& input_params = forward_inputs.input_params;
-  input_params.empty_kv_cache = pb_forward_input->empty_kv_cache();
-  input_params.global_empty_kv_cache =
-      pb_forward_input->global_empty_kv_cache();
-  input_params.num_sequences = block_tables_vec.size();
-  input_params.kv_max_seq_len = pb_forward_input->max_seq_len();
-  input_params.q_max_seq_len = pb_forward_input->q_max_seq_len();
-  input_params.kv_seq_lens = torch::tensor(seq_lens, tensor_options);
-  input_params.q_seq_lens = torch::tensor(q_seq_lens, tensor_options);
-  input_params.kv_seq_lens_vec = std::move(seq_lens);
-  input_params.q_seq_lens_vec = std::move(q_seq_lens);
-
-  input_params.new_cache_slots =
-      torch::tensor(new_token_slot_ids, tensor_options);
-  input_params.prefill_indices = prefill_indices;
-
-  util::pad_2d_vector(block_tables_vec, /*pad_value=*/0);
-  input_params.block_tables =
-      std::move(create_2d_tensor(block_tables_vec, torch::kInt));
-
-  input_params.dp_global_token_nums = std::move(dp_global_token_nums);
-  input_params.embedding_ids = std::move(embedding_ids);
-
-  if (pb_forward_input->embeds().size() > 0) {
-    const int32_t rows = pb_forward_input->embeds().size();
-    const int32_t cols = pb_forward_input->embeds()[0].vals().size();
-    std::vector<std::vector<float>> embeddings_vec;
-    for (size_t i = 0; i < rows; ++i) {
-      embeddings_vec.emplace_back(
-          std::vector<float>(pb_forward_input->embeds()[i].vals().begin(),
-                             pb_forward_input->embeds()[i].vals().end()));
-    }
-    torch::Tensor embeddings =
-        create_2d_tensor(embeddings_vec, torch::kBFloat16);
-    input_params.mm_data =
-        MMData(MMType::EMBEDDING, {{"embedding", embeddings}});
-  }
-
-  CHECK_EQ(sampling_params.size(), selected_token_idxes.size());
-  if (!selected_token_idxes.empty()) {
-    util::pad_2d_vector<int64_t>(unique_token_ids_vec, /*pad_value=*/0);
-    util::pad_2d_vector(unique_token_counts_vec, /*pad_value=*/0);
-    forward_inputs.sampling_params.init(sampling_params,
-                                        selected_token_idxes,
-                                        sample_idxes,
-                                        unique_token_ids_vec,
-                                        unique_token_counts_vec,
-                                        unique_token_lens_vec);
+  for (const auto& pb_embeds : pb_forward_input->embeds()) {
+    input.embeddings.emplace_back(
+        std::vector<float>(pb_embeds.vals().begin(), pb_embeds.vals().end()));
   }
 
-  forward_inputs.transfer_kv_infos.reserve(
+  input.transfer_kv_infos.reserve(
       pb_forward_input->transfer_kv_infos().size());
   for (int i = 0; i < pb_forward_input->transfer_kv_infos().size(); ++i) {
     TransferKVInfo transfer_kv_info;
@@ -245,20 +288,31 @@ void proto_to_forward_input(const proto::ForwardInput* pb_forward_input,
                                 .dp_size();
 
     transfer_kv_info.remote_instance_info = std::move(instance_info);
-    forward_inputs.transfer_kv_infos.emplace_back(std::move(transfer_kv_info));
+    input.transfer_kv_infos.emplace_back(std::move(transfer_kv_info));
   }
-  auto& eplb_info = forward_inputs.eplb_info;
+  auto& eplb_info = input.eplb_info;
   eplb_info.prepare_layer_id = pb_forward_input->eplb_info().prepare_layer_id();
   eplb_info.expert_ids =
       std::vector<int32_t>(pb_forward_input->eplb_info().expert_ids().begin(),
                            pb_forward_input->eplb_info().expert_ids().end());
   eplb_info.update_layer_id = pb_forward_input->eplb_info().update_layer_id();
-  forward_inputs.eplb_info = eplb_info;
+  input.block_transfer_infos.reserve(
+      pb_forward_input->block_transfer_infos().size());
+  for (const auto& pb_info : pb_forward_input->block_transfer_infos()) {
+    input.block_transfer_infos.emplace_back(
+        pb_info.src_block_id(),
+        pb_info.dst_block_id(),
+        static_cast<TransferType>(pb_info.transfer_type()));
+  }
+  build_forward_input(input, forward_inputs);
   COUNTER_ADD(proto_latency_seconds_proto2i, timer.elapsed_seconds());
+  return true;
 }
 
+
 void forward_input_to_proto(const RawForwardInput& inputs,
-                            proto::ForwardInput* pb_forward_input) {
+                            proto::ForwardInput* pb_forward_input,
+                            ForwardInputDeltaEncoder* delta_encoder) {
   Timer timer;
   ADD_VECTOR_TO_PROTO(pb_forward_input->mutable_flatten_tokens_vec(),
                       inputs.flatten_tokens_vec);
@@ -285,22 +339,26 @@ void forward_input_to_proto(const RawForwardInput& inputs,
                       inputs.selected_token_idxes);
   ADD_VECTOR_TO_PROTO(pb_forward_input->mutable_sample_idxes(),
                       inputs.sample_idxes);
-  pb_forward_input->mutable_unique_token_ids_vec()->Reserve(
-      inputs.unique_token_ids_vec.size());
-  for (auto ids : inputs.unique_token_ids_vec) {
-    proto::UniqueTokenIds pb_unique_token_ids;
-    ADD_VECTOR_TO_PROTO(pb_unique_token_ids.mutable_unique_token_ids(), ids);
-    *pb_forward_input->mutable_unique_token_ids_vec()->Add() =
-        pb_unique_token_ids;
-  }
-  pb_forward_input->mutable_unique_token_counts_vec()->Reserve(
-      inputs.unique_token_counts_vec.size());
-  for (auto counts : inputs.unique_token_counts_vec) {
-    proto::UniqueTokenCounts pb_unique_token_counts;
-    ADD_VECTOR_TO_PROTO(pb_unique_token_counts.mutable_unique_token_counts(),
-                        counts);
-    *pb_forward_input->mutable_unique_token_counts_vec()->Add() =
-        pb_unique_token_counts;
+  // the unique token counts are delta encoded together with the block tables
+  if (delta_encoder == nullptr) {
+    pb_forward_input->mutable_unique_token_ids_vec()->Reserve(
+        inputs.unique_token_sequences.size());
+    pb_forward_input->mutable_unique_token_counts_vec()->Reserve(
+        inputs.unique_token_sequences.size());
+    for (const auto* sequence : inputs.unique_token_sequences) {
+      auto* pb_unique_token_ids =
+          pb_forward_input->mutable_unique_token_ids_vec()->Add();
+      auto* pb_unique_token_counts =
+          pb_forward_input->mutable_unique_token_counts_vec()->Add();
+      if (sequence == nullptr) {
+        continue;
+      }
+      ADD_VECTOR_TO_PROTO(pb_unique_token_ids->mutable_unique_token_ids(),
+                          sequence->unique_token_ids());
+      ADD_VECTOR_TO_PROTO(
+          pb_unique_token_counts->mutable_unique_token_counts(),
+          sequence->unique_token_counts());
+    }
   }
   ADD_VECTOR_TO_PROTO(pb_forward_input->mutable_unique_token_lens_vec(),
                       inputs.unique_token_lens_vec);
@@ -313,12 +371,16 @@ void forward_input_to_proto(const RawForwardInput& inputs,
                       inputs.q_seq_lens);
   ADD_VECTOR_TO_PROTO(pb_forward_input->mutable_new_token_slot_ids(),
                       inputs.new_token_slot_ids);
-  pb_forward_input->mutable_block_tables_vec()->Reserve(
-      inputs.block_tables_vec.size());
-  for (auto t : inputs.block_tables_vec) {
-    proto::BlockTables pb_table;
-    ADD_VECTOR_TO_PROTO(pb_table.mutable_block_tables(), t);
-    *pb_forward_input->mutable_block_tables_vec()->Add() = pb_table;
+  if (delta_encoder != nullptr) {
+    delta_encoder->encode(inputs, pb_forward_input);
+  } else {
+    pb_forward_input->mutable_block_tables_vec()->Reserve(
+        inputs.block_tables_vec.size());
+    for (const auto& t : inputs.block_tables_vec) {
+      proto::BlockTables pb_table;
+      ADD_VECTOR_TO_PROTO(pb_table.mutable_block_tables(), t);
+      *pb_forward_input->mutable_block_tables_vec()->Add() = pb_table;
+    }
   }
   pb_forward_input->set_num_sequences(inputs.num_sequences);
   ADD_VECTOR_TO_PROTO(pb_forward_input->mutable_dp_global_token_nums(),
@@ -364,6 +426,14 @@ void forward_input_to_proto(const RawForwardInput& inputs,
   ADD_VECTOR_TO_PROTO(
       pb_forward_input->mutable_eplb_info()->mutable_expert_ids(),
       inputs.eplb_info.expert_ids);
+  pb_forward_input->mutable_block_transfer_infos()->Reserve(
+      inputs.block_transfer_infos.size());
+  for (const auto& info : inputs.block_transfer_infos) {
+    auto pb_info = pb_forward_input->mutable_block_transfer_infos()->Add();
+    pb_info->set_src_block_id(info.src_block_id);
+    pb_info->set_dst_block_id(info.dst_block_id);
+    pb_info->set_transfer_type(static_cast<int32_t>(info.transfer_type));
+  }
   pb_forward_input->mutable_embeds()->Reserve(inputs.embeddings.size());
   for (auto t : inputs.embeddings) {
     proto::Embeddings embeds;
@@ -376,6 +446,174 @@ void forward_input_to_proto(const RawForwardInput& inputs,
                       inputs.embedding_ids);
 }
 
+void forward_input_to_flat(const RawForwardInput& inputs, FlatWriter* writer) {
+  writer->write_vector(inputs.flatten_tokens_vec);
+  writer->write_vector(inputs.flatten_positions_vec);
+  writer->write<uint64_t>(inputs.sampling_params.size());
+  for (const auto* sampling_param : inputs.sampling_params) {
+    writer->write(*sampling_param);
+  }
+  writer->write_vector(inputs.selected_token_idxes);
+  writer->write_vector(inputs.sample_idxes);
+  // the whole unique token counts, a memcpy is cheaper than the delta
+  writer->write<uint64_t>(inputs.unique_token_sequences.size());
+  for (const auto* sequence : inputs.unique_token_sequences) {
+    if (sequence == nullptr) {
+      writer->write_vector(std::vector<int64_t>());
+      writer->write_vector(std::vector<int32_t>());
+      continue;
+    }
+    writer->write_vector(sequence->unique_token_ids());
+    writer->write_vector(sequence->unique_token_counts());
+  }
+  writer->write_vector(inputs.unique_token_lens_vec);
+  writer->write<uint8_t>(inputs.empty_kv_cache);
+  writer->write<uint8_t>(inputs.global_empty_kv_cache);
+  writer->write(inputs.max_seq_len);
+  writer->write(inputs.q_max_seq_len);
+  writer->write_vector(inputs.seq_lens);
+  writer->write_vector(inputs.q_seq_lens);
+  writer->write_vector(inputs.new_token_slot_ids);
+  writer->write<uint64_t>(inputs.block_tables_vec.size());
+  for (const auto& block_table : inputs.block_tables_vec) {
+    writer->write_vector(block_table);
+  }
+  writer->write(inputs.num_sequences);
+  writer->write_vector(inputs.dp_global_token_nums);
+  writer->write<uint64_t>(inputs.transfer_kv_infos.size());
+  for (const auto& transfer_kv_info : inputs.transfer_kv_infos) {
+    const auto& instance_info = transfer_kv_info.remote_instance_info;
+    writer->write_string(transfer_kv_info.request_id);
+    writer->write_vector(transfer_kv_info.local_blocks_ids);
+    writer->write_vector(transfer_kv_info.remote_blocks_ids);
+    writer->write(transfer_kv_info.dp_rank);
+    writer->write_string(instance_info.name);
+    writer->write_string(instance_info.rpc_address);
+    writer->write_string(instance_info.type);
+    writer->write_vector(instance_info.cluster_ids);
+    writer->write<uint64_t>(instance_info.addrs.size());
+    for (const auto& addr : instance_info.addrs) {
+      writer->write_string(addr);
+    }
+    writer->write_vector(instance_info.k_cache_ids);
+    writer->write_vector(instance_info.v_cache_ids);
+    writer->write(instance_info.dp_size);
+  }
+  writer->write(inputs.eplb_info.prepare_layer_id);
+  writer->write_vector(inputs.eplb_info.expert_ids);
+  writer->write(inputs.eplb_info.update_layer_id);
+  writer->write_vector(inputs.block_transfer_infos);
+  writer->write<uint64_t>(inputs.embeddings.size());
+  for (const auto& embedding : inputs.embeddings) {
+    writer->write_vector(embedding);
+  }
+  writer->write(inputs.prefill_seq_len);
+  writer->write_vector(inputs.embedding_ids);
+}
+
+bool flat_to_forward_input(FlatReader* reader,
+                           ForwardInput& forward_inputs,
+                           int32_t* num_sequences,
+                           uint32_t* prefill_seq_len) {
+  ReceivedForwardInput input;
+  // reads the size of a list, each element takes at least one byte
+  auto read_size = [reader](size_t* size) {
+    uint64_t value = 0;
+    if (!reader->read(&value) || value > reader->remaining()) {
+      return false;
+    }
+    *size = value;
+    return true;
+  };
+  size_t size = 0;
+  reader->read_vector(&input.flatten_tokens_vec);
+  reader->read_vector(&input.flatten_positions_vec);
+  if (!read_size(&size)) {
+    return false;
+  }
+  input.sampling_params.resize(size);
+  for (auto& sampling_param : input.sampling_params) {
+    reader->read(&sampling_param);
+  }
+  reader->read_vector(&input.selected_token_idxes);
+  reader->read_vector(&input.sample_idxes);
+  if (!read_size(&size)) {
+    return false;
+  }
+  input.unique_token_ids_vec.resize(size);
+  input.unique_token_counts_vec.resize(size);
+  for (size_t i = 0; i < size; ++i) {
+    reader->read_vector(&input.unique_token_ids_vec[i]);
+    reader->read_vector(&input.unique_token_counts_vec[i]);
+  }
+  reader->read_vector(&input.unique_token_lens_vec);
+  uint8_t empty_kv_cache = 0;
+  uint8_t global_empty_kv_cache = 0;
+  reader->read(&empty_kv_cache);
+  reader->read(&global_empty_kv_cache);
+  input.empty_kv_cache = empty_kv_cache != 0;
+  input.global_empty_kv_cache = global_empty_kv_cache != 0;
+  reader->read(&input.max_seq_len);
+  reader->read(&input.q_max_seq_len);
+  reader->read_vector(&input.seq_lens);
+  reader->read_vector(&input.q_seq_lens);
+  reader->read_vector(&input.new_token_slot_ids);
+  if (!read_size(&size)) {
+    return false;
+  }
+  input.block_tables_vec.resize(size);
+  for (auto& block_table : input.block_tables_vec) {
+    reader->read_vector(&block_table);
+  }
+  reader->read(num_sequences);
+  reader->read_vector(&input.dp_global_token_nums);
+  if (!read_size(&size)) {
+    return false;
+  }
+  input.transfer_kv_infos.resize(size);
+  for (auto& transfer_kv_info : input.transfer_kv_infos) {
+    auto& instance_info = transfer_kv_info.remote_instance_info;
+    reader->read_string(&transfer_kv_info.request_id);
+    reader->read_vector(&transfer_kv_info.local_blocks_ids);
+    reader->read_vector(&transfer_kv_info.remote_blocks_ids);
+    reader->read(&transfer_kv_info.dp_rank);
+    reader->read_string(&instance_info.name);
+    reader->read_string(&instance_info.rpc_address);
+    reader->read_string(&instance_info.type);
+    reader->read_vector(&instance_info.cluster_ids);
+    if (!read_size(&size)) {
+      return false;
+    }
+    instance_info.addrs.resize(size);
+    for (auto& addr : instance_info.addrs) {
+      reader->read_string(&addr);
+    }
+    reader->read_vector(&instance_info.k_cache_ids);
+    reader->read_vector(&instance_info.v_cache_ids);
+    reader->read(&instance_info.dp_size);
+  }
+  reader->read(&input.eplb_info.prepare_layer_id);
+  reader->read_vector(&input.eplb_info.expert_ids);
+  reader->read(&input.eplb_info.update_layer_id);
+  reader->read_vector(&input.block_transfer_infos);
+  if (!read_size(&size)) {
+    return false;
+  }
+  input.embeddings.resize(size);
+  for (auto& embedding : input.embeddings) {
+    reader->read_vector(&embedding);
+  }
+  reader->read(prefill_seq_len);
+  reader->read_vector(&input.embedding_ids);
+  if (!reader->done() ||
+      input.sampling_params.size() != input.selected_token_idxes.size()) {
+    return false;
+  }
+
+  build_forward_input(input, forward_inputs);
+  return true;
+}
+
 void proto_to_forward_output(const proto::ForwardOutput& pb_output,
                              RawForwardOutput& raw_forward_output) {
   Timer timer;
@@ -416,6 +654,56 @@ void proto_to_forward_output(const proto::ForwardOutput& pb_output,
   COUNTER_ADD(proto_latency_seconds_proto2o, timer.elapsed_seconds());
 }
 
+namespace {
+// the tokens of the sequence at output_idx. next_tokens is 2-D when a step
+// generates several tokens per sequence, which end at the first -1.
+std::vector<Token> output_tokens(int32_t output_idx,
+                                 const torch::Tensor& next_tokens,
+                                 const torch::Tensor& logprobs,
+                                 const torch::Tensor& top_tokens,
+                                 const torch::Tensor& top_logprobs) {
+  if (next_tokens.dim() != 2) {
+    return {build_token(
+        output_idx, next_tokens, logprobs, top_tokens, top_logprobs)};
+  }
+  const auto curr_next_tokens = next_tokens[output_idx];
+  const auto curr_logprobs =
+      logprobs.defined() ? logprobs[output_idx] : logprobs;
+  const auto curr_top_tokens =
+      top_tokens.defined() ? top_tokens[output_idx] : top_tokens;
+  const auto curr_top_logprobs =
+      top_logprobs.defined() ? top_logprobs[output_idx] : top_logprobs;
+
+  const int32_t num_tokens = curr_next_tokens.size(0);
+  std::vector<Token> tokens;
+  tokens.reserve(num_tokens);
+  for (int32_t i = 0; i < num_tokens; ++i) {
+    const auto token = build_token(i,
+                                   curr_next_tokens,
+                                   curr_logprobs,
+                                   curr_top_tokens,
+                                   curr_top_logprobs);
+    if (token.id == -1) {
+      break;
+    }
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+
+// the embeddings of the token_idx-th token of the sequence at output_idx
+torch::Tensor output_token_embeddings(int32_t output_idx,
+                                      size_t token_idx,
+                                      const torch::Tensor& next_tokens,
+                                      const torch::Tensor& embeddings) {
+  if (!embeddings.defined()) {
+    return embeddings;
+  }
+  return next_tokens.dim() == 2 ? embeddings[output_idx][token_idx]
+                                : embeddings[output_idx];
+}
+}  // namespace
+
 void forward_output_to_proto(const torch::Tensor& next_tokens,
                              const torch::Tensor& logprobs,
                              const torch::Tensor& top_tokens,
@@ -426,74 +714,14 @@ void forward_output_to_proto(const torch::Tensor& next_tokens,
                              proto::ForwardOutput* pb_forward_output) {
   Timer timer;
   const int32_t num_seqs = next_tokens.size(0);
-  int32_t output_idx = 0;
   pb_forward_output->mutable_outputs()->Reserve(num_seqs);
   for (int32_t output_idx = 0; output_idx < num_seqs; ++output_idx) {
-    if (next_tokens.dim() == 2) {
-      const auto curr_idx = output_idx;
-      const auto curr_next_tokens = next_tokens[curr_idx];
-      const auto curr_logprobs =
-          logprobs.defined() ? logprobs[curr_idx] : logprobs;
-      const auto curr_top_tokens =
-          top_tokens.defined() ? top_tokens[curr_idx] : top_tokens;
-      const auto curr_top_logprobs =
-          top_logprobs.defined() ? top_logprobs[curr_idx] : top_logprobs;
-      const auto curr_embeddings =
-          embeddings.defined() ? embeddings[curr_idx] : embeddings;
-
-      int32_t num_tokens = curr_next_tokens.size(0);
-      std::vector<Token> tokens;
-      tokens.reserve(num_tokens);
-      for (int32_t i = 0; i < num_tokens; ++i) {
-        const auto token = build_token(i,
-                                       curr_next_tokens,
-                                       curr_logprobs,
-                                       curr_top_tokens,
-                                       curr_top_logprobs);
-        if (token.id == -1) {
-          break;
-        }
-        tokens.push_back(token);
-      }
-      num_tokens = tokens.size();
-      proto::SquenceOutput pb_seq_out;
-      pb_seq_out.mutable_tokens()->Reserve(num_tokens);
-      for (int32_t i = 0; i < num_tokens; ++i) {
-        const auto& token = tokens[i];
-        proto::Token pb_token;
-        pb_token.set_id(token.id);
-        if (token.logprob.has_value()) {
-          pb_token.set_logprob(token.logprob.value());
-        } else {
-          pb_token.set_empty(true);
-        }
-        pb_token.mutable_top_tokens()->Reserve(token.top_tokens.size());
-        for (auto it = token.top_tokens.begin(); it != token.top_tokens.end();
-             ++it) {
-          pb_token.add_top_tokens(*it);
-        }
-        pb_token.mutable_top_logprobs()->Reserve(token.top_logprobs.size());
-        for (auto it = token.top_logprobs.begin();
-             it != token.top_logprobs.end();
-             ++it) {
-          pb_token.add_top_logprobs(*it);
-        }
-        const auto token_embeddings =
-            curr_embeddings.defined() ? curr_embeddings[i] : curr_embeddings;
-        if (token_embeddings.defined()) {
-          Slice<float> embedding_slice = {token_embeddings.data_ptr<float>(),
-                                          token_embeddings.size(0)};
-          ADD_VECTOR_TO_PROTO(pb_token.mutable_embeddings()->mutable_vals(),
-                              embedding_slice);
-        }
-        *pb_seq_out.mutable_tokens()->Add() = pb_token;
-      }
-      *pb_forward_output->mutable_outputs()->Add() = pb_seq_out;
-    } else {
-      const auto token = build_token(
-          output_idx, next_tokens, logprobs, top_tokens, top_logprobs);
-      proto::SquenceOutput pb_seq_out;
-      pb_seq_out.mutable_tokens()->Reserve(1);
+    const auto tokens = output_tokens(
+        output_idx, next_tokens, logprobs, top_tokens, top_logprobs);
+    proto::SquenceOutput pb_seq_out;
+    pb_seq_out.mutable_tokens()->Reserve(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+      const auto& token = tokens[i];
       proto::Token pb_token;
       pb_token.set_id(token.id);
       if (token.logprob.has_value()) {
@@ -512,7 +740,7 @@ void forward_output_to_proto(const torch::Tensor& next_tokens,
         pb_token.add_top_logprobs(*it);
       }
       const auto token_embeddings =
-          embeddings.defined() ? embeddings[output_idx] : embeddings;
+          output_token_embeddings(output_idx, i, next_tokens, embeddings);
       if (token_embeddings.defined()) {
         Slice<float> embedding_slice = {token_embeddings.data_ptr<float>(),
                                         token_embeddings.size(0)};
@@ -520,8 +748,8 @@ void forward_output_to_proto(const torch::Tensor& next_tokens,
                             embedding_slice);
       }
       *pb_seq_out.mutable_tokens()->Add() = pb_token;
-      *pb_forward_output->mutable_outputs()->Add() = pb_seq_out;
     }
+    *pb_forward_output->mutable_outputs()->Add() = pb_seq_out;
   }
 
   if (FLAGS_enable_eplb) {
@@ -541,6 +769,84 @@ void forward_output_to_proto(const torch::Tensor& next_tokens,
   return;
 }
 
+void forward_output_to_flat(const torch::Tensor& next_tokens,
+                            const torch::Tensor& logprobs,
+                            const torch::Tensor& top_tokens,
+                            const torch::Tensor& top_logprobs,
+                            const torch::Tensor& embeddings,
+                            const torch::Tensor& expert_load_data,
+                            int32_t prepared_layer_id,
+                            FlatWriter* writer) {
+  const int32_t num_seqs = next_tokens.defined() ? next_tokens.size(0) : 0;
+  writer->write<uint64_t>(num_seqs);
+  for (int32_t output_idx = 0; output_idx < num_seqs; ++output_idx) {
+    const auto tokens = output_tokens(
+        output_idx, next_tokens, logprobs, top_tokens, top_logprobs);
+    writer->write<uint64_t>(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+      const auto& token = tokens[i];
+      writer->write(token.id);
+      writer->write<uint8_t>(token.logprob.has_value());
+      writer->write(token.logprob.value_or(0.0f));
+      writer->write_array(token.top_tokens.data(), token.top_tokens.size());
+      writer->write_array(token.top_logprobs.data(),
+                          token.top_logprobs.size());
+      const auto token_embeddings =
+          output_token_embeddings(output_idx, i, next_tokens, embeddings);
+      if (token_embeddings.defined()) {
+        writer->write_array(token_embeddings.data_ptr<float>(),
+                            token_embeddings.size(0));
+      } else {
+        writer->write_array<float>(nullptr, 0);
+      }
+    }
+  }
+
+  // the same as the proto, which carries them only with eplb
+  writer->write<int32_t>(FLAGS_enable_eplb ? prepared_layer_id : 0);
+  if (FLAGS_enable_eplb && expert_load_data.defined()) {
+    torch::Tensor expert_load_data_flattened =
+        expert_load_data.view({-1}).contiguous();
+    writer->write_array(expert_load_data_flattened.data_ptr<int64_t>(),
+                        expert_load_data_flattened.size(0));
+  } else {
+    writer->write_array<int64_t>(nullptr, 0);
+  }
+}
+
+bool flat_to_forward_output(FlatReader* reader,
+                            RawForwardOutput& raw_forward_output) {
+  uint64_t num_seqs = 0;
+  // each sequence and token takes at least one byte
+  if (!reader->read(&num_seqs) || num_seqs > reader->remaining()) {
+    return false;
+  }
+  raw_forward_output.outputs.resize(num_seqs);
+  for (auto& output : raw_forward_output.outputs) {
+    uint64_t num_tokens = 0;
+    if (!reader->read(&num_tokens) || num_tokens > reader->remaining()) {
+      return false;
+    }
+    output.tokens.resize(num_tokens);
+    for (auto& token : output.tokens) {
+      uint8_t has_logprob = 0;
+      float logprob = 0.0f;
+      reader->read(&token.id);
+      reader->read(&has_logprob);
+      reader->read(&logprob);
+      if (has_logprob != 0) {
+        token.logprob = logprob;
+      }
+      reader->read_vector(&token.top_tokens);
+      reader->read_vector(&token.top_logprobs);
+      reader->read_vector(&token.embeddings);
+    }
+  }
+  reader->read(&raw_forward_output.prepared_layer_id);
+  reader->read_vector(&raw_forward_output.expert_load_data);
+  return reader->done();
+}
+
 Token build_token(int64_t index,
                   torch::Tensor token_ids,
                   torch::Tensor logprobs,
@@ -4,21 +4,53 @@
 
 #include "framework/model/model_input_params.h"
 #include "framework/request/sequence.h"
+#include "runtime/forward_input_delta.h"
 #include "runtime/forward_params.h"
+#include "util/flat_buffer.h"
 #include "worker.pb.h"
 
 namespace xllm {
 
-void proto_to_forward_input(const proto::ForwardInput* pb_forward_input,
-                            ForwardInput& forward_inputs,
-                            int64_t num_decoding_tokens);
+// returns false if the delta encoded block tables can not be decoded.
+bool proto_to_forward_input(
+    const proto::ForwardInput* pb_forward_input,
+    ForwardInput& forward_inputs,
+    int64_t num_decoding_tokens,
+    ForwardInputDeltaDecoder* delta_decoder = nullptr);
 
-void forward_input_to_proto(const RawForwardInput& inputs,
-                            proto::ForwardInput* pb_forward_input);
+// the block tables are delta encoded if delta_encoder is not nullptr.
+void forward_input_to_proto(
+    const RawForwardInput& inputs,
+    proto::ForwardInput* pb_forward_input,
+    ForwardInputDeltaEncoder* delta_encoder = nullptr);
 
 void proto_to_forward_output(const proto::ForwardOutput& pb_output,
                              RawForwardOutput& raw_forward_output);
 
+// the flat layout of the inputs and outputs sent through the shared memory
+// step channel, which the processes of the same binary read without parsing.
+// the block tables and the unique token counts are written in full.
+void forward_input_to_flat(const RawForwardInput& inputs, FlatWriter* writer);
+
+// returns false if the data is malformed.
+bool flat_to_forward_input(FlatReader* reader,
+                           ForwardInput& forward_inputs,
+                           int32_t* num_sequences,
+                           uint32_t* prefill_seq_len);
+
+void forward_output_to_flat(const torch::Tensor& next_tokens,
+                            const torch::Tensor& logprobs,
+                            const torch::Tensor& top_tokens,
+                            const torch::Tensor& top_logprobs,
+                            const torch::Tensor& embeddings,
+                            const torch::Tensor& expert_load_data,
+                            int32_t prepared_layer_id,
+                            FlatWriter* writer);
+
+// returns false if the data is malformed.
+bool flat_to_forward_output(FlatReader* reader,
+                            RawForwardOutput& raw_forward_output);
+
 void forward_output_to_proto(const torch::Tensor& next_tokens,
                              const torch::Tensor& logprobs,
                              const torch::Tensor& top_tokens,
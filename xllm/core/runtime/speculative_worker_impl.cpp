@@ -105,7 +105,8 @@ bool SpeculativeWorkerImpl::init_model(const std::string& model_weights_path) {
 }
 
 bool SpeculativeWorkerImpl::allocate_kv_cache(
-    const std::vector<std::vector<int64_t>>& kv_cache_shape) {
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
   // init embedding cache, using total number of blocks
   if (impl_->get_status() == WorkerImpl::Status::LOADED) {
     embedding_allocator_ = std::make_shared<EmbeddingAllocator>(
@@ -113,10 +114,10 @@ bool SpeculativeWorkerImpl::allocate_kv_cache(
   }
 
   if (impl_->get_status() == WorkerImpl::Status::LOADED) {
-    return impl_->allocate_kv_cache(kv_cache_shape);
+    return impl_->allocate_kv_cache(kv_cache_shape, num_host_blocks);
   } else {
     CHECK_EQ(draft_impl_->get_status(), WorkerImpl::Status::LOADED);
-    return draft_impl_->allocate_kv_cache(kv_cache_shape);
+    return draft_impl_->allocate_kv_cache(kv_cache_shape, num_host_blocks);
   }
 }
 
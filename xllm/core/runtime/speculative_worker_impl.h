@@ -51,7 +51,8 @@ class SpeculativeWorkerImpl : public WorkerImpl {
 
   // allocate kv cache. blocking call
   bool allocate_kv_cache(
-      const std::vector<std::vector<int64_t>>& kv_cache_shape) override;
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks) override;
 
   bool allocate_kv_cache_with_transfer(
       const uint64_t kv_cache_size,
@@ -228,7 +228,8 @@ bool VLMEngine::allocate_kv_cache(const Engine::KVCacheCapacity& kv_cache_cap) {
   std::vector<folly::SemiFuture<bool>> futures;
   futures.reserve(workers_.size());
   for (auto& worker : workers_) {
-    futures.push_back(worker->allocate_kv_cache_async(kv_cache_shape));
+    futures.push_back(worker->allocate_kv_cache_async(kv_cache_shape,
+                                                      /*num_host_blocks=*/0));
   }
   // wait for all futures to complete
   auto results = folly::collectAll(futures).get();
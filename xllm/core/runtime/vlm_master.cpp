@@ -9,9 +9,11 @@
 #include <utility>
 #include <vector>
 
+#include "common/global_flags.h"
 #include "common/metrics.h"
 #include "framework/model/model_args.h"
 #include "framework/request/mm_data.h"
+#include "framework/request/mm_data_cache.h"
 #include "framework/request/request.h"
 #include "models/model_registry.h"
 #include "runtime/speculative_engine.h"
@@ -24,9 +26,9 @@
 #include "util/device_name_utils.h"
 #include "util/scope_guard.h"
 #include "util/timer.h"
+#include "xllm/processors/image_processor.h"
 
 namespace xllm {
-
 VLMMaster::VLMMaster(const Options& options)
     : Master(options, EngineType::VLM) {
   CHECK(engine_->init());
@@ -128,6 +130,11 @@ VLMMaster::VLMMaster(const Options& options)
     image_processor_ = image_processor_factory(model_args_);
   }
 
+  if (FLAGS_mm_data_cache_size_mb > 0) {
+    mm_data_cache_ = std::make_unique<MMDataCache>(
+        static_cast<size_t>(FLAGS_mm_data_cache_size_mb) << 20);
+  }
+
   // construct tokenizer and handling threads
   tokenizer_ = engine_->tokenizer()->clone();
   threadpool_ = std::make_unique<ThreadPool>(options_.num_handling_threads());
@@ -148,13 +155,77 @@ void VLMMaster::handle_request(const std::vector<Message>& messages,
                                RequestParams sp,
                                OutputCallback callback) {
   MMData mm_data;
-  if (!mm_inputs.empty() && !image_processor_->process(mm_inputs, mm_data)) {
+  if (!mm_inputs.empty() && !process_mm_inputs(mm_inputs, mm_data)) {
     LOG(ERROR) << " image processor process failed";
   }
 
   this->handle_request(messages, mm_data, sp, callback);
 }
 
+bool VLMMaster::process_mm_inputs(const MMInput& mm_inputs, MMData& mm_data) {
+  std::vector<std::string> hashes;
+  hashes.reserve(mm_inputs.items_.size());
+  bool all_images = true;
+  // the contents are unknown without the raw data
+  bool has_raw_data = true;
+  for (const auto& item : mm_inputs.items_) {
+    if (mm_data_cache_ != nullptr) {
+      hashes.push_back(MMDataCache::hash(item.raw_data_));
+    }
+    all_images = all_images && item.type_ == MMType::IMAGE;
+    has_raw_data = has_raw_data && !item.raw_data_.empty();
+  }
+
+  if (mm_data_cache_ == nullptr || !has_raw_data) {
+    if (!image_processor_->process(mm_inputs, mm_data)) {
+      return false;
+    }
+  } else if (all_images && image_processor_->process_images_independently()) {
+    // cache the data of each image, a request with a new image reuses the
+    // data of the others
+    std::vector<MMData> mm_datas;
+    mm_datas.reserve(hashes.size());
+    for (size_t i = 0; i < hashes.size(); ++i) {
+      if (auto cached = mm_data_cache_->get(hashes[i])) {
+        COUNTER_INC(mm_data_cache_hit_total);
+        mm_datas.push_back(std::move(cached.value()));
+        continue;
+      }
+      COUNTER_INC(mm_data_cache_miss_total);
+      MMInput image;
+      image.items_.resize(1);
+      image.items_[0].type_ = MMType::IMAGE;
+      image.items_[0].decode_data_ = mm_inputs.items_[i].decode_data_;
+      MMData image_data;
+      if (!image_processor_->process(image, image_data)) {
+        return false;
+      }
+      mm_data_cache_->put(hashes[i], image_data);
+      mm_datas.push_back(std::move(image_data));
+    }
+    mm_data = MMData::batch(mm_datas);
+  } else {
+    // the images are processed together, key them together
+    std::string key;
+    for (const auto& hash : hashes) {
+      key += hash;
+    }
+    key = MMDataCache::hash(key);
+    if (auto cached = mm_data_cache_->get(key)) {
+      COUNTER_ADD(mm_data_cache_hit_total, hashes.size());
+      mm_data = std::move(cached.value());
+    } else {
+      COUNTER_ADD(mm_data_cache_miss_total, hashes.size());
+      if (!image_processor_->process(mm_inputs, mm_data)) {
+        return false;
+      }
+      mm_data_cache_->put(key, mm_data);
+    }
+  }
+
+  return true;
+}
+
 void VLMMaster::handle_batch_request(const std::vector<std::string>& prompts,
                                      const std::vector<MMData>& mm_datas,
                                      std::vector<RequestParams> sps,
@@ -163,7 +234,7 @@ void VLMMaster::handle_batch_request(const std::vector<std::string>& prompts,
       << "Number of prompts and sampling parameters should be the same";
 
   const size_t num_requests = prompts.size();
-  scheduler_->incr_pending_requests(num_requests);
+  // handle_request() counts each request as pending
   for (size_t i = 0; i < num_requests; ++i) {
     handle_request(std::move(prompts[i]),
                    std::move(mm_datas[i]),
@@ -185,7 +256,7 @@ void VLMMaster::handle_batch_request(
       << "Number of conversations and sampling parameters should be the same";
 
   const size_t num_requests = conversations.size();
-  scheduler_->incr_pending_requests(num_requests);
+  // handle_request() counts each request as pending
   for (size_t i = 0; i < num_requests; ++i) {
     handle_request(std::move(conversations[i]),
                    std::move(mm_datas[i]),
@@ -417,6 +488,13 @@ std::shared_ptr<Request> VLMMaster::generate_request(std::string prompt,
                          false, /*enable_schedule_overlap*/
                          callback,
                          nullptr);
+  req_state.priority = sp.priority;
+  req_state.ttft_slo_ms = sp.ttft_slo_ms;
+  req_state.tpot_slo_ms = sp.tpot_slo_ms;
+  req_state.tenant = sp.tenant;
+  // the prompt is charged to the tenant at admission and the generated tokens
+  // when the request finishes
+  rate_limiter_.consume_tokens(sp.tenant, req_state.prompt_tokens.size());
   auto request = std::make_shared<Request>(sp.request_id,
                                            sp.x_request_id,
                                            sp.x_request_time,
@@ -25,6 +25,7 @@ namespace xllm {
 
 struct MMData;
 class ImageProcessor;
+class MMDataCache;
 
 class VLMMaster : public Master {
  public:
@@ -81,6 +82,10 @@ class VLMMaster : public Master {
       const RequestParams& sp,
       OutputCallback callback);
 
+  // process the images with the image processor, the processed data is served
+  // from the cache for the images seen before.
+  bool process_mm_inputs(const MMInput& mm_inputs, MMData& mm_data);
+
   Tokenizer* get_tls_tokenizer();
 
   std::unique_ptr<Scheduler> scheduler_;
@@ -103,6 +108,9 @@ class VLMMaster : public Master {
 
   std::unique_ptr<ImageProcessor> image_processor_;
 
+  // the processed images keyed by their contents, null if disabled
+  std::unique_ptr<MMDataCache> mm_data_cache_;
+
   // thread for moving forward the scheduler
   std::thread loop_thread_;
 
@@ -49,8 +49,9 @@ bool Worker::init_model(const std::string& model_weights_path) {
 }
 
 bool Worker::allocate_kv_cache(
-    const std::vector<std::vector<int64_t>>& kv_cache_shape) {
-  return impl_->allocate_kv_cache(kv_cache_shape);
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
+  return impl_->allocate_kv_cache(kv_cache_shape, num_host_blocks);
 }
 
 void Worker::get_device_info(std::string& device_ip, uint16_t& port) {
@@ -113,8 +114,9 @@ folly::SemiFuture<bool> Worker::init_model_async(
 }
 
 folly::SemiFuture<bool> Worker::allocate_kv_cache_async(
-    const std::vector<std::vector<int64_t>>& kv_cache_shape) {
-  return impl_->allocate_kv_cache_async(kv_cache_shape);
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
+  return impl_->allocate_kv_cache_async(kv_cache_shape, num_host_blocks);
 }
 
 folly::SemiFuture<bool> Worker::allocate_kv_cache_with_transfer_async(
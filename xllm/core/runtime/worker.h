@@ -34,7 +34,8 @@ class Worker {
 
   // allocate kv cache. blocking call
   bool allocate_kv_cache(
-      const std::vector<std::vector<int64_t>>& kv_cache_shape);
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks);
 
   void get_device_info(std::string& device_ip, uint16_t& port);
 
@@ -69,7 +70,8 @@ class Worker {
 
   // initialize kv cache. async call
   folly::SemiFuture<bool> allocate_kv_cache_async(
-      const std::vector<std::vector<int64_t>>& kv_cache_shape);
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks);
 
   // initialize kv cache with kv cache transfer. async call
   virtual folly::SemiFuture<bool> allocate_kv_cache_with_transfer_async(
@@ -24,8 +24,9 @@ bool WorkerClient::init_model(const std::string& model_weights_path) {
 }
 
 bool WorkerClient::allocate_kv_cache(
-    const std::vector<std::vector<int64_t>>& kv_cache_shape) {
-  return worker_->allocate_kv_cache(kv_cache_shape);
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
+  return worker_->allocate_kv_cache(kv_cache_shape, num_host_blocks);
 }
 
 void WorkerClient::get_device_info(std::string& device_ip, uint16_t& port) {
@@ -107,8 +108,9 @@ folly::SemiFuture<bool> WorkerClient::init_model_async(
 }
 
 folly::SemiFuture<bool> WorkerClient::allocate_kv_cache_async(
-    const std::vector<std::vector<int64_t>>& kv_cache_shape) {
-  return worker_->allocate_kv_cache_async(kv_cache_shape);
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
+  return worker_->allocate_kv_cache_async(kv_cache_shape, num_host_blocks);
 }
 
 folly::SemiFuture<bool> WorkerClient::allocate_kv_cache_with_transfer_async(
@@ -32,7 +32,8 @@ class WorkerClient {
 
   // allocate kv cache. blocking call
   virtual bool allocate_kv_cache(
-      const std::vector<std::vector<int64_t>>& kv_cache_shape);
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks);
 
   virtual void get_device_info(std::string& device_ip, uint16_t& port);
 
@@ -72,7 +73,8 @@ class WorkerClient {
 
   // allocate kv cache. async call
   virtual folly::SemiFuture<bool> allocate_kv_cache_async(
-      const std::vector<std::vector<int64_t>>& kv_cache_shape);
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks);
 
   // allocate kv cache with kv cache transfer. async call
   virtual folly::SemiFuture<bool> allocate_kv_cache_with_transfer_async(
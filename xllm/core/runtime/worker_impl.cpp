@@ -26,6 +26,7 @@
 #include "framework/parallel_state.h"
 #include "framework/sampling/sampler.h"
 #include "framework/state_dict/state_dict.h"
+#include "framework/state_dict/weight_cache.h"
 #include "kernels/ascend/xllm_ops/replace_token.h"
 #include "pytorch/adapter/utils/utils.h"
 #include "util/tensor_helper.h"
@@ -72,7 +73,8 @@ WorkerImpl::WorkerImpl(const ParallelArgs& parallel_args,
 WorkerImpl::~WorkerImpl() = default;
 
 bool WorkerImpl::allocate_kv_cache(
-    const std::vector<std::vector<int64_t>>& kv_cache_shape) {
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
   CHECK(model_ != nullptr) << "Model is not initialized.";
   CHECK(kv_caches_.empty()) << "KV caches are already initialized.";
 
@@ -119,7 +121,7 @@ bool WorkerImpl::allocate_kv_cache_with_transfer(
     kv_cache_transfer_ = std::make_unique<HcclKVCacheTransfer>(
         device_.index(), options_.transfer_listen_port());
 
-    allocate_kv_cache(kv_cache_shape);
+    allocate_kv_cache(kv_cache_shape, /*num_host_blocks=*/0);
     kv_cache_transfer_->register_kv_cache(kv_caches_, kv_cache_shape, dtype_);
   }
 
@@ -376,6 +378,23 @@ bool WorkerImpl::init_model(const std::string& model_weights_path) {
   auto tokenizer = model_loader->tokenizer();
   CHECK(tokenizer != nullptr);
 
+  const auto& parallel_args = context_.get_parallel_args();
+  // a rank of a sharded model reads only its slices of the weights, reading
+  // the whole weights files ahead would touch every byte on every rank.
+  model_loader->set_read_ahead(parallel_args.world_size() <= 1);
+
+  std::shared_ptr<WeightCache> weight_cache;
+  if (!FLAGS_weight_cache_dir.empty()) {
+    weight_cache = std::make_shared<WeightCache>(
+        WeightCache::cache_dir(FLAGS_weight_cache_dir,
+                               model_weights_path,
+                               parallel_args.world_size(),
+                               parallel_args.dp_size(),
+                               parallel_args.ep_size()),
+        parallel_args.rank());
+    model_loader->set_weight_cache(weight_cache);
+  }
+
   auto args = model_loader->model_args();
   auto quant_args = model_loader->quant_args();
   torch::ScalarType dtype = util::parse_dtype(args.dtype(), device_);
@@ -405,6 +424,10 @@ bool WorkerImpl::init_model(const std::string& model_weights_path) {
   }
 
   this->load_model(std::move(model_loader));
+  if (weight_cache != nullptr) {
+    // the model is loaded, the next load reads the weights from the cache
+    weight_cache->commit();
+  }
 
   status_ = Status::LOADED;
   if (FLAGS_enable_eplb) {
@@ -425,14 +448,18 @@ void WorkerImpl::load_model(std::unique_ptr<ModelLoader> loader) {
 }
 
 folly::SemiFuture<bool> WorkerImpl::allocate_kv_cache_async(
-    const std::vector<std::vector<int64_t>>& kv_cache_shape) {
+    const std::vector<std::vector<int64_t>>& kv_cache_shape,
+    int64_t num_host_blocks) {
   folly::Promise<bool> promise;
   auto future = promise.getSemiFuture();
-  threadpool_.schedule(
-      [this, &kv_cache_shape, promise = std::move(promise)]() mutable {
-        const bool success = this->allocate_kv_cache(kv_cache_shape);
-        promise.setValue(success);
-      });
+  threadpool_.schedule([this,
+                        &kv_cache_shape,
+                        num_host_blocks,
+                        promise = std::move(promise)]() mutable {
+    const bool success =
+        this->allocate_kv_cache(kv_cache_shape, num_host_blocks);
+    promise.setValue(success);
+  });
   return future;
 }
 
@@ -49,9 +49,11 @@ class WorkerImpl {
 
   virtual std::tuple<int64_t, int64_t> estimate_kv_cache_capacity();
 
-  // allocate kv cache. blocking call
+  // allocate kv cache. blocking call. num_host_blocks is the size of the host
+  // kv cache, 0 if the host memory tier is off.
   virtual bool allocate_kv_cache(
-      const std::vector<std::vector<int64_t>>& kv_cache_shape);
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks);
 
   virtual bool allocate_kv_cache_with_transfer(
       uint64_t kv_cache_size,
@@ -100,7 +102,8 @@ class WorkerImpl {
 
   // initialize kv cache. async call
   virtual folly::SemiFuture<bool> allocate_kv_cache_async(
-      const std::vector<std::vector<int64_t>>& kv_cache_shape);
+      const std::vector<std::vector<int64_t>>& kv_cache_shape,
+      int64_t num_host_blocks);
 
   virtual folly::SemiFuture<bool> allocate_kv_cache_with_transfer_async(
       uint64_t kv_cache_size,
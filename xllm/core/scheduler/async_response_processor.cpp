@@ -4,6 +4,7 @@
 #include <absl/time/clock.h>
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "common/global_flags.h"
@@ -13,6 +14,7 @@
 #include "framework/request/sequence.h"
 #include "util/blocking_counter.h"
 #include "util/env_var.h"
+#include "util/event_notifier.h"
 
 namespace xllm {
 
@@ -20,12 +22,14 @@ AsyncResponseProcessor::AsyncResponseProcessor(
     const Tokenizer* tokenizer,
     const std::optional<InstanceRole>& role,
     bool enable_schedule_overlap,
-    bool enable_decode_response_to_service)
+    bool enable_decode_response_to_service,
+    EventNotifier* scheduler_notifier)
     : response_threadpool_(FLAGS_num_response_handling_threads),
       tokenizer_(tokenizer->clone()),
       role_(role.value_or(InstanceRole::DEFAULT)),
       enable_schedule_overlap_(enable_schedule_overlap),
-      enable_decode_response_to_service_(enable_decode_response_to_service) {
+      enable_decode_response_to_service_(enable_decode_response_to_service),
+      scheduler_notifier_(scheduler_notifier) {
   if (role_ == InstanceRole::DECODE) {
     enable_batch_response_ =
         util::get_bool_env("ENABLE_PD_DECODE_BATCH_RESPONSE", true);
@@ -121,35 +125,58 @@ void AsyncResponseProcessor::process_completed_requests(
 
 void AsyncResponseProcessor::batch_process_completed_requests(
     std::vector<std::shared_ptr<Request>>& requests) {
-  size_t requests_size = requests.size();
-  auto counter = new BlockingCounter(requests_size);
+  // the requests stay on their response threads, the outputs of the requests
+  // of each thread are decoded together with decode_batch().
+  const size_t num_threads = response_threadpool_.size();
+  std::vector<std::vector<size_t>> thread_requests(num_threads);
+  size_t num_unassigned = 0;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto& response_thread_id = requests[i]->state().response_thread_id;
+    if (response_thread_id < 0) {
+      response_thread_id = num_unassigned++ % num_threads;
+    }
+    thread_requests[response_thread_id].push_back(i);
+  }
+
+  const size_t num_groups =
+      std::count_if(thread_requests.begin(),
+                    thread_requests.end(),
+                    [](const auto& indices) { return !indices.empty(); });
+  auto counter = new BlockingCounter(num_groups);
   std::vector<RequestOutput> request_outputs;
-  request_outputs.resize(requests_size);
-  for (int i = 0; i < requests_size; ++i) {
-    auto& request = requests[i];
+  request_outputs.resize(requests.size());
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    if (thread_requests[tid].empty()) {
+      continue;
+    }
+    std::vector<Request*> group;
+    std::vector<RequestOutput*> group_outputs;
+    for (const size_t i : thread_requests[tid]) {
+      group.push_back(requests[i].get());
+      group_outputs.push_back(&request_outputs[i]);
+    }
     auto runnable = [counter,
                      this,
-                     request = request.get(),
-                     request_output = &request_outputs[i]]() mutable {
+                     group = std::move(group),
+                     group_outputs = std::move(group_outputs)]() mutable {
       AUTO_COUNTER(responsing_latency_seconds_non_stream);
-      double end_2_end_latency_seconds = request->elapsed_seconds();
-      // update the metrics for the request
-      HISTOGRAM_OBSERVE(
-          end_2_end_latency_milliseconds,
-          static_cast<int64_t>(end_2_end_latency_seconds * 1000.0));
-      request->log_statistic(end_2_end_latency_seconds);
+      for (Request* request : group) {
+        double end_2_end_latency_seconds = request->elapsed_seconds();
+        // update the metrics for the request
+        HISTOGRAM_OBSERVE(
+            end_2_end_latency_milliseconds,
+            static_cast<int64_t>(end_2_end_latency_seconds * 1000.0));
+        request->log_statistic(end_2_end_latency_seconds);
+      }
 
       auto tokenizer = this->get_tls_tokenizer();
-      *request_output = std::move(request->generate_output(*tokenizer));
+      batch_decode_outputs(group, *tokenizer);
+      for (size_t i = 0; i < group.size(); ++i) {
+        *group_outputs[i] = group[i]->generate_output(*tokenizer);
+      }
       counter->decrement_count();
     };
-    if (request->state().response_thread_id < 0) {
-      request->state().response_thread_id =
-          response_threadpool_.schedule(runnable);
-    } else {
-      response_threadpool_.schedule_with_tid(
-          runnable, request->state().response_thread_id);
-    }
+    response_threadpool_.schedule_with_tid(std::move(runnable), tid);
   }
 
   rpc_threadpool_.schedule(
@@ -162,9 +189,48 @@ void AsyncResponseProcessor::batch_process_completed_requests(
       });
 }
 
+void AsyncResponseProcessor::batch_decode_outputs(
+    const std::vector<Request*>& requests,
+    const Tokenizer& tokenizer) {
+  // group the sequences by skip_special_tokens, the sequences that can't be
+  // decoded in one pass are decoded incrementally in generate_output().
+  for (const bool skip_special_tokens : {true, false}) {
+    std::vector<Sequence*> seqs;
+    std::vector<Slice<int32_t>> ids;
+    for (Request* request : requests) {
+      if (request->state().stream) {
+        continue;
+      }
+      for (auto& seq : request->sequences()) {
+        if (seq->skip_special_tokens() != skip_special_tokens) {
+          continue;
+        }
+        auto seq_ids = seq->output_tokens_to_decode();
+        if (!seq_ids.empty()) {
+          seqs.push_back(seq.get());
+          ids.push_back(seq_ids);
+        }
+      }
+    }
+    if (seqs.empty()) {
+      continue;
+    }
+
+    auto texts = tokenizer.decode_batch(ids, skip_special_tokens);
+    CHECK_EQ(texts.size(), seqs.size());
+    for (size_t i = 0; i < seqs.size(); ++i) {
+      seqs[i]->set_decoded_output_text(std::move(texts[i]));
+    }
+  }
+}
+
 void AsyncResponseProcessor::process_stream_request(
     std::shared_ptr<Request> request) {
   CHECK(request->state().stream) << "request is not a streaming request";
+  if (!should_flush_stream(request.get())) {
+    // the outputs are sent together with the following steps
+    return;
+  }
 
   std::vector<size_t> indexes;
   std::vector<size_t> num_tokens;
@@ -223,12 +289,12 @@ void AsyncResponseProcessor::process_stream_request(
       if (callback != nullptr) {
         if (!callback(req_output)) {
           // cancel the request if on_stream returns false
-          request->set_cancel();
+          cancel_request(request.get());
         }
       } else {
         if (!request->state().output_func(req_output)) {
           // cancel the request if on_stream returns false
-          request->set_cancel();
+          cancel_request(request.get());
         }
       }
     };
@@ -251,13 +317,24 @@ void AsyncResponseProcessor::process_stream_requests(
     return;
   }
 
-  size_t requests_size = requests.size();
+  std::vector<std::shared_ptr<Request>> flush_requests;
+  flush_requests.reserve(requests.size());
+  for (const auto& request : requests) {
+    CHECK(request->state().stream) << "request is not a streaming request";
+    if (should_flush_stream(request.get())) {
+      flush_requests.push_back(request);
+    }
+  }
+  if (flush_requests.empty()) {
+    return;
+  }
+
+  size_t requests_size = flush_requests.size();
   auto counter = new BlockingCounter(requests_size);
   std::vector<RequestOutput> request_outputs;
   request_outputs.resize(requests_size);
   for (int i = 0; i < requests_size; ++i) {
-    auto& request = requests[i];
-    CHECK(request->state().stream) << "request is not a streaming request";
+    auto& request = flush_requests[i];
 
     std::vector<size_t> indexes;
     std::vector<size_t> num_tokens;
@@ -315,8 +392,9 @@ void AsyncResponseProcessor::process_stream_requests(
   }
 
   rpc_threadpool_.schedule(
-      [counter = std::unique_ptr<BlockingCounter>(counter),
-       requests = std::move(requests),
+      [this,
+       counter = std::unique_ptr<BlockingCounter>(counter),
+       requests = std::move(flush_requests),
        request_outputs = std::move(request_outputs)]() mutable {
         auto& resp_callback = requests[0]->state().outputs_func;
         counter->wait();
@@ -325,12 +403,48 @@ void AsyncResponseProcessor::process_stream_requests(
         for (size_t i = 0; i < requests.size(); ++i) {
           if (!status_set[i]) {
             // cancel the request if on_stream returns false
-            requests[i]->set_cancel();
+            cancel_request(requests[i].get());
           }
         }
       });
 }
 
+bool AsyncResponseProcessor::should_flush_stream(Request* request) const {
+  if (FLAGS_stream_flush_interval_ms <= 0) {
+    return true;
+  }
+
+  auto& state = request->state();
+  const absl::Time now = absl::Now();
+  // the first token is always sent immediately
+  bool flush = state.last_stream_flush_time == absl::InfinitePast() ||
+               now - state.last_stream_flush_time >=
+                   absl::Milliseconds(FLAGS_stream_flush_interval_ms);
+  for (const auto& seq : request->sequences()) {
+    if (flush) {
+      break;
+    }
+    if (seq->is_closed()) {
+      continue;
+    }
+    flush = seq->finished() ||
+            (FLAGS_stream_flush_max_tokens > 0 &&
+             seq->num_unsent_tokens() >=
+                 static_cast<size_t>(FLAGS_stream_flush_max_tokens));
+  }
+  if (flush) {
+    state.last_stream_flush_time = now;
+  }
+  return flush;
+}
+
+void AsyncResponseProcessor::cancel_request(Request* request) {
+  request->set_cancel();
+  if (scheduler_notifier_ != nullptr) {
+    scheduler_notifier_->notify();
+  }
+}
+
 // for batch generate, wait all response done.
 void AsyncResponseProcessor::wait_completion() {
   while (!response_threadpool_.empty()) {
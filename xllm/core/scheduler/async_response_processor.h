@@ -8,6 +8,7 @@
 namespace xllm {
 
 class BlockManager;
+class EventNotifier;
 class Request;
 class Sequence;
 class Tokenizer;
@@ -16,7 +17,8 @@ class AsyncResponseProcessor final {
   AsyncResponseProcessor(const Tokenizer* tokenizer,
                          const std::optional<InstanceRole>& role,
                          bool enable_schedule_overlap,
-                         bool enable_decode_response_to_service);
+                         bool enable_decode_response_to_service,
+                         EventNotifier* scheduler_notifier = nullptr);
   virtual ~AsyncResponseProcessor() = default;
 
   void process_completed_request(std::shared_ptr<Request> request);
@@ -42,6 +44,14 @@ class AsyncResponseProcessor final {
   Tokenizer* get_tls_tokenizer();
   void batch_process_completed_requests(
       std::vector<std::shared_ptr<Request>>& requests);
+  // decode the outputs of the finished sequences with decode_batch()
+  void batch_decode_outputs(const std::vector<Request*>& requests,
+                            const Tokenizer& tokenizer);
+  // cancel the request and wake up the scheduler to release its blocks
+  void cancel_request(Request* request);
+  // whether the streaming outputs of the request should be sent in this step,
+  // see FLAGS_stream_flush_interval_ms.
+  bool should_flush_stream(Request* request) const;
 
  private:
   // the threadpool to handle responses
@@ -74,6 +84,9 @@ class AsyncResponseProcessor final {
   //   |                         |
   //   ---------------------------
   bool enable_decode_response_to_service_ = false;
+
+  // notifier to wake up the scheduler when a request is cancelled, not owned
+  EventNotifier* scheduler_notifier_ = nullptr;
 };
 
 }  // namespace xllm
@@ -201,19 +201,7 @@ void ChunkedPrefillScheduler::handle_running_queue_requests(
     // memory exhausted, preempt lowest priority request and retry.
     // preemptable_requests_ only contain decoding requests.
     if (running_queue_.size() > 1) {
-      std::shared_ptr<Request> request_to_preempt = running_queue_.back();
-
-      if (request_to_preempt.get() != request.get()) {
-        ++num_preempted_requests;
-        block_manager_->deallocate(request_to_preempt.get());
-        running_queue_.pop_back();
-        // add preemptable request to waiting priority queue
-        request_to_preempt->set_preempted();
-        waiting_priority_queue_.push(request_to_preempt);
-      } else {
-        LOG(FATAL) << "Unexpected error: preempting the candidate itself.";
-      }
-
+      preempt_request_for(request, num_preempted_requests);
       continue;
     }
 
@@ -287,8 +275,11 @@ void ChunkedPrefillScheduler::handle_prefill_requests(
       if (!allocate_blocks_for(prefill_sequence.get(),
                                num_tokens,
                                &current_step_handle_tokens)) {
-        // release shared blocks
-        block_manager_->deallocate(prefill_sequence.get());
+        // release shared blocks, a swapped out sequence keeps its host
+        // blocks to be swapped in later
+        if (prefill_sequence->kv_state().num_host_blocks() == 0) {
+          block_manager_->deallocate(prefill_sequence.get());
+        }
         can_schedule = false;
         blocks_exhausted = true;
         break;
@@ -447,6 +438,7 @@ std::vector<Batch> ChunkedPrefillScheduler::prepare_batch() {
     // push the request front to the priority deque
     running_queue_.push_front(request);
   }
+  sort_running_queue();
 
   // clear previous batch
   running_requests_.clear();
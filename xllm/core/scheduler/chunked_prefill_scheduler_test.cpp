@@ -3,6 +3,7 @@
 #include <absl/time/clock.h>
 #include <gtest/gtest.h>
 
+#include "common/global_flags.h"
 #include "runtime/engine.h"
 #include "util/utils.h"
 
@@ -30,10 +31,13 @@ class FakeTokenizer : public Tokenizer {
 
 class FakeEngine : public Engine {
  public:
-  FakeEngine(int32_t num_blocks, int32_t block_size) {
+  FakeEngine(int32_t num_blocks,
+             int32_t block_size,
+             int32_t num_host_blocks = 0) {
     BlockManager::Options opt;
     opt.num_blocks_ = num_blocks;
     opt.block_size_ = block_size;
+    opt.num_host_blocks_ = num_host_blocks;
     opt.enable_prefix_cache_ = false;  // we dont consider prefix cache here
     fake_tokenizer_ = std::make_unique<FakeTokenizer>();
     fake_block_manager_ = std::make_unique<BlockManagerPool>(opt, 1);
@@ -347,4 +351,132 @@ TEST(ChunkedPrefillSchedulerTest, PreemptSchedule) {
   EXPECT_TRUE(batch[0].size() == 1);
 }
 
+// TEST-5:
+// test preempt by priority
+TEST(ChunkedPrefillSchedulerTest, PreemptLowPriorityRequest) {
+  // set max free blocks: 9, support 9*32=288 tokens
+  int block_num = 9;
+  int block_size = 32;
+  int max_tokens_per_chunk_for_prefill = 1024;
+  ContinuousScheduler::Options opt = create_scheduler_options(
+      10000, 256, 0, max_tokens_per_chunk_for_prefill, 1);
+  auto engine = std::make_unique<FakeEngine>(block_num, block_size);
+  auto scheduler = std::make_unique<ChunkedPrefillScheduler>(engine.get(), opt);
+  EXPECT_TRUE(scheduler != nullptr);
+
+  // request-1 arrives first but has lower priority than request-2
+  auto requests = generate_request({127, 127}, {10, 10}, 30000);
+  requests[0]->state().priority = RequestPriority::LOW;
+  requests[1]->state().priority = RequestPriority::HIGH;
+  for (auto req : requests) {
+    scheduler->add_request(req);
+  }
+  auto batch = scheduler->prepare_batch_test();
+  EXPECT_TRUE(batch.size() == 1);
+  EXPECT_TRUE(batch[0].size() == 2);
+  update_requests(requests);
+
+  batch = scheduler->prepare_batch_test();
+  EXPECT_TRUE(batch.size() == 1);
+  EXPECT_TRUE(batch[0].size() == 2);
+  update_requests(requests);
+
+  // no enough blocks for both requests, the low priority one is preempted.
+  batch = scheduler->prepare_batch_test();
+  EXPECT_TRUE(batch.size() == 1);
+  EXPECT_TRUE(batch[0].size() == 1);
+  EXPECT_TRUE(requests[0]->preempted());
+  EXPECT_FALSE(requests[1]->preempted());
+}
+
+// TEST-6:
+// test preempt by tpot slack within the same priority
+TEST(ChunkedPrefillSchedulerTest, PreemptRequestWithMostSlack) {
+  // set max free blocks: 9, support 9*32=288 tokens
+  int block_num = 9;
+  int block_size = 32;
+  int max_tokens_per_chunk_for_prefill = 1024;
+  ContinuousScheduler::Options opt = create_scheduler_options(
+      10000, 256, 0, max_tokens_per_chunk_for_prefill, 1);
+  auto engine = std::make_unique<FakeEngine>(block_num, block_size);
+  auto scheduler = std::make_unique<ChunkedPrefillScheduler>(engine.get(), opt);
+  EXPECT_TRUE(scheduler != nullptr);
+
+  // each request takes 3 blocks until it generates the 2nd token.
+  // request-3 has a tpot slo, the others have infinite slack.
+  auto requests = generate_request({95, 95, 95}, {10, 10, 10}, 30000);
+  requests[2]->state().tpot_slo_ms = 50;
+  for (auto req : requests) {
+    scheduler->add_request(req);
+  }
+  auto batch = scheduler->prepare_batch_test();
+  EXPECT_TRUE(batch.size() == 1);
+  EXPECT_TRUE(batch[0].size() == 3);
+  update_requests(requests);
+
+  batch = scheduler->prepare_batch_test();
+  EXPECT_TRUE(batch.size() == 1);
+  EXPECT_TRUE(batch[0].size() == 3);
+  update_requests(requests);
+
+  // request-2 is preempted instead of request-3 at the back of the queue.
+  batch = scheduler->prepare_batch_test();
+  EXPECT_FALSE(requests[0]->preempted());
+  EXPECT_TRUE(requests[1]->preempted());
+  EXPECT_FALSE(requests[2]->preempted());
+}
+
+// TEST-7:
+// test a swapped out request keeps its host blocks when it can be swapped in
+// but the blocks for its new tokens can not be allocated
+TEST(ChunkedPrefillSchedulerTest, SwapInKeepsHostBlocksWhenGrowthFails) {
+  FLAGS_enable_swap_preemption = true;
+  // set max free blocks: 9, one of them is held by the test
+  int block_num = 10;
+  int block_size = 32;
+  int max_tokens_per_chunk_for_prefill = 1024;
+  ContinuousScheduler::Options opt = create_scheduler_options(
+      10000, 256, 0, max_tokens_per_chunk_for_prefill, 1);
+  auto engine = std::make_unique<FakeEngine>(block_num, block_size, 8);
+  auto scheduler = std::make_unique<ChunkedPrefillScheduler>(engine.get(), opt);
+  EXPECT_TRUE(scheduler != nullptr);
+
+  BlockManagerPool* block_manager_pool = engine->block_manager_pool();
+  int32_t dp_rank = 0;
+  std::vector<Block> held_blocks =
+      block_manager_pool->allocate(block_size, dp_rank);
+  ASSERT_EQ(held_blocks.size(), 1);
+
+  auto requests = generate_request({127, 127}, {10, 10}, 30000);
+  for (auto req : requests) {
+    scheduler->add_request(req);
+  }
+  auto batch = scheduler->prepare_batch_test();
+  EXPECT_TRUE(batch[0].size() == 2);
+  update_requests(requests);
+
+  batch = scheduler->prepare_batch_test();
+  EXPECT_TRUE(batch[0].size() == 2);
+  update_requests(requests);
+
+  // request-2 is swapped out to make room for the 5th block of request-1
+  batch = scheduler->prepare_batch_test();
+  EXPECT_TRUE(batch[0].size() == 1);
+  EXPECT_TRUE(requests[1]->preempted());
+  Sequence* swapped_sequence = requests[1]->sequences()[0].get();
+  EXPECT_EQ(swapped_sequence->kv_state().num_host_blocks(), 4);
+  update_requests({requests[0]});
+
+  // 4 free blocks are enough to swap in request-2, but not for its new token
+  held_blocks.clear();
+  EXPECT_EQ(util::max(block_manager_pool->num_free_blocks()), 4);
+  batch = scheduler->prepare_batch_test();
+  EXPECT_TRUE(batch[0].size() == 1);
+  EXPECT_EQ(swapped_sequence->kv_state().num_host_blocks(), 4);
+  EXPECT_EQ(swapped_sequence->kv_state().num_kv_blocks(), 0);
+  EXPECT_EQ(util::max(block_manager_pool->num_free_blocks()), 4);
+
+  FLAGS_enable_swap_preemption = false;
+}
+
 }  // namespace xllm
@@ -5,10 +5,12 @@
 #include <folly/MPMCQueue.h>
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <memory>
 
+#include "common/global_flags.h"
 #include "common/metrics.h"
 #include "framework/batch/batch_factory.h"
 #include "framework/request/request.h"
@@ -34,7 +36,8 @@ ContinuousScheduler::ContinuousScheduler(Engine* engine, const Options& options)
       engine_->tokenizer(),
       options_.instance_role(),
       options_.enable_schedule_overlap(),
-      options_.enable_decode_response_to_service());
+      options_.enable_decode_response_to_service(),
+      &notifier_);
 
   if (options_.enable_service_routing()) {
     XServiceClient::get_instance()->set_scheduler(this);
@@ -48,6 +51,7 @@ bool ContinuousScheduler::add_request(std::shared_ptr<Request>& request) {
   CHECK(!request->sequences().empty());
 
   if (request_queue_.write(request)) {
+    notifier_.notify();
     return true;
   }
 
@@ -110,7 +114,10 @@ void ContinuousScheduler::handle_prefill_requests(
       }
 
       if (!block_manager_->allocate(prefill_sequence.get())) {
-        block_manager_->deallocate(prefill_sequence.get());
+        // a swapped out sequence keeps its host blocks to be swapped in later
+        if (prefill_sequence->kv_state().num_host_blocks() == 0) {
+          block_manager_->deallocate(prefill_sequence.get());
+        }
         can_schedule = false;
         break;
       }
@@ -260,19 +267,7 @@ void ContinuousScheduler::handle_decode_requests(
 
     // memory exhausted, try to preempt lowest priority request
     if (running_queue_.size() > 1) {
-      std::shared_ptr<Request> request_to_preempt = running_queue_.back();
-
-      if (request_to_preempt.get() != request.get()) {
-        ++num_preempted_requests;
-        block_manager_->deallocate(request_to_preempt.get());
-        running_queue_.pop_back();
-        // add preemptable request to waiting priority queue
-        request_to_preempt->set_preempted();
-        waiting_priority_queue_.push(request_to_preempt);
-      } else {
-        LOG(FATAL) << "Unexpected error: preempting the candidate itself.";
-      }
-
+      preempt_request_for(request, num_preempted_requests);
       continue;
     }
 
@@ -289,6 +284,62 @@ void ContinuousScheduler::handle_decode_requests(
   }
 }
 
+void ContinuousScheduler::release_preempted_request(Request* request) {
+  if (FLAGS_enable_swap_preemption) {
+    block_manager_->swap_out(request);
+  } else {
+    block_manager_->deallocate(request);
+  }
+}
+
+void ContinuousScheduler::sort_running_queue() {
+  std::stable_sort(running_queue_.begin(),
+                   running_queue_.end(),
+                   [](const std::shared_ptr<Request>& a,
+                      const std::shared_ptr<Request>& b) {
+                     return a->priority() < b->priority();
+                   });
+}
+
+void ContinuousScheduler::preempt_request_for(
+    const std::shared_ptr<Request>& candidate,
+    size_t& num_preempted_requests) {
+  CHECK(running_queue_.size() > 1);
+  CHECK(running_queue_.front().get() == candidate.get());
+
+  // iterate from the back, so that the latest request is preempted among the
+  // requests with the same priority and slack.
+  auto victim = running_queue_.end();
+  absl::Time victim_deadline;
+  for (auto it = running_queue_.end() - 1; it != running_queue_.begin();
+       --it) {
+    const absl::Time deadline = (*it)->tpot_deadline();
+    if (victim == running_queue_.end() ||
+        (*it)->priority() > (*victim)->priority() ||
+        ((*it)->priority() == (*victim)->priority() &&
+         deadline > victim_deadline)) {
+      victim = it;
+      victim_deadline = deadline;
+    }
+  }
+
+  std::shared_ptr<Request> request_to_preempt = *victim;
+  if (request_to_preempt->priority() < candidate->priority()) {
+    // don't preempt a request with higher priority than the candidate
+    request_to_preempt = candidate;
+    victim = running_queue_.begin();
+  }
+  CHECK(request_to_preempt.get() != candidate.get() ||
+        victim == running_queue_.begin());
+
+  ++num_preempted_requests;
+  release_preempted_request(request_to_preempt.get());
+  running_queue_.erase(victim);
+  // add preemptable request to waiting priority queue
+  request_to_preempt->set_preempted();
+  waiting_priority_queue_.push(request_to_preempt);
+}
+
 // NOTE: refactor ChunkedPrefillScheduler and ContinuousScheduler later.
 void ContinuousScheduler::handle_abnormal_request(
     const std::vector<Sequence*>& candidate_sequences,
@@ -457,6 +508,7 @@ std::vector<Batch> ContinuousScheduler::prepare_batch() {
       running_queue_.push_front(*it);
     }
   }
+  sort_running_queue();
 
   // clear previous batch
   last_step_prefill_ = false;
@@ -510,6 +562,8 @@ std::vector<Batch> ContinuousScheduler::schedule_request(
   const auto deadline = absl::Now() + timeout;
   std::vector<Batch> batch;
   while (true) {
+    // the notifications sent before prepare_batch() are handled by it
+    notifier_.reset();
     batch = prepare_batch();
     bool all_empty =
         std::all_of(batch.begin(), batch.end(), [](const Batch& one_batch) {
@@ -519,19 +573,18 @@ std::vector<Batch> ContinuousScheduler::schedule_request(
       return batch;
     }
 
-    if (!waiting_priority_queue_.empty() || !running_queue_.empty()) {
-      continue;
-    }
-
-    const auto now = absl::Now();
-    if (now > deadline) {
+    // nothing can be scheduled, wait for new requests to arrive, requests to
+    // be cancelled or blocks to be released.
+    if (!notifier_.wait_until(deadline)) {
       break;
     }
-    // wait for new requests to arrive
-    constexpr uint64_t kStepSleepTimeMs = 10;
-    const auto time_to_sleep =
-        std::min(absl::Milliseconds(kStepSleepTimeMs), deadline - now);
-    absl::SleepFor(time_to_sleep);
+    // give the requests arriving in a burst a chance to join the same batch
+    if (FLAGS_schedule_coalescing_window_us > 0 &&
+        waiting_priority_queue_.empty() && running_queue_.empty()) {
+      const auto window =
+          absl::Microseconds(FLAGS_schedule_coalescing_window_us);
+      absl::SleepFor(std::min(window, deadline - absl::Now()));
+    }
   }
   // return an empty batch
   return batch;
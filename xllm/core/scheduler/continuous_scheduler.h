@@ -8,6 +8,7 @@
 #include <queue>
 
 #include "async_response_processor.h"
+#include "fair_request_queue.h"
 #include "common/macros.h"
 #include "common/types.h"
 #include "framework/batch/batch.h"
@@ -16,17 +17,11 @@
 #include "framework/request/sequence.h"
 #include "runtime/xservice_client.h"
 #include "scheduler.h"
+#include "util/event_notifier.h"
 
 namespace xllm {
 class Engine;
 
-struct RequestComparator {
-  bool operator()(std::shared_ptr<Request> a,
-                  std::shared_ptr<Request> b) const {
-    return a->created_time() > b->created_time();
-  }
-};
-
 class ContinuousScheduler : public Scheduler {
  public:
   struct Options {
@@ -83,6 +78,10 @@ class ContinuousScheduler : public Scheduler {
 
   void generate() override;
 
+  // wake up the scheduler waiting for new requests, e.g. after cache blocks
+  // are released outside of the scheduler thread.
+  void wakeup() { notifier_.notify(); }
+
   // inc/dec pending requests
   void incr_pending_requests(size_t count) override {
     pending_requests_.fetch_add(count, std::memory_order_relaxed);
@@ -117,6 +116,10 @@ class ContinuousScheduler : public Scheduler {
   // the schedule owns the requests and manages their lifetimes.
   folly::MPMCQueue<std::shared_ptr<Request>> request_queue_;
 
+  // wakes up the idle scheduler when a request arrives or is cancelled, or
+  // cache blocks are released by other threads.
+  EventNotifier notifier_;
+
   // a batch of requests in running state, sorted by priority from high to low.
   // This may include decoding requests and prefill requests in chunked prefill
   // scheudler.
@@ -139,15 +142,12 @@ class ContinuousScheduler : public Scheduler {
   // the number of requests that are waiting to be scheduled
   std::atomic<size_t> pending_requests_{0};
 
+  // keep all new requests, generally speaking, they do not have any kv cache.
   // Requests with HIGH priority are processed first, followed by MEDIUM
   // priority requests, and finally LOW priority requests. Within each priority
-  // level, requests are handled on First-Come-First-Served (FCFS) basis.
-  using RequestPriorityQueue =
-      std::priority_queue<std::shared_ptr<Request>,
-                          std::vector<std::shared_ptr<Request>>,
-                          RequestComparator>;
-  // keep all new requests, generally speaking, they do not have any kv cache.
-  RequestPriorityQueue waiting_priority_queue_;
+  // level, tenants share the prefill budget fairly, and the requests of a
+  // tenant are ordered by the deadline of the first token.
+  FairRequestQueue waiting_priority_queue_;
 
   // keep all running request from high priority to low.
   // NOTE: Maybe not all requests are scheduled in one step,
@@ -169,6 +169,22 @@ class ContinuousScheduler : public Scheduler {
       bool block_exhausted);
   void handle_running_requests(std::shared_ptr<Request> request);
 
+  // order running_queue_ by priority class, keeping the order of the requests
+  // in the same class, so that higher classes are scheduled first and lower
+  // classes are at the back where the preemption victims are picked.
+  void sort_running_queue();
+
+  // release the kv cache of a preempted request, it is swapped out to host
+  // memory instead of being recomputed if swap preemption is enabled.
+  void release_preempted_request(Request* request);
+
+  // preempt a request in running_queue_ to release blocks for the candidate
+  // at the front of the queue. the victim is chosen from the lowest priority
+  // class, preferring the request with the most tpot slack. the candidate
+  // itself is preempted if all other requests have a higher priority.
+  void preempt_request_for(const std::shared_ptr<Request>& candidate,
+                           size_t& num_preempted_requests);
+
   // build a batch of requests from the priority queue
   virtual std::vector<Batch> prepare_batch();
 
@@ -227,7 +227,10 @@ std::vector<Batch> DisaggPrefillScheduler::prepare_batch() {
     }
 
     if (!block_manager_->allocate(prefill_sequence.get())) {
-      block_manager_->deallocate(prefill_sequence.get());
+      // a swapped out sequence keeps its host blocks to be swapped in later
+      if (prefill_sequence->kv_state().num_host_blocks() == 0) {
+        block_manager_->deallocate(prefill_sequence.get());
+      }
       break;
     }
 
@@ -377,6 +380,10 @@ void DisaggPrefillScheduler::dispatch_requests() {
       req->set_is_embeddings(requests[i]->state().sampling_param.is_embeddings);
       req->set_echo(requests[i]->state().echo);
       req->set_skip_special_tokens(requests[i]->state().skip_special_tokens);
+      req->set_priority(static_cast<int32_t>(requests[i]->state().priority));
+      req->set_ttft_slo_ms(requests[i]->state().ttft_slo_ms.value_or(0));
+      req->set_tpot_slo_ms(requests[i]->state().tpot_slo_ms.value_or(0));
+      req->set_tenant(requests[i]->state().tenant);
       //*reqs.mutable_reqs()->Add() = req;
     }
     std::vector<std::string> device_ips;
@@ -422,6 +429,7 @@ void DisaggPrefillScheduler::dispatch_requests() {
 
         // push to request_queue_, and will be executed by engine.
         request_queue_.write(requests[i]);
+        notifier_.notify();
       }
     }
   }
@@ -539,6 +547,7 @@ void DisaggPrefillScheduler::prefill_send_first_generation() {
         // according to whether all the blocks have been transmitted or not.
         block_manager_->deallocate(request.get());
       }
+      notifier_.notify();
     }
   });
 }
@@ -571,6 +580,7 @@ bool DisaggPrefillScheduler::prefill_recv_generation(
           // cancel the request if on_stream returns false
           if (!output.finished) {
             request->set_cancel();
+            notifier_.notify();
           }
           {
             std::lock_guard<std::mutex> lock(remote_requests_map_mutex_);
@@ -657,6 +667,7 @@ bool DisaggDecodeScheduler::decode_schedule(
     LOG(ERROR) << "Failed to create rpc channel for prefill instance: "
                << prefill_instance_name;
     block_manager_->deallocate(request.get());
+    scheduler_->wakeup();
     return false;
   }
 
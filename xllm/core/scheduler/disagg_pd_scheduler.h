@@ -99,11 +99,7 @@ class DisaggPrefillScheduler final : public DisaggPDScheduler {
   std::unordered_map<std::string, std::shared_ptr<Request>>
       remote_requests_map_;
   std::mutex remote_requests_map_mutex_;
-  using RequestPriorityQueue =
-      std::priority_queue<std::shared_ptr<Request>,
-                          std::vector<std::shared_ptr<Request>>,
-                          RequestComparator>;
-  RequestPriorityQueue waiting_priority_queue_;
+  FairRequestQueue waiting_priority_queue_;
 
   // use threadpool to handle prefill-completed request
   ThreadPool prefill_threadpool_;
@@ -0,0 +1,106 @@
+#include "fair_request_queue.h"
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "common/global_flags.h"
+
+namespace xllm {
+
+FairRequestQueue::FairRequestQueue() {
+  for (absl::string_view entry :
+       absl::StrSplit(FLAGS_tenant_weights, ',', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> kv = absl::StrSplit(entry, ':');
+    int64_t weight = 0;
+    CHECK(kv.size() == 2 && absl::SimpleAtoi(kv[1], &weight) && weight > 0)
+        << "Invalid tenant weight: " << entry;
+    weights_[std::string(kv[0])] = weight;
+  }
+}
+
+void FairRequestQueue::push(const std::shared_ptr<Request>& request) {
+  const std::string tenant =
+      FLAGS_enable_tenant_fair_share ? request->tenant() : std::string();
+  auto [it, inserted] = tenants_.try_emplace(tenant);
+  if (inserted) {
+    it->second.weight = tenant_weight(tenant);
+    order_.push_back(tenant);
+  }
+  it->second.requests.push(request);
+  ++size_;
+  // the new request may outrank the selected one
+  selected_ = nullptr;
+}
+
+const std::shared_ptr<Request>& FairRequestQueue::top() {
+  CHECK(!empty());
+  select_tenant();
+  return selected_->requests.top();
+}
+
+void FairRequestQueue::pop() {
+  CHECK(!empty());
+  select_tenant();
+  auto& requests = selected_->requests;
+  if (tenants_.size() > 1) {
+    selected_->deficit -= request_cost(requests.top());
+  }
+  requests.pop();
+  --size_;
+  if (requests.empty()) {
+    // idle tenants do not accumulate deficit
+    tenants_.erase(order_.front());
+    order_.pop_front();
+  }
+  selected_ = nullptr;
+}
+
+void FairRequestQueue::select_tenant() {
+  if (selected_ != nullptr) {
+    return;
+  }
+  if (tenants_.size() == 1) {
+    selected_ = &tenants_.begin()->second;
+    return;
+  }
+
+  RequestPriority best_priority = RequestPriority::LOW;
+  for (const auto& [tenant, queue] : tenants_) {
+    best_priority = std::min(best_priority, queue.requests.top()->priority());
+  }
+
+  const int64_t quantum = std::max(FLAGS_tenant_quantum_tokens, 1);
+  while (true) {
+    auto& queue = tenants_.at(order_.front());
+    const auto& request = queue.requests.top();
+    if (request->priority() == best_priority) {
+      if (queue.deficit >= request_cost(request)) {
+        selected_ = &queue;
+        return;
+      }
+      queue.deficit += quantum * queue.weight;
+    }
+    order_.push_back(order_.front());
+    order_.pop_front();
+  }
+}
+
+int64_t FairRequestQueue::tenant_weight(const std::string& tenant) const {
+  auto it = weights_.find(tenant);
+  return it == weights_.end() ? 1 : it->second;
+}
+
+int64_t FairRequestQueue::request_cost(const std::shared_ptr<Request>& request) {
+  int64_t num_tokens = 0;
+  for (const auto& sequence : request->sequences()) {
+    if (!sequence->finished()) {
+      num_tokens += sequence->num_tokens();
+    }
+  }
+  return num_tokens;
+}
+
+}  // namespace xllm
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/global_flags.h"
+#include "framework/request/request.h"
+
+namespace xllm {
+
+// order the requests by priority class, then by the deadline of the first
+// token, then by arrival time. a request without ttft slo is due
+// FLAGS_default_ttft_slo_ms after its arrival, so a stream of requests with a
+// long slo can not starve the others, and these requests are handled in FCFS
+// order.
+struct RequestComparator {
+  bool operator()(const std::shared_ptr<Request>& a,
+                  const std::shared_ptr<Request>& b) const {
+    if (a->priority() != b->priority()) {
+      return a->priority() > b->priority();
+    }
+    const absl::Duration default_ttft_slo =
+        absl::Milliseconds(FLAGS_default_ttft_slo_ms);
+    const absl::Time a_deadline = a->ttft_deadline(default_ttft_slo);
+    const absl::Time b_deadline = b->ttft_deadline(default_ttft_slo);
+    if (a_deadline != b_deadline) {
+      return a_deadline > b_deadline;
+    }
+    return a->created_time() > b->created_time();
+  }
+};
+
+// A priority queue of waiting requests that shares the prefill budget fairly
+// across tenants with deficit round robin (DRR). Each tenant keeps its own
+// priority queue ordered by RequestComparator. Only tenants whose best request
+// is in the highest waiting priority class compete, and a tenant is served
+// while its deficit covers the prefill tokens of its best request, so a
+// tenant sending long prompts can not starve the others. The kv blocks taken
+// by a request are proportional to its tokens, so they are bounded as well.
+//
+// Without FLAGS_enable_tenant_fair_share all requests belong to the same
+// tenant, and the queue behaves like a plain priority queue.
+class FairRequestQueue final {
+ public:
+  FairRequestQueue();
+
+  void push(const std::shared_ptr<Request>& request);
+
+  // the next request to schedule, the queue must not be empty.
+  const std::shared_ptr<Request>& top();
+
+  // remove the request returned by top() and charge it to its tenant.
+  void pop();
+
+  bool empty() const { return size_ == 0; }
+
+  size_t size() const { return size_; }
+
+ private:
+  using RequestPriorityQueue =
+      std::priority_queue<std::shared_ptr<Request>,
+                          std::vector<std::shared_ptr<Request>>,
+                          RequestComparator>;
+
+  struct TenantQueue {
+    RequestPriorityQueue requests;
+
+    // prefill tokens the tenant can still take in the current round
+    int64_t deficit = 0;
+
+    int64_t weight = 1;
+  };
+
+  // pick the tenant to serve next with deficit round robin.
+  void select_tenant();
+
+  int64_t tenant_weight(const std::string& tenant) const;
+
+  static int64_t request_cost(const std::shared_ptr<Request>& request);
+
+  std::unordered_map<std::string, TenantQueue> tenants_;
+
+  // the round robin order of the tenants with waiting requests, the selected
+  // tenant is always at the front.
+  std::deque<std::string> order_;
+
+  // the tenant top() returns the request of, nullptr if not selected yet.
+  TenantQueue* selected_ = nullptr;
+
+  std::unordered_map<std::string, int64_t> weights_;
+
+  size_t size_ = 0;
+};
+
+}  // namespace xllm
@@ -0,0 +1,125 @@
+#include "fair_request_queue.h"
+
+#include <gtest/gtest.h>
+
+#include "common/global_flags.h"
+
+namespace xllm {
+
+namespace {
+std::shared_ptr<Request> generate_request(const std::string& tenant,
+                                          int32_t prompt_len,
+                                          uint32_t ttft_slo_ms,
+                                          RequestPriority priority) {
+  std::vector<int32_t> prompt_token_ids(prompt_len, 1);
+  RequestSamplingParam sampling_param;
+  StoppingChecker stopping_checker;
+  stopping_checker.set_max_generated_tokens(10);
+  stopping_checker.set_max_context_len(prompt_len + 30000);
+  stopping_checker.set_ignore_eos(true);
+  RequestState req_state("x",
+                         prompt_token_ids,
+                         sampling_param,
+                         stopping_checker,
+                         prompt_len + 30000,
+                         1,
+                         1,
+                         false,
+                         false,
+                         false,
+                         false,
+                         false,
+                         nullptr,
+                         nullptr);
+  req_state.tenant = tenant;
+  req_state.priority = priority;
+  // the slo keeps the arrival order within a tenant, 0 for no slo
+  if (ttft_slo_ms > 0) {
+    req_state.ttft_slo_ms = ttft_slo_ms;
+  }
+  return std::make_shared<Request>("1", "1", "1", std::move(req_state), "1");
+}
+
+std::vector<std::string> pop_tenants(FairRequestQueue& queue) {
+  std::vector<std::string> tenants;
+  while (!queue.empty()) {
+    tenants.emplace_back(queue.top()->tenant());
+    queue.pop();
+  }
+  return tenants;
+}
+}  // namespace
+
+TEST(FairRequestQueueTest, Disabled) {
+  FLAGS_enable_tenant_fair_share = false;
+  FairRequestQueue queue;
+  queue.push(generate_request("a", 32000, 1, RequestPriority::MEDIUM));
+  queue.push(generate_request("a", 32000, 2, RequestPriority::MEDIUM));
+  queue.push(generate_request("b", 100, 3, RequestPriority::MEDIUM));
+  queue.push(generate_request("b", 100, 4, RequestPriority::HIGH));
+  EXPECT_EQ(queue.size(), 4);
+  // ordered by priority, then by arrival
+  EXPECT_EQ(pop_tenants(queue),
+            std::vector<std::string>({"b", "a", "a", "b"}));
+}
+
+TEST(FairRequestQueueTest, NoSloHasDefaultDeadline) {
+  FLAGS_enable_tenant_fair_share = false;
+  FLAGS_default_ttft_slo_ms = 10000;
+  FairRequestQueue queue;
+  queue.push(generate_request("a", 100, 0, RequestPriority::MEDIUM));
+  queue.push(generate_request("b", 100, 0, RequestPriority::MEDIUM));
+  queue.push(generate_request("c", 100, 60000, RequestPriority::MEDIUM));
+  queue.push(generate_request("d", 100, 100, RequestPriority::MEDIUM));
+  // a tighter slo goes first, a looser one does not starve the requests
+  // without slo, which keep their arrival order
+  EXPECT_EQ(pop_tenants(queue),
+            std::vector<std::string>({"d", "a", "b", "c"}));
+}
+
+TEST(FairRequestQueueTest, LongPromptsDoNotStarveOthers) {
+  FLAGS_enable_tenant_fair_share = true;
+  FLAGS_tenant_quantum_tokens = 1000;
+  FairRequestQueue queue;
+  for (uint32_t i = 0; i < 3; ++i) {
+    queue.push(generate_request("a", 4000, i + 1, RequestPriority::MEDIUM));
+  }
+  for (uint32_t i = 0; i < 6; ++i) {
+    queue.push(generate_request("b", 1000, i + 10, RequestPriority::MEDIUM));
+  }
+  // the long prompt of tenant a waits for enough credit while the short
+  // prompts of tenant b keep being served
+  EXPECT_EQ(
+      pop_tenants(queue),
+      std::vector<std::string>({"b", "b", "b", "a", "b", "b", "b", "a", "a"}));
+  FLAGS_enable_tenant_fair_share = false;
+}
+
+TEST(FairRequestQueueTest, Weights) {
+  FLAGS_enable_tenant_fair_share = true;
+  FLAGS_tenant_quantum_tokens = 1000;
+  FLAGS_tenant_weights = "a:2";
+  FairRequestQueue queue;
+  for (uint32_t i = 0; i < 4; ++i) {
+    queue.push(generate_request("a", 1000, i + 1, RequestPriority::MEDIUM));
+    queue.push(generate_request("b", 1000, i + 10, RequestPriority::MEDIUM));
+  }
+  EXPECT_EQ(
+      pop_tenants(queue),
+      std::vector<std::string>({"a", "a", "b", "a", "a", "b", "b", "b"}));
+  FLAGS_tenant_weights = "";
+  FLAGS_enable_tenant_fair_share = false;
+}
+
+TEST(FairRequestQueueTest, PriorityBeforeFairness) {
+  FLAGS_enable_tenant_fair_share = true;
+  FLAGS_tenant_quantum_tokens = 1000;
+  FairRequestQueue queue;
+  queue.push(generate_request("a", 1000, 1, RequestPriority::LOW));
+  queue.push(generate_request("b", 1000, 2, RequestPriority::HIGH));
+  queue.push(generate_request("b", 1000, 3, RequestPriority::HIGH));
+  EXPECT_EQ(pop_tenants(queue), std::vector<std::string>({"b", "b", "a"}));
+  FLAGS_enable_tenant_fair_share = false;
+}
+
+}  // namespace xllm
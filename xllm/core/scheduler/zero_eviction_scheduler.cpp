@@ -491,6 +491,7 @@ std::vector<Batch> ZeroEvictionScheduler::prepare_batch() {
       running_queue_.push_front(*it);
     }
   }
+  sort_running_queue();
 
   // clear previous batch
   last_step_prefill_ = false;
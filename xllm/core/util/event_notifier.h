@@ -0,0 +1,45 @@
+#pragma once
+
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
+namespace xllm {
+
+// a level-triggered notifier to wake up a waiting thread. notifications are
+// coalesced: any number of notify() calls before wait_until() wakes up the
+// waiter once, and a notification sent while nobody is waiting is not lost.
+class EventNotifier final {
+ public:
+  EventNotifier() = default;
+  ~EventNotifier() = default;
+
+  // wake up the waiter, can be called from any thread
+  void notify() {
+    absl::MutexLock lock(&mutex_);
+    notified_ = true;
+  }
+
+  // wait until notified or the deadline is reached, returns true if notified.
+  // the notification is consumed by the call.
+  bool wait_until(absl::Time deadline) {
+    absl::MutexLock lock(&mutex_);
+    auto notified = [this]() { return notified_; };
+    const bool ret =
+        mutex_.AwaitWithDeadline(absl::Condition(&notified), deadline);
+    notified_ = false;
+    return ret;
+  }
+
+  // consume the pending notification without waiting
+  void reset() {
+    absl::MutexLock lock(&mutex_);
+    notified_ = false;
+  }
+
+ private:
+  absl::Mutex mutex_;
+
+  bool notified_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace xllm
@@ -0,0 +1,40 @@
+#include "event_notifier.h"
+
+#include <absl/time/clock.h>
+#include <gtest/gtest.h>
+
+#include "util/threadpool.h"
+
+namespace xllm {
+
+TEST(EventNotifierTest, Timeout) {
+  EventNotifier notifier;
+  const auto start = absl::Now();
+  EXPECT_FALSE(notifier.wait_until(start + absl::Milliseconds(10)));
+  EXPECT_GE(absl::Now() - start, absl::Milliseconds(10));
+}
+
+TEST(EventNotifierTest, NotifyBeforeWait) {
+  EventNotifier notifier;
+  notifier.notify();
+  notifier.notify();
+  // the notifications are coalesced into one wakeup
+  EXPECT_TRUE(notifier.wait_until(absl::Now() + absl::Seconds(10)));
+  EXPECT_FALSE(notifier.wait_until(absl::Now()));
+
+  notifier.notify();
+  notifier.reset();
+  EXPECT_FALSE(notifier.wait_until(absl::Now()));
+}
+
+TEST(EventNotifierTest, NotifyFromOtherThread) {
+  ThreadPool threadpool(1);
+  EventNotifier notifier;
+  threadpool.schedule([&notifier]() {
+    absl::SleepFor(absl::Milliseconds(10));
+    notifier.notify();
+  });
+  EXPECT_TRUE(notifier.wait_until(absl::Now() + absl::Seconds(10)));
+}
+
+}  // namespace xllm
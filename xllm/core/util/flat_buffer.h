@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace xllm {
+
+// Writes trivially copyable values into a flat buffer in host byte order,
+// for messages between processes of the same binary. A vector is written as
+// its size followed by its elements, so it is read back with one memcpy.
+class FlatWriter final {
+ public:
+  // appends to the buffer
+  explicit FlatWriter(std::string* buffer) : buffer_(buffer) {}
+
+  template <typename T>
+  void write(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    buffer_->append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  void write_array(const T* values, size_t size) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    write<uint64_t>(size);
+    if (size > 0) {
+      buffer_->append(reinterpret_cast<const char*>(values), size * sizeof(T));
+    }
+  }
+
+  template <typename T>
+  void write_vector(const std::vector<T>& values) {
+    write_array(values.data(), values.size());
+  }
+
+  void write_string(const std::string& value) {
+    write_array(value.data(), value.size());
+  }
+
+ private:
+  std::string* buffer_;
+};
+
+// Reads the values written by FlatWriter in the same order. The data does not
+// need to be aligned. A read past the end fails and so do all the following
+// reads, so a message can be checked once at the end.
+class FlatReader final {
+ public:
+  FlatReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  bool read(T* value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (!consume(sizeof(T))) {
+      return false;
+    }
+    std::memcpy(value, data_ + pos_ - sizeof(T), sizeof(T));
+    return true;
+  }
+
+  template <typename T>
+  bool read_vector(std::vector<T>* values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    uint64_t size = 0;
+    if (!read(&size) || size > (size_ - pos_) / sizeof(T) ||
+        !consume(size * sizeof(T))) {
+      failed_ = true;
+      return false;
+    }
+    const size_t num_bytes = size * sizeof(T);
+    values->resize(size);
+    std::memcpy(values->data(), data_ + pos_ - num_bytes, num_bytes);
+    return true;
+  }
+
+  bool read_string(std::string* value) {
+    uint64_t size = 0;
+    if (!read(&size) || size > size_ - pos_ || !consume(size)) {
+      failed_ = true;
+      return false;
+    }
+    value->assign(data_ + pos_ - size, size);
+    return true;
+  }
+
+  // whether all the reads succeeded and the whole data is read
+  bool done() const { return !failed_ && pos_ == size_; }
+
+  bool failed() const { return failed_; }
+
+  size_t remaining() const { return size_ - pos_; }
+
+ private:
+  bool consume(size_t size) {
+    if (failed_ || size > size_ - pos_) {
+      failed_ = true;
+      return false;
+    }
+    pos_ += size;
+    return true;
+  }
+
+  const char* data_;
+
+  size_t size_;
+
+  size_t pos_ = 0;
+
+  bool failed_ = false;
+};
+
+}  // namespace xllm
@@ -0,0 +1,68 @@
+#include "flat_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xllm {
+
+TEST(FlatBufferTest, RoundTrip) {
+  std::string buffer;
+  FlatWriter writer(&buffer);
+  writer.write<int32_t>(-7);
+  writer.write<uint8_t>(1);
+  writer.write_vector(std::vector<int64_t>{1, 2, 3});
+  writer.write_vector(std::vector<float>{});
+  writer.write_string("xllm");
+  writer.write<double>(0.5);
+
+  // read from an odd offset, the values are not aligned
+  std::string unaligned = " " + buffer;
+  FlatReader reader(unaligned.data() + 1, buffer.size());
+  int32_t i = 0;
+  EXPECT_TRUE(reader.read(&i));
+  EXPECT_EQ(i, -7);
+  uint8_t b = 0;
+  EXPECT_TRUE(reader.read(&b));
+  EXPECT_EQ(b, 1);
+  std::vector<int64_t> ids;
+  EXPECT_TRUE(reader.read_vector(&ids));
+  EXPECT_EQ(ids, std::vector<int64_t>({1, 2, 3}));
+  std::vector<float> empty = {1.0f};
+  EXPECT_TRUE(reader.read_vector(&empty));
+  EXPECT_TRUE(empty.empty());
+  std::string str;
+  EXPECT_TRUE(reader.read_string(&str));
+  EXPECT_EQ(str, "xllm");
+  EXPECT_FALSE(reader.done());
+  double d = 0;
+  EXPECT_TRUE(reader.read(&d));
+  EXPECT_EQ(d, 0.5);
+  EXPECT_TRUE(reader.done());
+}
+
+TEST(FlatBufferTest, ReadPastTheEnd) {
+  std::string buffer;
+  FlatWriter writer(&buffer);
+  writer.write_vector(std::vector<int32_t>{1, 2, 3});
+
+  // a truncated vector fails and so do the following reads
+  FlatReader truncated(buffer.data(), buffer.size() - 1);
+  std::vector<int32_t> values;
+  EXPECT_FALSE(truncated.read_vector(&values));
+  uint8_t b = 0;
+  EXPECT_FALSE(truncated.read(&b));
+  EXPECT_TRUE(truncated.failed());
+  EXPECT_FALSE(truncated.done());
+
+  // a corrupted size larger than the data
+  std::string corrupted = buffer;
+  corrupted[7] = 0x7f;
+  FlatReader reader(corrupted.data(), corrupted.size());
+  EXPECT_FALSE(reader.read_vector(&values));
+  EXPECT_TRUE(reader.failed());
+}
+
+}  // namespace xllm
@@ -3,6 +3,7 @@
 #include <openssl/sha.h>
 
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -53,21 +54,24 @@ struct Sha256Key {
   }
 };
 
+// the keys are already uniformly distributed hash values, so the leading
+// bytes are used as the hash directly instead of hashing the whole key again
 template <class FixedStringKey>
 struct FixedStringKeyHash {
   size_t operator()(const FixedStringKey& key) const {
-    return std::hash<std::string_view>()(std::string_view(
-        reinterpret_cast<const char*>(key.data), sizeof(key.data)));
+    static_assert(sizeof(key.data) >= sizeof(size_t));
+    size_t hash;
+    memcpy(&hash, key.data, sizeof(hash));
+    return hash;
   }
 };
 
+// compare all bytes, the hash values may contain zero bytes
 template <class FixedStringKey>
 struct FixedStringKeyEqual {
   bool operator()(const FixedStringKey& left,
                   const FixedStringKey& right) const {
-    return strncmp(reinterpret_cast<const char*>(left.data),
-                   reinterpret_cast<const char*>(right.data),
-                   sizeof(left.data)) == 0;
+    return memcmp(left.data, right.data, sizeof(left.data)) == 0;
   }
 };
 
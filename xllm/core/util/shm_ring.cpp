@@ -0,0 +1,159 @@
+#include "shm_ring.h"
+
+#include <absl/time/clock.h>
+#include <glog/logging.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <new>
+#include <thread>
+
+namespace xllm {
+
+namespace {
+// marks the unused tail of the ring, the next message starts at offset 0
+constexpr uint64_t kWrapMarker = ~uint64_t{0};
+
+// a step usually finishes within a few microseconds to milliseconds, spin a
+// little before going to sleep.
+constexpr int32_t kNumSpins = 256;
+
+void futex_wait(std::atomic<uint32_t>* addr,
+                uint32_t expected,
+                absl::Duration timeout) {
+  timespec ts = absl::ToTimespec(timeout);
+  // not FUTEX_PRIVATE_FLAG since the word can be shared between processes
+  syscall(SYS_futex,
+          reinterpret_cast<uint32_t*>(addr),
+          FUTEX_WAIT,
+          expected,
+          &ts,
+          nullptr,
+          0);
+}
+
+void futex_wake(std::atomic<uint32_t>* addr) {
+  syscall(SYS_futex,
+          reinterpret_cast<uint32_t*>(addr),
+          FUTEX_WAKE,
+          INT_MAX,
+          nullptr,
+          nullptr,
+          0);
+}
+}  // namespace
+
+size_t ShmRing::memory_size(size_t capacity) {
+  return sizeof(Control) + capacity;
+}
+
+ShmRing::ShmRing(void* memory, size_t capacity, bool initialize)
+    : capacity_(capacity) {
+  CHECK_EQ(capacity % 8, 0) << "capacity must be a multiple of 8";
+  CHECK_GE(capacity, 4 * kHeaderSize);
+  CHECK_EQ(reinterpret_cast<uintptr_t>(memory) % alignof(Control), 0);
+  control_ = initialize ? new (memory) Control()
+                        : static_cast<Control*>(memory);
+  data_ = static_cast<char*>(memory) + sizeof(Control);
+}
+
+template <typename Pred>
+bool ShmRing::wait(std::atomic<uint32_t>& seq,
+                   Pred ready,
+                   absl::Duration timeout) {
+  for (int32_t i = 0; i < kNumSpins; ++i) {
+    if (ready()) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  const absl::Time deadline = absl::Now() + timeout;
+  while (true) {
+    // load the sequence before checking, a notification after the check
+    // changes the sequence and the futex returns immediately.
+    const uint32_t expected = seq.load();
+    if (ready()) {
+      return true;
+    }
+    const absl::Duration remaining = deadline - absl::Now();
+    if (remaining <= absl::ZeroDuration()) {
+      return false;
+    }
+    control_->num_waiters.fetch_add(1);
+    // wake up at least every second in case of an infinite timeout
+    futex_wait(&seq, expected, std::min(remaining, absl::Seconds(1)));
+    control_->num_waiters.fetch_sub(1);
+  }
+}
+
+void ShmRing::notify(std::atomic<uint32_t>& seq) {
+  seq.fetch_add(1);
+  if (control_->num_waiters.load() > 0) {
+    futex_wake(&seq);
+  }
+}
+
+char* ShmRing::begin_write(size_t size, absl::Duration timeout) {
+  CHECK_LE(size, max_message_size());
+  const uint64_t write_pos =
+      control_->write_pos.load(std::memory_order_relaxed);
+  const size_t offset = write_pos % capacity_;
+  const size_t record = record_size(size);
+  // a message never wraps around, skip the tail if it does not fit
+  write_wrap_ = capacity_ - offset < record;
+  const size_t needed = write_wrap_ ? capacity_ - offset + record : record;
+  auto has_space = [&]() {
+    const uint64_t read_pos =
+        control_->read_pos.load(std::memory_order_acquire);
+    return capacity_ - (write_pos - read_pos) >= needed;
+  };
+  if (!wait(control_->read_seq, has_space, timeout)) {
+    return nullptr;
+  }
+  write_record_pos_ = write_wrap_ ? write_pos + capacity_ - offset : write_pos;
+  write_record_size_ = size;
+  return data_ + write_record_pos_ % capacity_ + kHeaderSize;
+}
+
+void ShmRing::end_write() {
+  if (write_wrap_) {
+    const uint64_t write_pos =
+        control_->write_pos.load(std::memory_order_relaxed);
+    *reinterpret_cast<uint64_t*>(data_ + write_pos % capacity_) = kWrapMarker;
+  }
+  *reinterpret_cast<uint64_t*>(data_ + write_record_pos_ % capacity_) =
+      write_record_size_;
+  control_->write_pos.store(write_record_pos_ + record_size(write_record_size_),
+                            std::memory_order_release);
+  notify(control_->write_seq);
+}
+
+const char* ShmRing::begin_read(size_t* size, absl::Duration timeout) {
+  uint64_t read_pos = control_->read_pos.load(std::memory_order_relaxed);
+  auto has_message = [&]() {
+    return control_->write_pos.load(std::memory_order_acquire) > read_pos;
+  };
+  if (!wait(control_->write_seq, has_message, timeout)) {
+    return nullptr;
+  }
+  uint64_t header = *reinterpret_cast<uint64_t*>(data_ + read_pos % capacity_);
+  if (header == kWrapMarker) {
+    read_pos += capacity_ - read_pos % capacity_;
+    header = *reinterpret_cast<uint64_t*>(data_ + read_pos % capacity_);
+  }
+  read_record_pos_ = read_pos;
+  read_record_size_ = header;
+  *size = header;
+  return data_ + read_pos % capacity_ + kHeaderSize;
+}
+
+void ShmRing::end_read() {
+  control_->read_pos.store(read_record_pos_ + record_size(read_record_size_),
+                           std::memory_order_release);
+  notify(control_->read_seq);
+}
+
+}  // namespace xllm
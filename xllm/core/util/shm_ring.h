@@ -0,0 +1,82 @@
+#pragma once
+
+#include <absl/time/time.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace xllm {
+
+// A single producer single consumer ring buffer of variable sized messages
+// over a memory region, which can be shared between processes. Messages are
+// written and read in place, and a waiting side sleeps on a futex instead of
+// polling.
+class ShmRing final {
+ public:
+  // the size of the memory region needed for a ring with the capacity in
+  // bytes. the capacity must be a multiple of 8.
+  static size_t memory_size(size_t capacity);
+
+  // the memory must be 64 bytes aligned and zero filled when initialize is
+  // true. only one side initializes the ring, before the other side uses it.
+  ShmRing(void* memory, size_t capacity, bool initialize);
+
+  // the largest message that fits into the ring
+  size_t max_message_size() const {
+    return (capacity_ / 2 & ~size_t{7}) - kHeaderSize;
+  }
+
+  // reserve size bytes for the next message, waits until there is enough
+  // space. returns nullptr on timeout.
+  char* begin_write(size_t size, absl::Duration timeout);
+
+  // publish the message reserved by begin_write().
+  void end_write();
+
+  // the next message, waits until a message is available. returns nullptr on
+  // timeout.
+  const char* begin_read(size_t* size, absl::Duration timeout);
+
+  // release the message returned by begin_read().
+  void end_read();
+
+ private:
+  // each message is prefixed with its size and padded to 8 bytes
+  static constexpr size_t kHeaderSize = sizeof(uint64_t);
+
+  struct Control {
+    // total bytes written and released, the offset in the ring is the
+    // position modulo the capacity.
+    alignas(64) std::atomic<uint64_t> write_pos;
+    alignas(64) std::atomic<uint64_t> read_pos;
+    // futex words bumped whenever a message is written or released
+    alignas(64) std::atomic<uint32_t> write_seq;
+    alignas(64) std::atomic<uint32_t> read_seq;
+    std::atomic<uint32_t> num_waiters;
+  };
+
+  template <typename Pred>
+  bool wait(std::atomic<uint32_t>& seq, Pred ready, absl::Duration timeout);
+
+  void notify(std::atomic<uint32_t>& seq);
+
+  static size_t record_size(size_t size) {
+    return kHeaderSize + ((size + 7) & ~size_t{7});
+  }
+
+  Control* control_ = nullptr;
+
+  char* data_ = nullptr;
+
+  size_t capacity_ = 0;
+
+  // the record reserved by begin_write() or returned by begin_read()
+  uint64_t write_record_pos_ = 0;
+  size_t write_record_size_ = 0;
+  bool write_wrap_ = false;
+  uint64_t read_record_pos_ = 0;
+  size_t read_record_size_ = 0;
+};
+
+}  // namespace xllm
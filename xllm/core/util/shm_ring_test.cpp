@@ -0,0 +1,89 @@
+#include "shm_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace xllm {
+
+namespace {
+struct AlignedDeleter {
+  void operator()(void* ptr) const { std::free(ptr); }
+};
+
+std::unique_ptr<void, AlignedDeleter> allocate_ring_memory(size_t capacity) {
+  const size_t size = ShmRing::memory_size(capacity);
+  void* ptr = std::aligned_alloc(64, (size + 63) / 64 * 64);
+  std::memset(ptr, 0, size);
+  return std::unique_ptr<void, AlignedDeleter>(ptr);
+}
+
+void write_string(ShmRing& ring, const std::string& str) {
+  char* data = ring.begin_write(str.size(), absl::Seconds(10));
+  ASSERT_NE(data, nullptr);
+  std::memcpy(data, str.data(), str.size());
+  ring.end_write();
+}
+
+std::string read_string(ShmRing& ring) {
+  size_t size = 0;
+  const char* data = ring.begin_read(&size, absl::Seconds(10));
+  EXPECT_NE(data, nullptr);
+  std::string str(data, size);
+  ring.end_read();
+  return str;
+}
+}  // namespace
+
+TEST(ShmRingTest, WriteAndRead) {
+  auto memory = allocate_ring_memory(128);
+  ShmRing writer(memory.get(), 128, /*initialize=*/true);
+  ShmRing reader(memory.get(), 128, /*initialize=*/false);
+
+  size_t size = 0;
+  EXPECT_EQ(reader.begin_read(&size, absl::Milliseconds(1)), nullptr);
+
+  // wraps around the end of the ring several times
+  for (int32_t i = 0; i < 20; ++i) {
+    const std::string str(i % 7 * 8 + 1, 'a' + i);
+    write_string(writer, str);
+    EXPECT_EQ(read_string(reader), str);
+  }
+  write_string(writer, "");
+  EXPECT_EQ(read_string(reader), "");
+}
+
+TEST(ShmRingTest, FullRing) {
+  auto memory = allocate_ring_memory(64);
+  ShmRing ring(memory.get(), 64, /*initialize=*/true);
+  EXPECT_EQ(ring.max_message_size(), 24);
+  write_string(ring, std::string(24, 'a'));
+  write_string(ring, std::string(24, 'b'));
+  EXPECT_EQ(ring.begin_write(1, absl::Milliseconds(1)), nullptr);
+  EXPECT_EQ(read_string(ring), std::string(24, 'a'));
+  write_string(ring, "c");
+  EXPECT_EQ(read_string(ring), std::string(24, 'b'));
+  EXPECT_EQ(read_string(ring), "c");
+}
+
+TEST(ShmRingTest, ProducerConsumer) {
+  auto memory = allocate_ring_memory(256);
+  ShmRing writer(memory.get(), 256, /*initialize=*/true);
+  ShmRing reader(memory.get(), 256, /*initialize=*/false);
+  constexpr int32_t kNumMessages = 10000;
+
+  std::thread producer([&writer]() {
+    for (int32_t i = 0; i < kNumMessages; ++i) {
+      write_string(writer, std::to_string(i));
+    }
+  });
+  for (int32_t i = 0; i < kNumMessages; ++i) {
+    EXPECT_EQ(read_string(reader), std::to_string(i));
+  }
+  producer.join();
+}
+
+}  // namespace xllm
@@ -4,6 +4,7 @@
 #include <glog/logging.h>
 #include <torch/torch.h>
 
+#include <algorithm>
 #include <fstream>
 #include <vector>
 
@@ -35,6 +36,42 @@ inline torch::Tensor create_2d_tensor(const std::vector<std::vector<T> >& vec,
   return tensor;
 };
 
+// Creates a 2d tensor of the rows padded to the longest one, a null row is all
+// padding. The rows are copied into the tensor directly, without padding them
+// in a 2d vector first.
+template <typename T>
+inline torch::Tensor create_padded_2d_tensor(
+    const std::vector<const std::vector<T>*>& rows,
+    T pad_value,
+    torch::ScalarType dtype) {
+  if (rows.empty()) {
+    return {};
+  }
+  size_t n_cols = 0;
+  for (const auto* row : rows) {
+    if (row != nullptr) {
+      n_cols = std::max(n_cols, row->size());
+    }
+  }
+  // create tensor on cpu pinned memory here
+  auto tensor =
+      torch::full({static_cast<int64_t>(rows.size()),
+                   static_cast<int64_t>(n_cols)},
+                  pad_value,
+                  torch::TensorOptions()
+                      .dtype(dtype)
+                      .device(torch::kCPU)
+                      .pinned_memory(true));
+  CHECK_EQ(tensor.element_size(), sizeof(T));
+  T* data = static_cast<T*>(tensor.data_ptr());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    if (rows[i] != nullptr) {
+      std::copy(rows[i]->begin(), rows[i]->end(), data + i * n_cols);
+    }
+  }
+  return tensor;
+}
+
 inline torch::Tensor safe_to(const torch::Tensor& t,
                              const torch::TensorOptions& options,
                              bool non_blocking = false) {
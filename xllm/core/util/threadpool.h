@@ -31,6 +31,9 @@ class ThreadPool final {
 
   void schedule_with_tid(Runnable runnable, size_t tid);
 
+  // the number of threads
+  size_t size() const { return queues_.size(); }
+
   bool empty() {
     return std::all_of(queues_.begin(), queues_.end(), [](auto& queue) {
       return queue.empty();
@@ -1,7 +1,7 @@
 #include "base_format_detector.h"
 
+#include <algorithm>
 #include <iostream>
-#include <regex>
 #include <sstream>
 
 namespace xllm {
@@ -12,7 +12,9 @@ BaseFormatDetector::BaseFormatDetector()
       current_tool_name_sent_(false),
       bot_token_(""),
       eot_token_(""),
-      tool_call_separator_(", ") {}
+      tool_call_separator_(", "),
+      in_tool_call_(false),
+      current_tool_skipped_(false) {}
 
 std::unordered_map<std::string, int> BaseFormatDetector::get_tool_indices(
     const std::vector<JsonTool>& tools) {
@@ -95,5 +97,188 @@ std::vector<ToolCallItem> BaseFormatDetector::parse_base_json(
   return results;
 }
 
+bool BaseFormatDetector::consume_normal_text(StreamingParseResult* result) {
+  const size_t bot_pos = buffer_.find(bot_token_);
+  const size_t text_end =
+      bot_pos != std::string::npos
+          ? bot_pos
+          : buffer_.size() - partial_token_length(buffer_, bot_token_);
+  std::string_view text(buffer_.data(), text_end);
+  // the separators between the tool calls are not normal text
+  if (!has_streamed_tool_calls() ||
+      text.find_first_not_of(" \t\n\r") != std::string_view::npos) {
+    result->normal_text.append(text);
+  }
+  if (bot_pos == std::string::npos) {
+    buffer_.erase(0, text_end);
+    return false;
+  }
+  buffer_.erase(0, bot_pos + bot_token_.size());
+  return true;
+}
+
+bool BaseFormatDetector::start_streaming_tool_call(
+    const std::string& name,
+    const std::vector<JsonTool>& tools,
+    StreamingParseResult* result) {
+  if (tool_indices_.empty()) {
+    tool_indices_ = get_tool_indices(tools);
+  }
+  if (tool_indices_.find(name) == tool_indices_.end()) {
+    LOG(ERROR) << "Model attempted to call undefined function: " << name;
+    return false;
+  }
+
+  ++current_tool_id_;
+  current_tool_name_sent_ = true;
+  streamed_args_for_tool_.emplace_back();
+  prev_tool_call_arr_.push_back({{"name", name}, {"arguments", ""}});
+  result->calls.emplace_back(current_tool_id_, name, "");
+  return true;
+}
+
+void BaseFormatDetector::stream_tool_arguments(std::string_view arguments,
+                                               StreamingParseResult* result) {
+  const size_t begin = arguments.find_first_not_of(" \t\n\r");
+  if (begin == std::string_view::npos) {
+    return;
+  }
+  arguments.remove_prefix(begin);
+
+  auto& streamed_args = streamed_args_for_tool_[current_tool_id_];
+  if (arguments.size() <= streamed_args.size()) {
+    return;
+  }
+  std::string diff(arguments.substr(streamed_args.size()));
+  streamed_args.append(diff);
+  result->calls.emplace_back(current_tool_id_, std::nullopt, std::move(diff));
+}
+
+void BaseFormatDetector::finish_streaming_tool_call() {
+  if (current_tool_name_sent_) {
+    prev_tool_call_arr_[current_tool_id_]["arguments"] =
+        streamed_args_for_tool_[current_tool_id_];
+  }
+  current_tool_name_sent_ = false;
+  current_tool_skipped_ = false;
+}
+
+StreamingParseResult BaseFormatDetector::finish_streaming() {
+  StreamingParseResult result;
+  if (!in_tool_call_) {
+    // the separators between the tool calls are not normal text
+    if (!has_streamed_tool_calls() ||
+        buffer_.find_first_not_of(" \t\n\r") != std::string::npos) {
+      result.normal_text = std::move(buffer_);
+    }
+  } else {
+    // the end token is missing, a tool call without a complete name is
+    // dropped
+    if (current_tool_name_sent_ &&
+        streamed_args_for_tool_[current_tool_id_].empty()) {
+      stream_tool_arguments("{}", &result);
+    }
+    finish_streaming_tool_call();
+  }
+  buffer_.clear();
+  in_tool_call_ = false;
+  return result;
+}
+
+size_t BaseFormatDetector::partial_token_length(std::string_view text,
+                                                std::string_view token) {
+  const size_t max_len = std::min(text.size(), token.size() - 1);
+  for (size_t len = max_len; len > 0; --len) {
+    if (text.substr(text.size() - len) == token.substr(0, len)) {
+      return len;
+    }
+  }
+  return 0;
+}
+
+size_t BaseFormatDetector::find_json_value_end(std::string_view text) {
+  size_t pos = text.find_first_not_of(" \t\n\r");
+  if (pos == std::string_view::npos) {
+    return std::string_view::npos;
+  }
+  const char first = text[pos];
+  if (first != '{' && first != '[' && first != '"') {
+    // numbers and literals end at the first delimiter
+    return text.find_first_of(" \t\n\r,]}", pos);
+  }
+
+  int32_t depth = 0;
+  bool in_string = false;
+  bool escaped = false;
+  for (; pos < text.size(); ++pos) {
+    const char c = text[pos];
+    if (in_string) {
+      if (escaped) {
+        escaped = false;
+      } else if (c == '\\') {
+        escaped = true;
+      } else if (c == '"') {
+        in_string = false;
+        if (depth == 0) {
+          return pos + 1;
+        }
+      }
+    } else if (c == '"') {
+      in_string = true;
+    } else if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      if (--depth == 0) {
+        return pos + 1;
+      }
+    }
+  }
+  return std::string_view::npos;
+}
+
+std::vector<BaseFormatDetector::JsonMember>
+BaseFormatDetector::scan_json_object(std::string_view text) {
+  std::vector<JsonMember> members;
+  const char* whitespace = " \t\n\r";
+  size_t pos = text.find_first_not_of(whitespace);
+  if (pos == std::string_view::npos || text[pos] != '{') {
+    return members;
+  }
+  ++pos;
+
+  while (true) {
+    pos = text.find_first_not_of(whitespace, pos);
+    if (pos == std::string_view::npos || text[pos] != '"') {
+      // the end of the object or an incomplete member
+      return members;
+    }
+    const size_t key_end = find_json_value_end(text.substr(pos));
+    if (key_end == std::string_view::npos) {
+      return members;
+    }
+    std::string key(text.substr(pos + 1, key_end - 2));
+    pos = text.find_first_not_of(whitespace, pos + key_end);
+    if (pos == std::string_view::npos || text[pos] != ':') {
+      return members;
+    }
+    pos = text.find_first_not_of(whitespace, pos + 1);
+    if (pos == std::string_view::npos) {
+      return members;
+    }
+
+    const size_t value_end = find_json_value_end(text.substr(pos));
+    if (value_end == std::string_view::npos) {
+      members.push_back({std::move(key), pos, std::string_view::npos});
+      return members;
+    }
+    members.push_back({std::move(key), pos, pos + value_end});
+    pos = text.find_first_not_of(whitespace, pos + value_end);
+    if (pos == std::string_view::npos || text[pos] != ',') {
+      return members;
+    }
+    ++pos;
+  }
+}
+
 }  // namespace function_call
 }  // namespace xllm
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -57,6 +58,53 @@ class BaseFormatDetector {
   // Tool indices cache
   std::unordered_map<std::string, int> tool_indices_;
 
+  // Whether the streaming parser is inside a tool call (or a tool calls
+  // section for the formats that wrap the calls into one).
+  bool in_tool_call_;
+
+  // Whether the current tool call is dropped because the function is not
+  // defined, its arguments are consumed without being streamed.
+  bool current_tool_skipped_;
+
+  // Moves the text in buffer_ before bot_token_ to the normal text, holding
+  // back a possibly incomplete bot_token_ at the end. Returns true if
+  // bot_token_ is found and consumed.
+  bool consume_normal_text(StreamingParseResult* result);
+
+  // Starts streaming a new tool call by sending its name. Returns false if
+  // the function is not defined.
+  bool start_streaming_tool_call(const std::string& name,
+                                 const std::vector<JsonTool>& tools,
+                                 StreamingParseResult* result);
+
+  // Sends the part of the arguments of the current tool call that has not
+  // been sent yet. arguments is the raw json received so far.
+  void stream_tool_arguments(std::string_view arguments,
+                             StreamingParseResult* result);
+
+  // Finishes the current tool call, the next one starts with a new name.
+  void finish_streaming_tool_call();
+
+  // Returns the length of the longest suffix of text that is a prefix of
+  // token, i.e. the part of text that may be the beginning of token.
+  static size_t partial_token_length(std::string_view text,
+                                     std::string_view token);
+
+  // Returns the end of the json value at the beginning of text, leading
+  // whitespaces are skipped. Returns npos if the value is incomplete.
+  static size_t find_json_value_end(std::string_view text);
+
+  struct JsonMember {
+    std::string key;
+    size_t value_begin;
+    // npos if the value is incomplete
+    size_t value_end;
+  };
+
+  // Scans the members of the possibly incomplete json object at the
+  // beginning of text. Stops at the first incomplete member.
+  static std::vector<JsonMember> scan_json_object(std::string_view text);
+
  public:
   std::unordered_map<std::string, int> get_tool_indices(
       const std::vector<JsonTool>& tools);
@@ -69,6 +117,24 @@ class BaseFormatDetector {
       const std::vector<JsonTool>& tools) = 0;
 
   virtual bool has_tool_call(const std::string& text) = 0;
+
+  // Parses the text generated since the last call. Returns the normal text
+  // that can be sent to the client and the tool call deltas: the name of a
+  // new call first with empty parameters, then its arguments in pieces. The
+  // tool_index of a delta is the index of the call in the response.
+  virtual StreamingParseResult parse_streaming_increment(
+      const std::string& new_text,
+      const std::vector<JsonTool>& tools) = 0;
+
+  // Flushes the streaming state at the end of the stream. The text held back
+  // as a possible start token is returned as normal text, and a tool call
+  // without its end token is closed with the arguments received so far.
+  StreamingParseResult finish_streaming();
+
+  // Whether any tool call has been sent in streaming mode.
+  bool has_streamed_tool_calls() const {
+    return !streamed_args_for_tool_.empty();
+  }
 };
 
 }  // namespace function_call
@@ -0,0 +1,207 @@
+#include "base_format_detector.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "deepseekv3_detector.h"
+#include "kimik2_detector.h"
+#include "qwen25_detector.h"
+#include "streaming_test_utils.h"
+
+namespace xllm {
+namespace function_call {
+
+// The tool call format of a detector. In call_begin, {name} and {index} stand
+// for the function name and the index of the call.
+struct ToolCallFormat {
+  std::string name;
+  std::function<std::unique_ptr<BaseFormatDetector>()> create_detector;
+  std::string calls_begin;
+  std::string calls_end;
+  std::string call_separator;
+  std::string call_begin;
+  // the text closing the arguments and the end token of a call
+  std::string call_args_end;
+  std::string call_end_token;
+};
+
+std::string replace_all(std::string text,
+                        const std::string& from,
+                        const std::string& to) {
+  for (size_t pos = text.find(from); pos != std::string::npos;
+       pos = text.find(from, pos + to.size())) {
+    text.replace(pos, from.size(), to);
+  }
+  return text;
+}
+
+// Formats a tool call without its end token
+std::string unterminated_tool_call(const ToolCallFormat& format,
+                                   size_t index,
+                                   const std::string& name,
+                                   const std::string& arguments) {
+  std::string call_begin = replace_all(format.call_begin, "{name}", name);
+  call_begin = replace_all(call_begin, "{index}", std::to_string(index));
+  return call_begin + arguments + format.call_args_end;
+}
+
+std::string tool_call(const ToolCallFormat& format,
+                      size_t index,
+                      const std::string& name,
+                      const std::string& arguments) {
+  return unterminated_tool_call(format, index, name, arguments) +
+         format.call_end_token;
+}
+
+std::vector<ToolCallFormat> tool_call_formats() {
+  return {
+      {"Qwen25",
+       [] { return std::make_unique<Qwen25Detector>(); },
+       "",
+       "",
+       "\n",
+       "<tool_call>\n{\"name\": \"{name}\", \"arguments\": ",
+       "}",
+       "\n</tool_call>"},
+      {"KimiK2",
+       [] { return std::make_unique<KimiK2Detector>(); },
+       "<|tool_calls_section_begin|>",
+       "<|tool_calls_section_end|>",
+       "",
+       "<|tool_call_begin|>functions.{name}:{index} "
+       "<|tool_call_argument_begin|>",
+       "",
+       "<|tool_call_end|>"},
+      {"DeepSeekV3",
+       [] { return std::make_unique<DeepSeekV3Detector>(); },
+       "<｜tool▁calls▁begin｜>",
+       "<｜tool▁calls▁end｜>",
+       "\n",
+       "<｜tool▁call▁begin｜>function<｜tool▁sep｜>{name}\n```json\n",
+       "\n```",
+       "<｜tool▁call▁end｜>"},
+  };
+}
+
+class BaseFormatDetectorTest : public ::testing::TestWithParam<ToolCallFormat> {
+ protected:
+  void SetUp() override {
+    nlohmann::json weather_params = {
+        {"type", "object"},
+        {"properties",
+         {{"location",
+           {{"type", "string"},
+            {"description", "The city and state, e.g. San Francisco, CA"}}}}},
+        {"required", {"location"}}};
+    JsonFunction weather_func("get_current_weather",
+                              "Get the current weather in a given location",
+                              weather_params);
+
+    nlohmann::json calculator_params = {
+        {"type", "object"},
+        {"properties",
+         {{"expression",
+           {{"type", "string"},
+            {"description", "Mathematical expression to evaluate"}}}}},
+        {"required", {"expression"}}};
+    JsonFunction calculator_func(
+        "calculate", "Calculate mathematical expressions", calculator_params);
+
+    tools_ = {JsonTool("function", weather_func),
+              JsonTool("function", calculator_func)};
+  }
+
+  std::vector<JsonTool> tools_;
+};
+
+// Test that text without tool calls is streamed as is, a possible start token
+// is held back until it is ruled out or the stream finishes
+TEST_P(BaseFormatDetectorTest, StreamingNormalText) {
+  auto detector = GetParam().create_detector();
+  std::string normal_text;
+  for (const std::string chunk : {"Hello <", "b>world</b>", " a<"}) {
+    auto result = detector->parse_streaming_increment(chunk, {});
+    EXPECT_TRUE(result.calls.empty());
+    normal_text += result.normal_text;
+  }
+  EXPECT_EQ(normal_text, "Hello <b>world</b> a");
+
+  auto result = detector->finish_streaming();
+  EXPECT_TRUE(result.calls.empty());
+  EXPECT_EQ(result.normal_text, "<");
+  EXPECT_FALSE(detector->has_streamed_tool_calls());
+}
+
+// Test that the held back text is flushed when the text is fed in chunks
+TEST_P(BaseFormatDetectorTest, StreamingFlushInChunks) {
+  const std::string text = "1 < 2 and 3 <";
+  for (size_t chunk_size : {1, 2, 1000}) {
+    auto detector = GetParam().create_detector();
+    auto streamed = stream_in_chunks(*detector, text, chunk_size, {});
+    EXPECT_EQ(streamed.normal_text, text);
+    EXPECT_TRUE(streamed.names.empty());
+  }
+}
+
+// Test parsing the tool calls in streaming mode, with the text split into
+// chunks of different sizes
+TEST_P(BaseFormatDetectorTest, StreamingToolCallParsing) {
+  const ToolCallFormat& format = GetParam();
+  std::string text =
+      "Let me check. " + format.calls_begin +
+      tool_call(
+          format, 0, "get_current_weather", "{\"location\": \"Beijing\"}") +
+      format.call_separator +
+      tool_call(format, 1, "calculate", "{\"expression\": \"2 + 3 * 4\"}") +
+      format.calls_end;
+
+  for (size_t chunk_size : {1, 3, 7, 1000}) {
+    auto detector = format.create_detector();
+    auto streamed = stream_in_chunks(*detector, text, chunk_size, tools_);
+    EXPECT_EQ(streamed.normal_text, "Let me check. ");
+    ASSERT_EQ(streamed.names.size(), 2);
+    EXPECT_EQ(streamed.names[0], "get_current_weather");
+    EXPECT_EQ(nlohmann::json::parse(streamed.arguments[0])["location"],
+              "Beijing");
+    EXPECT_EQ(streamed.names[1], "calculate");
+    EXPECT_EQ(nlohmann::json::parse(streamed.arguments[1])["expression"],
+              "2 + 3 * 4");
+    EXPECT_TRUE(detector->has_streamed_tool_calls());
+  }
+}
+
+// Test that a tool call without its end token is closed when the stream
+// finishes
+TEST_P(BaseFormatDetectorTest, StreamingUnterminatedToolCall) {
+  const ToolCallFormat& format = GetParam();
+  std::string text =
+      format.calls_begin +
+      unterminated_tool_call(
+          format, 0, "calculate", "{\"expression\": \"1 + 1\"}");
+
+  for (size_t chunk_size : {1, 1000}) {
+    auto detector = format.create_detector();
+    auto streamed = stream_in_chunks(*detector, text, chunk_size, tools_);
+    EXPECT_TRUE(streamed.normal_text.empty());
+    ASSERT_EQ(streamed.names.size(), 1);
+    EXPECT_EQ(streamed.names[0], "calculate");
+    EXPECT_EQ(nlohmann::json::parse(streamed.arguments[0])["expression"],
+              "1 + 1");
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Detectors,
+    BaseFormatDetectorTest,
+    ::testing::ValuesIn(tool_call_formats()),
+    [](const ::testing::TestParamInfo<ToolCallFormat>& info) {
+      return info.param.name;
+    });
+
+}  // namespace function_call
+}  // namespace xllm
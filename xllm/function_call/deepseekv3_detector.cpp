@@ -12,6 +12,9 @@ DeepSeekV3Detector::DeepSeekV3Detector() : BaseFormatDetector() {
   bot_token_ = "<｜tool▁calls▁begin｜>";
   eot_token_ = "<｜tool▁calls▁end｜>";
   tool_call_separator_ = "";
+  tool_call_begin_token_ = "<｜tool▁call▁begin｜>";
+  tool_call_end_token_ = "<｜tool▁call▁end｜>";
+  tool_sep_token_ = "<｜tool▁sep｜>";
 }
 
 bool DeepSeekV3Detector::has_tool_call(const std::string& text) {
@@ -37,8 +40,8 @@ DeepSeekV3Detector::find_tool_call_ranges(const std::string& text) const {
   std::vector<std::pair<size_t, size_t>> ranges;
   ranges.reserve(4);
 
-  const std::string call_begin = "<｜tool▁call▁begin｜>";
-  const std::string call_end = "<｜tool▁call▁end｜>";
+  const std::string& call_begin = tool_call_begin_token_;
+  const std::string& call_end = tool_call_end_token_;
 
   size_t search_pos = 0;
   const size_t call_begin_len = call_begin.length();
@@ -95,7 +98,7 @@ StreamingParseResult DeepSeekV3Detector::detect_and_parse(
 
     try {
       // Parse DeepSeek V3 format: <tool_sep>function_name\n```json\n{args}\n```
-      const std::string tool_sep = "<｜tool▁sep｜>";
+      const std::string& tool_sep = tool_sep_token_;
       size_t sep_pos = trimmed_content.find(tool_sep);
       if (sep_pos == std::string_view::npos) {
         LOG(ERROR) << "Failed to find tool separator in: "
@@ -171,5 +174,89 @@ StreamingParseResult DeepSeekV3Detector::detect_and_parse(
   return StreamingParseResult(std::move(normal_text), std::move(calls));
 }
 
+StreamingParseResult DeepSeekV3Detector::parse_streaming_increment(
+    const std::string& new_text,
+    const std::vector<JsonTool>& tools) {
+  buffer_.append(new_text);
+
+  StreamingParseResult result;
+  while (true) {
+    if (!in_tool_call_) {
+      if (!consume_normal_text(&result)) {
+        break;
+      }
+      in_tool_call_ = true;
+    }
+    if (!parse_streaming_tool_calls(tools, &result)) {
+      break;
+    }
+    in_tool_call_ = false;
+  }
+  return result;
+}
+
+bool DeepSeekV3Detector::parse_streaming_tool_calls(
+    const std::vector<JsonTool>& tools,
+    StreamingParseResult* result) {
+  // <｜tool▁call▁begin｜>function<｜tool▁sep｜>{name}\n```json\n{args}\n```
+  // <｜tool▁call▁end｜>, repeated until <｜tool▁calls▁end｜>
+  const std::string json_start = "```json\n";
+  while (true) {
+    if (!current_tool_name_sent_ && !current_tool_skipped_) {
+      const size_t call_pos = buffer_.find(tool_call_begin_token_);
+      const size_t eot_pos = buffer_.find(eot_token_);
+      if (eot_pos != std::string::npos &&
+          (call_pos == std::string::npos || eot_pos < call_pos)) {
+        buffer_.erase(0, eot_pos + eot_token_.size());
+        return true;
+      }
+      if (call_pos == std::string::npos) {
+        return false;
+      }
+      const size_t sep_pos = buffer_.find(tool_sep_token_, call_pos);
+      if (sep_pos == std::string::npos) {
+        return false;
+      }
+      const size_t name_start = sep_pos + tool_sep_token_.size();
+      const size_t name_end = buffer_.find('\n', name_start);
+      if (name_end == std::string::npos) {
+        return false;
+      }
+      const std::string name(trim_whitespace(
+          std::string_view(buffer_).substr(name_start, name_end - name_start)));
+      buffer_.erase(0, name_end + 1);
+      current_tool_skipped_ = !start_streaming_tool_call(name, tools, result);
+    }
+
+    size_t args_end = std::string::npos;
+    const size_t json_pos = buffer_.find(json_start);
+    if (json_pos != std::string::npos) {
+      std::string_view args = std::string_view(buffer_).substr(
+          json_pos + json_start.size());
+      const size_t value_end = find_json_value_end(args);
+      if (current_tool_name_sent_) {
+        stream_tool_arguments(args.substr(0, value_end), result);
+      }
+      if (value_end != std::string::npos) {
+        args_end = json_pos + json_start.size() + value_end;
+      }
+    }
+
+    // wait for the end of the call, a malformed call is dropped once it
+    // arrives
+    const size_t call_end_pos = buffer_.find(
+        tool_call_end_token_, args_end != std::string::npos ? args_end : 0);
+    if (call_end_pos == std::string::npos) {
+      return false;
+    }
+    if (current_tool_name_sent_ &&
+        streamed_args_for_tool_[current_tool_id_].empty()) {
+      stream_tool_arguments("{}", result);
+    }
+    finish_streaming_tool_call();
+    buffer_.erase(0, call_end_pos + tool_call_end_token_.size());
+  }
+}
+
 }  // namespace function_call
 }  // namespace xllm
\ No newline at end of file
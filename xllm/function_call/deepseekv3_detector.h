@@ -19,9 +19,20 @@ class DeepSeekV3Detector : public BaseFormatDetector {
       const std::string& text,
       const std::vector<JsonTool>& tools) override;
 
+  StreamingParseResult parse_streaming_increment(
+      const std::string& new_text,
+      const std::vector<JsonTool>& tools) override;
+
  private:
-  std::string func_call_regex_;
-  std::string func_detail_regex_;
+  // parses the tool calls section in buffer_, returns true once the end of
+  // the section is consumed.
+  bool parse_streaming_tool_calls(const std::vector<JsonTool>& tools,
+                                  StreamingParseResult* result);
+
+  std::string tool_call_begin_token_;
+  std::string tool_call_end_token_;
+  std::string tool_sep_token_;
+
   std::string_view trim_whitespace(std::string_view str) const;
   std::vector<std::pair<size_t, size_t>> find_tool_call_ranges(
       const std::string& text) const;
@@ -57,6 +57,15 @@ FunctionCallParser::parse_non_stream(const std::string& full_text) {
   }
 }
 
+StreamingParseResult FunctionCallParser::parse_streaming_increment(
+    const std::string& new_text) {
+  return detector_->parse_streaming_increment(new_text, tools_);
+}
+
+StreamingParseResult FunctionCallParser::finish_streaming() {
+  return detector_->finish_streaming();
+}
+
 std::unique_ptr<BaseFormatDetector> FunctionCallParser::create_detector(
     const std::string& tool_call_parser) {
   auto it = ToolCallParserEnum.find(tool_call_parser);
@@ -34,6 +34,14 @@ class FunctionCallParser {
   std::tuple<std::string, std::vector<ToolCallItem>> parse_non_stream(
       const std::string& full_text);
 
+  // parse the text generated since the last call in streaming mode, see
+  // BaseFormatDetector::parse_streaming_increment.
+  StreamingParseResult parse_streaming_increment(const std::string& new_text);
+
+  // flush the streaming state at the end of the stream, see
+  // BaseFormatDetector::finish_streaming.
+  StreamingParseResult finish_streaming();
+
   // StructuralTagResponseFormat get_structure_tag();
 
   // std::tuple<std::string, std::any> get_structure_constraint(const
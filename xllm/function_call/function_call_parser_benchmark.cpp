@@ -0,0 +1,157 @@
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "function_call_parser.h"
+
+using namespace xllm;
+using namespace xllm::function_call;
+
+namespace {
+
+const std::string kReasoning =
+    "The user wants the weather of several cities and a few conversions, "
+    "so I will call the tools one by one and summarize the results. ";
+
+std::vector<JsonTool> tools() {
+  nlohmann::json weather_params = {
+      {"type", "object"},
+      {"properties",
+       {{"location", {{"type", "string"}}},
+        {"unit", {{"type", "string"}, {"enum", {"celsius", "fahrenheit"}}}}}},
+      {"required", {"location"}}};
+  nlohmann::json calculator_params = {
+      {"type", "object"},
+      {"properties", {{"expression", {{"type", "string"}}}}},
+      {"required", {"expression"}}};
+  return {JsonTool("function",
+                   JsonFunction("get_current_weather",
+                                "Get the current weather in a given location",
+                                weather_params)),
+          JsonTool("function",
+                   JsonFunction("calculate",
+                                "Calculate mathematical expressions",
+                                calculator_params))};
+}
+
+std::string arguments(size_t i) {
+  if (i % 2 == 0) {
+    return "{\"location\": \"City " + std::to_string(i) +
+           ", CA\", \"unit\": \"celsius\"}";
+  }
+  return "{\"expression\": \"" + std::to_string(i) + " * 3.14159 + 42\"}";
+}
+
+std::string function_name(size_t i) {
+  return i % 2 == 0 ? "get_current_weather" : "calculate";
+}
+
+// a long preamble followed by num_calls tool calls in the given format
+std::string tool_call_output(const std::string& format, size_t num_calls) {
+  std::string text;
+  for (size_t i = 0; i < 16; ++i) {
+    text += kReasoning;
+  }
+  if (format == "qwen25") {
+    for (size_t i = 0; i < num_calls; ++i) {
+      text += "\n<tool_call>\n{\"name\": \"" + function_name(i) +
+              "\", \"arguments\": " + arguments(i) + "}\n</tool_call>";
+    }
+  } else if (format == "kimi_k2") {
+    text += "<|tool_calls_section_begin|>";
+    for (size_t i = 0; i < num_calls; ++i) {
+      text += "<|tool_call_begin|>functions." + function_name(i) + ":" +
+              std::to_string(i) + "<|tool_call_argument_begin|>" +
+              arguments(i) + "<|tool_call_end|>";
+    }
+    text += "<|tool_calls_section_end|>";
+  } else {
+    text += "<｜tool▁calls▁begin｜>";
+    for (size_t i = 0; i < num_calls; ++i) {
+      text += "<｜tool▁call▁begin｜>function<｜tool▁sep｜>" + function_name(i) +
+              "\n```json\n" + arguments(i) + "\n```<｜tool▁call▁end｜>";
+    }
+    text += "<｜tool▁calls▁end｜>";
+  }
+  return text;
+}
+
+void parse_non_stream(benchmark::State& state, const std::string& format) {
+  const auto json_tools = tools();
+  const std::string text = tool_call_output(format, state.range(0));
+  size_t num_calls = 0;
+  for (auto _ : state) {
+    FunctionCallParser parser(json_tools, format);
+    auto [normal_text, calls] = parser.parse_non_stream(text);
+    num_calls = calls.size();
+    benchmark::DoNotOptimize(calls.data());
+  }
+  CHECK_EQ(num_calls, state.range(0));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          text.size());
+}
+
+// feeds the output a few bytes at a time like the detokenizer does
+void parse_streaming(benchmark::State& state, const std::string& format) {
+  const auto json_tools = tools();
+  const std::string text = tool_call_output(format, state.range(0));
+  constexpr size_t kChunkSize = 4;
+  size_t num_names = 0;
+  for (auto _ : state) {
+    FunctionCallParser parser(json_tools, format);
+    num_names = 0;
+    for (size_t pos = 0; pos < text.size(); pos += kChunkSize) {
+      auto result =
+          parser.parse_streaming_increment(text.substr(pos, kChunkSize));
+      for (const auto& call : result.calls) {
+        num_names += call.name.has_value() ? 1 : 0;
+      }
+    }
+  }
+  CHECK_EQ(num_names, state.range(0));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          text.size());
+}
+
+}  // namespace
+
+static void BM_ParseNonStreamQwen25(benchmark::State& state) {
+  parse_non_stream(state, "qwen25");
+}
+
+static void BM_ParseNonStreamKimiK2(benchmark::State& state) {
+  parse_non_stream(state, "kimi_k2");
+}
+
+static void BM_ParseNonStreamDeepSeekV3(benchmark::State& state) {
+  parse_non_stream(state, "deepseekv3");
+}
+
+static void BM_ParseStreamingQwen25(benchmark::State& state) {
+  parse_streaming(state, "qwen25");
+}
+
+static void BM_ParseStreamingKimiK2(benchmark::State& state) {
+  parse_streaming(state, "kimi_k2");
+}
+
+static void BM_ParseStreamingDeepSeekV3(benchmark::State& state) {
+  parse_streaming(state, "deepseekv3");
+}
+
+BENCHMARK(BM_ParseNonStreamQwen25)->Arg(1)->Arg(8)->Arg(64);
+
+BENCHMARK(BM_ParseNonStreamKimiK2)->Arg(1)->Arg(8)->Arg(64);
+
+BENCHMARK(BM_ParseNonStreamDeepSeekV3)->Arg(1)->Arg(8)->Arg(64);
+
+BENCHMARK(BM_ParseStreamingQwen25)->Arg(1)->Arg(8)->Arg(64);
+
+BENCHMARK(BM_ParseStreamingKimiK2)->Arg(1)->Arg(8)->Arg(64);
+
+BENCHMARK(BM_ParseStreamingDeepSeekV3)->Arg(1)->Arg(8)->Arg(64);
+
+BENCHMARK_MAIN();
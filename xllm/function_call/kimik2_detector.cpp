@@ -1,8 +1,9 @@
 #include "kimik2_detector.h"
 
+#include <cctype>
 #include <iostream>
-#include <regex>
 #include <stdexcept>
+#include <string_view>
 
 namespace xllm {
 namespace function_call {
@@ -15,22 +16,6 @@ KimiK2Detector::KimiK2Detector() : BaseFormatDetector() {
   tool_call_end_token_ = "<|tool_call_end|>";
   tool_call_argument_begin_token_ = "<|tool_call_argument_begin|>";
 
-  // Regex pattern for parsing tool calls with the following format:
-  //   <|tool_call_begin|>functions.{func_name}:{index}
-  //   <|tool_call_argument_begin|>{json_args}<|tool_call_end|>
-  // Note: C++ regex doesn't support named groups, so we use numbered groups:
-  //   Group 1: tool_call_id (functions.{func_name}:{index})
-  //   Group 2: function_arguments ({json_args})
-  std::string pattern =
-      R"(<\|tool_call_begin\|>\s*([\w\.]+:\d+)\s*<\|tool_call_argument_begin\|>\s*(\{.*?\})\s*<\|tool_call_end\|>)";
-
-  try {
-    tool_call_regex_ = std::regex(pattern, std::regex_constants::ECMAScript);
-  } catch (const std::regex_error& e) {
-    LOG(ERROR) << "Failed to compile KimiK2 regex pattern: " << e.what();
-    throw;
-  }
-
   last_arguments_ = "";
 }
 
@@ -51,38 +36,158 @@ StreamingParseResult KimiK2Detector::detect_and_parse(
     return StreamingParseResult(normal_text);
   }
 
+  // Scan for tool calls with the following format:
+  //   <|tool_call_begin|>functions.{func_name}:{index}
+  //   <|tool_call_argument_begin|>{json_args}<|tool_call_end|>
+  // in a single forward pass, a call that does not match is skipped.
   std::vector<ToolCallItem> calls;
+  const std::string_view view(text);
+  size_t pos = bot_pos + bot_token_.size();
+  while (true) {
+    const size_t call_pos = view.find(tool_call_start_token_, pos);
+    if (call_pos == std::string_view::npos) {
+      break;
+    }
+    const size_t id_start = call_pos + tool_call_start_token_.size();
+    const size_t arg_pos = view.find(tool_call_argument_begin_token_, id_start);
+    if (arg_pos == std::string_view::npos) {
+      break;
+    }
+    const size_t args_start = arg_pos + tool_call_argument_begin_token_.size();
+    const size_t end_pos = view.find(tool_call_end_token_, args_start);
+    if (end_pos == std::string_view::npos) {
+      break;
+    }
+    pos = end_pos + tool_call_end_token_.size();
 
-  try {
-    std::sregex_iterator iter(
-        text.begin() + bot_pos, text.end(), tool_call_regex_);
-    std::sregex_iterator end;
+    const std::string_view tool_call_id =
+        trim_whitespace(view.substr(id_start, arg_pos - id_start));
+    const std::string_view function_arguments =
+        trim_whitespace(view.substr(args_start, end_pos - args_start));
+    if (!is_valid_tool_call_id(tool_call_id) ||
+        function_arguments.size() < 2 || function_arguments.front() != '{' ||
+        function_arguments.back() != '}') {
+      LOG(WARNING) << "Skip malformed KimiK2 tool call: "
+                   << view.substr(call_pos, pos - call_pos);
+      continue;
+    }
 
-    for (; iter != end; ++iter) {
-      std::smatch match = *iter;
+    const std::string id(tool_call_id);
+    calls.emplace_back(extract_function_index(id),  // Use the call index in
+                                                    // the response, not tool
+                                                    // position
+                       extract_function_name(id),   // Function name
+                       std::string(function_arguments)  // JSON parameters
+    );
+  }
 
-      if (match.size() >= 3) {
-        std::string tool_call_id = match[1].str();
-        std::string function_arguments = match[2].str();
+  return StreamingParseResult(normal_text, calls);
+}
 
-        std::string function_name = extract_function_name(tool_call_id);
-        int function_index = extract_function_index(tool_call_id);
+StreamingParseResult KimiK2Detector::parse_streaming_increment(
+    const std::string& new_text,
+    const std::vector<JsonTool>& tools) {
+  buffer_.append(new_text);
+
+  StreamingParseResult result;
+  while (true) {
+    if (!in_tool_call_) {
+      if (!consume_normal_text(&result)) {
+        break;
+      }
+      in_tool_call_ = true;
+    }
+    if (!parse_streaming_tool_calls(tools, &result)) {
+      break;
+    }
+    in_tool_call_ = false;
+  }
+  return result;
+}
 
-        calls.emplace_back(function_index,     // Use the call index in the
-                                               // response, not tool position
-                           function_name,      // Function name
-                           function_arguments  // JSON parameters
-        );
+bool KimiK2Detector::parse_streaming_tool_calls(
+    const std::vector<JsonTool>& tools,
+    StreamingParseResult* result) {
+  // <|tool_call_begin|>functions.{name}:{index}<|tool_call_argument_begin|>
+  // {args}<|tool_call_end|>, repeated until <|tool_calls_section_end|>
+  while (true) {
+    if (!current_tool_name_sent_ && !current_tool_skipped_) {
+      const size_t call_pos = buffer_.find(tool_call_start_token_);
+      const size_t eot_pos = buffer_.find(eot_token_);
+      if (eot_pos != std::string::npos &&
+          (call_pos == std::string::npos || eot_pos < call_pos)) {
+        buffer_.erase(0, eot_pos + eot_token_.size());
+        return true;
+      }
+      if (call_pos == std::string::npos) {
+        return false;
+      }
+      const size_t id_start = call_pos + tool_call_start_token_.size();
+      const size_t arg_pos =
+          buffer_.find(tool_call_argument_begin_token_, id_start);
+      if (arg_pos == std::string::npos) {
+        return false;
       }
+      std::string tool_call_id = buffer_.substr(id_start, arg_pos - id_start);
+      const size_t id_begin = tool_call_id.find_first_not_of(" \t\n\r");
+      const size_t id_end = tool_call_id.find_last_not_of(" \t\n\r");
+      tool_call_id = id_begin == std::string::npos
+                         ? ""
+                         : tool_call_id.substr(id_begin, id_end - id_begin + 1);
+      buffer_.erase(0, arg_pos + tool_call_argument_begin_token_.size());
+      current_tool_skipped_ = !start_streaming_tool_call(
+          extract_function_name(tool_call_id), tools, result);
     }
 
-    return StreamingParseResult(normal_text, calls);
+    const size_t args_end = find_json_value_end(buffer_);
+    if (current_tool_name_sent_) {
+      stream_tool_arguments(std::string_view(buffer_).substr(0, args_end),
+                            result);
+    }
 
-  } catch (const std::exception& e) {
-    LOG(ERROR) << "Error in KimiK2 detect_and_parse: " << e.what();
-    // Return the normal text if parsing fails
-    return StreamingParseResult(normal_text);
+    // wait for the end of the call, a malformed call is dropped once it
+    // arrives
+    const size_t call_end_pos = buffer_.find(
+        tool_call_end_token_, args_end != std::string::npos ? args_end : 0);
+    if (call_end_pos == std::string::npos) {
+      return false;
+    }
+    if (current_tool_name_sent_ &&
+        streamed_args_for_tool_[current_tool_id_].empty()) {
+      stream_tool_arguments("{}", result);
+    }
+    finish_streaming_tool_call();
+    buffer_.erase(0, call_end_pos + tool_call_end_token_.size());
+  }
+}
+
+std::string_view KimiK2Detector::trim_whitespace(std::string_view str) {
+  const size_t begin = str.find_first_not_of(" \t\n\r");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  const size_t end = str.find_last_not_of(" \t\n\r");
+  return str.substr(begin, end - begin + 1);
+}
+
+bool KimiK2Detector::is_valid_tool_call_id(std::string_view tool_call_id) {
+  // [\w.]+:\d+
+  const size_t colon_pos = tool_call_id.rfind(':');
+  if (colon_pos == std::string_view::npos || colon_pos == 0 ||
+      colon_pos + 1 == tool_call_id.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < tool_call_id.size(); ++i) {
+    const unsigned char c = tool_call_id[i];
+    if (i < colon_pos) {
+      if (!std::isalnum(c) && c != '_' && c != '.') {
+        return false;
+      }
+    } else if (i > colon_pos && !std::isdigit(c)) {
+      return false;
+    }
   }
+  return true;
 }
 
 std::string KimiK2Detector::extract_function_name(
@@ -1,7 +1,7 @@
 #pragma once
 
-#include <regex>
 #include <string>
+#include <string_view>
 
 #include "base_format_detector.h"
 
@@ -33,8 +33,6 @@ class KimiK2Detector : public BaseFormatDetector {
   std::string tool_call_end_token_;
   std::string tool_call_argument_begin_token_;
 
-  std::regex tool_call_regex_;
-
   std::string last_arguments_;
 
  public:
@@ -44,7 +42,21 @@ class KimiK2Detector : public BaseFormatDetector {
       const std::string& text,
       const std::vector<JsonTool>& tools) override;
 
+  StreamingParseResult parse_streaming_increment(
+      const std::string& new_text,
+      const std::vector<JsonTool>& tools) override;
+
  private:
+  // parses the tool calls section in buffer_, returns true once the end of
+  // the section is consumed.
+  bool parse_streaming_tool_calls(const std::vector<JsonTool>& tools,
+                                  StreamingParseResult* result);
+
+  static std::string_view trim_whitespace(std::string_view str);
+
+  // whether the id matches functions.{func_name}:{index}
+  static bool is_valid_tool_call_id(std::string_view tool_call_id);
+
   std::string extract_function_name(const std::string& tool_call_id) const;
 
   int extract_function_index(const std::string& tool_call_id) const;
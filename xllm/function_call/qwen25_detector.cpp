@@ -11,11 +11,6 @@ Qwen25Detector::Qwen25Detector() : BaseFormatDetector() {
   bot_token_ = "<tool_call>\n";
   eot_token_ = "\n</tool_call>";
   tool_call_separator_ = "\n";
-
-  std::string pattern = bot_token_ + "([\\s\\S]*?)" + eot_token_;
-  tool_call_regex_ = std::regex(
-      pattern,
-      std::regex_constants::ECMAScript | std::regex_constants::optimize);
 }
 
 bool Qwen25Detector::has_tool_call(const std::string& text) {
@@ -112,5 +107,81 @@ StreamingParseResult Qwen25Detector::detect_and_parse(
   return StreamingParseResult(std::move(normal_text), std::move(calls));
 }
 
+StreamingParseResult Qwen25Detector::parse_streaming_increment(
+    const std::string& new_text,
+    const std::vector<JsonTool>& tools) {
+  buffer_.append(new_text);
+
+  StreamingParseResult result;
+  while (true) {
+    if (!in_tool_call_) {
+      if (!consume_normal_text(&result)) {
+        break;
+      }
+      in_tool_call_ = true;
+    }
+    if (!parse_streaming_tool_call(tools, &result)) {
+      break;
+    }
+    in_tool_call_ = false;
+  }
+  return result;
+}
+
+bool Qwen25Detector::parse_streaming_tool_call(
+    const std::vector<JsonTool>& tools,
+    StreamingParseResult* result) {
+  // the tool call is a json object: {"name": ..., "arguments": {...}}
+  const auto members = scan_json_object(buffer_);
+  if (!current_tool_name_sent_ && !current_tool_skipped_) {
+    for (const auto& member : members) {
+      if (member.key != "name" || member.value_end == std::string::npos) {
+        continue;
+      }
+      try {
+        auto name = nlohmann::json::parse(buffer_.substr(
+            member.value_begin, member.value_end - member.value_begin));
+        current_tool_skipped_ =
+            !name.is_string() ||
+            !start_streaming_tool_call(name.get<std::string>(), tools, result);
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Failed to parse tool name, error: " << e.what();
+        current_tool_skipped_ = true;
+      }
+      break;
+    }
+  }
+  if (current_tool_name_sent_) {
+    for (const auto& member : members) {
+      if (member.key != "arguments" && member.key != "parameters") {
+        continue;
+      }
+      const size_t value_end = member.value_end != std::string::npos
+                                   ? member.value_end
+                                   : buffer_.size();
+      stream_tool_arguments(
+          std::string_view(buffer_).substr(member.value_begin,
+                                           value_end - member.value_begin),
+          result);
+      break;
+    }
+  }
+
+  // wait for the end token, a malformed json is dropped once it arrives
+  const size_t json_end = find_json_value_end(buffer_);
+  const size_t eot_pos = buffer_.find(
+      eot_token_, json_end != std::string::npos ? json_end : 0);
+  if (eot_pos == std::string::npos) {
+    return false;
+  }
+  if (current_tool_name_sent_ &&
+      streamed_args_for_tool_[current_tool_id_].empty()) {
+    stream_tool_arguments("{}", result);
+  }
+  finish_streaming_tool_call();
+  buffer_.erase(0, eot_pos + eot_token_.size());
+  return true;
+}
+
 }  // namespace function_call
 }  // namespace xllm
\ No newline at end of file
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <regex>
 #include <string>
 #include <string_view>
 
@@ -18,8 +17,6 @@ class Qwen25Detector : public BaseFormatDetector {
  private:
   std::string normal_text_buffer_;
 
-  std::regex tool_call_regex_;
-
   std::string_view trim_whitespace(std::string_view str) const;
 
   std::vector<std::pair<size_t, size_t>> find_tool_call_ranges(
@@ -31,6 +28,16 @@ class Qwen25Detector : public BaseFormatDetector {
   StreamingParseResult detect_and_parse(
       const std::string& text,
       const std::vector<JsonTool>& tools) override;
+
+  StreamingParseResult parse_streaming_increment(
+      const std::string& new_text,
+      const std::vector<JsonTool>& tools) override;
+
+ private:
+  // parses the json of the current tool call in buffer_, returns true once
+  // the tool call is complete and consumed.
+  bool parse_streaming_tool_call(const std::vector<JsonTool>& tools,
+                                 StreamingParseResult* result);
 };
 
 }  // namespace function_call
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "base_format_detector.h"
+
+namespace xllm {
+namespace function_call {
+
+// the normal text and the tool calls assembled from the streaming deltas
+struct StreamedToolCalls {
+  std::string normal_text;
+  std::vector<std::string> names;
+  std::vector<std::string> arguments;
+};
+
+// Feeds text to the detector in chunks of chunk_size and finishes the stream.
+// Checks that the name of each tool call is sent first with empty parameters
+// and its arguments follow before the next call starts.
+inline StreamedToolCalls stream_in_chunks(BaseFormatDetector& detector,
+                                          const std::string& text,
+                                          size_t chunk_size,
+                                          const std::vector<JsonTool>& tools) {
+  StreamedToolCalls streamed;
+  auto collect = [&streamed](const StreamingParseResult& result) {
+    streamed.normal_text += result.normal_text;
+    for (const auto& call : result.calls) {
+      const size_t tool_index = static_cast<size_t>(call.tool_index);
+      if (call.name.has_value()) {
+        EXPECT_EQ(tool_index, streamed.names.size());
+        EXPECT_TRUE(call.parameters.empty());
+        streamed.names.push_back(call.name.value());
+        streamed.arguments.emplace_back();
+      } else if (tool_index + 1 == streamed.names.size()) {
+        streamed.arguments.back() += call.parameters;
+      } else {
+        ADD_FAILURE() << "Arguments of tool call " << call.tool_index
+                      << " after " << streamed.names.size() << " names";
+      }
+    }
+  };
+  for (size_t pos = 0; pos < text.size(); pos += chunk_size) {
+    collect(detector.parse_streaming_increment(text.substr(pos, chunk_size),
+                                               tools));
+  }
+  collect(detector.finish_streaming());
+  return streamed;
+}
+
+}  // namespace function_call
+}  // namespace xllm
@@ -14,6 +14,12 @@ class ImageProcessor {
   virtual ~ImageProcessor() = default;
 
   virtual bool process(const MMInput& mm_inputs, MMData& mm_datas) = 0;
+
+  // whether processing the images of a request one by one and batching the
+  // results gives the same data as processing them together, so that the
+  // data of each image can be cached on its own.
+  virtual bool process_images_independently() const { return false; }
+
   virtual torch::Tensor resize(const torch::Tensor& image,
                                const std::vector<int64_t>& size,
                                int resample,
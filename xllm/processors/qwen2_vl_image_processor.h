@@ -15,6 +15,8 @@ class Qwen2VLImageProcessor : public ImageProcessor {
 
   bool process(const MMInput& mm_inputs, MMData& mm_datas) override;
 
+  bool process_images_independently() const override { return true; }
+
  private:
   bool process_images(std::vector<torch::Tensor> images, MMData& mm_datas);
   bool process_image(torch::Tensor image,
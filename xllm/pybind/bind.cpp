@@ -132,7 +132,17 @@ PYBIND11_MODULE(xllm_export, m) {
       .def_readwrite("ignore_eos", &RequestParams::ignore_eos)
       .def_readwrite("is_embeddings", &RequestParams::is_embeddings)
       .def_readwrite("stop", &RequestParams::stop)
-      .def_readwrite("stop_token_ids", &RequestParams::stop_token_ids);
+      .def_readwrite("stop_token_ids", &RequestParams::stop_token_ids)
+      .def_readwrite("priority", &RequestParams::priority)
+      .def_readwrite("ttft_slo_ms", &RequestParams::ttft_slo_ms)
+      .def_readwrite("tpot_slo_ms", &RequestParams::tpot_slo_ms)
+      .def_readwrite("tenant", &RequestParams::tenant);
+
+  py::enum_<RequestPriority>(m, "RequestPriority")
+      .value("HIGH", RequestPriority::HIGH)
+      .value("MEDIUM", RequestPriority::MEDIUM)
+      .value("LOW", RequestPriority::LOW)
+      .export_values();
 
   // 4. export RequestOutput
   py::class_<RequestOutput>(m, "RequestOutput")